@@ -11,7 +11,7 @@
 #include "Sound.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
-#include "utils/ThreadPool.h"
+#include "utils/TaskScheduler.h"
 #include "RetroAchievements.h"
 #include "utils/ZipFile.h"
 #include "Paths.h"
@@ -1362,10 +1362,10 @@ std::vector<std::string> ApiSystem::extractPdfImages(const std::string fileName,
 			int pc = getPdfPageCount(fileName);
 			if (pc > 0)
 			{
-				Utils::ThreadPool pool(1);
+				Utils::TaskGroup pool(Utils::TASK_UI);
 
 				for (int i = 0; i < pc; i += numberOfPagesToProcess)
-					pool.queueWorkItem([this, fileName, i, numberOfPagesToProcess] { extractPdfImages(fileName, i + 1, numberOfPagesToProcess); });
+					pool.run([this, fileName, i, numberOfPagesToProcess] { extractPdfImages(fileName, i + 1, numberOfPagesToProcess); });
 
 				pool.wait();
 
@@ -15,11 +15,12 @@
 #include "LocaleES.h"
 #include <pugixml/src/pugixml.hpp>
 #include <fstream>
+#include <set>
 #include "Gamelist.h"
 #include "FileSorts.h"
 #include "views/gamelist/ISimpleGameListView.h"
 #include "PlatformId.h"
-#include "utils/ThreadPool.h"
+#include "utils/TaskScheduler.h"
 #include "Genres.h"
 #include "Paths.h"
 
@@ -460,9 +461,7 @@ void CollectionSystemManager::sortLastPlayed(SystemData* system)
 	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(system->getSortId());
 
 	std::vector<FileData*>& childs = (std::vector<FileData*>&) rootFolder->getChildren();
-	std::sort(childs.begin(), childs.end(), sort.comparisonFunction);
-	if (!sort.ascending)
-		std::reverse(childs.begin(), childs.end());
+	FileSorts::sort(childs, sort);
 }
 
 void CollectionSystemManager::trimCollectionCount(FolderData* rootFolder, int limit)
@@ -919,14 +918,94 @@ SystemData* CollectionSystemManager::createNewCollectionEntry(std::string name,
 // populates an Automatic Collection System
 void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysData)
 {
-	SystemData* newSys = sysData->system;
-	CollectionSystemDecl sysDecl = sysData->decl;
-	FolderData* rootFolder = newSys->getRootFolder();
+	populateAutoCollections({ sysData });
+}
+
+// Players metadata : "2", "1-4" or "2+"
+static bool hasPlayers(std::string players, int val)
+{
+	if (players.empty())
+		return false;
+
+	int min = -1;
+
+	auto split = players.rfind("+");
+	if (split != std::string::npos)
+		players = Utils::String::replace(players, "+", "-999");
+
+	split = players.rfind("-");
+	if (split != std::string::npos)
+	{
+		min = atoi(players.substr(0, split).c_str());
+		players = players.substr(split + 1);
+	}
+
+	int max = atoi(players.c_str());
+	return min <= 0 ? (val == max) : (min <= val && val <= max);
+}
+
+static bool isInAutoCollection(const CollectionSystemDecl& sysDecl, FileData* game, bool isArcade)
+{
+	switch (sysDecl.type)
+	{
+	case AUTO_ALL_GAMES:
+		return true;
+	case AUTO_VERTICALARCADE:
+		return game->isVerticalArcadeGame();
+	case AUTO_LIGHTGUN:
+		return game->isLightGunGame();
+	case AUTO_RETROACHIEVEMENTS:
+		return game->hasCheevos();
+	case AUTO_LAST_PLAYED:
+		return game->getMetadata(MetaDataId::PlayCount) > "0";
+	case AUTO_NEVER_PLAYED:
+		return !(game->getMetadata(MetaDataId::PlayCount) > "0");
+	case AUTO_FAVORITES:
+		// we may still want to add files we don't want in auto collections in "favorites"
+		return game->getFavorite();
+	case AUTO_ARCADE:
+		return isArcade;
+	case AUTO_AT2PLAYERS:
+		return hasPlayers(game->getMetadata(MetaDataId::Players), 2);
+	case AUTO_AT4PLAYERS:
+		return hasPlayers(game->getMetadata(MetaDataId::Players), 4);
+	default:
+		break;
+	}
+
+	return true;
+}
+
+// Populates many Automatic Collection Systems with a single pass over the games : each game is tested against all of them at once.
+// Genre & arcade system collections are found from the genre ids and arcade system of the game, so enabling many of them costs a lookup, not a pass.
+void CollectionSystemManager::populateAutoCollections(const std::vector<CollectionSystemData*>& collections)
+{
+	if (collections.empty())
+		return;
+
+	StopWatch stopWatch("populateAutoCollections - " + std::to_string(collections.size()) + " collections :", LogDebug);
+
+	std::vector<int> typeCollections;
+	std::unordered_map<int, std::vector<int>> genreCollections;
+	std::unordered_map<std::string, std::vector<int>> arcadeCollections;
+
+	for (int i = 0; i < (int)collections.size(); i++)
+	{
+		auto& sysDecl = collections[i]->decl;
+
+		if (!sysDecl.isCustom && !sysDecl.displayIfEmpty && sysDecl.isGenreCollection())
+			genreCollections[((int)sysDecl.type) - 10000].push_back(i);
+		else if (!sysDecl.isCustom && !sysDecl.displayIfEmpty && sysDecl.isArcadeSubSystem())
+			arcadeCollections[sysDecl.themeFolder].push_back(i);
+		else
+			typeCollections.push_back(i);
+	}
 
 	bool hiddenSystemsShowGames = Settings::HiddenSystemsShowGames();
 	auto hiddenSystems = Utils::String::split(Settings::getInstance()->getString("HiddenSystems"), ';');
 
-	for (auto& system : SystemData::sSystemVector)
+	std::vector<SystemData*> systems;
+	for (auto system : SystemData::sSystemVector)
 	{
 		// we won't iterate all collections
 		if (!system->isGameSystem() || system->isCollection())
@@ -935,6 +1014,17 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 		if (!hiddenSystemsShowGames && std::find(hiddenSystems.cbegin(), hiddenSystems.cend(), system->getName()) != hiddenSystems.cend())
 			continue;
 
+		systems.push_back(system);
+	}
+
+	// Games of each collection, per source system
+	std::vector<std::vector<std::vector<FileData*>>> matches(systems.size(), std::vector<std::vector<FileData*>>(collections.size()));
+
+	auto classifySystem = [&](int systemIndex)
+	{
+		SystemData* system = systems[systemIndex];
+		auto& systemMatches = matches[systemIndex];
+
 		std::vector<PlatformIds::PlatformId> platforms = system->getPlatformIds();
 		bool isArcade = std::find(platforms.begin(), platforms.end(), PlatformIds::ARCADE) != platforms.end();
 
@@ -948,8 +1038,7 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 			if (system->isGroupSystem() && game->getSystem() != system)
 				continue;
 
-			bool include = includeFileInAutoCollections(game);
-			if (!include)
+			if (!includeFileInAutoCollections(game))
 				continue;
 
 			if (hiddenExts.size() > 0 && game->getType() == GAME)
@@ -959,89 +1048,84 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 					continue;
 			}
 
-			switch (sysDecl.type)
-			{
-			case AUTO_ALL_GAMES:
-				break;
-			case AUTO_VERTICALARCADE:
-				include = game->isVerticalArcadeGame();
-				break;
-			case AUTO_LIGHTGUN:
-				include = game->isLightGunGame();
-				break;
-			case AUTO_RETROACHIEVEMENTS:
-				include = game->hasCheevos();
-				break;
-			case AUTO_LAST_PLAYED:
-				include = game->getMetadata(MetaDataId::PlayCount) > "0";
-				break;
-			case AUTO_NEVER_PLAYED:
-				include = !(game->getMetadata(MetaDataId::PlayCount) > "0");
-				break;
-			case AUTO_FAVORITES:
-				// we may still want to add files we don't want in auto collections in "favorites"
-				include = game->getFavorite();
-				break;
-			case AUTO_ARCADE:
-				include = isArcade;
-				break;
-			case AUTO_AT2PLAYERS: 
-			case AUTO_AT4PLAYERS:
+			for (auto index : typeCollections)
+				if (isInAutoCollection(collections[index]->decl, game, isArcade))
+					systemMatches[index].push_back(game);
+
+			if (genreCollections.size() > 0)
 			{
-				std::string players = game->getMetadata(MetaDataId::Players);
-				if (players.empty())
-					include = false;
-				else
-				{
-					int min = -1;
-
-					auto split = players.rfind("+");
-					if (split != std::string::npos)
-						players = Utils::String::replace(players, "+", "-999");
-
-					split = players.rfind("-");
-					if (split != std::string::npos)
-					{
-						min = atoi(players.substr(0, split).c_str());
-						players = players.substr(split + 1);
-					}
-
-					int max = atoi(players.c_str());
-					int val = (sysDecl.type == AUTO_AT2PLAYERS ? 2 : 4);
-					include = min <= 0 ? (val == max) : (min <= val && val <= max);
-				}
-			}
-			break;
+				// A genre id may be listed twice : add the game once to each collection
+				std::set<int> genreIds;
+				for (auto id : Utils::String::split(game->getMetadata(MetaDataId::GenreIds), ',', true))
+					genreIds.insert(atoi(id.c_str()));
 
-			default:
-				if (!sysDecl.isCustom && !sysDecl.displayIfEmpty)
+				for (auto id : genreIds)
 				{
-					if (sysDecl.isGenreCollection())
-						include = Genres::genreExists(&game->getMetadata(), ((int)sysDecl.type) - 10000);
-					else if (sysDecl.isArcadeSubSystem())
-						include = isArcade && game->getMetadata(MetaDataId::ArcadeSystemName) == sysDecl.themeFolder;
+					auto it = genreCollections.find(id);
+					if (it != genreCollections.cend())
+						for (auto index : it->second)
+							systemMatches[index].push_back(game);
 				}
+			}
 
-				break;
+			if (isArcade && arcadeCollections.size() > 0)
+			{
+				auto it = arcadeCollections.find(game->getMetadata(MetaDataId::ArcadeSystemName));
+				if (it != arcadeCollections.cend())
+					for (auto index : it->second)
+						systemMatches[index].push_back(game);
 			}
+		}
+	};
+
+	auto buildCollection = [&](int index)
+	{
+		CollectionSystemData* sysData = collections[index];
+		SystemData* newSys = sysData->system;
+		FolderData* rootFolder = newSys->getRootFolder();
 
-			if (include)
+		for (auto& systemMatches : matches)
+		{
+			for (auto game : systemMatches[index])
 			{
 				CollectionFileData* newGame = new CollectionFileData(game, newSys);
 				rootFolder->addChild(newGame);
 				newSys->addToIndex(newGame);
 			}
 		}
-	}
 
-	if (sysDecl.type == AUTO_LAST_PLAYED)
+		if (sysData->decl.type == AUTO_LAST_PLAYED)
+		{
+			sortLastPlayed(newSys);
+			trimCollectionCount(rootFolder, LAST_PLAYED_MAX);
+		}
+
+		sysData->isPopulated = true;
+		updateCollectionFolderMetadata(newSys);
+	};
+
+	if (Settings::getInstance()->getBool("ThreadedLoading"))
 	{
-		sortLastPlayed(newSys);
-		trimCollectionCount(rootFolder, LAST_PLAYED_MAX);
+		Utils::TaskGroup pool(Utils::TASK_UI);
+
+		for (int i = 0; i < (int)systems.size(); i++)
+			pool.run([classifySystem, i] { classifySystem(i); });
+
+		pool.wait();
+
+		for (int i = 0; i < (int)collections.size(); i++)
+			pool.run([buildCollection, i] { buildCollection(i); });
+
+		pool.wait();
 	}
+	else
+	{
+		for (int i = 0; i < (int)systems.size(); i++)
+			classifySystem(i);
 
-	sysData->isPopulated = true;
-	updateCollectionFolderMetadata(newSys);
+		for (int i = 0; i < (int)collections.size(); i++)
+			buildCollection(i);
+	}
 }
 
 // populates a Custom Collection System
@@ -1170,29 +1254,38 @@ void CollectionSystemManager::removeCollectionsFromDisplayedSystems()
 
 void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData, std::unordered_map<std::string, FileData*>* pMap)
 {
-	if (Settings::getInstance()->getBool("ThreadedLoading"))
+	std::vector<CollectionSystemData*> autoCollections;
+	std::vector<CollectionSystemData*> customCollections;
+
+	for (auto it = colSystemData->begin(); it != colSystemData->end(); it++)
 	{
-		std::vector<CollectionSystemData*> collectionsToPopulate;
-		for (auto it = colSystemData->begin(); it != colSystemData->end(); it++)
-			if (it->second.isEnabled && !it->second.isPopulated)
-				collectionsToPopulate.push_back(&(it->second));
+		if (!it->second.isEnabled || it->second.isPopulated)
+			continue;
 
-		if (collectionsToPopulate.size() > 1)
-		{
-			getAllGamesCollection();
+		if (it->second.decl.isCustom)
+			customCollections.push_back(&(it->second));
+		else
+			autoCollections.push_back(&(it->second));
+	}
 
-			Utils::ThreadPool pool;
+	// Custom collections are made from the games of the "all" collection
+	if (customCollections.size() > 0)
+	{
+		CollectionSystemData* allSysData = &mAutoCollectionSystemsData["all"];
+		if (!allSysData->isPopulated && std::find(autoCollections.cbegin(), autoCollections.cend(), allSysData) == autoCollections.cend())
+			autoCollections.push_back(allSysData);
+	}
 
-			for (auto collection : collectionsToPopulate)
-			{
-				if (collection->decl.isCustom)
-					pool.queueWorkItem([this, collection, pMap] { populateCustomCollection(collection, pMap); });
-				else
-					pool.queueWorkItem([this, collection, pMap] { populateAutoCollection(collection); });
-			}
+	populateAutoCollections(autoCollections);
 
-			pool.wait();
-		}
+	if (customCollections.size() > 1 && Settings::getInstance()->getBool("ThreadedLoading"))
+	{
+		Utils::TaskGroup pool(Utils::TASK_UI);
+
+		for (auto collection : customCollections)
+			pool.run([this, collection, pMap] { populateCustomCollection(collection, pMap); });
+
+		pool.wait();
 	}
 
 	// add auto enabled ones
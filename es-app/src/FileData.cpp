@@ -23,9 +23,11 @@
 #include "ApiSystem.h"
 #include <time.h>
 #include <algorithm>
+#include <atomic>
 #include "LangParser.h"
 #include "resources/ResourceManager.h"
 #include "RetroAchievements.h"
+#include "HashDatabase.h"
 #include "SaveStateRepository.h"
 #include "Genres.h"
 #include "TextToSpeech.h"
@@ -828,6 +830,8 @@ std::set<std::string> FileData::getContentFiles()
 
 void FileData::deleteGameFiles()
 {
+	removeFromGamelistRecovery(this);
+
 	for (auto mdd : mMetadata.getMDD())
 	{
 		if (mMetadata.getType(mdd.id) != MetaDataType::MD_PATH)
@@ -888,139 +892,361 @@ const std::string& CollectionFileData::getName()
 	return mSourceFileData->getName();
 }
 
-const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+// Incremented by every change of the children of any folder
+static std::atomic<unsigned int> sChildrenVersion(0);
+
+// Changes applied to a display list without building it again. Above, sorting everything is cheaper.
+#define DISPLAYLIST_MAX_CHANGES 32
+
+// Displayed children of a folder, and what they were built from.
+// While nothing else changes, edited, added or removed games are moved in the sorted list.
+struct FolderDisplayCache
 {
-	std::vector<FileData*> ret;
+	FolderDisplayCache() : valid(false), incremental(false), system(nullptr), index(nullptr), indexVersion(0), settingsVersion(0), sortId(0),
+		kiosk(false), kid(false), childrenVersion(0), metadataRevision(0), showHiddenFiles(false), filterKidGame(false) { }
 
-	std::string showFoldersMode = getSystem()->getFolderViewMode();
-	
-	bool showHiddenFiles = Settings::ShowHiddenFiles();
+	bool		valid;
+	bool		incremental; // Visibility & order of the children only depend on their own metadata
 
-	auto shv = Settings::getInstance()->getString(getSystem()->getName() + ".ShowHiddenFiles");
-	if (shv == "1") showHiddenFiles = true;
-	else if (shv == "0") showHiddenFiles = false;
+	SystemData*		 system;
+	FileFilterIndex* index;
+	unsigned int	 indexVersion;
+	unsigned int	 settingsVersion;
+	unsigned int	 sortId;
+	bool			 kiosk;
+	bool			 kid;
+	unsigned int	 childrenVersion;
+	unsigned int	 metadataRevision;
+
+	bool					 showHiddenFiles;
+	bool					 filterKidGame;
+	std::string				 showFoldersMode;
+	std::vector<std::string> hiddenExts;
+
+	std::vector<FileData*>						items;
+	std::unordered_map<FileData*, int>			scores;	   // Relevancy of the items when searching
+	std::unordered_map<FileData*, unsigned int>	revisions; // Metadata revision of the children the list was built with
 
-	bool filterKidGame = false;
+	std::vector<FileData*> added;	// Children added or removed since the list was built
+	std::vector<FileData*> removed;
+};
 
-	if (!Settings::getInstance()->getBool("ForceDisableFilters"))
+// Order of the displayed items : relevancy first when searching, then the sort of the system
+struct DisplayOrder
+{
+	DisplayOrder(const FileSorts::SortType& sortType, const std::unordered_map<FileData*, int>* scoringBoard) : sort(sortType), scores(scoringBoard) { }
+
+	bool operator()(FileData* file1, FileData* file2) const
 	{
-		if (UIModeController::getInstance()->isUIModeKiosk())
-			showHiddenFiles = false;
+		if (scores != nullptr)
+		{
+			auto s1 = scores->find(file1);
+			auto s2 = scores->find(file2);
+
+			int score1 = s1 != scores->cend() ? s1->second : 0;
+			int score2 = s2 != scores->cend() ? s2->second : 0;
+			if (score1 != score2)
+				return score1 < score2;
+
+			return FileSorts::compareKeys(sort, file1, file2);
+		}
 
-		if (UIModeController::getInstance()->isUIModeKid())
-			filterKidGame = true;
+		// Descending lists are sorted, then reversed
+		return sort.ascending ? FileSorts::compareKeys(sort, file1, file2) : FileSorts::compareKeys(sort, file2, file1);
 	}
 
-	auto sys = CollectionSystemManager::get()->getSystemToView(mSystem);
+	const FileSorts::SortType&					sort;
+	const std::unordered_map<FileData*, int>*	scores;
+};
 
-	std::vector<std::string> hiddenExts;
-	if (mSystem->isGameSystem() && !mSystem->isCollection())
-		hiddenExts = Utils::String::split(Utils::String::toLower(Settings::getInstance()->getString(mSystem->getName() + ".HiddenExt")), ';');
+static const FileSorts::SortType& getDisplaySortType(SystemData* sys)
+{
+	unsigned int currentSortId = sys->getSortId();
+	if (currentSortId >= FileSorts::getSortTypes().size())
+		currentSortId = 0;
 
-	FileFilterIndex* idx = sys->getIndex(false);
-	if (idx != nullptr && !idx->isFiltered())
-		idx = nullptr;
+	return FileSorts::getSortTypes().at(currentSortId);
+}
+
+void FolderData::invalidateDisplayList()
+{
+	sChildrenVersion++;
+
+	if (mDisplayCache != nullptr)
+		mDisplayCache->valid = false;
+}
+
+void FolderData::onChildChanged(FileData* file, bool added)
+{
+	sChildrenVersion++;
+
+	if (mDisplayCache == nullptr || !mDisplayCache->valid)
+		return;
+
+	if (mDisplayCache->added.size() + mDisplayCache->removed.size() >= DISPLAYLIST_MAX_CHANGES)
+	{
+		mDisplayCache->valid = false;
+		mDisplayCache->added.clear();
+		mDisplayCache->removed.clear();
+		return;
+	}
+
+	if (added)
+	{
+		mDisplayCache->added.push_back(file);
+		return;
+	}
+
+	// The pointer can't be used anymore : only remove it from the list
+	auto it = std::find(mDisplayCache->added.begin(), mDisplayCache->added.end(), file);
+	if (it != mDisplayCache->added.end())
+		mDisplayCache->added.erase(it);
+
+	mDisplayCache->removed.push_back(file);
+}
+
+// Returns 0 if the child is not displayed, else its relevancy score. 'display' receives the item to show instead of the child
+int FolderData::getDisplayScore(FileData* file, FileFilterIndex* idx, FileData*& display)
+{
+	FolderDisplayCache& cache = *mDisplayCache;
+
+	display = file;
+
+	if (!cache.showHiddenFiles && file->getHidden())
+		return 0;
+
+	if (cache.filterKidGame && file->getType() == GAME && !file->getKidGame())
+		return 0;
+
+	if (cache.hiddenExts.size() > 0 && file->getType() == GAME)
+	{
+		std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension(file->getFileName(), false));
+		if (std::find(cache.hiddenExts.cbegin(), cache.hiddenExts.cend(), extlow) != cache.hiddenExts.cend())
+			return 0;
+	}
+
+	int score = 1;
+
+	if (idx != nullptr)
+	{
+		score = idx->showFile(file);
+		if (score == 0)
+			return 0;
+	}
+
+	if (file->getType() == FOLDER && cache.showFoldersMode == "having multiple games")
+	{
+		FolderData* pFolder = (FolderData*)file;
+		if (pFolder->getChildren().size() == 0)
+			return 0;
+
+		if (pFolder->isVirtualStorage() && pFolder->getSourceFileData()->getSystem()->isGroupChildSystem() && pFolder->getSourceFileData()->getSystem()->getName() == "windows_installers")
+			return score;
+
+		auto fd = pFolder->findUniqueGameForFolder();
+		if (fd != nullptr)
+		{
+			if (idx != nullptr && !idx->showFile(fd))
+				return 0;
+
+			if (!cache.showHiddenFiles && fd->getHidden())
+				return 0;
+
+			if (cache.filterKidGame && !fd->getKidGame())
+				return 0;
+
+			display = fd;
+		}
+	}
+
+	return score;
+}
+
+void FolderData::buildDisplayList(SystemData* sys, FileFilterIndex* idx)
+{
+	FolderDisplayCache& cache = *mDisplayCache;
+
+	if (cache.settingsVersion != Settings::getInstance()->getVersion() || !cache.valid || cache.system != sys || cache.kiosk != UIModeController::getInstance()->isUIModeKiosk() || cache.kid != UIModeController::getInstance()->isUIModeKid())
+	{
+		cache.showFoldersMode = getSystem()->getFolderViewMode();
+
+		cache.showHiddenFiles = Settings::ShowHiddenFiles();
+
+		auto shv = Settings::getInstance()->getString(getSystem()->getName() + ".ShowHiddenFiles");
+		if (shv == "1") cache.showHiddenFiles = true;
+		else if (shv == "0") cache.showHiddenFiles = false;
+
+		cache.filterKidGame = false;
+
+		if (!Settings::getInstance()->getBool("ForceDisableFilters"))
+		{
+			if (UIModeController::getInstance()->isUIModeKiosk())
+				cache.showHiddenFiles = false;
+
+			if (UIModeController::getInstance()->isUIModeKid())
+				cache.filterKidGame = true;
+		}
+
+		cache.hiddenExts.clear();
+		if (mSystem->isGameSystem() && !mSystem->isCollection())
+			cache.hiddenExts = Utils::String::split(Utils::String::toLower(Settings::getInstance()->getString(mSystem->getName() + ".HiddenExt")), ';');
+	}
+
+	cache.system = sys;
+	cache.index = idx;
+	cache.indexVersion = idx != nullptr ? idx->getFiltersVersion() : 0;
+	cache.settingsVersion = Settings::getInstance()->getVersion();
+	cache.sortId = sys->getSortId();
+	cache.kiosk = UIModeController::getInstance()->isUIModeKiosk();
+	cache.kid = UIModeController::getInstance()->isUIModeKid();
+	cache.childrenVersion = sChildrenVersion;
+	cache.metadataRevision = MetaDataList::getGlobalRevision();
+
+	cache.items.clear();
+	cache.scores.clear();
+	cache.revisions.clear();
+	cache.added.clear();
+	cache.removed.clear();
 
   	std::vector<FileData*>* items = &mChildren;
 	
 	std::vector<FileData*> flatGameList;
-	if (showFoldersMode == "never")
+	if (cache.showFoldersMode == "never")
 	{
 		flatGameList = getFlatGameList(false, sys);
 		items = &flatGameList;		
 	}
 
-	std::map<FileData*, int> scoringBoard;
-
-	bool refactorUniqueGameFolders = (showFoldersMode == "having multiple games");
+	// Folders are displayed from their content, and flat lists from the whole system
+	cache.incremental = (items == &mChildren);
 
 	for (auto it = items->cbegin(); it != items->cend(); it++)
 	{
-		if (!showHiddenFiles && (*it)->getHidden())
-			continue;
+		if (cache.incremental && (*it)->getType() == FOLDER)
+			cache.incremental = false;
 
-		if (filterKidGame && (*it)->getType() == GAME && !(*it)->getKidGame())
+		FileData* display;
+
+		int score = getDisplayScore(*it, idx, display);
+		if (score == 0)
 			continue;
 
-		if (hiddenExts.size() > 0 && (*it)->getType() == GAME)
+		if (idx != nullptr)
+			cache.scores[*it] = score;
+
+		cache.items.push_back(display);
+	}
+
+	if (cache.incremental)
+		for (auto child : mChildren)
+			cache.revisions[child] = child->getMetadata().getRevision();
+
+	const FileSorts::SortType& sort = getDisplaySortType(sys);
+
+	FileSorts::sort(cache.items, sort, idx != nullptr && idx->hasRelevency() ? &cache.scores : nullptr);
+
+	cache.valid = true;
+}
+
+// Moves the games edited, added or removed since the list was built. Returns false when the list has to be built again
+bool FolderData::updateDisplayList(SystemData* sys, FileFilterIndex* idx)
+{
+	FolderDisplayCache& cache = *mDisplayCache;
+
+	std::vector<FileData*> changes = cache.added;
+
+	if (cache.metadataRevision != MetaDataList::getGlobalRevision())
+	{
+		for (auto child : mChildren)
 		{
-			std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension((*it)->getFileName(), false));
-			if (std::find(hiddenExts.cbegin(), hiddenExts.cend(), extlow) != hiddenExts.cend())
-				continue;
+			auto it = cache.revisions.find(child);
+			if (it != cache.revisions.cend() && it->second != child->getMetadata().getRevision())
+				changes.push_back(child);
 		}
+	}
 
-		if (idx != nullptr)
-		{
-			int score = idx->showFile(*it);
-			if (score == 0)
-				continue;
+	if (changes.size() + cache.removed.size() > DISPLAYLIST_MAX_CHANGES)
+		return false;
 
-			scoringBoard[*it] = score;
-		}
+	for (auto file : cache.removed)
+	{
+		cache.revisions.erase(file);
+		cache.scores.erase(file);
 
-		if ((*it)->getType() == FOLDER && refactorUniqueGameFolders)
-		{
-			FolderData* pFolder = (FolderData*)(*it);
-			if (pFolder->getChildren().size() == 0)
-				continue;
+		auto it = std::find(cache.items.begin(), cache.items.end(), file);
+		if (it != cache.items.end())
+			cache.items.erase(it);
+	}
 
-			if (pFolder->isVirtualStorage() && pFolder->getSourceFileData()->getSystem()->isGroupChildSystem() && pFolder->getSourceFileData()->getSystem()->getName() == "windows_installers")
-			{
-				ret.push_back(*it);
-				continue;
-			}
+	DisplayOrder order(getDisplaySortType(sys), idx != nullptr && idx->hasRelevency() ? &cache.scores : nullptr);
 
-			auto fd = pFolder->findUniqueGameForFolder();
-			if (fd != nullptr)
-			{
-				if (idx != nullptr && !idx->showFile(fd))
-					continue;
+	for (auto file : changes)
+	{
+		if (file->getType() == FOLDER)
+			return false;
 
-				if (!showHiddenFiles && fd->getHidden())
-					continue;
+		auto it = std::find(cache.items.begin(), cache.items.end(), file);
+		if (it != cache.items.end())
+			cache.items.erase(it);
 
-				if (filterKidGame && !fd->getKidGame())
-					continue;
+		cache.revisions[file] = file->getMetadata().getRevision();
+		cache.scores.erase(file);
 
-				ret.push_back(fd);
+		FileData* display;
 
-				continue;
-			}
-		}
+		int score = getDisplayScore(file, idx, display);
+		if (score == 0)
+			continue;
 
-		ret.push_back(*it);
+		if (idx != nullptr)
+			cache.scores[file] = score;
+
+		cache.items.insert(std::upper_bound(cache.items.begin(), cache.items.end(), file, order), file);
 	}
 
-	unsigned int currentSortId = sys->getSortId();
-	if (currentSortId > FileSorts::getSortTypes().size())
-		currentSortId = 0;
+	cache.childrenVersion = sChildrenVersion;
+	cache.metadataRevision = MetaDataList::getGlobalRevision();
+	cache.added.clear();
+	cache.removed.clear();
+	return true;
+}
+
+const std::vector<FileData*> FolderData::getChildrenListToDisplay() 
+{
+	auto sys = CollectionSystemManager::get()->getSystemToView(mSystem);
+
+	FileFilterIndex* idx = sys->getIndex(false);
+	if (idx != nullptr && !idx->isFiltered())
+		idx = nullptr;
 
-	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(currentSortId);
+	if (mDisplayCache == nullptr)
+		mDisplayCache = new FolderDisplayCache();
 
-	if (idx != nullptr && idx->hasRelevency())
+	FolderDisplayCache& cache = *mDisplayCache;
+
+	bool upToDate = cache.valid &&
+		cache.system == sys &&
+		cache.index == idx &&
+		cache.indexVersion == (idx != nullptr ? idx->getFiltersVersion() : 0) &&
+		cache.settingsVersion == Settings::getInstance()->getVersion() &&
+		cache.sortId == sys->getSortId() &&
+		cache.kiosk == UIModeController::getInstance()->isUIModeKiosk() &&
+		cache.kid == UIModeController::getInstance()->isUIModeKid();
+
+	if (!upToDate)
+		buildDisplayList(sys, idx);
+	else if (!cache.incremental)
 	{
-		auto compf = sort.comparisonFunction;
-
-		std::sort(ret.begin(), ret.end(), [scoringBoard, compf](const FileData* file1, const FileData* file2) -> bool
-		{ 
-			auto s1 = scoringBoard.find((FileData*) file1);
-			auto s2 = scoringBoard.find((FileData*) file2);		
-
-			if (s1 != scoringBoard.cend() && s2 != scoringBoard.cend() && s1->second != s2->second)
-				return s1->second < s2->second;
-			
-			return compf(file1, file2);
-		});
+		if (cache.childrenVersion != sChildrenVersion || cache.metadataRevision != MetaDataList::getGlobalRevision())
+			buildDisplayList(sys, idx);
 	}
-	else
+	else if (cache.added.size() > 0 || cache.removed.size() > 0 || cache.metadataRevision != MetaDataList::getGlobalRevision())
 	{
-		std::sort(ret.begin(), ret.end(), sort.comparisonFunction);
-
-		if (!sort.ascending)
-			std::reverse(ret.begin(), ret.end());
+		if (!updateDisplayList(sys, idx))
+			buildDisplayList(sys, idx);
 	}
 
-	return ret;
+	return cache.items;
 }
 
 std::shared_ptr<std::vector<FileData*>> FolderData::findChildrenListToDisplayAtCursor(FileData* toFind, std::stack<FileData*>& stack)
@@ -1172,6 +1398,35 @@ std::vector<FileData*> FolderData::getFilesRecursive(unsigned int typeMask, bool
 	return out;
 }
 
+// Root folders own the path index of their system, nested roots (collections in a bundle) keep their own
+static bool isPathIndexRoot(FileData* folder)
+{
+	return folder->getSystem() != nullptr && (FileData*) folder->getSystem()->getRootFolder() == folder;
+}
+
+SystemData* FolderData::getPathIndexOwner()
+{
+	for (FolderData* folder = this; folder != nullptr; folder = folder->getParent())
+		if (isPathIndexRoot(folder))
+			return folder->getSystem();
+
+	return nullptr;
+}
+
+void FolderData::updatePathIndex(SystemData* owner, FileData* file, bool add)
+{
+	if (add)
+		owner->addToPathIndex(file);
+	else
+		owner->removeFromPathIndex(file);
+
+	if (file->getType() != FOLDER || isPathIndexRoot(file))
+		return;
+
+	for (auto child : ((FolderData*)file)->mChildren)
+		updatePathIndex(owner, child, add);
+}
+
 void FolderData::addChild(FileData* file, bool assignParent)
 {
 #if DEBUG
@@ -1179,9 +1434,14 @@ void FolderData::addChild(FileData* file, bool assignParent)
 #endif
 
 	mChildren.push_back(file);
+	onChildChanged(file, true);
 
 	if (assignParent)
 		file->setParent(this);	
+
+	SystemData* owner = getPathIndexOwner();
+	if (owner != nullptr)
+		updatePathIndex(owner, file, true);
 }
 
 void FolderData::removeChild(FileData* file)
@@ -1195,8 +1455,13 @@ void FolderData::removeChild(FileData* file)
 	{
 		if (*it == file)
 		{
+			SystemData* owner = getPathIndexOwner();
+			if (owner != nullptr)
+				updatePathIndex(owner, file, false);
+
 			file->setParent(NULL);
 			mChildren.erase(it);
+			onChildChanged(file, false);
 			return;
 		}
 	}
@@ -1209,17 +1474,35 @@ void FolderData::removeChild(FileData* file)
 
 FileData* FolderData::FindByPath(const std::string& path)
 {
-	std::vector<FileData*> children = getChildren();
+	if (isPathIndexRoot(this))
+	{
+		FileData* item = getSystem()->getFileByPath(path);
+		if (item != nullptr)
+			return item;
 
-	for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it)
+		// Nested root folders are not part of our index
+		for (auto child : mChildren)
+		{
+			if (child->getType() != FOLDER || !isPathIndexRoot(child))
+				continue;
+
+			item = ((FolderData*)child)->FindByPath(path);
+			if (item != nullptr)
+				return item;
+		}
+
+		return nullptr;
+	}
+
+	for (auto child : mChildren)
 	{
-		if ((*it)->getPath() == path)
-			return (*it);
+		if (child->getPath() == path)
+			return child;
 
-		if ((*it)->getType() != FOLDER)
+		if (child->getType() != FOLDER)
 			continue;
 		
-		auto item = ((FolderData*)(*it))->FindByPath(path);
+		auto item = ((FolderData*)child)->FindByPath(path);
 		if (item != nullptr)
 			return item;
 	}
@@ -1418,7 +1701,7 @@ void FileData::checkCrc32(bool force)
 	if (system == nullptr)
 		return;
 
-	auto crc = ApiSystem::getInstance()->getCRC32(getPath(), system->shouldExtractHashesFromArchives());
+	auto crc = HashDatabase::getCrc32(getPath(), system->shouldExtractHashesFromArchives());
 	if (!crc.empty())
 	{
 		getMetadata().set(MetaDataId::Crc32, Utils::String::toUpper(crc));
@@ -1441,7 +1724,7 @@ void FileData::checkMd5(bool force)
 	if (system == nullptr)
 		return;
 
-	auto crc = ApiSystem::getInstance()->getMD5(getPath(), system->shouldExtractHashesFromArchives());
+	auto crc = HashDatabase::getMd5(getPath(), system->shouldExtractHashesFromArchives());
 	if (!crc.empty())
 	{
 		getMetadata().set(MetaDataId::Md5, Utils::String::toUpper(crc));
@@ -1465,7 +1748,12 @@ void FileData::checkCheevosHash(bool force)
 	if (system == nullptr)
 		return;
 
-	auto crc = RetroAchievements::getCheevosHash(system, getPath());
+	// The hash depends on the console of the system
+	auto crc = HashDatabase::get(getPath(), "cheevos:" + system->getName() + (system->shouldExtractHashesFromArchives() ? ":rom" : ""), [this, system]
+	{
+		return RetroAchievements::getCheevosHash(system, getPath());
+	});
+
 	getMetadata().set(MetaDataId::CheevosHash, Utils::String::toUpper(crc));
 	saveToGamelistRecovery(this);
 }
@@ -1593,7 +1881,7 @@ bool FileData::isExtensionCompatible()
 	return true;
 }
 
-FolderData::FolderData(const std::string& startpath, SystemData* system, bool ownsChildrens) : FileData(FOLDER, startpath, system)
+FolderData::FolderData(const std::string& startpath, SystemData* system, bool ownsChildrens) : FileData(FOLDER, startpath, system), mDisplayCache(nullptr)
 {
 	mIsDisplayableAsVirtualFolder = false;
 	mOwnsChildrens = ownsChildrens;
@@ -1602,10 +1890,20 @@ FolderData::FolderData(const std::string& startpath, SystemData* system, bool ow
 FolderData::~FolderData()
 {
 	clear();
+
+	delete mDisplayCache;
 }
 
 void FolderData::clear()
 {
+	SystemData* owner = getPathIndexOwner();
+
+	// Children attached to this folder are removed from the index by removeChild when deleted
+	if (owner != nullptr)
+		for (auto child : mChildren)
+			if (!mOwnsChildrens || child->getParent() != this)
+				updatePathIndex(owner, child, false);
+
 	if (mOwnsChildrens)
 	{
 		for (int i = mChildren.size() - 1; i >= 0; i--)
@@ -1613,6 +1911,7 @@ void FolderData::clear()
 	}
 
 	mChildren.clear();
+	invalidateDisplayList();
 }
 
 void FolderData::removeFromVirtualFolders(FileData* game)
@@ -1627,7 +1926,12 @@ void FolderData::removeFromVirtualFolders(FileData* game)
 
 		if ((*it) == game)
 		{
+			SystemData* owner = getPathIndexOwner();
+			if (owner != nullptr)
+				updatePathIndex(owner, game, false);
+
 			mChildren.erase(it);
+			onChildChanged(game, false);
 			return;
 		}
 	}
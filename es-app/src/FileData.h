@@ -54,6 +54,26 @@ struct LaunchGameOptions
 };
 
 class FolderData;
+class FileFilterIndex;
+struct FolderDisplayCache;
+
+class FileData;
+struct FileSortKey;
+
+typedef void FileSortKeyFunction(FileData* file, FileSortKey& key);
+
+// Sort key of a file for the last sort it was sorted with : see FileSorts::sort
+struct FileSortKey
+{
+	FileSortKey() : function(nullptr), revision(0), settingsVersion(0), number(0) { }
+
+	FileSortKeyFunction* function;
+	unsigned int		 revision;
+	unsigned int		 settingsVersion;
+
+	double		 number;
+	std::string	 text;
+};
 
 // A tree node that holds information for a file.
 class FileData : public IKeyboardMapContainer
@@ -154,10 +174,13 @@ public:
 
 	void setSelectedGame();
 
+	inline FileSortKey& getSortKey() { return mSortKey; }
+
 private:
 	std::string getKeyboardMappingFilePath();
 	std::string getMessageFromExitCode(int exitCode);
 	MetaDataList mMetadata;
+	FileSortKey mSortKey;
 
 protected:	
 	FolderData* mParent;
@@ -225,9 +248,20 @@ public:
 	void removeFromVirtualFolders(FileData* game);
 
 private:
+	SystemData* getPathIndexOwner();
+	static void updatePathIndex(SystemData* owner, FileData* file, bool add);
+
+	void invalidateDisplayList();
+	void onChildChanged(FileData* file, bool added);
+	int  getDisplayScore(FileData* file, FileFilterIndex* idx, FileData*& display);
+	void buildDisplayList(SystemData* sys, FileFilterIndex* idx);
+	bool updateDisplayList(SystemData* sys, FileFilterIndex* idx);
+
 	std::vector<FileData*> mChildren;
 	bool	mOwnsChildrens;
 	bool	mIsDisplayableAsVirtualFolder;
+
+	FolderDisplayCache* mDisplayCache;
 };
 
 #endif // ES_APP_FILE_DATA_H
@@ -0,0 +1,370 @@
+#include "FileFacetIndex.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// A posting list switches to a bitmap once its ids take more memory than the bitmap would
+#define DENSE_MIN_IDS 64
+
+static inline int popCount(uint64_t value)
+{
+#if defined(_MSC_VER)
+	return (int)__popcnt64(value);
+#else
+	return __builtin_popcountll(value);
+#endif
+}
+
+static inline void setBit(std::vector<uint64_t>& bits, int id)
+{
+	size_t word = (size_t)id >> 6;
+	if (word >= bits.size())
+		bits.resize(word + 1, 0);
+
+	bits[word] |= (uint64_t)1 << (id & 63);
+}
+
+static inline void resetBit(std::vector<uint64_t>& bits, int id)
+{
+	size_t word = (size_t)id >> 6;
+	if (word < bits.size())
+		bits[word] &= ~((uint64_t)1 << (id & 63));
+}
+
+static inline bool testBit(const std::vector<uint64_t>& bits, int id)
+{
+	size_t word = (size_t)id >> 6;
+	return word < bits.size() && (bits[word] & ((uint64_t)1 << (id & 63))) != 0;
+}
+
+FileFacetIndex::FileFacetIndex() : mFiltersVersion(0), mMaskValid(false)
+{
+}
+
+void FileFacetIndex::addToPosting(Posting& posting, int id)
+{
+	if (posting.dense)
+	{
+		setBit(posting.bits, id);
+		return;
+	}
+
+	posting.ids.push_back(id);
+
+	if (posting.ids.size() >= DENSE_MIN_IDS && posting.ids.size() * 32 >= mGames.size())
+	{
+		for (auto value : posting.ids)
+			setBit(posting.bits, value);
+
+		posting.ids.clear();
+		posting.ids.shrink_to_fit();
+		posting.dense = true;
+	}
+}
+
+void FileFacetIndex::removeFromPosting(Posting& posting, int id)
+{
+	if (posting.dense)
+	{
+		resetBit(posting.bits, id);
+		return;
+	}
+
+	auto it = std::find(posting.ids.begin(), posting.ids.end(), id);
+	if (it != posting.ids.end())
+	{
+		*it = posting.ids.back();
+		posting.ids.pop_back();
+	}
+}
+
+void FileFacetIndex::removeValues(Game& game, int id)
+{
+	for (auto& value : game.values)
+		removeFromPosting(mFacets[value.first].postings[value.second], id);
+
+	game.values.clear();
+}
+
+void FileFacetIndex::addGame(FileData* game, unsigned int revision, const FacetKeys& keys)
+{
+	int id;
+
+	auto it = mIds.find(game);
+	if (it != mIds.cend())
+	{
+		id = it->second;
+		removeValues(mGames[id], id);
+	}
+	else if (!mFreeIds.empty())
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+	else
+	{
+		id = (int)mGames.size();
+		mGames.push_back(Game());
+	}
+
+	mIds[game] = id;
+	setBit(mAlive, id);
+
+	Game& entry = mGames[id];
+	entry.game = game;
+	entry.revision = revision;
+
+	for (auto& key : keys)
+	{
+		if (key.first < 0)
+			continue;
+
+		if (key.first >= (int)mFacets.size())
+			mFacets.resize(key.first + 1);
+
+		Facet& facet = mFacets[key.first];
+
+		int valueId;
+
+		auto value = facet.ids.find(key.second);
+		if (value != facet.ids.cend())
+			valueId = value->second;
+		else
+		{
+			valueId = (int)facet.names.size();
+			facet.ids[key.second] = valueId;
+			facet.names.push_back(key.second);
+			facet.postings.push_back(Posting());
+		}
+
+		std::pair<int, int> facetValue(key.first, valueId);
+		if (std::find(entry.values.cbegin(), entry.values.cend(), facetValue) != entry.values.cend())
+			continue;
+
+		entry.values.push_back(facetValue);
+		addToPosting(facet.postings[valueId], id);
+	}
+
+	if (mMaskValid)
+		updateMask(id);
+}
+
+void FileFacetIndex::add(FileData* game, unsigned int revision, const FacetKeys& keys)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+	addGame(game, revision, keys);
+}
+
+void FileFacetIndex::remove(FileData* game)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto it = mIds.find(game);
+	if (it == mIds.cend())
+		return;
+
+	int id = it->second;
+	mIds.erase(it);
+
+	removeValues(mGames[id], id);
+	mGames[id] = Game();
+	mFreeIds.push_back(id);
+
+	resetBit(mAlive, id);
+	resetBit(mMask, id);
+}
+
+void FileFacetIndex::clear()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	mGames.clear();
+	mIds.clear();
+	mFreeIds.clear();
+	mAlive.clear();
+	mFacets.clear();
+	mMask.clear();
+	mMaskValid = false;
+}
+
+void FileFacetIndex::setFilters(unsigned int version, const Filters& filters)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	mFiltersVersion = version;
+	mFilters.clear();
+
+	for (auto& filter : filters)
+	{
+		Filter item;
+		item.facet = filter.first;
+
+		if (filter.second != nullptr)
+			item.values = *filter.second;
+
+		mFilters.push_back(item);
+	}
+
+	mMaskValid = false;
+}
+
+bool FileFacetIndex::matchesFilter(const Filter& filter, const Game& game) const
+{
+	for (auto& value : game.values)
+		if (value.first == filter.facet && filter.values.find(mFacets[value.first].names[value.second]) != filter.values.cend())
+			return true;
+
+	return false;
+}
+
+// Updates the bits of one game, so adding or changing a game doesn't evaluate the filters again
+void FileFacetIndex::updateMask(int id)
+{
+	const Game& game = mGames[id];
+
+	bool match = true;
+
+	for (auto& filter : mFilters)
+	{
+		if (matchesFilter(filter, game))
+			setBit(filter.mask, id);
+		else
+		{
+			resetBit(filter.mask, id);
+			match = false;
+		}
+	}
+
+	if (match)
+		setBit(mMask, id);
+	else
+		resetBit(mMask, id);
+}
+
+void FileFacetIndex::buildMask()
+{
+	size_t words = (mGames.size() + 63) / 64;
+
+	mMask = mAlive;
+	mMask.resize(words, 0);
+
+	for (auto& filter : mFilters)
+	{
+		filter.mask.assign(words, 0);
+
+		if (filter.facet >= 0 && filter.facet < (int)mFacets.size())
+		{
+			const Facet& facet = mFacets[filter.facet];
+
+			for (auto& value : filter.values)
+			{
+				auto it = facet.ids.find(value);
+				if (it == facet.ids.cend())
+					continue;
+
+				const Posting& posting = facet.postings[it->second];
+				if (posting.dense)
+				{
+					size_t count = std::min(words, posting.bits.size());
+					for (size_t i = 0; i < count; i++)
+						filter.mask[i] |= posting.bits[i];
+				}
+				else
+				{
+					for (auto id : posting.ids)
+						setBit(filter.mask, id);
+				}
+			}
+		}
+
+		for (size_t i = 0; i < words; i++)
+			mMask[i] &= filter.mask[i];
+	}
+
+	mMaskValid = true;
+}
+
+bool FileFacetIndex::matches(FileData* game, unsigned int revision, const std::function<FacetKeys()>& getKeys)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (!mMaskValid)
+		buildMask();
+
+	auto it = mIds.find(game);
+	if (it == mIds.cend())
+	{
+		FacetKeys keys = getKeys();
+
+		for (auto& filter : mFilters)
+		{
+			auto match = std::find_if(keys.cbegin(), keys.cend(), [&filter](const std::pair<int, std::string>& key) { return key.first == filter.facet && filter.values.find(key.second) != filter.values.cend(); });
+			if (match == keys.cend())
+				return false;
+		}
+
+		return true;
+	}
+
+	int id = it->second;
+	if (mGames[id].revision != revision)
+		addGame(game, revision, getKeys());
+
+	return testBit(mMask, id);
+}
+
+std::map<std::string, int> FileFacetIndex::getCounts(int facet)
+{
+	std::map<std::string, int> ret;
+
+	std::unique_lock<std::mutex> lock(mLock);
+
+	if (facet < 0 || facet >= (int)mFacets.size())
+		return ret;
+
+	if (!mMaskValid)
+		buildMask();
+
+	size_t words = (mGames.size() + 63) / 64;
+
+	Bitmap base = mAlive;
+	base.resize(words, 0);
+
+	for (auto& filter : mFilters)
+	{
+		if (filter.facet == facet)
+			continue;
+
+		for (size_t i = 0; i < words; i++)
+			base[i] &= i < filter.mask.size() ? filter.mask[i] : 0;
+	}
+
+	const Facet& data = mFacets[facet];
+
+	for (size_t valueId = 0; valueId < data.names.size(); valueId++)
+	{
+		const Posting& posting = data.postings[valueId];
+
+		int count = 0;
+
+		if (posting.dense)
+		{
+			size_t size = std::min(words, posting.bits.size());
+			for (size_t i = 0; i < size; i++)
+				count += popCount(base[i] & posting.bits[i]);
+		}
+		else
+		{
+			for (auto id : posting.ids)
+				if (testBit(base, id))
+					count++;
+		}
+
+		ret[data.names[valueId]] = count;
+	}
+
+	return ret;
+}
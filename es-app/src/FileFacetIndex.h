@@ -0,0 +1,102 @@
+#pragma once
+#ifndef ES_APP_FILE_FACET_INDEX_H
+#define ES_APP_FILE_FACET_INDEX_H
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <stdint.h>
+
+class FileData;
+
+// Facets (genre, players, year...) of the games of a FileFilterIndex. Games get dense ids, and each facet value
+// a posting list of the ids having it : a bitmap for common values, a list of ids for rare ones.
+// A filter combination is evaluated once into a bitmap of the matching games, which is then only tested per game.
+class FileFacetIndex
+{
+public:
+	typedef std::vector<std::pair<int, std::string>> FacetKeys; // Facet, value : the values a game is found with
+	typedef std::map<int, const std::unordered_set<std::string>*> Filters; // Facet -> selected values
+
+	FileFacetIndex();
+
+	void add(FileData* game, unsigned int revision, const FacetKeys& keys);
+	void remove(FileData* game);
+	void clear();
+
+	// Filters are copied, and kept until they are set with another version
+	unsigned int getFiltersVersion() const { return mFiltersVersion; }
+	void setFilters(unsigned int version, const Filters& filters);
+
+	// Games match when they have one of the selected values of every filtered facet.
+	// Games indexed with another revision are indexed again, the others are checked directly.
+	bool matches(FileData* game, unsigned int revision, const std::function<FacetKeys()>& getKeys);
+
+	// Number of games having each value of the facet, among the games matching the filters of the other facets
+	std::map<std::string, int> getCounts(int facet);
+
+private:
+	typedef std::vector<uint64_t> Bitmap;
+
+	struct Posting
+	{
+		Posting() : dense(false) { }
+
+		std::vector<int> ids;
+		Bitmap			 bits;
+		bool			 dense;
+	};
+
+	struct Facet
+	{
+		std::unordered_map<std::string, int> ids;
+		std::vector<std::string>			 names;
+		std::vector<Posting>				 postings;
+	};
+
+	struct Game
+	{
+		Game() : game(nullptr), revision(0) { }
+
+		FileData*						 game;
+		unsigned int					 revision;
+		std::vector<std::pair<int, int>> values; // Facet, value id
+	};
+
+	struct Filter
+	{
+		int								facet;
+		std::unordered_set<std::string> values;
+		Bitmap							mask; // Games having one of the values
+	};
+
+	void addGame(FileData* game, unsigned int revision, const FacetKeys& keys);
+	void removeValues(Game& game, int id);
+
+	void addToPosting(Posting& posting, int id);
+	void removeFromPosting(Posting& posting, int id);
+
+	bool matchesFilter(const Filter& filter, const Game& game) const;
+	void updateMask(int id);
+	void buildMask();
+
+	std::mutex					mLock;
+
+	std::vector<Game>			mGames;
+	std::unordered_map<FileData*, int> mIds;
+	std::vector<int>			mFreeIds;
+	Bitmap						mAlive;
+
+	std::vector<Facet>			mFacets;
+
+	unsigned int				mFiltersVersion;
+	std::vector<Filter>			mFilters;
+	Bitmap						mMask;
+	bool						mMaskValid;
+};
+
+#endif // ES_APP_FILE_FACET_INDEX_H
@@ -17,8 +17,10 @@
 #define UNKNOWN_LABEL "UNKNOWN"
 #define INCLUDE_UNKNOWN false;
 
+unsigned int FileFilterIndex::sFiltersVersion = 0;
+
 FileFilterIndex::FileFilterIndex()
-	: filterByFavorites(false), filterByGenre(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), filterByYear(false)
+	: filterByFavorites(false), filterByGenre(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), filterByYear(false), mFiltersVersion(0)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = 
@@ -84,6 +86,8 @@ void FileFilterIndex::copyFrom(FileFilterIndex* indexToImport)
 
 		*src->second.filteredByRef = *decl.second.filteredByRef;
 	}
+
+	onFiltersChanged();
 }
 
 void FileFilterIndex::importIndex(FileFilterIndex* indexToImport)
@@ -151,6 +155,9 @@ void FileFilterIndex::resetIndex()
 	clearIndex(cheevosIndexAllKeys);
 	clearIndex(verticalIndexAllKeys);
 
+	mSearchIndex.clear();
+	mFacetIndex.clear();
+
 	manageIndexEntry(&favoritesIndexAllKeys, "FALSE", false);
 	manageIndexEntry(&favoritesIndexAllKeys, "TRUE", false);
 
@@ -326,6 +333,11 @@ void FileFilterIndex::addToIndex(FileData* game)
 	manageYearEntryInIndex(game);
 	manageLangEntryInIndex(game);
 	manageRegionEntryInIndex(game);		
+
+	FileData* source = game->getSourceFileData();
+	mSearchIndex.add(source, source->getName());
+
+	mFacetIndex.add(game, game->getMetadata().getRevision(), getFacetKeys(game));
 }
 
 void FileFilterIndex::removeFromIndex(FileData* game)
@@ -337,6 +349,9 @@ void FileFilterIndex::removeFromIndex(FileData* game)
 	manageYearEntryInIndex(game, true);
 	manageLangEntryInIndex(game, true);
 	manageRegionEntryInIndex(game, true);	
+
+	mSearchIndex.remove(game->getSourceFileData());
+	mFacetIndex.remove(game);
 }
 
 void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>* values)
@@ -355,6 +370,7 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 	FilterDataDecl& filterData = it->second;
 	*(filterData.filteredByRef) = values != nullptr && values->size() > 0;
 	filterData.currentFilteredKeys->clear();
+	onFiltersChanged();
 
 	if (values == nullptr)
 		return;
@@ -389,7 +405,8 @@ void FileFilterIndex::clearAllFilters()
 		*(filterData.filteredByRef) = false;
 		filterData.currentFilteredKeys->clear();
 	}
-	return;
+
+	onFiltersChanged();
 }
 
 void FileFilterIndex::resetFilters()
@@ -413,96 +430,12 @@ void FileFilterIndex::setUIModeFilters()
 
 void FileFilterIndex::setTextFilter(const std::string text, bool useRelevancy) 
 { 
+	if (mTextFilter == text && mUseRelevency == useRelevancy)
+		return;
+
 	mTextFilter = text;
 	mUseRelevency = useRelevancy;
-}
-
-float jw_distance(std::string s1, std::string s2, bool caseSensitive = true) {
-	float m = 0;
-	int low, high, range;
-	int k = 0, numTrans = 0;
-
-	// Exit early if either are empty
-	if (s1.length() == 0 || s2.length() == 0) {
-		return 0;
-	}
-
-	// Convert to lower if case-sensitive is false
-	if (caseSensitive == false) {
-		transform(s1.begin(), s1.end(), s1.begin(), ::tolower);
-		transform(s2.begin(), s2.end(), s2.begin(), ::tolower);
-	}
-
-	// Exit early if they're an exact match.
-	if (s1 == s2) {
-		return 1;
-	}
-
-	range = (std::max(s1.length(), s2.length()) / 2) - 1;
-	int s1Matches[65000] = {};
-	int s2Matches[65000] = {};
-
-	for (int i = 0; i < s1.length(); i++) {
-
-		// Low Value;
-		if (i >= range) {
-			low = i - range;
-		}
-		else {
-			low = 0;
-		}
-
-		// High Value;
-		if (i + range <= (s2.length() - 1)) {
-			high = i + range;
-		}
-		else {
-			high = s2.length() - 1;
-		}
-
-		for (int j = low; j <= high; j++) {
-			if (s1Matches[i] != 1 && s2Matches[j] != 1 && s1[i] == s2[j]) {
-				m += 1;
-				s1Matches[i] = 1;
-				s2Matches[j] = 1;
-				break;
-			}
-		}
-	}
-
-	// Exit early if no matches were found
-	if (m == 0) {
-		return 0;
-	}
-
-	// Count the transpositions.
-	for (int i = 0; i < s1.length(); i++) {
-		if (s1Matches[i] == 1) {
-			int j;
-			for (j = k; j < s2.length(); j++) {
-				if (s2Matches[j] == 1) {
-					k = j + 1;
-					break;
-				}
-			}
-
-			if (s1[i] != s2[j]) {
-				numTrans += 1;
-			}
-		}
-	}
-
-	float weight = (m / s1.length() + m / s2.length() + (m - (numTrans / 2)) / m) / 3;
-	float l = 0;
-	float p = 0.1;
-	if (weight > 0.7) {
-		while (s1[l] == s2[l] && l < 4) {
-			l += 1;
-		}
-
-		weight += l * p * (1 - weight);
-	}
-	return weight;
+	onFiltersChanged();
 }
 
 int FileFilterIndex::showFile(FileData* game)
@@ -525,220 +458,99 @@ int FileFilterIndex::showFile(FileData* game)
 		return 0;
 	}
 
-	bool keepGoing = false;
-	
-	int textScore = 0;
+	int textScore = 1;
 
 	if (!mTextFilter.empty())
 	{
-		auto name = game->getSourceFileData()->getName();
+		FileData* source = game->getSourceFileData();
 
-		if (!mUseRelevency)
-		{
-			if (mTextFilter.find(',') == std::string::npos)
-			{
-				if (Utils::String::containsIgnoreCase(name, mTextFilter))
-				{
-					textScore = 1;
-					keepGoing = true;
-				}
-			}
-			else
-			{
-				for (auto token : Utils::String::split(mTextFilter, ',', true))
-				{
-					if (Utils::String::containsIgnoreCase(name, Utils::String::trim(token)))
-					{
-						textScore = 1;
-						keepGoing = true;
-						break;
-					}
-				}
-			}
-		}
-		else
+		textScore = mSearchIndex.getScore(source, source->getName(), mTextFilter, mUseRelevency);
+		if (textScore == 0)
+			return 0;
+	}
+
+	bool hasFilter = false;
+
+	for (auto& it : mFilterDecl)
+	{
+		if (*(it.second.filteredByRef))
 		{
-			if (Utils::String::compareIgnoreCase(name, mTextFilter) == 0)
-			{
-				keepGoing = true;
-				textScore = 1;
-			}
-			else if (Utils::String::startsWithIgnoreCase(name, mTextFilter))
-			{
-				keepGoing = true;
-				textScore = 2;
-			}
-			else if (mTextFilter.find(' ') == std::string::npos && Utils::String::containsIgnoreCase(name, mTextFilter))
-			{
-				keepGoing = true;
-				textScore = 3;
-			}
-			else if (mTextFilter.find(' ') != std::string::npos)
-			{
-				auto simplify = [](const std::string& text)
-				{
-					auto s = Utils::String::toLower(text);
-					s = Utils::String::replace(s, ":", "");
-					s = Utils::String::replace(s, ".", "");
-					s = Utils::String::replace(s, " - ", " ");
-					s = Utils::String::replace(s, "- ", " ");				
-
-					std::vector<std::string> ret;
-
-					for (auto v : Utils::String::split(s, ' '))
-					{
-						if (v.empty() || v.length() <= 2 || v == "and" || v == "not" || v == "for" || v == "the" || v == "les" || v == "des")
-							continue;
-
-						ret.push_back(v);
-					}
-
-					return ret;
-				};
-
-				auto filters = simplify(mTextFilter);
-				auto words = simplify(name);
-
-				int totalWords = 0;
-				int commonWords = 0;
-				
-				for (int i = 0; i < filters.size(); i++)
-				{
-					auto filter = filters[i];
-
-					for (auto word : words)
-					{
-						if (word == filter)
-						{
-							commonWords++;
-							break;
-						}
-					}
-
-					totalWords++;
-				}
-				
-				int continuousWords = 0;
-				int maxContinuousWords = 0;
-				int wordsAtStart = 0;
-				bool countStart = true;
-
-				for (int j = 0 ; j < words.size(); j++)
-				{
-					auto word = words[j];
-
-					for (int i = 0; i < filters.size(); i++)
-					{
-						auto filter = filters[i];
-
-						if (word == filter)
-						{
-							if (countStart && i == j)
-								wordsAtStart++;
-							else
-								countStart = false;
-
-							continuousWords++;
-
-							if (maxContinuousWords < continuousWords)
-								maxContinuousWords = continuousWords;
-
-							j++;
-
-							if (j < words.size())
-								word = words[j];
-							else
-								break;
-
-							continue;
-						}
-						else
-							countStart = false;
-
-						continuousWords = 0;
-					}					
-				}
-				
-				if (commonWords > 0)
-				{
-					if (commonWords > 1 || (commonWords > 0 && filters.size() == 1))
-					{
-						int sc = ((wordsAtStart * 2) + (maxContinuousWords * 3) + commonWords);
-						textScore = 1000 - sc;
-						keepGoing = true;
-					}
-					else
-					{
-						auto dist = jw_distance(mTextFilter, name, false);
-						if (dist > 0.66)
-						{
-							textScore = 1500 - (500 * dist);
-							keepGoing = true;
-						}
-					}
-				}
-			}
+			hasFilter = true;
+			break;
 		}
 	}
 
-	bool hasFilter = false;
+	if (hasFilter)
+	{
+		syncFacetFilters();
+
+		// Games need one of the selected keys of every filter type
+		if (!mFacetIndex.matches(game, game->getMetadata().getRevision(), [this, game] { return getFacetKeys(game); }))
+			return 0;
+	}
+	else if (mTextFilter.empty())
+		return 0;
+
+	return textScore;
+}
+
+// Keys a game is found with when filtering : primary & secondary keys, every genre, language or region
+FileFacetIndex::FacetKeys FileFilterIndex::getFacetKeys(FileData* game)
+{
+	FileFacetIndex::FacetKeys keys;
 
 	for (auto& it : mFilterDecl)
 	{
 		FilterDataDecl& filterData = it.second;
-		if (!(*(filterData.filteredByRef)))
-			continue;
-		
-		hasFilter = true;
 
 		if (filterData.type == GENRE_FILTER)
 		{
 			for (auto val : Genres::getGenreFiltersNames(&game->getMetadata()))
-			{
-				if (isKeyBeingFilteredBy(val, filterData.type))
-				{
-					keepGoing = true;
-					break;
-				}
-			}
+				keys.push_back(std::make_pair((int)filterData.type, val));
+
+			continue;
 		}
-		else
-		{
-			// try to find a match
-			std::string key = getIndexableKey(game, filterData.type, false);
-			if (filterData.type == LANG_FILTER || filterData.type == REGION_FILTER)
-			{
-				for (auto val : Utils::String::split(key, ','))
-					if (isKeyBeingFilteredBy(val, filterData.type))
-						keepGoing = true;
-			}
-			else
-				keepGoing = isKeyBeingFilteredBy(key, filterData.type);
 
-			// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
-			if (!keepGoing)
-			{
-				if (!filterData.hasSecondaryKey)
-					return 0;
+		std::string key = getIndexableKey(game, filterData.type, false);
 
-				std::string secKey = getIndexableKey(game, filterData.type, true);
-				if (secKey != UNKNOWN_LABEL)
-					keepGoing = isKeyBeingFilteredBy(secKey, filterData.type);
-			}
+		if (filterData.type == LANG_FILTER || filterData.type == REGION_FILTER)
+		{
+			for (auto val : Utils::String::split(key, ','))
+				keys.push_back(std::make_pair((int)filterData.type, val));
 		}
+		else
+			keys.push_back(std::make_pair((int)filterData.type, key));
 
-		// if still nothing, then it's not a match
-		if (!keepGoing)
-			return 0;		
+		// secondary keys - i.e. publisher and dev
+		if (filterData.hasSecondaryKey)
+		{
+			std::string secKey = getIndexableKey(game, filterData.type, true);
+			if (secKey != UNKNOWN_LABEL)
+				keys.push_back(std::make_pair((int)filterData.type, secKey));
+		}
 	}
 
-	if (keepGoing && !mTextFilter.empty())
-		return textScore;
-	
-	if (mTextFilter.empty() && !hasFilter)
-		return 0;
-	
-	return keepGoing ? 1 : 0;
+	return keys;
+}
+
+void FileFilterIndex::syncFacetFilters()
+{
+	if (mFacetIndex.getFiltersVersion() == mFiltersVersion)
+		return;
+
+	FileFacetIndex::Filters filters;
+
+	for (auto& it : mFilterDecl)
+		if (*(it.second.filteredByRef))
+			filters[(int)it.second.type] = it.second.currentFilteredKeys;
+
+	mFacetIndex.setFilters(mFiltersVersion, filters);
+}
+
+std::map<std::string, int> FileFilterIndex::getFacetCounts(FilterIndexType type)
+{
+	syncFacetFilters();
+	return mFacetIndex.getCounts((int)type);
 }
 
 bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
@@ -892,7 +704,7 @@ void FileFilterIndex::manageIndexEntry(std::map<std::string, int>* index, const
 		(index->at(key))++;
 }
 
-void FileFilterIndex::clearIndex(std::map<std::string, int> indexMap)
+void FileFilterIndex::clearIndex(std::map<std::string, int>& indexMap)
 {
 	indexMap.clear();
 }
@@ -926,6 +738,8 @@ bool CollectionFilter::createFromSystem(const std::string name, SystemData* syst
 		*(filterData.filteredByRef) = (filterData.currentFilteredKeys->size() > 0);
 	}
 
+	onFiltersChanged();
+
 	mName = name;
 	mPath = getCollectionsFolder() + "/" + mName + ".xcc";
 	
@@ -1010,6 +824,8 @@ bool CollectionFilter::load(const std::string file)
 		*(filterData.filteredByRef) = (filterData.currentFilteredKeys->size() > 0);
 	}
 
+	onFiltersChanged();
+
 	return true;
 }
 
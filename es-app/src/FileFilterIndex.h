@@ -6,6 +6,8 @@
 #include <vector>
 #include <unordered_set>
 #include <string>
+#include "FileFacetIndex.h"
+#include "FileSearchIndex.h"
 
 class FileData;
 class SystemData;
@@ -67,6 +69,9 @@ public:
 	bool isKeyBeingFilteredBy(std::string key, FilterIndexType type);
 	std::vector<FilterDataDecl> getFilterDataDecls();
 
+	// Number of games for each key of the filter type, taking the other filters into account
+	std::map<std::string, int> getFacetCounts(FilterIndexType type);
+
 	void importIndex(FileFilterIndex* indexToImport);
 	void copyFrom(FileFilterIndex* indexToImport);
 
@@ -78,6 +83,9 @@ public:
 	inline const std::string getTextFilter() { return mTextFilter; }
 	inline bool hasRelevency() { return !mTextFilter.empty() && mUseRelevency; }
 
+	// Changes with every filter change, and is never the same for two indexes
+	inline unsigned int getFiltersVersion() { return mFiltersVersion; }
+
 protected:
 	//std::vector<FilterDataDecl> filterDataDecl;
 	std::map<int, FilterDataDecl> mFilterDecl;
@@ -94,7 +102,11 @@ protected:
 	void manageLangEntryInIndex(FileData* game, bool remove = false);
 	void manageRegionEntryInIndex(FileData* game, bool remove = false);
 
-	void clearIndex(std::map<std::string, int> indexMap);
+	void clearIndex(std::map<std::string, int>& indexMap);
+
+	FileFacetIndex::FacetKeys getFacetKeys(FileData* game);
+	void syncFacetFilters();
+	inline void onFiltersChanged() { mFiltersVersion = ++sFiltersVersion; }
 
 	bool filterByGenre;
 	bool filterByFamily;
@@ -141,6 +153,12 @@ protected:
 
 	std::string mTextFilter;
 	bool		mUseRelevency;
+
+	FileSearchIndex mSearchIndex;
+	FileFacetIndex	mFacetIndex;
+	unsigned int	mFiltersVersion;
+
+	static unsigned int sFiltersVersion;
 };
 
 class CollectionFilter : public FileFilterIndex
@@ -0,0 +1,518 @@
+#include "FileSearchIndex.h"
+
+#include "utils/StringUtil.h"
+#include <algorithm>
+#include <string.h>
+
+// Indexes with a lot of removed entries are rebuilt
+#define COMPACT_MIN_REMOVED 1024
+
+// Latin letters without their accents, from U+00C0 to U+017F. 0 : kept as is, or expanded by foldAccent
+static const char sLatin1Letters[] =
+	"aaaaaa\0ceeeeiiii" "dnooooo\0ouuuuy\0\0"	// U+00C0
+	"aaaaaa\0ceeeeiiii" "dnooooo\0ouuuuy\0y";	// U+00E0
+
+static const char sLatinExtendedLetters[] =
+	"aaaaaaccccccccddddeeeeeeeeeegggggggghhhhiiiiiiiiiiiijjkkk"	// U+0100
+	"llllllllllnnnnnnnnnoooooooorrrrrrsssssssstttttt"			// U+0139
+	"uuuuuuuuuuuuwwyyyzzzzzzs";									// U+0168
+
+// Appends the letter without its accent, returns false if the character has to be kept as is
+static bool foldAccent(unsigned int unicode, std::string& text)
+{
+	switch (unicode)
+	{
+	case 0x00C6: case 0x00E6: text += "ae"; return true;
+	case 0x0152: case 0x0153: text += "oe"; return true;
+	case 0x00DF: text += "ss"; return true;
+	}
+
+	char letter = 0;
+
+	if (unicode >= 0x00C0 && unicode < 0x0100)
+		letter = sLatin1Letters[unicode - 0x00C0];
+	else if (unicode >= 0x0100 && unicode < 0x0180)
+		letter = sLatinExtendedLetters[unicode - 0x0100];
+
+	if (letter == 0)
+		return false;
+
+	text += letter;
+	return true;
+}
+
+static inline uint32_t getTrigram(const std::string& text, size_t pos)
+{
+	return ((uint32_t)(unsigned char)text[pos] << 16) | ((uint32_t)(unsigned char)text[pos + 1] << 8) | (uint32_t)(unsigned char)text[pos + 2];
+}
+
+// Jaro-Winkler similarity of two normalized strings. Match flags are kept on the stack for usual names.
+static float jaroWinkler(const std::string& s1, const std::string& s2)
+{
+	int l1 = (int)s1.length();
+	int l2 = (int)s2.length();
+
+	if (l1 == 0 || l2 == 0)
+		return 0;
+
+	if (s1 == s2)
+		return 1;
+
+	char buffer[512];
+	std::vector<char> heap;
+
+	char* flags = buffer;
+	if (l1 + l2 > (int)sizeof(buffer))
+	{
+		heap.resize(l1 + l2);
+		flags = heap.data();
+	}
+
+	memset(flags, 0, l1 + l2);
+
+	char* s1Matches = flags;
+	char* s2Matches = flags + l1;
+
+	int range = std::max(0, std::max(l1, l2) / 2 - 1);
+	float m = 0;
+
+	for (int i = 0; i < l1; i++)
+	{
+		int low = std::max(0, i - range);
+		int high = std::min(l2 - 1, i + range);
+
+		for (int j = low; j <= high; j++)
+		{
+			if (!s2Matches[j] && s1[i] == s2[j])
+			{
+				m += 1;
+				s1Matches[i] = 1;
+				s2Matches[j] = 1;
+				break;
+			}
+		}
+	}
+
+	if (m == 0)
+		return 0;
+
+	// Count the transpositions
+	int k = 0;
+	int numTrans = 0;
+
+	for (int i = 0; i < l1; i++)
+	{
+		if (!s1Matches[i])
+			continue;
+
+		int j;
+		for (j = k; j < l2; j++)
+		{
+			if (s2Matches[j])
+			{
+				k = j + 1;
+				break;
+			}
+		}
+
+		if (j < l2 && s1[i] != s2[j])
+			numTrans++;
+	}
+
+	float weight = (m / l1 + m / l2 + (m - (numTrans / 2)) / m) / 3;
+	if (weight > 0.7)
+	{
+		int l = 0;
+		while (l < 4 && l < l1 && l < l2 && s1[l] == s2[l])
+			l++;
+
+		weight += l * 0.1f * (1 - weight);
+	}
+
+	return weight;
+}
+
+FileSearchIndex::FileSearchIndex() : mRemovedCount(0), mGeneration(0), mReusable(false)
+{
+}
+
+std::string FileSearchIndex::normalize(const std::string& text)
+{
+	std::string lower = Utils::String::toLower(text);
+
+	std::string ret;
+	ret.reserve(lower.size());
+
+	size_t i = 0;
+	while (i < lower.size())
+	{
+		unsigned char c = lower[i];
+		if (c < 0x80)
+		{
+			ret += (char)c;
+			i++;
+			continue;
+		}
+
+		size_t pos = i;
+		if (!foldAccent(Utils::String::chars2Unicode(lower, i), ret))
+			ret.append(lower, pos, std::min(i, lower.size()) - pos);
+	}
+
+	return ret;
+}
+
+std::vector<std::string> FileSearchIndex::getWords(const std::string& text)
+{
+	auto s = Utils::String::replace(text, ":", "");
+	s = Utils::String::replace(s, ".", "");
+	s = Utils::String::replace(s, " - ", " ");
+	s = Utils::String::replace(s, "- ", " ");
+
+	std::vector<std::string> ret;
+
+	for (auto v : Utils::String::split(s, ' '))
+	{
+		if (v.empty() || v.length() <= 2 || v == "and" || v == "not" || v == "for" || v == "the" || v == "les" || v == "des")
+			continue;
+
+		ret.push_back(v);
+	}
+
+	return ret;
+}
+
+void FileSearchIndex::buildEntry(Entry& entry, const std::string& name)
+{
+	entry.source = name;
+	entry.name = normalize(name);
+	entry.words = getWords(entry.name);
+}
+
+void FileSearchIndex::prepareQuery(Query& query, const std::string& filter, bool relevancy)
+{
+	query.text = filter;
+	query.relevancy = relevancy;
+	query.hasSpace = filter.find(' ') != std::string::npos;
+	query.filter = normalize(filter);
+	query.tokens.clear();
+	query.words.clear();
+
+	if (relevancy)
+	{
+		query.tokens.push_back(query.filter);
+
+		if (query.hasSpace)
+			query.words = getWords(query.filter);
+	}
+	else if (query.filter.find(',') == std::string::npos)
+		query.tokens.push_back(query.filter);
+	else
+	{
+		for (auto token : Utils::String::split(query.filter, ',', true))
+			query.tokens.push_back(Utils::String::trim(token));
+	}
+}
+
+int FileSearchIndex::computeScore(const Entry& entry, const Query& query)
+{
+	const std::string& name = entry.name;
+
+	if (!query.relevancy)
+	{
+		for (auto& token : query.tokens)
+			if (name.find(token) != std::string::npos)
+				return 1;
+
+		return 0;
+	}
+
+	if (name == query.filter)
+		return 1;
+
+	if (Utils::String::startsWith(name, query.filter))
+		return 2;
+
+	if (!query.hasSpace)
+		return name.find(query.filter) != std::string::npos ? 3 : 0;
+
+	const std::vector<std::string>& filters = query.words;
+	const std::vector<std::string>& words = entry.words;
+
+	int commonWords = 0;
+
+	for (auto& filter : filters)
+	{
+		for (auto& word : words)
+		{
+			if (word == filter)
+			{
+				commonWords++;
+				break;
+			}
+		}
+	}
+
+	if (commonWords == 0)
+		return 0;
+
+	if (commonWords == 1 && filters.size() > 1)
+	{
+		float dist = jaroWinkler(query.filter, name);
+		if (dist > 0.66)
+			return (int)(1500 - (500 * dist));
+
+		return 0;
+	}
+
+	int continuousWords = 0;
+	int maxContinuousWords = 0;
+	int wordsAtStart = 0;
+	bool countStart = true;
+
+	for (int j = 0; j < (int)words.size(); j++)
+	{
+		const std::string* word = &words[j];
+
+		for (int i = 0; i < (int)filters.size(); i++)
+		{
+			if (*word == filters[i])
+			{
+				if (countStart && i == j)
+					wordsAtStart++;
+				else
+					countStart = false;
+
+				continuousWords++;
+
+				if (maxContinuousWords < continuousWords)
+					maxContinuousWords = continuousWords;
+
+				j++;
+
+				if (j < (int)words.size())
+					word = &words[j];
+				else
+					break;
+
+				continue;
+			}
+			else
+				countStart = false;
+
+			continuousWords = 0;
+		}
+	}
+
+	return 1000 - ((wordsAtStart * 2) + (maxContinuousWords * 3) + commonWords);
+}
+
+int FileSearchIndex::addEntry(FileData* game, const std::string& name)
+{
+	int id = (int)mEntries.size();
+
+	mEntries.push_back(Entry());
+
+	Entry& entry = mEntries.back();
+	entry.game = game;
+	buildEntry(entry, name);
+
+	mIds[game] = id;
+
+	for (size_t i = 0; i + 3 <= entry.name.size(); i++)
+	{
+		auto& ids = mTrigrams[getTrigram(entry.name, i)];
+		if (ids.empty() || ids.back() != id)
+			ids.push_back(id);
+	}
+
+	for (auto& word : entry.words)
+	{
+		auto& ids = mWords[word];
+		if (ids.empty() || ids.back() != id)
+			ids.push_back(id);
+	}
+
+	// Keep the results of the current query complete
+	if (mQuery.valid)
+		setScore(id);
+
+	return id;
+}
+
+void FileSearchIndex::setScore(int id)
+{
+	Entry& entry = mEntries[id];
+
+	entry.score = computeScore(entry, mQuery);
+	entry.generation = mGeneration;
+
+	if (entry.score != 0)
+		mMatches.push_back(id);
+}
+
+void FileSearchIndex::removeEntry(int id)
+{
+	Entry& entry = mEntries[id];
+	if (entry.game == nullptr)
+		return;
+
+	mIds.erase(entry.game);
+
+	// Trigrams & matches still reference the entry until the index is compacted
+	entry = Entry();
+	mRemovedCount++;
+
+	if (mRemovedCount >= COMPACT_MIN_REMOVED && mRemovedCount * 2 > mEntries.size())
+		compact();
+}
+
+void FileSearchIndex::compact()
+{
+	std::vector<Entry> entries;
+	entries.swap(mEntries);
+
+	mIds.clear();
+	mTrigrams.clear();
+	mWords.clear();
+	mMatches.clear();
+	mQuery.valid = false;
+	mReusable = false;
+	mRemovedCount = 0;
+
+	for (auto& entry : entries)
+		if (entry.game != nullptr)
+			addEntry(entry.game, entry.source);
+}
+
+void FileSearchIndex::add(FileData* game, const std::string& name)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto it = mIds.find(game);
+	if (it != mIds.cend())
+		removeEntry(it->second);
+
+	addEntry(game, name);
+}
+
+void FileSearchIndex::remove(FileData* game)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto it = mIds.find(game);
+	if (it != mIds.cend())
+		removeEntry(it->second);
+}
+
+void FileSearchIndex::clear()
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	mEntries.clear();
+	mIds.clear();
+	mTrigrams.clear();
+	mWords.clear();
+	mMatches.clear();
+	mQuery = Query();
+	mReusable = false;
+	mRemovedCount = 0;
+}
+
+void FileSearchIndex::addCandidates(const std::string& token, std::vector<int>& candidates)
+{
+	if (token.size() < 3)
+	{
+		for (int id = 0; id < (int)mEntries.size(); id++)
+			if (mEntries[id].game != nullptr)
+				candidates.push_back(id);
+
+		return;
+	}
+
+	// Only the names having the rarest trigram of the token have to be checked
+	const std::vector<int>* rarest = nullptr;
+
+	for (size_t i = 0; i + 3 <= token.size(); i++)
+	{
+		auto it = mTrigrams.find(getTrigram(token, i));
+		if (it == mTrigrams.cend())
+			return;
+
+		if (rarest == nullptr || it->second.size() < rarest->size())
+			rarest = &it->second;
+	}
+
+	candidates.insert(candidates.end(), rarest->cbegin(), rarest->cend());
+}
+
+void FileSearchIndex::setQuery(const std::string& filter, bool relevancy)
+{
+	if (mQuery.valid && mQuery.relevancy == relevancy && mQuery.text == filter)
+		return;
+
+	Query query;
+	prepareQuery(query, filter, relevancy);
+
+	std::vector<int> candidates;
+
+	if (!isSubstringQuery(query))
+	{
+		// Names starting with the filter contain it, the others need a word in common
+		addCandidates(query.filter, candidates);
+
+		for (auto& word : query.words)
+		{
+			auto it = mWords.find(word);
+			if (it != mWords.cend())
+				candidates.insert(candidates.end(), it->second.cbegin(), it->second.cend());
+		}
+	}
+	else if (mQuery.valid && mReusable && query.tokens.size() == 1 && !mQuery.tokens[0].empty() && query.tokens[0].find(mQuery.tokens[0]) != std::string::npos)
+	{
+		// The text was extended : only the names which contained the previous text can match
+		candidates.swap(mMatches);
+	}
+	else
+	{
+		for (auto& token : query.tokens)
+			addCandidates(token, candidates);
+	}
+
+	mQuery = query;
+	mQuery.valid = true;
+	mReusable = isSubstringQuery(query) && query.tokens.size() == 1;
+	mGeneration++;
+	mMatches.clear();
+
+	// Entries which are not candidates keep the score of an older generation, which means 0
+	for (auto id : candidates)
+		if (mEntries[id].game != nullptr && mEntries[id].generation != mGeneration)
+			setScore(id);
+}
+
+int FileSearchIndex::getScore(FileData* game, const std::string& name, const std::string& filter, bool relevancy)
+{
+	std::unique_lock<std::mutex> lock(mLock);
+
+	auto it = mIds.find(game);
+	if (it != mIds.cend() && mEntries[it->second].source != name)
+	{
+		// Renamed since it was indexed (scraped, edited...)
+		removeEntry(it->second);
+		addEntry(game, name);
+		it = mIds.find(game);
+	}
+
+	setQuery(filter, relevancy);
+
+	if (it == mIds.cend())
+	{
+		Entry entry;
+		buildEntry(entry, name);
+		return computeScore(entry, mQuery);
+	}
+
+	const Entry& entry = mEntries[it->second];
+	return entry.generation == mGeneration ? entry.score : 0;
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef ES_APP_FILE_SEARCH_INDEX_H
+#define ES_APP_FILE_SEARCH_INDEX_H
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <stdint.h>
+
+class FileData;
+
+// Text search structure of a FileFilterIndex : game names are normalized once when they are indexed,
+// a trigram index gives the few names which can contain the searched text, and a word index the names relevancy can match.
+// The results of a query are kept, so typing one more character only checks the previous matches.
+class FileSearchIndex
+{
+public:
+	FileSearchIndex();
+
+	void add(FileData* game, const std::string& name);
+	void remove(FileData* game);
+	void clear();
+
+	// Same scores as FileFilterIndex::showFile : 0 when the name doesn't match the filter.
+	// Games which are not indexed, or were renamed since, are scored directly.
+	int getScore(FileData* game, const std::string& name, const std::string& filter, bool relevancy);
+
+	// Lower case, accents removed
+	static std::string normalize(const std::string& text);
+
+private:
+	struct Entry
+	{
+		Entry() : game(nullptr), score(0), generation(0) { }
+
+		FileData*				 game;
+		std::string				 source; // Name the entry was built from
+		std::string				 name;   // Normalized name
+		std::vector<std::string> words;  // Significant words of the name, for relevancy
+
+		int						 score;		 // Score for the query of the same generation, 0 for older queries
+		unsigned int			 generation;
+	};
+
+	struct Query
+	{
+		Query() : relevancy(false), hasSpace(false), valid(false) { }
+
+		std::string				 text;
+		bool					 relevancy;
+		bool					 hasSpace;
+		bool					 valid;
+
+		std::string				 filter; // Normalized filter
+		std::vector<std::string> tokens; // Texts searched in the names (comma separated filters)
+		std::vector<std::string> words;  // Significant words of the filter, for relevancy
+	};
+
+	static void buildEntry(Entry& entry, const std::string& name);
+	static void prepareQuery(Query& query, const std::string& filter, bool relevancy);
+	static int computeScore(const Entry& entry, const Query& query);
+	static std::vector<std::string> getWords(const std::string& text);
+
+	int  addEntry(FileData* game, const std::string& name);
+	void removeEntry(int id);
+	void compact();
+
+	void setQuery(const std::string& filter, bool relevancy);
+	bool isSubstringQuery(const Query& query) const { return !query.relevancy || !query.hasSpace; }
+	void addCandidates(const std::string& token, std::vector<int>& candidates);
+	void setScore(int id);
+
+	std::mutex							 mLock;
+
+	std::vector<Entry>					 mEntries;
+	std::unordered_map<FileData*, int>	 mIds;
+	std::unordered_map<uint32_t, std::vector<int>> mTrigrams;
+	std::unordered_map<std::string, std::vector<int>> mWords;
+	size_t								 mRemovedCount;
+
+	Query								 mQuery;
+	unsigned int						 mGeneration;
+	std::vector<int>					 mMatches;  // Ids of the entries matching mQuery
+	bool								 mReusable; // mMatches holds every entry containing mQuery.tokens[0]
+};
+
+#endif // ES_APP_FILE_SEARCH_INDEX_H
@@ -2,7 +2,13 @@
 #include "FileSorts.h"
 
 #include "utils/StringUtil.h"
+#include "utils/TaskScheduler.h"
 #include "LocaleES.h"
+#include <algorithm>
+#include <stdint.h>
+
+// Below, the keys are computed and sorted on one thread
+#define SORT_PARALLEL_MIN 8192
 
 namespace FileSorts
 {
@@ -40,35 +46,41 @@ namespace FileSorts
 
 	Singleton::Singleton()
 	{
-		mSortTypes.push_back(SortType(FILENAME_ASCENDING, &compareName, true, _("FILENAME, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(FILENAME_DESCENDING, &compareName, false, _("FILENAME, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(RATING_ASCENDING, &compareRating, true, _("RATING, ASCENDING"), _U("\uF165 ")));
-		mSortTypes.push_back(SortType(RATING_DESCENDING, &compareRating, false, _("RATING, DESCENDING"), _U("\uF164 ")));
-		mSortTypes.push_back(SortType(TIMESPLAYED_ASCENDING, &compareTimesPlayed, true, _("TIMES PLAYED, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(TIMESPLAYED_DESCENDING, &compareTimesPlayed, false, _("TIMES PLAYED, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(LASTPLAYED_ASCENDING, &compareLastPlayed, true, _("LAST PLAYED, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(LASTPLAYED_DESCENDING, &compareLastPlayed, false, _("LAST PLAYED, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(NUMBERPLAYERS_ASCENDING, &compareNumPlayers, true, _("NUMBER PLAYERS, ASCENDING"), _U("\uF162 ")));
-		mSortTypes.push_back(SortType(NUMBERPLAYERS_DESCENDING, &compareNumPlayers, false, _("NUMBER PLAYERS, DESCENDING"), _U("\uF163 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_ASCENDING, &compareReleaseDate, true, _("RELEASE DATE, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_DESCENDING, &compareReleaseDate, false, _("RELEASE DATE, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(GENRE_ASCENDING, &compareGenre, true, _("GENRE, ASCENDING"), _U("\uF15d ")));		
-		mSortTypes.push_back(SortType(GENRE_DESCENDING, &compareGenre, false, _("GENRE, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(DEVELOPER_ASCENDING, &compareDeveloper, true, _("DEVELOPER, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(DEVELOPER_DESCENDING, &compareDeveloper, false, _("DEVELOPER, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(PUBLISHER_ASCENDING, &comparePublisher, true, _("PUBLISHER, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(PUBLISHER_DESCENDING, &comparePublisher, false, _("PUBLISHER, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(SYSTEM_ASCENDING, &compareSystem, true, _("SYSTEM, ASCENDING"), _U("\uF15d ")));
-		mSortTypes.push_back(SortType(SYSTEM_DESCENDING, &compareSystem, false, _("SYSTEM, DESCENDING"), _U("\uF15e ")));
-		mSortTypes.push_back(SortType(FILECREATION_DATE_ASCENDING, &compareFileCreationDate, true, _("FILE CREATION DATE, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(FILECREATION_DATE_DESCENDING, &compareFileCreationDate, false, _("FILE CREATION DATE, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(GAMETIME_ASCENDING, &compareGameTime, true, _("GAME TIME, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(GAMETIME_DESCENDING, &compareGameTime, false, _("GAME TIME, DESCENDING"), _U("\uF161 ")));
-
-		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_ASCENDING, &compareSystemReleaseYear, true, _("SYSTEM, RELEASE YEAR, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_DESCENDING, &compareSystemReleaseYear, false, _("SYSTEM, RELEASE YEAR, DESCENDING"), _U("\uF161 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_ASCENDING, &compareReleaseYearSystem, true, _("RELEASE YEAR, SYSTEM, ASCENDING"), _U("\uF160 ")));
-		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_DESCENDING, &compareReleaseYearSystem, false, _("RELEASE YEAR, SYSTEM, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(FILENAME_ASCENDING, &compareName, &getNameKey, true, _("FILENAME, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(FILENAME_DESCENDING, &compareName, &getNameKey, false, _("FILENAME, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(RATING_ASCENDING, &compareRating, &getRatingKey, true, _("RATING, ASCENDING"), _U("\uF165 ")));
+		mSortTypes.push_back(SortType(RATING_DESCENDING, &compareRating, &getRatingKey, false, _("RATING, DESCENDING"), _U("\uF164 ")));
+		mSortTypes.push_back(SortType(TIMESPLAYED_ASCENDING, &compareTimesPlayed, &getTimesPlayedKey, true, _("TIMES PLAYED, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(TIMESPLAYED_DESCENDING, &compareTimesPlayed, &getTimesPlayedKey, false, _("TIMES PLAYED, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(LASTPLAYED_ASCENDING, &compareLastPlayed, &getLastPlayedKey, true, _("LAST PLAYED, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(LASTPLAYED_DESCENDING, &compareLastPlayed, &getLastPlayedKey, false, _("LAST PLAYED, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(NUMBERPLAYERS_ASCENDING, &compareNumPlayers, &getNumPlayersKey, true, _("NUMBER PLAYERS, ASCENDING"), _U("\uF162 ")));
+		mSortTypes.push_back(SortType(NUMBERPLAYERS_DESCENDING, &compareNumPlayers, &getNumPlayersKey, false, _("NUMBER PLAYERS, DESCENDING"), _U("\uF163 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_ASCENDING, &compareReleaseDate, &getReleaseDateKey, true, _("RELEASE DATE, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_DESCENDING, &compareReleaseDate, &getReleaseDateKey, false, _("RELEASE DATE, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(GENRE_ASCENDING, &compareGenre, &getGenreKey, true, _("GENRE, ASCENDING"), _U("\uF15d ")));		
+		mSortTypes.push_back(SortType(GENRE_DESCENDING, &compareGenre, &getGenreKey, false, _("GENRE, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(DEVELOPER_ASCENDING, &compareDeveloper, &getDeveloperKey, true, _("DEVELOPER, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(DEVELOPER_DESCENDING, &compareDeveloper, &getDeveloperKey, false, _("DEVELOPER, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(PUBLISHER_ASCENDING, &comparePublisher, &getPublisherKey, true, _("PUBLISHER, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(PUBLISHER_DESCENDING, &comparePublisher, &getPublisherKey, false, _("PUBLISHER, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(SYSTEM_ASCENDING, &compareSystem, &getSystemKey, true, _("SYSTEM, ASCENDING"), _U("\uF15d ")));
+		mSortTypes.push_back(SortType(SYSTEM_DESCENDING, &compareSystem, &getSystemKey, false, _("SYSTEM, DESCENDING"), _U("\uF15e ")));
+		mSortTypes.push_back(SortType(FILECREATION_DATE_ASCENDING, &compareFileCreationDate, &getFileCreationDateKey, true, _("FILE CREATION DATE, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(FILECREATION_DATE_DESCENDING, &compareFileCreationDate, &getFileCreationDateKey, false, _("FILE CREATION DATE, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(GAMETIME_ASCENDING, &compareGameTime, &getGameTimeKey, true, _("GAME TIME, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(GAMETIME_DESCENDING, &compareGameTime, &getGameTimeKey, false, _("GAME TIME, DESCENDING"), _U("\uF161 ")));
+
+		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_ASCENDING, &compareSystemReleaseYear, &getSystemReleaseYearKey, true, _("SYSTEM, RELEASE YEAR, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(SYSTEM_RELEASEDATE_DESCENDING, &compareSystemReleaseYear, &getSystemReleaseYearKey, false, _("SYSTEM, RELEASE YEAR, DESCENDING"), _U("\uF161 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_ASCENDING, &compareReleaseYearSystem, &getReleaseYearSystemKey, true, _("RELEASE YEAR, SYSTEM, ASCENDING"), _U("\uF160 ")));
+		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_DESCENDING, &compareReleaseYearSystem, &getReleaseYearSystemKey, false, _("RELEASE YEAR, SYSTEM, DESCENDING"), _U("\uF161 ")));
+	}
+
+	static const std::vector<std::string>& getLeadingArticles()
+	{
+		static auto articles = Utils::String::commaStringToVector(_("A,AN,THE"));
+		return articles;
 	}
 
 	//returns if file1 should come before file2
@@ -84,7 +96,7 @@ namespace FileSorts
 
 		if (Settings::IgnoreLeadingArticles())
 		{
-			static auto articles = Utils::String::commaStringToVector(_("A,AN,THE"));
+			auto& articles = getLeadingArticles();
 			name1 = stripLeadingArticle(name1, articles);
 			name2 = stripLeadingArticle(name2, articles);
 		}
@@ -225,4 +237,235 @@ namespace FileSorts
 		std::string system2 = ((FileData*)file2)->getSourceFileData()->getSystemName();
 		return Utils::String::compareIgnoreCase(system1, system2) < 0;		
 	}
+	void getNameKey(FileData* file, FileSortKey& key)
+	{
+		// Folders first
+		key.number = file->getType() == FOLDER ? 0 : 1;
+
+		std::string name = file->getName();
+		if (Settings::IgnoreLeadingArticles())
+			name = stripLeadingArticle(name, getLeadingArticles());
+
+		key.text = Utils::String::toCollationKey(name);
+	}
+
+	void getRatingKey(FileData* file, FileSortKey& key)
+	{
+		key.number = file->getMetadata().getFloat(MetaDataId::Rating);
+	}
+
+	void getTimesPlayedKey(FileData* file, FileSortKey& key)
+	{
+		if (file->getMetadata().getType() == GAME_METADATA)
+			key.number = file->getMetadata().getInt(MetaDataId::PlayCount);
+	}
+
+	void getGameTimeKey(FileData* file, FileSortKey& key)
+	{
+		if (file->getMetadata().getType() == GAME_METADATA)
+			key.number = file->getMetadata().getInt(MetaDataId::GameTime);
+	}
+
+	void getLastPlayedKey(FileData* file, FileSortKey& key)
+	{
+		key.text = file->getMetadata().get(MetaDataId::LastPlayed);
+	}
+
+	void getNumPlayersKey(FileData* file, FileSortKey& key)
+	{
+		key.number = file->getMetadata().getInt(MetaDataId::Players);
+	}
+
+	// Parts of composite keys are separated with a 0, which is lower than any character
+	static void appendKeyPart(std::string& key, const std::string& part)
+	{
+		key += '\0';
+		key += part;
+	}
+
+	void getSystemReleaseYearKey(FileData* file, FileSortKey& key)
+	{
+		key.text = Utils::String::toCollationKey(file->getSourceFileData()->getSystemName());
+		appendKeyPart(key.text, file->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4));
+		appendKeyPart(key.text, Utils::String::toCollationKey(file->getName()));
+	}
+
+	void getReleaseYearSystemKey(FileData* file, FileSortKey& key)
+	{
+		key.text = file->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
+		appendKeyPart(key.text, Utils::String::toCollationKey(file->getSourceFileData()->getSystemName()));
+		appendKeyPart(key.text, Utils::String::toCollationKey(file->getName()));
+	}
+
+	void getReleaseDateKey(FileData* file, FileSortKey& key)
+	{
+		key.text = file->getMetadata().get(MetaDataId::ReleaseDate);
+	}
+
+	void getFileCreationDateKey(FileData* file, FileSortKey& key)
+	{
+		key.text = Utils::FileSystem::getFileCreationDate(file->getPath()).getIsoString();
+	}
+
+	void getGenreKey(FileData* file, FileSortKey& key)
+	{
+		key.text = Utils::String::toCollationKey(file->getMetadata().get(MetaDataId::Genre));
+	}
+
+	void getDeveloperKey(FileData* file, FileSortKey& key)
+	{
+		key.text = Utils::String::toCollationKey(file->getMetadata().get(MetaDataId::Developer));
+	}
+
+	void getPublisherKey(FileData* file, FileSortKey& key)
+	{
+		key.text = Utils::String::toCollationKey(file->getMetadata().get(MetaDataId::Publisher));
+	}
+
+	void getSystemKey(FileData* file, FileSortKey& key)
+	{
+		key.text = Utils::String::toCollationKey(file->getSourceFileData()->getSystemName());
+	}
+
+	// Names depend on settings too (ShowFilenames, IgnoreLeadingArticles...)
+	static const FileSortKey& getSortKey(FileData* file, FileSortKeyFunction* function, unsigned int settingsVersion)
+	{
+		FileSortKey& key = file->getSortKey();
+
+		unsigned int revision = file->getMetadata().getRevision();
+		if (key.function == function && key.revision == revision && key.settingsVersion == settingsVersion)
+			return key;
+
+		key.number = 0;
+		key.text.clear();
+		function(file, key);
+
+		key.function = function;
+		key.revision = revision;
+		key.settingsVersion = settingsVersion;
+		return key;
+	}
+
+	struct SortEntry
+	{
+		int					score;
+		double				number;
+		uint64_t			prefix; // First bytes of the text, most significant first
+		size_t				length;
+		const std::string*	text;
+		FileData*			file;
+	};
+
+	static inline uint64_t getKeyPrefix(const std::string& text)
+	{
+		uint64_t prefix = 0;
+
+		for (size_t i = 0; i < 8; i++)
+			prefix = (prefix << 8) | (i < text.size() ? (unsigned char)text[i] : 0);
+
+		return prefix;
+	}
+
+	static inline bool compareEntries(const SortEntry& e1, const SortEntry& e2)
+	{
+		if (e1.score != e2.score)
+			return e1.score < e2.score;
+
+		if (e1.number != e2.number)
+			return e1.number < e2.number;
+
+		if (e1.prefix != e2.prefix)
+			return e1.prefix < e2.prefix;
+
+		// Same prefix : short texts only differ by trailing zeros
+		if (e1.length <= 8 && e2.length <= 8)
+			return e1.length < e2.length;
+
+		return e1.text->compare(*e2.text) < 0;
+	}
+
+	void sort(std::vector<FileData*>& files, const SortType& sortType, const std::unordered_map<FileData*, int>* scores)
+	{
+		size_t count = files.size();
+		if (count < 2)
+			return;
+
+		std::vector<SortEntry> entries(count);
+
+		unsigned int settingsVersion = Settings::getInstance()->getVersion();
+
+		auto sortRange = [&files, &entries, &sortType, scores, settingsVersion](size_t from, size_t to)
+		{
+			for (size_t i = from; i < to; i++)
+			{
+				const FileSortKey& key = getSortKey(files[i], sortType.keyFunction, settingsVersion);
+
+				SortEntry& entry = entries[i];
+				entry.score = 0;
+				entry.number = key.number;
+				entry.prefix = getKeyPrefix(key.text);
+				entry.length = key.text.size();
+				entry.text = &key.text;
+				entry.file = files[i];
+
+				if (scores != nullptr)
+				{
+					auto it = scores->find(files[i]);
+					if (it != scores->cend())
+						entry.score = it->second;
+				}
+			}
+
+			std::sort(entries.begin() + from, entries.begin() + to, compareEntries);
+		};
+
+		size_t chunks = 1;
+		if (count >= SORT_PARALLEL_MIN)
+			chunks = std::min<size_t>(Utils::TaskScheduler::getInstance().getThreadCount() + 1, 8);
+
+		if (chunks <= 1)
+			sortRange(0, count);
+		else
+		{
+			// Each chunk is sorted on its own thread, then sorted chunks are merged by pairs
+			size_t chunkSize = (count + chunks - 1) / chunks;
+
+			Utils::TaskGroup sorts(Utils::TASK_UI);
+			for (size_t from = 0; from < count; from += chunkSize)
+				sorts.run([&sortRange, from, chunkSize, count] { sortRange(from, std::min(count, from + chunkSize)); });
+			sorts.wait();
+
+			for (size_t width = chunkSize; width < count; width *= 2)
+			{
+				Utils::TaskGroup merges(Utils::TASK_UI);
+				for (size_t from = 0; from + width < count; from += 2 * width)
+				{
+					merges.run([&entries, from, width, count]
+					{
+						std::inplace_merge(entries.begin() + from, entries.begin() + from + width, entries.begin() + std::min(count, from + 2 * width), compareEntries);
+					});
+				}
+				merges.wait();
+			}
+		}
+
+		for (size_t i = 0; i < count; i++)
+			files[i] = entries[i].file;
+
+		if (scores == nullptr && !sortType.ascending)
+			std::reverse(files.begin(), files.end());
+	}
+
+	bool compareKeys(const SortType& sortType, FileData* file1, FileData* file2)
+	{
+		unsigned int settingsVersion = Settings::getInstance()->getVersion();
+
+		const FileSortKey& key1 = getSortKey(file1, sortType.keyFunction, settingsVersion);
+		const FileSortKey& key2 = getSortKey(file2, sortType.keyFunction, settingsVersion);
+
+		if (key1.number != key2.number)
+			return key1.number < key2.number;
+
+		return key1.text < key2.text;
+	}
 };
@@ -3,6 +3,7 @@
 #define ES_APP_FILE_SORTS_H
 
 #include "FileData.h"
+#include <unordered_map>
 #include <vector>
 
 namespace FileSorts
@@ -46,12 +47,13 @@ namespace FileSorts
 	{
 		int id;
 		ComparisonFunction* comparisonFunction;
+		FileSortKeyFunction* keyFunction;
 		bool ascending;
 		std::string description;
 		std::string icon;
 
-		SortType(int sortId, ComparisonFunction* sortFunction, bool sortAscending, const std::string & sortDescription, const std::string & iconId = "")
-			: id(sortId), comparisonFunction(sortFunction), ascending(sortAscending), description(sortDescription), icon(iconId) {}
+		SortType(int sortId, ComparisonFunction* sortFunction, FileSortKeyFunction* sortKeyFunction, bool sortAscending, const std::string & sortDescription, const std::string & iconId = "")
+			: id(sortId), comparisonFunction(sortFunction), keyFunction(sortKeyFunction), ascending(sortAscending), description(sortDescription), icon(iconId) {}
 	};
 
 	class Singleton
@@ -83,5 +85,29 @@ namespace FileSorts
 	bool compareReleaseYearSystem(const FileData* file1, const FileData* file2);
 
 	std::string stripLeadingArticle(const std::string &string, const std::vector<std::string> &articles);
+
+	// Sort keys : same order as the comparison functions, but computed once per file & metadata revision
+	void getNameKey(FileData* file, FileSortKey& key);
+	void getRatingKey(FileData* file, FileSortKey& key);
+	void getTimesPlayedKey(FileData* file, FileSortKey& key);
+	void getLastPlayedKey(FileData* file, FileSortKey& key);
+	void getNumPlayersKey(FileData* file, FileSortKey& key);
+	void getReleaseDateKey(FileData* file, FileSortKey& key);
+	void getGenreKey(FileData* file, FileSortKey& key);
+	void getDeveloperKey(FileData* file, FileSortKey& key);
+	void getPublisherKey(FileData* file, FileSortKey& key);
+	void getSystemKey(FileData* file, FileSortKey& key);
+	void getFileCreationDateKey(FileData* file, FileSortKey& key);
+	void getGameTimeKey(FileData* file, FileSortKey& key);
+
+	void getSystemReleaseYearKey(FileData* file, FileSortKey& key);
+	void getReleaseYearSystemKey(FileData* file, FileSortKey& key);
+
+	// Sorts the files by their keys, on several threads for large lists. 
+	// With scores, files are sorted by score first, and never reversed.
+	void sort(std::vector<FileData*>& files, const SortType& sortType, const std::unordered_map<FileData*, int>* scores = nullptr);
+
+	// Whether file1 is before file2 in an ascending sort
+	bool compareKeys(const SortType& sortType, FileData* file1, FileData* file2);
 };
 #endif // ES_APP_FILE_SORTS_H
@@ -10,25 +10,132 @@
 #include <pugixml/src/pugixml.hpp>
 #include "Genres.h"
 #include "Paths.h"
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+#include <stdio.h>
+#include <string.h>
 
 #ifdef WIN32
 #include <Windows.h>
 #include <direct.h>
+#include <io.h>
 #else
 #include <unistd.h>
 #endif
 
+// Journal records are single lines appended after this header, the closing tag is added when it's read
+#define GAMELIST_JOURNAL_HEADER "<gameList parentHash=\""
+
+static std::mutex sJournalLock;
+
 std::string getGamelistRecoveryPath(SystemData* system)
 {
 	return Utils::FileSystem::getGenericPath(Paths::getUserEmulationStationPath() + "/recovery/" + system->getName());
 }
 
+std::string getGamelistJournalPath(SystemData* system)
+{
+	return getGamelistRecoveryPath(system) + ".journal";
+}
+
+static FILE* openGamelistFile(const std::string& path, const char* mode)
+{
+#if WIN32
+	return _wfopen(Utils::String::convertToWideString(path).c_str(), Utils::String::convertToWideString(mode).c_str());
+#else
+	return fopen(path.c_str(), mode);
+#endif
+}
+
+// GamelistFsync : "none", "gamelist" (only when the gamelist is written) or "always" (journal appends too)
+static bool shouldSyncGamelistFile(bool journal)
+{
+	std::string policy = Settings::getInstance()->getString("GamelistFsync");
+	if (policy == "always")
+		return true;
+
+	return !journal && policy != "none";
+}
+
+static bool syncGamelistFile(FILE* file)
+{
+	if (fflush(file) != 0)
+		return false;
+
+#if WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Writes a temporary file which replaces the gamelist once complete : a crash can't leave a truncated gamelist
+static bool saveGamelistDocument(const pugi::xml_document& doc, const std::string& path)
+{
+	std::stringstream stream;
+	doc.save(stream);
+	std::string xml = stream.str();
+
+	std::string tmpPath = path + ".tmp";
+
+	FILE* file = openGamelistFile(tmpPath, "wb");
+	if (file == nullptr)
+		return false;
+
+	bool written = fwrite(xml.data(), 1, xml.size(), file) == xml.size();
+	if (written && shouldSyncGamelistFile(false))
+		written = syncGamelistFile(file);
+
+	fclose(file);
+
+#if WIN32
+	if (written)
+		written = MoveFileExW(Utils::String::convertToWideString(tmpPath).c_str(), Utils::String::convertToWideString(path).c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	if (written)
+		written = rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+
+	if (!written)
+		Utils::FileSystem::removeFile(tmpPath);
+
+	return written;
+}
+
+// Returns the complete records of the journal as a gameList document, or an empty string if there are none.
+// checkSize is the size of the gamelist the journal must have been started from, SIZE_MAX to accept any.
+static std::string readGamelistJournal(SystemData* system, size_t checkSize)
+{
+	std::string content = Utils::FileSystem::readAllText(getGamelistJournalPath(system));
+
+	// A record interrupted by a crash has no line ending : drop it
+	size_t end = content.rfind('\n');
+	if (end == std::string::npos)
+		return "";
+
+	content.resize(end + 1);
+
+	if (content.compare(0, strlen(GAMELIST_JOURNAL_HEADER), GAMELIST_JOURNAL_HEADER) != 0)
+		return "";
+
+	if (checkSize != SIZE_MAX && strtoull(content.c_str() + strlen(GAMELIST_JOURNAL_HEADER), nullptr, 10) != checkSize)
+		return "";
+
+	return content + "</gameList>";
+}
+
 FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType type, std::unordered_map<std::string, FileData*>& fileMap)
 {
 	auto pGame = fileMap.find(path);
 	if (pGame != fileMap.end())
 		return pGame->second;
 
+	FileData* file = system->getFileByPath(path);
+	if (file != nullptr)
+		return file;
+
 	// first, verify that path is within the system's root folder
 	FolderData* root = system->getRootFolder();
 	bool contains = false;
@@ -47,7 +154,7 @@ FileData* findOrCreateFile(SystemData* system, const std::string& path, FileType
 	while(path_it != pathList.end())
 	{
 		std::string key = Utils::FileSystem::combine(treeNode->getPath(), *path_it);
-		FileData* item = (fileMap.find(key) != fileMap.end()) ? fileMap[key] : nullptr;
+		FileData* item = system->getFileByPath(key);
 		if (item != nullptr)
 		{
 			if (item->getType() == FOLDER)
@@ -112,7 +219,8 @@ std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* s
 
 	bool trustGamelist = Settings::getInstance()->getBool("ParseGamelistOnly");
 
-	LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
+	if (fromFile)
+		LOG(LogInfo) << "Parsing XML file \"" << xmlpath << "\"...";
 
 	pugi::xml_document doc;
 	pugi::xml_parse_result result = fromFile ? doc.load_file(xmlpath.c_str()) : doc.load_string(xmlpath.c_str());
@@ -154,6 +262,20 @@ std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* s
 			continue;
 
 		const std::string path = Utils::FileSystem::resolveRelativePath(fileNode.child("path").text().get(), relativeTo, false);
+
+		// Journal record of a deleted game : it may have been created by the gamelist or an earlier record
+		if (fileNode.attribute("removed").as_bool())
+		{
+			FileData* removed = system->getFileByPath(path);
+			if (removed != nullptr && removed->getType() == GAME)
+			{
+				fileMap.erase(path);
+				ret.erase(std::remove(ret.begin(), ret.end(), removed), ret.end());
+				delete removed;
+			}
+
+			continue;
+		}
 				
 		if (!trustGamelist && !Utils::FileSystem::exists(path))
 		{
@@ -202,20 +324,43 @@ void clearTemporaryGamelistRecovery(SystemData* system)
 
 void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
 {
+	StopWatch stopWatch("parseGamelist - " + system->getName() + " :", LogDebug);
+
 	std::string xmlpath = system->getGamelistPath(false);
 
 	auto size = Utils::FileSystem::getFileSize(xmlpath);
 	if (size != 0)
 		loadGamelistFile(xmlpath, system, fileMap, SIZE_MAX, true);
 
+	// Recovery files written by previous versions, one per changed file
 	auto files = Utils::FileSystem::getDirContent(getGamelistRecoveryPath(system), true);
 	for (auto file : files)
 		loadGamelistFile(file, system, fileMap, size, true);
 
+	// Changes saved since the gamelist was written : they are already persisted, so the files are not dirty
+	std::string journal = readGamelistJournal(system, size);
+	if (!journal.empty())
+		loadGamelistFile(journal, system, fileMap, SIZE_MAX, false);
+	else if (Utils::FileSystem::exists(getGamelistJournalPath(system)))
+	{
+		LOG(LogWarning) << "Gamelist journal of " << system->getName() << " doesn't match its gamelist, ignoring";
+		Utils::FileSystem::removeFile(getGamelistJournalPath(system));
+	}
+
 	if (size != SIZE_MAX)
 		system->setGamelistHash(size);	
 }
 
+static std::string getFileDataNodePath(FileData* file, SystemData* system)
+{
+	// try and make the path relative if we can so things still work if we change the rom folder location in the future
+	std::string path = Utils::FileSystem::createRelativePath(file->getPath(), system->getStartPath(), false);
+	if (path.empty() && file->getType() == FOLDER)
+		path = ".";
+
+	return path;
+}
+
 bool addFileDataNode(pugi::xml_node& parent, FileData* file, const char* tag, SystemData* system, bool fullPaths = false)
 {
 	//create game and add to parent node
@@ -236,16 +381,9 @@ bool addFileDataNode(pugi::xml_node& parent, FileData* file, const char* tag, Sy
 
 	if (fullPaths)
 		newNode.prepend_child("path").text().set(file->getPath().c_str());
-	else
-	{
-		// there's something useful in there so we'll keep the node, add the path
-		// try and make the path relative if we can so things still work if we change the rom folder location in the future
-		std::string path = Utils::FileSystem::createRelativePath(file->getPath(), system->getStartPath(), false).c_str();
-		if (path.empty() && file->getType() == FOLDER)
-			path = ".";
+	else // there's something useful in there so we'll keep the node, add the path
+		newNode.prepend_child("path").text().set(getFileDataNodePath(file, system).c_str());
 
-		newNode.prepend_child("path").text().set(path.c_str());
-	}
 	return true;	
 }
 
@@ -281,6 +419,59 @@ bool saveToXml(FileData* file, const std::string& fileName, bool fullPaths)
 	return false;
 }
 
+static bool appendToGamelistJournal(SystemData* system, FileData* file, bool removed = false)
+{
+	const char* tag = file->getType() == GAME ? "game" : "folder";
+
+	pugi::xml_document doc;
+	if (removed || !addFileDataNode(doc, file, tag, system))
+	{
+		// Only the default name is left : the record still replaces the previous one
+		pugi::xml_node node = doc.append_child(tag);
+		node.append_child("path").text().set(getFileDataNodePath(file, system).c_str());
+
+		if (removed)
+			node.append_attribute("removed").set_value("true");
+	}
+
+	std::stringstream record;
+	doc.first_child().print(record, "", pugi::format_raw);
+	record << "\n";
+
+	std::string data = record.str();
+	std::string path = getGamelistJournalPath(system);
+
+	std::unique_lock<std::mutex> lock(sJournalLock);
+
+	bool newJournal = Utils::FileSystem::getFileSize(path) == 0;
+	if (newJournal)
+	{
+		Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+		// The journal only applies to the gamelist it was started from
+		std::string gamelistPath = system->getGamelistPath(false);
+		data = GAMELIST_JOURNAL_HEADER + std::to_string(Utils::FileSystem::getFileSize(gamelistPath)) + "\">\n" + data;
+	}
+
+	FILE* journal = openGamelistFile(path, newJournal ? "wb" : "ab");
+	if (journal == nullptr)
+	{
+		LOG(LogError) << "Error opening gamelist journal \"" << path << "\"";
+		return false;
+	}
+
+	bool written = fwrite(data.data(), 1, data.size(), journal) == data.size();
+	if (written && shouldSyncGamelistFile(true))
+		written = syncGamelistFile(journal);
+
+	fclose(journal);
+
+	if (!written)
+		LOG(LogError) << "Error writing gamelist journal \"" << path << "\"";
+
+	return written;
+}
+
 bool saveToGamelistRecovery(FileData* file)
 {
 	if (!Settings::getInstance()->getBool("SaveGamelistsOnExit"))
@@ -290,14 +481,12 @@ bool saveToGamelistRecovery(FileData* file)
 	if (!Settings::HiddenSystemsShowGames() && !system->isVisible())
 		return false;
 
-	std::string fp = file->getFullPath();
-	fp = Utils::FileSystem::createRelativePath(file->getFullPath(), system->getRootFolder()->getFullPath(), true);
-	fp = Utils::FileSystem::getParent(fp) + "/" + Utils::FileSystem::getStem(fp) + ".xml";
-
-	std::string path = Utils::FileSystem::getAbsolutePath(fp, getGamelistRecoveryPath(system));
-	path = Utils::FileSystem::getCanonicalPath(path);
+	if (!appendToGamelistJournal(system, file))
+		return false;
 
-	return saveToXml(file, path);
+	// The change is persisted : only the journal records have to be merged in the gamelist
+	file->getMetadata().resetChangedFlag();
+	return true;
 }
 
 bool removeFromGamelistRecovery(FileData* file)
@@ -306,6 +495,10 @@ bool removeFromGamelistRecovery(FileData* file)
 	if (system == nullptr)
 		return false;
 
+	// The deleted game must not come back from the journal, nor stay in the gamelist once it's merged
+	if (file->getType() == GAME && system->isGameSystem() && !system->isCollection())
+		appendToGamelistJournal(system, file->getSourceFileData(), true);
+
 	std::string fp = file->getFullPath();
 	fp = Utils::FileSystem::createRelativePath(file->getFullPath(), system->getRootFolder()->getFullPath(), true);
 	fp = Utils::FileSystem::getParent(fp) + "/" + Utils::FileSystem::getStem(fp) + ".xml";
@@ -324,6 +517,10 @@ bool hasDirtyFile(SystemData* system)
 	if (system == nullptr || !system->isGameSystem() || (!Settings::HiddenSystemsShowGames() && !system->isVisible())) // || system->hasPlatformId(PlatformIds::IMAGEVIEWER))
 		return false;
 
+	// Journal records are merged in the gamelist on exit
+	if (Utils::FileSystem::exists(getGamelistJournalPath(system)))
+		return true;
+
 	FolderData* rootFolder = system->getRootFolder();
 	if (rootFolder == nullptr)
 		return false;
@@ -355,15 +552,49 @@ void updateGamelist(SystemData* system)
 		return;
 	}
 
+	std::unique_lock<std::mutex> lock(sJournalLock);
+
 	std::vector<FileData*> dirtyFiles;
+	std::unordered_set<FileData*> knownFiles;
 	
 	auto files = rootFolder->getFilesRecursive(GAME | FOLDER, false, nullptr, false);
 	for (auto file : files)
-		if (file->getSystem() == system && file->getMetadata().wasChanged())
+		if (file->getSystem() == system && file->getMetadata().wasChanged() && knownFiles.insert(file).second)
 			dirtyFiles.push_back(file);
 
-	if (dirtyFiles.size() == 0)
+	// Files saved in the journal : their metadata is already loaded, only their nodes have to be replaced
+	std::unordered_set<std::string> removedPaths;
+
+	std::string journal = readGamelistJournal(system, SIZE_MAX);
+	if (!journal.empty())
+	{
+		pugi::xml_document journalDoc;
+		if (journalDoc.load_string(journal.c_str()))
+		{
+			for (pugi::xml_node fileNode : journalDoc.child("gameList").children())
+			{
+				std::string path = Utils::FileSystem::resolveRelativePath(fileNode.child("path").text().get(), system->getStartPath(), false);
+
+				FileData* file = system->getFileByPath(path);
+
+				// Deleted games : their nodes are removed, unless the game was added again afterwards
+				if (fileNode.attribute("removed").as_bool())
+				{
+					if (file == nullptr)
+						removedPaths.insert(path);
+
+					continue;
+				}
+
+				if (file != nullptr && file->getSystem() == system && knownFiles.insert(file).second)
+					dirtyFiles.push_back(file);
+			}
+		}
+	}
+
+	if (dirtyFiles.size() == 0 && removedPaths.size() == 0)
 	{
+		Utils::FileSystem::removeFile(getGamelistJournalPath(system));
 		clearTemporaryGamelistRecovery(system);
 		return;
 	}
@@ -391,30 +622,40 @@ void updateGamelist(SystemData* system)
 	else //set up an empty gamelist to append to		
 		root = doc.append_child("gameList");
 
-	std::map<std::string, pugi::xml_node> xmlMap;
+	// Paths are resolved the same way parseGamelist does, so they match the FileData paths without canonicalizing every node
+	std::unordered_map<std::string, pugi::xml_node> xmlMap;
 
 	for (pugi::xml_node fileNode : root.children())
 	{
 		pugi::xml_node path = fileNode.child("path");
 		if (path)
+			xmlMap[Utils::FileSystem::resolveRelativePath(path.text().get(), system->getStartPath(), false)] = fileNode;
+	}
+	
+	for (auto path : removedPaths)
+	{
+		auto xmf = xmlMap.find(path);
+		if (xmf != xmlMap.cend())
 		{
-			std::string nodePath = Utils::FileSystem::getCanonicalPath(Utils::FileSystem::resolveRelativePath(path.text().get(), system->getStartPath(), true));
-			xmlMap[nodePath] = fileNode;
+			root.remove_child(xmf->second);
+			xmlMap.erase(xmf);
+			++numUpdated;
 		}
 	}
-	
-	// iterate through all files, checking if they're already in the XML
+
+	// iterate through the changed files, checking if they're already in the XML
 	for(auto file : dirtyFiles)
 	{
 		bool removed = false;
 
 		// check if the file already exists in the XML
 		// if it does, remove it before adding
-		auto xmf = xmlMap.find(Utils::FileSystem::getCanonicalPath(file->getPath()));
+		auto xmf = xmlMap.find(file->getPath());
 		if (xmf != xmlMap.cend())
 		{
 			removed = true;
 			root.remove_child(xmf->second);
+			xmlMap.erase(xmf);
 		}
 		
 		const char* tag = (file->getType() == GAME) ? "game" : "folder";
@@ -435,13 +676,20 @@ void updateGamelist(SystemData* system)
 
 		LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
 
-		if (!doc.save_file(xmlWritePath.c_str()))
+		if (!saveGamelistDocument(doc, xmlWritePath))
+		{
 			LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
-		else
-			clearTemporaryGamelistRecovery(system);
+			return;
+		}
+
+		system->setGamelistHash(Utils::FileSystem::getFileSize(xmlWritePath));
 	}
-	else
-		clearTemporaryGamelistRecovery(system);
+
+	for (auto file : dirtyFiles)
+		file->getMetadata().resetChangedFlag();
+
+	Utils::FileSystem::removeFile(getGamelistJournalPath(system));
+	clearTemporaryGamelistRecovery(system);
 }
 
 
@@ -457,6 +705,9 @@ void cleanupGamelist(SystemData* system)
 		return;
 	}
 
+	// Merge pending changes first : the journal doesn't apply to the rewritten gamelist
+	updateGamelist(system);
+
 	std::string xmlReadPath = system->getGamelistPath(false);
 	if (!Utils::FileSystem::exists(xmlReadPath))
 		return;
@@ -655,7 +906,7 @@ void cleanupGamelist(SystemData* system)
 		Utils::FileSystem::removeFile(oldXml);
 		Utils::FileSystem::copyFile(xmlWritePath, oldXml);
 
-		if (!doc.save_file(xmlWritePath.c_str()))
+		if (!saveGamelistDocument(doc, xmlWritePath))
 			LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
 		else
 			clearTemporaryGamelistRecovery(system);
@@ -12,10 +12,11 @@ class FileData;
 // Loads gamelist.xml data into a SystemData.
 void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
 
-// Writes currently loaded metadata for a SystemData to gamelist.xml.
+// Merges the changed files and the journal records of a SystemData in gamelist.xml.
 void updateGamelist(SystemData* system);
 void cleanupGamelist(SystemData* system);
 
+// Appends the metadata of a file to the journal of its system, replayed by parseGamelist until updateGamelist merges it.
 bool saveToGamelistRecovery(FileData* file);
 bool removeFromGamelistRecovery(FileData* file);
 
@@ -23,6 +24,9 @@ bool saveToXml(FileData* file, const std::string& fileName, bool fullPaths = fal
 
 bool hasDirtyFile(SystemData* system);
 
+std::string getGamelistRecoveryPath(SystemData* system);
+std::string getGamelistJournalPath(SystemData* system);
+
 std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX, bool fromFile = true);
 
 #endif // ES_APP_GAME_LIST_H
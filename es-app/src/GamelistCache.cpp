@@ -0,0 +1,416 @@
+#include "GamelistCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "EmulationStation.h"
+#include "FileData.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "MetaData.h"
+#include "Paths.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <stdint.h>
+#include <stdio.h>
+
+#define GAMELISTCACHE_MAGIC		0x43475345 // "ESGC"
+#define GAMELISTCACHE_VERSION	1
+#define GAMELISTCACHE_NOPARENT	0xFFFFFFFF
+
+class CacheWriter
+{
+public:
+	template<typename T> void write(T value) { mBuffer.append((const char*)&value, sizeof(T)); }
+
+	void writeString(const std::string& value)
+	{
+		write<uint32_t>((uint32_t)value.size());
+		mBuffer.append(value);
+	}
+
+	template<typename T> void patch(size_t offset, T value) { memcpy(&mBuffer[offset], &value, sizeof(T)); }
+
+	size_t offset() { return mBuffer.size(); }
+	const std::string& buffer() { return mBuffer; }
+
+private:
+	std::string mBuffer;
+};
+
+class CacheReader
+{
+public:
+	CacheReader(const char* data, size_t size) : mPos(data), mEnd(data + size), mValid(true) { }
+
+	template<typename T> T read()
+	{
+		T value = T();
+
+		if (!mValid || mPos + sizeof(T) > mEnd)
+		{
+			mValid = false;
+			return value;
+		}
+
+		memcpy(&value, mPos, sizeof(T));
+		mPos += sizeof(T);
+		return value;
+	}
+
+	std::string readString()
+	{
+		uint32_t size = read<uint32_t>();
+		if (!mValid || mPos + size > mEnd)
+		{
+			mValid = false;
+			return "";
+		}
+
+		std::string value(mPos, size);
+		mPos += size;
+		return value;
+	}
+
+	bool isValid() { return mValid; }
+
+private:
+	const char* mPos;
+	const char* mEnd;
+	bool		mValid;
+};
+
+void GamelistCache::writeMetadata(CacheWriter& writer, const MetaDataList& mdl)
+{
+	writer.write<uint8_t>(mdl.mRelativeTo != nullptr ? 1 : 0);
+	writer.writeString(mdl.mName);
+
+	uint16_t valueCount = 0;
+	for (int i = 0; i < MetaDataList::SLOT_COUNT; i++)
+		if (mdl.hasValue((MetaDataId)i))
+			valueCount++;
+
+	writer.write<uint16_t>(valueCount);
+	for (int i = 0; i < MetaDataList::SLOT_COUNT; i++)
+	{
+		if (!mdl.hasValue((MetaDataId)i))
+			continue;
+
+		writer.write<uint8_t>((uint8_t)i);
+		writer.writeString(mdl.getValue((MetaDataId)i));
+	}
+
+	writer.write<uint8_t>((uint8_t)mdl.mScrapeDates.size());
+	for (auto& item : mdl.mScrapeDates)
+	{
+		writer.write<uint8_t>((uint8_t)item.first);
+		writer.write<int64_t>((int64_t)item.second.getTime());
+	}
+
+	writer.write<uint16_t>((uint16_t)mdl.mUnKnownElements.size());
+	for (auto& item : mdl.mUnKnownElements)
+	{
+		writer.writeString(std::get<0>(item));
+		writer.writeString(std::get<1>(item));
+		writer.write<uint8_t>(std::get<2>(item) ? 1 : 0);
+	}
+}
+
+bool GamelistCache::readMetadata(CacheReader& reader, MetaDataList& mdl, SystemData* system)
+{
+
+	mdl.mRelativeTo = reader.read<uint8_t>() ? system : nullptr;
+	mdl.mName = reader.readString();
+
+	mdl.clearValues();
+
+	uint16_t count = reader.read<uint16_t>();
+	for (uint16_t i = 0; i < count && reader.isValid(); i++)
+	{
+		uint8_t id = reader.read<uint8_t>();
+		if (id >= MetaDataList::SLOT_COUNT)
+			return false;
+
+		mdl.setValue((MetaDataId)id, reader.readString());
+	}
+
+	mdl.mScrapeDates.clear();
+
+	uint8_t scrapeCount = reader.read<uint8_t>();
+	for (uint8_t i = 0; i < scrapeCount && reader.isValid(); i++)
+	{
+		int scraperId = reader.read<uint8_t>();
+		mdl.mScrapeDates[scraperId] = Utils::Time::DateTime((time_t)reader.read<int64_t>());
+	}
+
+	mdl.mUnKnownElements.clear();
+
+	count = reader.read<uint16_t>();
+	for (uint16_t i = 0; i < count && reader.isValid(); i++)
+	{
+		std::string name = reader.readString();
+		std::string value = reader.readString();
+		bool isElement = reader.read<uint8_t>() != 0;
+
+		mdl.mUnKnownElements.push_back(std::tuple<std::string, std::string, bool>(name, value, isElement));
+	}
+
+	mdl.mWasChanged = false;
+	return reader.isValid();
+}
+
+void GamelistCache::writeFolder(CacheWriter& writer, FolderData* folder, uint32_t folderIndex, uint32_t& count)
+{
+	for (auto child : folder->getChildren())
+	{
+		if (child->getType() == FOLDER && ((FolderData*)child)->isVirtualStorage())
+			continue;
+
+		uint32_t index = count++;
+
+		writer.write<uint8_t>((uint8_t)child->getType());
+		writer.write<uint32_t>(folderIndex);
+		writer.writeString(child->getPath());
+		writeMetadata(writer, child->getMetadata());
+
+		if (child->getType() == FOLDER)
+			writeFolder(writer, (FolderData*)child, index, count);
+	}
+}
+
+static std::string getFileKey(const std::string& path)
+{
+	if (!Utils::FileSystem::exists(path))
+		return "";
+
+	return std::to_string(Utils::FileSystem::getFileSize(path)) + "|" + std::to_string((int64_t)Utils::FileSystem::getFileModificationDate(path).getTime());
+}
+
+// The journal holds changes which are not in the gamelist yet
+static std::string getGamelistKey(SystemData* system, const std::string& xmlPath)
+{
+	return getFileKey(xmlPath) + "|" + getFileKey(getGamelistJournalPath(system));
+}
+
+bool GamelistCache::isEnabled()
+{
+	return Settings::getInstance()->getBool("GamelistCache") && !Settings::IgnoreGamelist();
+}
+
+std::string GamelistCache::getCachePath(SystemData* system)
+{
+	return Utils::FileSystem::getGenericPath(Paths::getUserEmulationStationPath() + "/cache/gamelists/" + system->getName() + ".cache");
+}
+
+// Everything which changes the result of populateFolder/parseGamelist without touching the rom folders or the gamelist
+std::string GamelistCache::getCacheKey(SystemData* system)
+{
+	std::string key = PROGRAM_VERSION_STRING " - " PROGRAM_BUILT_STRING;
+	key += "|" + system->getStartPath();
+
+	for (auto ext : system->getExtensions())
+		key += "|" + ext;
+
+	key += "|" + std::to_string(MetaDataList::getMDD().size());
+	key += "|" + Settings::getInstance()->getString(system->getName() + ".ShowHiddenFiles");
+	key += Settings::ShowHiddenFiles() ? "|1" : "|0";
+	key += Settings::ParseGamelistOnly() ? "|1" : "|0";
+	key += Settings::PreloadMedias() ? "|1" : "|0";
+	key += Settings::RemoveMultiDiskContent() ? "|1" : "|0";
+
+	return key;
+}
+
+bool GamelistCache::load(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	if (!isEnabled() || (system->isHidden() && !Settings::HiddenSystemsShowGames()))
+		return false;
+
+	std::string path = getCachePath(system);
+	if (!Utils::FileSystem::exists(path))
+		return false;
+
+	// Pending changes are only stored in the recovery folder : parse gamelists to apply them
+	if (Utils::FileSystem::getDirContent(getGamelistRecoveryPath(system), true).size() > 0)
+		return false;
+
+	StopWatch stopWatch("GamelistCache::load - " + system->getName() + " :", LogDebug);
+
+	Utils::FileSystem::MappedFile file(path);
+	if (!file.isValid())
+		return false;
+
+	CacheReader reader(file.data(), file.size());
+
+	if (reader.read<uint32_t>() != GAMELISTCACHE_MAGIC || reader.read<uint32_t>() != GAMELISTCACHE_VERSION)
+		return false;
+
+	if (reader.readString() != getCacheKey(system))
+		return false;
+
+	std::string xmlPath = reader.readString();
+	if (xmlPath != system->getGamelistPath(false) || reader.readString() != getGamelistKey(system, xmlPath))
+	{
+		LOG(LogDebug) << "GamelistCache : gamelist changed for " << system->getName();
+		return false;
+	}
+
+	uint32_t folderCount = reader.read<uint32_t>();
+	for (uint32_t i = 0; i < folderCount && reader.isValid(); i++)
+	{
+		std::string folder = reader.readString();
+		time_t time = (time_t)reader.read<int64_t>();
+
+		if (!reader.isValid() || Utils::FileSystem::getFileModificationDate(folder).getTime() != time)
+		{
+			LOG(LogDebug) << "GamelistCache : folder " << folder << " changed for " << system->getName();
+			return false;
+		}
+
+		Utils::FileSystem::FileSystemCacheActivator::keepDirectoryListing(folder);
+	}
+
+	uint32_t count = reader.read<uint32_t>();
+	if (!reader.isValid() || count == 0)
+		return false;
+
+	FolderData* root = system->getRootFolder();
+	MetaDataList rootMetadata = root->getMetadata();
+
+	std::vector<FileData*> nodes;
+	nodes.reserve(count);
+
+	bool valid = true;
+
+	for (uint32_t i = 0; i < count && valid; i++)
+	{
+		FileType type = (FileType)reader.read<uint8_t>();
+		uint32_t parent = reader.read<uint32_t>();
+		std::string filePath = reader.readString();
+
+		if (!reader.isValid())
+		{
+			valid = false;
+			break;
+		}
+
+		if (i == 0)
+		{
+			if (parent != GAMELISTCACHE_NOPARENT || filePath != root->getPath())
+			{
+				valid = false;
+				break;
+			}
+
+			valid = readMetadata(reader, root->getMetadata(), system);
+			nodes.push_back(root);
+			continue;
+		}
+
+		if (parent >= nodes.size() || nodes[parent]->getType() != FOLDER || (type != GAME && type != FOLDER))
+		{
+			valid = false;
+			break;
+		}
+
+		FileData* file = (type == FOLDER ? new FolderData(filePath, system) : new FileData(GAME, filePath, system));
+		((FolderData*)nodes[parent])->addChild(file);
+		fileMap[filePath] = file;
+		nodes.push_back(file);
+
+		valid = readMetadata(reader, file->getMetadata(), system);
+	}
+
+	if (!valid || !reader.isValid())
+	{
+		LOG(LogWarning) << "GamelistCache : invalid cache file for " << system->getName();
+
+		root->clear();
+		root->setMetadata(rootMetadata);
+		root->getMetadata().resetChangedFlag();
+
+		fileMap.clear();
+		fileMap[system->getStartPath()] = root;
+		return false;
+	}
+
+	LOG(LogInfo) << "GamelistCache : loaded " << (count - 1) << " entries for " << system->getName();
+	return true;
+}
+
+bool GamelistCache::save(SystemData* system, const FolderStates& folders)
+{
+	if (!isEnabled())
+		return false;
+
+	// Pending changes would be saved as unchanged : ignore
+	if (Utils::FileSystem::getDirContent(getGamelistRecoveryPath(system), true).size() > 0)
+		return false;
+
+	FolderData* root = system->getRootFolder();
+	if (root == nullptr)
+		return false;
+
+	CacheWriter writer;
+	writer.write<uint32_t>(GAMELISTCACHE_MAGIC);
+	writer.write<uint32_t>(GAMELISTCACHE_VERSION);
+	writer.writeString(getCacheKey(system));
+
+	std::string xmlPath = system->getGamelistPath(false);
+	writer.writeString(xmlPath);
+	writer.writeString(getGamelistKey(system, xmlPath));
+
+	writer.write<uint32_t>((uint32_t)folders.size());
+	for (auto& folder : folders)
+	{
+		writer.writeString(folder.path);
+		writer.write<int64_t>((int64_t)folder.time);
+	}
+
+	size_t countOffset = writer.offset();
+	writer.write<uint32_t>(0);
+
+	writer.write<uint8_t>((uint8_t)root->getType());
+	writer.write<uint32_t>(GAMELISTCACHE_NOPARENT);
+	writer.writeString(root->getPath());
+	writeMetadata(writer, root->getMetadata());
+
+	uint32_t count = 1;
+	writeFolder(writer, root, 0, count);
+	writer.patch<uint32_t>(countOffset, count);
+
+	std::string path = getCachePath(system);
+	std::string tmpPath = path + ".tmp";
+
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+#if defined(_WIN32)
+	FILE* file = _wfopen(Utils::String::convertToWideString(tmpPath).c_str(), L"wb");
+#else
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+#endif
+	if (file == nullptr)
+	{
+		LOG(LogWarning) << "GamelistCache : unable to write " << tmpPath;
+		return false;
+	}
+
+	bool written = fwrite(writer.buffer().data(), 1, writer.buffer().size(), file) == writer.buffer().size();
+	fclose(file);
+
+	if (!written || !Utils::FileSystem::renameFile(tmpPath, path))
+	{
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	return true;
+}
+
+void GamelistCache::invalidate(SystemData* system)
+{
+	Utils::FileSystem::removeFile(getCachePath(system));
+}
+
+void GamelistCache::clear()
+{
+	Utils::FileSystem::deleteDirectoryFiles(Utils::FileSystem::getGenericPath(Paths::getUserEmulationStationPath() + "/cache/gamelists"));
+}
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef ES_APP_GAMELIST_CACHE_H
+#define ES_APP_GAMELIST_CACHE_H
+
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <time.h>
+#include <stdint.h>
+
+class SystemData;
+class FileData;
+class FolderData;
+class MetaDataList;
+class CacheWriter;
+class CacheReader;
+
+// Binary snapshot of a system's FileData tree (files, folders & metadata) built after a full scan + gamelist.xml parsing.
+// It is keyed by the gamelist size/mtime and by the mtime of every scanned rom directory, so the next boot
+// can restore the tree without any readdir or XML parsing as long as nothing changed on disk.
+class GamelistCache
+{
+public:
+	struct FolderState
+	{
+		FolderState(const std::string& _path, time_t _time) : path(_path), time(_time) { }
+
+		std::string path;
+		time_t		time;
+	};
+
+	typedef std::vector<FolderState> FolderStates;
+
+	static bool isEnabled();
+
+	static bool load(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
+	static bool save(SystemData* system, const FolderStates& folders);
+	static void invalidate(SystemData* system);
+	static void clear();
+
+private:
+	static std::string getCachePath(SystemData* system);
+	static std::string getCacheKey(SystemData* system);
+
+	static void writeFolder(CacheWriter& writer, FolderData* folder, uint32_t folderIndex, uint32_t& count);
+	static void writeMetadata(CacheWriter& writer, const MetaDataList& mdl);
+	static bool readMetadata(CacheReader& reader, MetaDataList& mdl, SystemData* system);
+};
+
+#endif // ES_APP_GAMELIST_CACHE_H
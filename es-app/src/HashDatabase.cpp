@@ -0,0 +1,372 @@
+#include "HashDatabase.h"
+
+#include "utils/AppendLog.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/ZipFile.h"
+#include "utils/md5.h"
+#include "ApiSystem.h"
+#include "Log.h"
+#include "Paths.h"
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#include <sys/sysmacros.h>
+#endif
+
+#define HASHDATABASE_MAGIC		0x44485345 // "ESHD"
+#define HASHDATABASE_VERSION	1
+
+// Retroarch CRC calculations are limited in size. See encoding_crc32.c
+#define HASH_BUFFER_SIZE		1048576
+#define CRC32_MAX_SIZE			(64 * HASH_BUFFER_SIZE)
+
+struct FileIdentity
+{
+	uint64_t device;
+	uint64_t inode;
+	int64_t  size;
+	int64_t  time;
+};
+
+static std::mutex sLock;
+static bool sLoaded = false;
+
+// Key : FileIdentity bytes followed by the kind of hash
+static std::unordered_map<std::string, std::string> sHashes;
+
+// Records : FileIdentity, uint8 kind length, kind, uint8 value length, value
+static Utils::AppendLog& getDatabase()
+{
+	static Utils::AppendLog database(Utils::FileSystem::getGenericPath(Paths::getUserEmulationStationPath() + "/cache/hashes.cache"), HASHDATABASE_MAGIC, HASHDATABASE_VERSION);
+	return database;
+}
+
+static bool getIdentity(const std::string& path, FileIdentity& identity)
+{
+	memset(&identity, 0, sizeof(FileIdentity));
+
+#if defined(_WIN32)
+	struct _stat64 info;
+	if (_wstat64(Utils::String::convertToWideString(path).c_str(), &info) != 0)
+		return false;
+
+	// No inodes on Windows : the path is used instead, so a renamed or moved rom is hashed again
+	identity.inode = Utils::String::computeHash(Utils::String::toLower(Utils::FileSystem::getGenericPath(path)));
+#else
+	struct stat64 info;
+	if (stat64(path.c_str(), &info) != 0)
+		return false;
+
+	identity.inode = (uint64_t)info.st_ino;
+#endif
+
+	identity.device = (uint64_t)info.st_dev;
+	identity.size = (int64_t)info.st_size;
+	identity.time = (int64_t)info.st_mtime;
+	return true;
+}
+
+static std::string getKey(const FileIdentity& identity, const std::string& kind)
+{
+	return std::string((const char*)&identity, sizeof(FileIdentity)) + kind;
+}
+
+static void addRecord(std::string& data, const std::string& key, const std::string& value)
+{
+	unsigned char kindSize = (unsigned char)(key.size() - sizeof(FileIdentity));
+	unsigned char valueSize = (unsigned char)value.size();
+
+	data.append(key.data(), sizeof(FileIdentity));
+	data.append((const char*)&kindSize, 1);
+	data.append(key.data() + sizeof(FileIdentity), kindSize);
+	data.append((const char*)&valueSize, 1);
+	data.append(value);
+}
+
+// Returns the size of the record, 0 if it is incomplete
+static size_t readRecord(const char* data, size_t size)
+{
+	size_t pos = sizeof(FileIdentity);
+	if (pos + 1 > size)
+		return 0;
+
+	unsigned char kindSize = (unsigned char)data[pos++];
+	if (pos + kindSize + 1 > size)
+		return 0;
+
+	const char* kind = data + pos;
+	pos += kindSize;
+
+	unsigned char valueSize = (unsigned char)data[pos++];
+	if (pos + valueSize > size)
+		return 0;
+
+	std::string key(data, sizeof(FileIdentity));
+	key.append(kind, kindSize);
+
+	sHashes[key] = std::string(data + pos, valueSize);
+	return pos + valueSize;
+}
+
+// Records are appended when they are computed : the file is rewritten at load when many of them were replaced
+static void loadDatabase()
+{
+	if (sLoaded)
+		return;
+
+	sLoaded = true;
+
+	Utils::AppendLog& database = getDatabase();
+	if (!database.load(readRecord))
+		return;
+
+	LOG(LogDebug) << "HashDatabase : " << sHashes.size() << " hashes loaded";
+
+	if (database.needsCompaction((int)sHashes.size(), 256))
+	{
+		std::string data;
+		for (auto& item : sHashes)
+			addRecord(data, item.first, item.second);
+
+		database.rewrite(data, (int)sHashes.size());
+	}
+}
+
+static bool findHash(const FileIdentity& identity, const std::string& kind, std::string& value)
+{
+	std::unique_lock<std::mutex> lock(sLock);
+	loadDatabase();
+
+	auto it = sHashes.find(getKey(identity, kind));
+	if (it == sHashes.cend())
+		return false;
+
+	value = it->second;
+	return true;
+}
+
+static void storeHashes(const FileIdentity& identity, const std::vector<std::pair<std::string, std::string>>& values)
+{
+	std::unique_lock<std::mutex> lock(sLock);
+	loadDatabase();
+
+	std::string data;
+	int count = 0;
+
+	for (auto& item : values)
+	{
+		if (item.second.empty() || item.first.size() > 255 || item.second.size() > 255)
+			continue;
+
+		std::string key = getKey(identity, item.first);
+		sHashes[key] = item.second;
+
+		addRecord(data, key, item.second);
+		count++;
+	}
+
+	if (count > 0)
+		getDatabase().append(data, count);
+}
+
+static bool isArchive(const std::string& path)
+{
+	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(path));
+	return ext == ".zip" || ext == ".7z";
+}
+
+// Single rom of a zip archive, ignoring the text files. Empty if there are many.
+static std::string getSingleRomName(Utils::Zip::ZipFile& file)
+{
+	std::string romName;
+
+	for (auto name : file.namelist())
+	{
+		if (Utils::FileSystem::getExtension(name) == ".txt" || Utils::String::endsWith(name, "/"))
+			continue;
+
+		if (!romName.empty())
+			return "";
+
+		romName = name;
+	}
+
+	return romName;
+}
+
+struct HashState
+{
+	HashState() : crc(0), crcSize(0) { }
+
+	void update(const void* data, size_t size)
+	{
+		if (crcSize < CRC32_MAX_SIZE)
+		{
+			size_t crcLength = std::min(size, (size_t)(CRC32_MAX_SIZE - crcSize));
+			crc = Utils::Zip::ZipFile::computeCRC(crc, data, crcLength);
+			crcSize += crcLength;
+		}
+
+		md5.update((const char*)data, (MD5::size_type)size);
+	}
+
+	unsigned int crc;
+	size_t		 crcSize;
+	MD5			 md5;
+};
+
+// CRC32 and MD5 with a single read : zip members are read in-process, 7z archives still need 7za
+static bool computeHashes(const std::string& path, bool fromZipContents, bool needMd5, std::string& crc, std::string& md5)
+{
+	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(path));
+
+	if (fromZipContents && ext == ".zip")
+	{
+		Utils::Zip::ZipFile file;
+		if (file.load(path))
+		{
+			std::string romName = getSingleRomName(file);
+			if (!romName.empty())
+			{
+				// The zip directory already has the CRC of its members
+				crc = file.getFileCrc(romName);
+				md5 = file.getFileMd5(romName);
+				return !crc.empty() && !md5.empty();
+			}
+		}
+	}
+	else if (fromZipContents && ext == ".7z")
+	{
+		crc = ApiSystem::getInstance()->getCRC32(path, true);
+		if (needMd5)
+			md5 = ApiSystem::getInstance()->getMD5(path, true);
+
+		return !crc.empty();
+	}
+
+#if defined(_WIN32)
+	FILE* file = _wfopen(Utils::String::convertToWideString(path).c_str(), L"rb");
+#else
+	FILE* file = fopen(path.c_str(), "rb");
+#endif
+	if (file == nullptr)
+		return false;
+
+	HashState state;
+
+	char* buffer = new char[HASH_BUFFER_SIZE];
+
+	size_t size;
+	while ((size = fread(buffer, 1, HASH_BUFFER_SIZE, file)) > 0)
+		state.update(buffer, size);
+
+	delete[] buffer;
+	fclose(file);
+
+	state.md5.finalize();
+
+	crc = Utils::String::toHexString(state.crc);
+	md5 = state.md5.hexdigest();
+	return true;
+}
+
+static std::string getHash(const std::string& path, bool fromZipContents, bool wantMd5)
+{
+	fromZipContents = fromZipContents && isArchive(path);
+
+	std::string crcKind = fromZipContents ? "crc32:rom" : "crc32";
+	std::string md5Kind = fromZipContents ? "md5:rom" : "md5";
+
+	FileIdentity identity;
+	if (!getIdentity(path, identity))
+		return "";
+
+	std::string value;
+	if (findHash(identity, wantMd5 ? md5Kind : crcKind, value))
+		return value;
+
+	std::string crc, md5;
+	if (!computeHashes(path, fromZipContents, wantMd5, crc, md5))
+		return "";
+
+	storeHashes(identity, { { crcKind, crc }, { md5Kind, md5 } });
+
+	return wantMd5 ? md5 : crc;
+}
+
+std::string HashDatabase::getCrc32(const std::string& path, bool fromZipContents)
+{
+	return getHash(path, fromZipContents, false);
+}
+
+std::string HashDatabase::getMd5(const std::string& path, bool fromZipContents)
+{
+	return getHash(path, fromZipContents, true);
+}
+
+std::string HashDatabase::get(const std::string& path, const std::string& kind, const std::function<std::string()>& compute)
+{
+	FileIdentity identity;
+	if (!getIdentity(path, identity))
+		return compute();
+
+	std::string value;
+	if (findHash(identity, kind, value))
+		return value;
+
+	value = compute();
+	storeHashes(identity, { { kind, value } });
+	return value;
+}
+
+unsigned long long HashDatabase::getDevice(const std::string& path)
+{
+	FileIdentity identity;
+	if (!getIdentity(path, identity))
+		return 0;
+
+	return identity.device;
+}
+
+int HashDatabase::getIoConcurrency(unsigned long long device)
+{
+	int cores = std::max(1, (int)std::thread::hardware_concurrency() / 2);
+
+#if !defined(_WIN32)
+	// Partitions have no queue of their own : the one of the disk is in the parent directory
+	std::string sysPath = "/sys/dev/block/" + std::to_string(major((dev_t)device)) + ":" + std::to_string(minor((dev_t)device));
+
+	for (auto queue : { "/queue/rotational", "/../queue/rotational" })
+	{
+		std::ifstream file(sysPath + queue);
+		if (!file.is_open())
+			continue;
+
+		int rotational = 0;
+		file >> rotational;
+		return rotational ? 1 : cores;
+	}
+#endif
+
+	// Network shares, fuse mounts & unknown devices
+	return std::min(2, cores);
+}
+
+void HashDatabase::clear()
+{
+	std::unique_lock<std::mutex> lock(sLock);
+
+	sHashes.clear();
+	sLoaded = true;
+
+	getDatabase().remove();
+}
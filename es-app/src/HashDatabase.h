@@ -0,0 +1,29 @@
+#pragma once
+#ifndef ES_APP_HASH_DATABASE_H
+#define ES_APP_HASH_DATABASE_H
+
+#include <functional>
+#include <string>
+
+// Persistent store of the hashes computed from game files (CRC32, MD5, RetroAchievements hashes).
+// Entries are keyed by the device, inode, size and modification time of the file, so a renamed or moved rom keeps its hashes
+// (except on Windows, where the path replaces the inode), and a modified one is hashed again. CRC32 and MD5 are computed together, with a single read of the file.
+class HashDatabase
+{
+public:
+	// When fromZipContents is set, the hashes of a .zip or .7z archive are the ones of its single rom
+	static std::string getCrc32(const std::string& path, bool fromZipContents);
+	static std::string getMd5(const std::string& path, bool fromZipContents);
+
+	// Other hashes : compute is called when the file is unknown or has changed. Empty values are not stored.
+	static std::string get(const std::string& path, const std::string& kind, const std::function<std::string()>& compute);
+
+	// Device of the file, and how many files of that device can be hashed at the same time :
+	// one for spinning disks, where parallel reads only add seeks, a few for network shares, one per core for flash storage.
+	static unsigned long long getDevice(const std::string& path);
+	static int getIoConcurrency(unsigned long long device);
+
+	static void clear();
+};
+
+#endif // ES_APP_HASH_DATABASE_H
@@ -9,6 +9,10 @@
 #include "Settings.h"
 #include "FileData.h"
 #include "ImageIO.h"
+#include <unordered_set>
+#include <mutex>
+#include <atomic>
+#include <stdlib.h>
 
 std::vector<MetaDataDecl> MetaDataList::mMetaDataDecls;
 
@@ -16,6 +20,7 @@ static std::map<MetaDataId, int> mMetaDataIndexes;
 static std::string* mDefaultGameMap = nullptr;
 static MetaDataType* mGameTypeMap = nullptr;
 static std::map<std::string, MetaDataId> mGameIdMap;
+static std::atomic<unsigned int> mGlobalRevision(0);
 
 static std::map<std::string, int> KnowScrapersIds =
 {
@@ -140,9 +145,282 @@ MetaDataId MetaDataList::getId(const std::string& key) const
 	return mGameIdMap[key];
 }
 
-MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr)
+// Strings repeated across the games of a system. Pools are never released, so values stay valid for copies of MetaDataList outliving their system
+class MetaDataStringPool
 {
+public:
+	const char* intern(const std::string& value)
+	{
+		std::unique_lock<std::mutex> lock(mLock);
+		return mStrings.insert(value).first->c_str();
+	}
+
+	static MetaDataStringPool* get(SystemData* system)
+	{
+		std::unique_lock<std::mutex> lock(mPoolsLock);
+
+		MetaDataStringPool*& pool = mPools[system->getName()];
+		if (pool == nullptr)
+			pool = new MetaDataStringPool();
+
+		return pool;
+	}
+
+private:
+	std::mutex mLock;
+	std::unordered_set<std::string> mStrings;
+
+	static std::mutex mPoolsLock;
+	static std::map<std::string, MetaDataStringPool*> mPools;
+};
+
+std::mutex MetaDataStringPool::mPoolsLock;
+std::map<std::string, MetaDataStringPool*> MetaDataStringPool::mPools;
+
+static bool isPooledMetadata(MetaDataId id)
+{
+	switch (id)
+	{
+	case MetaDataId::Emulator:
+	case MetaDataId::Core:
+	case MetaDataId::Developer:
+	case MetaDataId::Publisher:
+	case MetaDataId::Genre:
+	case MetaDataId::GenreIds:
+	case MetaDataId::Family:
+	case MetaDataId::ArcadeSystemName:
+	case MetaDataId::Players:
+	case MetaDataId::Language:
+	case MetaDataId::Region:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+static std::string floatToString(float value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%g", value);
+	return buffer;
+}
+
+// "YYYYMMDDTHHMMSS" dates are packed as 14 BCD digits
+static bool packIsoDate(const std::string& value, long long& packed)
+{
+	if (value.size() != 15 || value[8] != 'T')
+		return false;
+
+	packed = 0;
+
+	for (int i = 0; i < 15; i++)
+	{
+		if (i == 8)
+			continue;
+
+		char c = value[i];
+		if (c < '0' || c > '9')
+			return false;
+
+		packed = (packed << 4) | (c - '0');
+	}
+
+	return true;
+}
+
+static std::string unpackIsoDate(long long packed)
+{
+	std::string value(15, 'T');
+
+	for (int i = 14; i >= 0; i--)
+	{
+		if (i == 8)
+			continue;
+
+		value[i] = '0' + (char)(packed & 0xF);
+		packed >>= 4;
+	}
+
+	return value;
+}
+
+MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRevision(0), mRelativeTo(nullptr)
+{
+	memset(mSlotKinds, SLOT_EMPTY, sizeof(mSlotKinds));
+}
+
+MetaDataList::MetaDataList(const MetaDataList& other) : mScrapeDates(other.mScrapeDates), mName(other.mName), mType(other.mType), mWasChanged(other.mWasChanged), mRevision(0), mRelativeTo(other.mRelativeTo), mUnKnownElements(other.mUnKnownElements)
+{
+	memset(mSlotKinds, SLOT_EMPTY, sizeof(mSlotKinds));
+	copyValues(other);
+}
+
+MetaDataList::MetaDataList(MetaDataList&& other) : mScrapeDates(std::move(other.mScrapeDates)), mName(std::move(other.mName)), mType(other.mType), mWasChanged(other.mWasChanged), mRevision(0), mRelativeTo(other.mRelativeTo), mUnKnownElements(std::move(other.mUnKnownElements))
+{
+	memcpy(mSlots, other.mSlots, sizeof(mSlots));
+	memcpy(mSlotKinds, other.mSlotKinds, sizeof(mSlotKinds));
+	memset(other.mSlotKinds, SLOT_EMPTY, sizeof(other.mSlotKinds));
+}
+
+MetaDataList::~MetaDataList()
+{
+	clearValues();
+}
+
+MetaDataList& MetaDataList::operator=(const MetaDataList& other)
+{
+	if (this == &other)
+		return *this;
+
+	clearValues();
+	copyValues(other);
+
+	mScrapeDates = other.mScrapeDates;
+	mName = other.mName;
+	mType = other.mType;
+	mWasChanged = other.mWasChanged;
+	mRelativeTo = other.mRelativeTo;
+	mUnKnownElements = other.mUnKnownElements;
+	return *this;
+}
+
+MetaDataList& MetaDataList::operator=(MetaDataList&& other)
+{
+	if (this == &other)
+		return *this;
+
+	clearValues();
+	memcpy(mSlots, other.mSlots, sizeof(mSlots));
+	memcpy(mSlotKinds, other.mSlotKinds, sizeof(mSlotKinds));
+	memset(other.mSlotKinds, SLOT_EMPTY, sizeof(other.mSlotKinds));
+
+	mScrapeDates = std::move(other.mScrapeDates);
+	mName = std::move(other.mName);
+	mType = other.mType;
+	mWasChanged = other.mWasChanged;
+	mRelativeTo = other.mRelativeTo;
+	mUnKnownElements = std::move(other.mUnKnownElements);
+	return *this;
+}
+
+void MetaDataList::copyValues(const MetaDataList& other)
+{
+	memcpy(mSlots, other.mSlots, sizeof(mSlots));
+	memcpy(mSlotKinds, other.mSlotKinds, sizeof(mSlotKinds));
+
+	for (int i = 0; i < SLOT_COUNT; i++)
+		if (mSlotKinds[i] == SLOT_TEXT)
+			mSlots[i].text = strdup(other.mSlots[i].text);
+}
+
+void MetaDataList::clearValue(MetaDataId id)
+{
+	if (mSlotKinds[id] == SLOT_TEXT)
+		free(mSlots[id].text);
 
+	mSlotKinds[id] = SLOT_EMPTY;
+	mRevision++;
+	mGlobalRevision++;
+}
+
+unsigned int MetaDataList::getGlobalRevision()
+{
+	return mGlobalRevision;
+}
+
+void MetaDataList::clearValues()
+{
+	for (int i = 0; i < SLOT_COUNT; i++)
+		clearValue((MetaDataId)i);
+}
+
+std::string MetaDataList::getValue(MetaDataId id) const
+{
+	switch (mSlotKinds[id])
+	{
+	case SLOT_INT:
+		return std::to_string(mSlots[id].number);
+	case SLOT_FLOAT:
+		return floatToString(mSlots[id].decimal);
+	case SLOT_BOOL:
+		return mSlots[id].number ? "true" : "false";
+	case SLOT_DATE:
+		return unpackIsoDate(mSlots[id].number);
+	case SLOT_POOLED:
+		return mSlots[id].pooled;
+	case SLOT_TEXT:
+		return mSlots[id].text;
+
+	default:
+		return "";
+	}
+}
+
+// Stores the value in its most compact form, as long as it converts back to the exact same string
+void MetaDataList::setValue(MetaDataId id, const std::string& value)
+{
+	clearValue(id);
+
+	switch (mGameTypeMap[id])
+	{
+	case MD_INT:
+		if (!value.empty() && value.size() < 19)
+		{
+			long long number = strtoll(value.c_str(), nullptr, 10);
+			if (std::to_string(number) == value)
+			{
+				mSlots[id].number = number;
+				mSlotKinds[id] = SLOT_INT;
+				return;
+			}
+		}
+		break;
+
+	case MD_RATING:
+		if (!value.empty())
+		{
+			float decimal = Utils::String::toFloat(value);
+			if (floatToString(decimal) == value)
+			{
+				mSlots[id].decimal = decimal;
+				mSlotKinds[id] = SLOT_FLOAT;
+				return;
+			}
+		}
+		break;
+
+	case MD_BOOL:
+		if (value == "true" || value == "false")
+		{
+			mSlots[id].number = (value == "true") ? 1 : 0;
+			mSlotKinds[id] = SLOT_BOOL;
+			return;
+		}
+		break;
+
+	case MD_DATE:
+	case MD_TIME:
+		if (packIsoDate(value, mSlots[id].number))
+		{
+			mSlotKinds[id] = SLOT_DATE;
+			return;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	if (mRelativeTo != nullptr && isPooledMetadata(id))
+	{
+		mSlots[id].pooled = MetaDataStringPool::get(mRelativeTo)->intern(value);
+		mSlotKinds[id] = SLOT_POOLED;
+		return;
+	}
+
+	mSlots[id].text = strdup(value.c_str());
+	mSlotKinds[id] = SLOT_TEXT;
 }
 
 MetaDataList MetaDataList::createFromXML(MetaDataListType type, pugi::xml_node& node, SystemData* system)
@@ -288,16 +566,15 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 		if (mddIter->id == MetaDataId::GenreIds)
 			continue;
 
-		auto mapIter = mMap.find(mddIter->id);
-		if(mapIter != mMap.cend())
+		if (hasValue(mddIter->id))
 		{
 			// we have this value!
 			// if it's just the default (and we ignore defaults), don't write it
-			if (ignoreDefaults && mapIter->second == mddIter->defaultValue)
+			std::string value = getValue(mddIter->id);
+			if (ignoreDefaults && value == mddIter->defaultValue)
 				continue;
 
 			// try and make paths relative if we can
-			std::string value = mapIter->second;
 			if (mddIter->type == MD_PATH)
 			{
 				if (fullPaths && mRelativeTo != nullptr)
@@ -356,24 +633,25 @@ void MetaDataList::set(MetaDataId id, const std::string& value)
 
 		mName = value;
 		mWasChanged = true;
+		mRevision++;
+		mGlobalRevision++;
 		return;
 	}
 
 	// Players -> remove "1-"
 	if (mType == GAME_METADATA && id == 12 && Utils::String::startsWith(value, "1-")) // "players"
 	{
-		mMap[id] = Utils::String::replace(value, "1-", "");
+		setValue(id, Utils::String::replace(value, "1-", ""));
 		return;
 	}
 
-	auto prev = mMap.find(id);
-	if (prev != mMap.cend() && prev->second == value)
+	if (hasValue(id) && getValue(id) == value)
 		return;
 
 	if (mGameTypeMap[id] == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-		mMap[id] = Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true);
+		setValue(id, Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true));
 	else
-		mMap[id] = Utils::String::trim(value);
+		setValue(id, Utils::String::trim(value));
 
 	mWasChanged = true;
 }
@@ -383,13 +661,12 @@ const std::string MetaDataList::get(MetaDataId id, bool resolveRelativePaths) co
 	if (id == MetaDataId::Name)
 		return mName;
 
-	auto it = mMap.find(id);
-	if (it != mMap.end())
+	if (hasValue(id))
 	{
 		if (resolveRelativePaths && mGameTypeMap[id] == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			return Utils::FileSystem::resolveRelativePath(it->second, mRelativeTo->getStartPath(), true);
+			return Utils::FileSystem::resolveRelativePath(getValue(id), mRelativeTo->getStartPath(), true);
 
-		return it->second;
+		return getValue(id);
 	}
 
 	return mDefaultGameMap[id];
@@ -413,11 +690,17 @@ const std::string MetaDataList::get(const std::string& key, bool resolveRelative
 
 int MetaDataList::getInt(MetaDataId id) const
 {
+	if (mSlotKinds[id] == SLOT_INT)
+		return (int)mSlots[id].number;
+
 	return atoi(get(id).c_str());
 }
 
 float MetaDataList::getFloat(MetaDataId id) const
 {
+	if (mSlotKinds[id] == SLOT_FLOAT)
+		return mSlots[id].decimal;
+
 	return Utils::String::toFloat(get(id));
 }
 
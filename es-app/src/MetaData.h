@@ -131,6 +131,8 @@ enum MetaDataListType
 
 class MetaDataList
 {
+	friend class GamelistCache;
+
 public:
 	static void initMetadata();
 
@@ -140,6 +142,12 @@ public:
 	void migrate(FileData* file, pugi::xml_node& node);
 
 	MetaDataList(MetaDataListType type);
+	MetaDataList(const MetaDataList& other);
+	MetaDataList(MetaDataList&& other);
+	~MetaDataList();
+
+	MetaDataList& operator=(const MetaDataList& other);
+	MetaDataList& operator=(MetaDataList&& other);
 	
 	void set(MetaDataId id, const std::string& value);
 
@@ -158,6 +166,11 @@ public:
 
 	bool wasChanged() const;
 	void resetChangedFlag();
+
+	// Incremented by every change : lets indexes detect their outdated entries
+	inline unsigned int getRevision() const { return mRevision; }
+	// Incremented by the changes of every list
+	static unsigned int getGlobalRevision();
 	const void setDirty() 
 	{ 
 		mWasChanged = true; 
@@ -175,12 +188,45 @@ public:
 	Utils::Time::DateTime* getScrapeDate(const std::string& scraper);
 
 private:
+	// Values are stored in one slot per MetaDataId. Numbers, booleans & dates are kept in their binary form,
+	// strings that repeat across games (developer, genre, region...) point to a string pool shared by the system.
+	enum SlotKind : unsigned char
+	{
+		SLOT_EMPTY,
+		SLOT_INT,
+		SLOT_FLOAT,
+		SLOT_BOOL,
+		SLOT_DATE,
+		SLOT_POOLED,
+		SLOT_TEXT
+	};
+
+	union Slot
+	{
+		long long	number;
+		float		decimal;
+		const char* pooled;
+		char*		text;
+	};
+
+	static const int SLOT_COUNT = MetaDataId::Bezel + 1;
+
+	inline bool hasValue(MetaDataId id) const { return mSlotKinds[id] != SLOT_EMPTY; }
+	std::string getValue(MetaDataId id) const;
+	void setValue(MetaDataId id, const std::string& value);
+	void clearValue(MetaDataId id);
+	void clearValues();
+	void copyValues(const MetaDataList& other);
+
+	Slot			mSlots[SLOT_COUNT];
+	unsigned char	mSlotKinds[SLOT_COUNT];
+
 	std::map<int, Utils::Time::DateTime> mScrapeDates;
 
 	std::string		mName;
 	MetaDataListType mType;
-	std::map<MetaDataId, std::string> mMap;
 	bool mWasChanged;
+	unsigned int	mRevision;
 	SystemData*		mRelativeTo;
 
 	static std::vector<MetaDataDecl> mMetaDataDecls;
@@ -1,6 +1,7 @@
 #include "RetroAchievements.h"
 #include "HttpReq.h"
 #include "ApiSystem.h"
+#include "HashDatabase.h"
 #include "SystemConf.h"
 #include "PlatformId.h"
 #include "SystemData.h"
@@ -519,7 +520,7 @@ std::string RetroAchievements::getCheevosHash( SystemData* system, const std::st
 		return getCheevosHashFromFile(consoleId, fileName);
 
 	if (consoleId == 0 || consolesWithmd5hashes.find(consoleId) != consolesWithmd5hashes.cend())
-		return ApiSystem::getInstance()->getMD5(fileName, fromZipContents);
+		return HashDatabase::getMd5(fileName, fromZipContents);
 
 	std::string ext = Utils::String::toLower(Utils::FileSystem::getExtension(fileName));
 	if (ext != ".zip" && ext != ".7z")
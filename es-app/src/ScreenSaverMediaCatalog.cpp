@@ -0,0 +1,322 @@
+#include "ScreenSaverMediaCatalog.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/Randomizer.h"
+#include "utils/TaskScheduler.h"
+#include "views/UIModeController.h"
+#include "Log.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include "Window.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#define MAX_MISSING_MEDIAS 10
+
+struct MediaList
+{
+	std::vector<ScreenSaverMediaCatalog::Entry> entries;
+	std::unordered_map<FileData*, size_t> positions;
+
+	void add(FileData* file, const std::string& path)
+	{
+		if (path.empty() || positions.find(file) != positions.cend())
+			return;
+
+		positions[file] = entries.size();
+		entries.push_back({ file, path });
+	}
+
+	// The last entry takes the place of the removed one
+	void remove(FileData* file)
+	{
+		auto it = positions.find(file);
+		if (it == positions.cend())
+			return;
+
+		size_t pos = it->second;
+		positions.erase(it);
+
+		if (pos != entries.size() - 1)
+		{
+			entries[pos] = entries.back();
+			positions[entries[pos].file] = pos;
+		}
+
+		entries.pop_back();
+	}
+
+	void clear()
+	{
+		entries.clear();
+		positions.clear();
+	}
+};
+
+// Media paths of a game, read on the UI thread : getVideoPath & getImagePath may store local art in the metadata
+struct MediaSnapshot
+{
+	MediaSnapshot() : file(nullptr), removed(false) { }
+
+	MediaSnapshot(FileData* game) : file(game), removed(false)
+	{
+		paths[ScreenSaverMediaCatalog::VIDEO] = game->getVideoPath();
+		paths[ScreenSaverMediaCatalog::IMAGE] = game->getImagePath();
+	}
+
+	FileData*	file;
+	std::string paths[2];
+	bool		removed;
+};
+
+static std::mutex sLock;
+static MediaList sLists[2];
+static bool sReady = false;
+static bool sBuilding = false;
+static std::atomic<int> sGeneration(0);
+static Window* sWindow = nullptr;
+
+// Games changed while the catalog is built, applied to the new lists
+static std::vector<MediaSnapshot> sPendingChanges;
+
+static Utils::TaskGroup* getBuildGroup()
+{
+	static Utils::TaskGroup* group = new Utils::TaskGroup(Utils::TASK_BACKGROUND);
+	return group;
+}
+
+static bool isCatalogSystem(SystemData* system)
+{
+	return system != nullptr && system->isGameSystem() && !system->isCollection();
+}
+
+// Games of a system shown in its game list : UI thread only
+static std::vector<MediaSnapshot> getDisplayedMedias(SystemData* system)
+{
+	std::vector<MediaSnapshot> medias;
+
+	for (auto game : system->getRootFolder()->getFilesRecursive(GAME, true))
+	{
+		MediaSnapshot media(game);
+		if (!media.paths[ScreenSaverMediaCatalog::VIDEO].empty() || !media.paths[ScreenSaverMediaCatalog::IMAGE].empty())
+			medias.push_back(media);
+	}
+
+	return medias;
+}
+
+// Media existence is checked when the entry is picked
+static void applyChange(MediaList* lists, const MediaSnapshot& media)
+{
+	lists[ScreenSaverMediaCatalog::VIDEO].remove(media.file);
+	lists[ScreenSaverMediaCatalog::IMAGE].remove(media.file);
+
+	if (!media.removed)
+	{
+		lists[ScreenSaverMediaCatalog::VIDEO].add(media.file, media.paths[ScreenSaverMediaCatalog::VIDEO]);
+		lists[ScreenSaverMediaCatalog::IMAGE].add(media.file, media.paths[ScreenSaverMediaCatalog::IMAGE]);
+	}
+}
+
+void ScreenSaverMediaCatalog::rebuild(Window* window)
+{
+	if (window != nullptr)
+		sWindow = window;
+
+	int generation = ++sGeneration;
+
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+		sBuilding = sWindow != nullptr;
+		sPendingChanges.clear();
+	}
+
+	if (sWindow == nullptr)
+		return;
+
+	std::vector<SystemData*> systems;
+	for (auto system : SystemData::sSystemVector)
+		if (isCatalogSystem(system))
+			systems.push_back(system);
+
+	Window* uiWindow = sWindow;
+
+	// The game lists are read on the UI thread, one system per frame : only the media checks run in the background
+	getBuildGroup()->run([generation, systems, uiWindow]
+	{
+		MediaList lists[2];
+
+		for (auto system : systems)
+		{
+			auto medias = std::make_shared<std::promise<std::vector<MediaSnapshot>>>();
+			std::future<std::vector<MediaSnapshot>> result = medias->get_future();
+
+			// Systems are only deleted after clear, which changes the generation on the UI thread
+			uiWindow->postToUiThread([generation, system, medias]
+			{
+				medias->set_value(sGeneration == generation ? getDisplayedMedias(system) : std::vector<MediaSnapshot>());
+			});
+
+			while (result.wait_for(std::chrono::milliseconds(50)) != std::future_status::ready)
+				if (sGeneration != generation)
+					return;
+
+			for (auto& media : result.get())
+			{
+				if (sGeneration != generation)
+					return;
+
+				for (int type = VIDEO; type <= IMAGE; type++)
+					if (!media.paths[type].empty() && Utils::FileSystem::exists(media.paths[type]))
+						lists[type].add(media.file, media.paths[type]);
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(sLock);
+		if (sGeneration != generation)
+			return;
+
+		for (auto& change : sPendingChanges)
+			applyChange(lists, change);
+
+		sPendingChanges.clear();
+
+		sLists[VIDEO] = std::move(lists[VIDEO]);
+		sLists[IMAGE] = std::move(lists[IMAGE]);
+		sReady = true;
+		sBuilding = false;
+
+		LOG(LogDebug) << "ScreenSaverMediaCatalog : " << sLists[VIDEO].entries.size() << " videos, " << sLists[IMAGE].entries.size() << " images";
+	});
+}
+
+void ScreenSaverMediaCatalog::clear()
+{
+	// Running builds stop waiting for the UI thread : wait for them before the games are deleted
+	sGeneration++;
+	getBuildGroup()->wait();
+
+	std::unique_lock<std::mutex> lock(sLock);
+	sLists[VIDEO].clear();
+	sLists[IMAGE].clear();
+	sPendingChanges.clear();
+	sReady = false;
+	sBuilding = false;
+}
+
+void ScreenSaverMediaCatalog::onFileChanged(FileData* file, FileChangeType change)
+{
+	if (change == FILE_SORTED)
+		return;
+
+	FileData* source = file->getSourceFileData();
+	if (!isCatalogSystem(source->getSystem()))
+		return;
+
+	// Whole folders are listed again : the current lists may reference their deleted games
+	if (source->getType() != GAME)
+	{
+		{
+			std::unique_lock<std::mutex> lock(sLock);
+			sLists[VIDEO].clear();
+			sLists[IMAGE].clear();
+			sReady = false;
+		}
+
+		rebuild();
+		return;
+	}
+
+	MediaSnapshot media;
+	media.file = source;
+	media.removed = true;
+
+	// Hidden & kid games are left out like in the game lists, the filters are applied by the next build
+	bool hidden = source->getHidden() && !Settings::ShowHiddenFiles();
+	bool kidHidden = UIModeController::getInstance()->isUIModeKid() && !source->getKidGame();
+
+	if (change != FILE_REMOVED && !hidden && !kidHidden)
+		media = MediaSnapshot(source);
+
+	std::unique_lock<std::mutex> lock(sLock);
+
+	if (sBuilding)
+		sPendingChanges.push_back(media);
+
+	if (sReady)
+		applyChange(sLists, media);
+}
+
+// Random entry of the list whose media still exists, scanning a few entries ahead when it is missing
+static bool pickFromList(const std::vector<ScreenSaverMediaCatalog::Entry>& entries, ScreenSaverMediaCatalog::Entry& entry)
+{
+	if (entries.size() == 0)
+		return false;
+
+	int missing = 0;
+	size_t start = (size_t)Randomizer::random((int)entries.size());
+
+	for (size_t i = 0; i < entries.size() && missing < MAX_MISSING_MEDIAS; i++)
+	{
+		auto& item = entries[(start + i) % entries.size()];
+		if (!Utils::FileSystem::exists(item.path))
+		{
+			missing++;
+			continue;
+		}
+
+		entry = item;
+		return true;
+	}
+
+	return false;
+}
+
+// Until the catalog is built : random system, then random children down to a game, without listing the games
+static bool pickFromGameLists(ScreenSaverMediaCatalog::MediaType type, ScreenSaverMediaCatalog::Entry& entry)
+{
+	std::vector<SystemData*> systems;
+	for (auto system : SystemData::sSystemVector)
+		if (isCatalogSystem(system))
+			systems.push_back(system);
+
+	if (systems.size() == 0)
+		return false;
+
+	for (int i = 0; i < MAX_MISSING_MEDIAS * 2; i++)
+	{
+		FileData* item = systems[Randomizer::random((int)systems.size())]->getRootFolder();
+		while (item->getType() == FOLDER && ((FolderData*)item)->getChildren().size() > 0)
+		{
+			auto& children = ((FolderData*)item)->getChildren();
+			item = children[Randomizer::random((int)children.size())];
+		}
+
+		if (item->getType() != GAME || (item->getHidden() && !Settings::ShowHiddenFiles()))
+			continue;
+
+		std::string path = type == ScreenSaverMediaCatalog::VIDEO ? item->getVideoPath() : item->getImagePath();
+		if (path.empty() || !Utils::FileSystem::exists(path))
+			continue;
+
+		entry = { item, path };
+		return true;
+	}
+
+	return false;
+}
+
+bool ScreenSaverMediaCatalog::pickRandom(MediaType type, Entry& entry)
+{
+	{
+		std::unique_lock<std::mutex> lock(sLock);
+		if (sReady)
+			return pickFromList(sLists[type].entries, entry);
+	}
+
+	return pickFromGameLists(type, entry);
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef ES_APP_SCREEN_SAVER_MEDIA_CATALOG_H
+#define ES_APP_SCREEN_SAVER_MEDIA_CATALOG_H
+
+#include "FileData.h"
+#include <string>
+
+class Window;
+
+// Games shown in the game lists having a video or an image, as flat arrays : the screensaver picks a random media without walking the game lists.
+// The catalog is built in the background once the systems are loaded, reading one system per frame on the UI thread.
+// ViewController::onFileChanged adds, replaces or removes the changed games in place.
+class ScreenSaverMediaCatalog
+{
+public:
+	enum MediaType
+	{
+		VIDEO = 0,
+		IMAGE = 1
+	};
+
+	struct Entry
+	{
+		FileData*	file;
+		std::string path;
+	};
+
+	// UI thread only. The window runs the game list reads : the last one given is kept.
+	static void rebuild(Window* window = nullptr);
+	static void clear(); // Must be called before the systems are deleted
+	static void onFileChanged(FileData* file, FileChangeType change);
+
+	// Random game shown in the game lists, whose media exists. Picks a few random games until the catalog is built.
+	static bool pickRandom(MediaType type, Entry& entry);
+};
+
+#endif // ES_APP_SCREEN_SAVER_MEDIA_CATALOG_H
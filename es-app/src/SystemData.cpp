@@ -2,7 +2,7 @@
 
 #include "SystemConf.h"
 #include "utils/FileSystemUtil.h"
-#include "utils/ThreadPool.h"
+#include "utils/TaskScheduler.h"
 #include "CollectionSystemManager.h"
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
@@ -19,10 +19,12 @@
 #include "utils/Randomizer.h"
 #include "views/ViewController.h"
 #include "ThreadedHasher.h"
+#include "ScreenSaverMediaCatalog.h"
 #include <unordered_set>
 #include <algorithm>
 #include "SaveStateRepository.h"
 #include "Paths.h"
+#include "utils/md5.h"
 
 #if WIN32
 #include "Win32ApiSystem.h"
@@ -45,6 +47,8 @@ SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envDat
 	mGridSizeOverride = Vector2f(0, 0);
 
 	mFilterIndex = nullptr;
+	mChangeCount = 0;
+	mIdIndexBuilt = false;
 
 	if (pEmulators != nullptr)
 		mEmulators = *pEmulators;
@@ -63,21 +67,28 @@ SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envDat
 		std::unordered_map<std::string, FileData*> fileMap;
 		fileMap[mEnvData->mStartPath] = mRootFolder;
 
-		if (!Settings::ParseGamelistOnly())
+		if (!GamelistCache::load(this, fileMap))
 		{
-			populateFolder(mRootFolder, fileMap);
-			if (mRootFolder->getChildren().size() == 0)
-				return;
+			GamelistCache::FolderStates folders;
 
-			if (mHidden && !Settings::HiddenSystemsShowGames())
-				return;
-		}
+			if (!Settings::ParseGamelistOnly())
+			{
+				populateFolder(mRootFolder, fileMap, GamelistCache::isEnabled() ? &folders : nullptr);
+				if (mRootFolder->getChildren().size() == 0)
+					return;
 
-		if (!Settings::IgnoreGamelist())
-			parseGamelist(this, fileMap);		
-		
-		if (Settings::RemoveMultiDiskContent())
-			removeMultiDiskContent(fileMap);
+				if (mHidden && !Settings::HiddenSystemsShowGames())
+					return;
+			}
+
+			if (!Settings::IgnoreGamelist())
+				parseGamelist(this, fileMap);
+
+			if (Settings::RemoveMultiDiskContent())
+				removeMultiDiskContent(fileMap);
+
+			GamelistCache::save(this, folders);
+		}
 	}
 	else
 	{
@@ -121,6 +132,119 @@ SystemData::~SystemData()
 		delete mFilterIndex;
 }
 
+FileData* SystemData::getFileByPath(const std::string& path)
+{
+	auto it = mPathIndex.find(path);
+	if (it != mPathIndex.cend())
+		return it->second.front().file;
+
+	return nullptr;
+}
+
+FileData* SystemData::findInPathIndex(const std::function<bool(FileData*)>& predicate)
+{
+	for (auto& item : mPathIndex)
+		if (predicate(item.second.front().file))
+			return item.second.front().file;
+
+	return nullptr;
+}
+
+void SystemData::addToPathIndex(FileData* file)
+{
+	// The web api reads the path index from its own thread : changes are made under the lock
+	std::unique_lock<std::mutex> lock(mIdIndexLock);
+
+	auto& entries = mPathIndex[file->getPath()];
+	for (auto& entry : entries)
+	{
+		if (entry.file == file)
+		{
+			entry.count++;
+			return;
+		}
+	}
+
+	entries.push_back({ file, 1 });
+	if (entries.size() > 1)
+		return;
+
+	mChangeCount++;
+
+	if (mIdIndexBuilt && file->getType() == GAME)
+		mIdIndex[getFileId(file)] = file;
+}
+
+void SystemData::removeFromPathIndex(FileData* file)
+{
+	std::unique_lock<std::mutex> lock(mIdIndexLock);
+
+	auto it = mPathIndex.find(file->getPath());
+	if (it == mPathIndex.cend())
+		return;
+
+	auto& entries = it->second;
+
+	auto entry = std::find_if(entries.begin(), entries.end(), [file](const PathIndexEntry& item) { return item.file == file; });
+	if (entry == entries.end() || --entry->count > 0)
+		return;
+
+	bool indexed = (entry == entries.begin());
+	entries.erase(entry);
+
+	if (!indexed)
+		return;
+
+	mChangeCount++;
+
+	FileData* replacement = entries.size() > 0 ? entries.front().file : nullptr;
+	if (replacement == nullptr)
+		mPathIndex.erase(it);
+
+	if (!mIdIndexBuilt)
+		return;
+
+	// Same path, same id : the id now designates the replacement
+	std::string id = getFileId(file);
+
+	if (replacement != nullptr && replacement->getType() == GAME)
+		mIdIndex[id] = replacement;
+	else
+	{
+		auto idx = mIdIndex.find(id);
+		if (idx != mIdIndex.cend() && idx->second == file)
+			mIdIndex.erase(idx);
+	}
+}
+
+std::string SystemData::getFileId(FileData* file)
+{
+	MD5 md5;
+	md5.update(file->getPath().c_str(), file->getPath().size());
+	md5.finalize();
+	return md5.hexdigest();
+}
+
+FileData* SystemData::getFileById(const std::string& id)
+{
+	std::unique_lock<std::mutex> lock(mIdIndexLock);
+
+	if (!mIdIndexBuilt)
+	{
+		for (auto& item : mPathIndex)
+			if (item.second.front().file->getType() == GAME)
+				mIdIndex[getFileId(item.second.front().file)] = item.second.front().file;
+
+		mIdIndexBuilt = true;
+	}
+
+	auto it = mIdIndex.find(id);
+	if (it != mIdIndex.cend())
+		return it->second;
+
+	return nullptr;
+}
+
 void SystemData::removeMultiDiskContent(std::unordered_map<std::string, FileData*>& fileMap)
 {	
 	if (mEnvData == nullptr ||!(mEnvData->isValidExtension(".cue") || mEnvData->isValidExtension(".ccd") || mEnvData->isValidExtension(".gdi") || mEnvData->isValidExtension(".m3u")))
@@ -188,9 +312,105 @@ void SystemData::setIsGameSystemStatus()
 	mIsGameSystem = (mMetadata.name != "retropie" && mMetadata.name != "retrobat");
 }
 
-void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap)
+// Result of the listing of one directory. Entries keep the directory order so that the tree is built the same way whatever the scanning threads
+struct SystemData::FolderScan
 {
-	const std::string& folderPath = folder->getPath();
+	struct Entry
+	{
+		Entry(FileData* _game) : game(_game), folder(nullptr) { }
+		Entry(FolderScan* _folder) : game(nullptr), folder(_folder) { }
+
+		FileData*	game;
+		FolderScan* folder;
+	};
+
+	FolderScan(const std::string& _path) : path(_path), time(0), isDirectory(false) { }
+
+	~FolderScan()
+	{
+		for (auto& entry : entries)
+		{
+			if (entry.game != nullptr)
+				delete entry.game;
+
+			if (entry.folder != nullptr)
+				delete entry.folder;
+		}
+	}
+
+	std::string path;
+	time_t		time;
+	bool		isDirectory;
+
+	std::vector<Entry> entries;
+};
+
+struct SystemData::FolderScanContext
+{
+	FolderScanContext() : showHidden(false), preloadMedias(false), recordTimes(false), group(nullptr) { }
+
+	bool showHidden;
+	bool preloadMedias;
+	bool recordTimes;
+
+	Utils::TaskGroup* group;
+};
+
+// Minimal count of sub directories in the root folder before the scan is spread on several threads
+#define THREADED_SCAN_MIN_FOLDERS 4
+
+void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap, GamelistCache::FolderStates* folders)
+{
+	StopWatch stopWatch("populateFolder - " + getName() + " :", LogDebug);
+
+	FolderScanContext context;
+	context.showHidden = Settings::ShowHiddenFiles();
+	context.preloadMedias = Settings::PreloadMedias();
+	context.recordTimes = (folders != nullptr);
+
+	auto shv = Settings::getInstance()->getString(getName() + ".ShowHiddenFiles");
+	if (shv == "1") context.showHidden = true;
+	else if (shv == "0") context.showHidden = false;
+
+	FolderScan scan(folder->getPath());
+	scanFolder(&scan, &context);
+
+	// Folder per game trees : scan the sub directories in parallel
+	int subFolders = 0;
+	for (auto& entry : scan.entries)
+		if (entry.folder != nullptr)
+			subFolders++;
+
+	if (subFolders >= THREADED_SCAN_MIN_FOLDERS && std::thread::hardware_concurrency() > 1 && Settings::ThreadedLoading())
+	{
+		Utils::TaskGroup group(Utils::TASK_UI);
+		context.group = &group;
+
+		for (auto& entry : scan.entries)
+			if (entry.folder != nullptr)
+				queueFolderScan(entry.folder, &context);
+
+		// Sub directories are queued by the workers themselves in the same group : waiting for it covers all of them
+		group.wait();
+	}
+	else
+	{
+		for (auto& entry : scan.entries)
+			if (entry.folder != nullptr)
+				scanFolder(entry.folder, &context, true);
+	}
+
+	populateFolder(folder, &scan, fileMap, folders);
+}
+
+void SystemData::queueFolderScan(FolderScan* scan, FolderScanContext* context)
+{
+	context->group->run([this, scan, context] { scanFolder(scan, context, true); });
+}
+
+void SystemData::scanFolder(FolderScan* scan, FolderScanContext* context, bool recursive)
+{
+	const std::string& folderPath = scan->path;
 
 	if(!Utils::FileSystem::isDirectory(folderPath))
 		return;
@@ -207,15 +427,15 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		}
 	}
 	*/
+	scan->isDirectory = true;
+
+	// Any file added or removed in a scanned folder changes its modification time : keep them to validate the gamelist cache
+	if (context->recordTimes)
+		scan->time = Utils::FileSystem::getFileModificationDate(folderPath).getTime();
+
 	std::string filePath;
 	std::string extension;
 	bool isGame;
-	bool showHidden = Settings::ShowHiddenFiles();
-	bool preloadMedias = Settings::PreloadMedias();
-
-	auto shv = Settings::getInstance()->getString(getName() + ".ShowHiddenFiles");
-	if (shv == "1") showHidden = true;
-	else if (shv == "0") showHidden = false;
 
 	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirectoryFiles(folderPath);
 	for (auto fileInfo : dirContent)
@@ -223,7 +443,7 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		filePath = fileInfo.path;
 
 		// skip hidden files and folders
-		if(!showHidden && fileInfo.hidden)
+		if(!context->showHidden && fileInfo.hidden)
 			continue;
 
 		//this is a little complicated because we allow a list of extensions to be defined (delimited with a space)
@@ -241,10 +461,11 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			// preventing new arcade assets to be added
 			if(!newGame->isArcadeAsset())
 			{
-				folder->addChild(newGame);
-				fileMap[filePath] = newGame;
+				scan->entries.push_back(FolderScan::Entry(newGame));
 				isGame = true;
 			}
+			else
+				delete newGame;
 		}
 
 		//add directories that also do not match an extension as folders
@@ -256,7 +477,7 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			if (fn == "artwork")
 				continue;
 
-			if (preloadMedias && (!mHidden || Settings::HiddenSystemsShowGames()))
+			if (context->preloadMedias && (!mHidden || Settings::HiddenSystemsShowGames()))
 			{
 				// Recurse list files in medias folder, just to let OS build filesystem cache 
 				if (fn == "media" || fn == "medias")
@@ -281,20 +502,51 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			if (mMetadata.name == "wiiu" && (fn == "content" || fn == "meta"))
 				continue;
 
-			FolderData* newFolder = new FolderData(filePath, this);
-			populateFolder(newFolder, fileMap);
+			FolderScan* subFolder = new FolderScan(filePath);
+			scan->entries.push_back(FolderScan::Entry(subFolder));
+
+			if (!recursive)
+				continue;
+
+			if (context->group != nullptr)
+				queueFolderScan(subFolder, context);
+			else
+				scanFolder(subFolder, context, true);
+		}
+	}
+}
+
+void SystemData::populateFolder(FolderData* folder, FolderScan* scan, std::unordered_map<std::string, FileData*>& fileMap, GamelistCache::FolderStates* folders)
+{
+	if (!scan->isDirectory)
+		return;
+
+	if (folders != nullptr)
+		folders->push_back(GamelistCache::FolderState(scan->path, scan->time));
+
+	for (auto& entry : scan->entries)
+	{
+		if (entry.game != nullptr)
+		{
+			folder->addChild(entry.game);
+			fileMap[entry.game->getPath()] = entry.game;
+			entry.game = nullptr;
+			continue;
+		}
+
+		FolderData* newFolder = new FolderData(entry.folder->path, this);
+		populateFolder(newFolder, entry.folder, fileMap, folders);
 
-			//ignore folders that do not contain games
-			if(newFolder->getChildren().size() == 0)
-				delete newFolder;
-			else 
+		//ignore folders that do not contain games
+		if(newFolder->getChildren().size() == 0)
+			delete newFolder;
+		else 
+		{
+			const std::string& key = newFolder->getPath();
+			if (fileMap.find(key) == fileMap.end())
 			{
-				const std::string& key = newFolder->getPath();
-				if (fileMap.find(key) == fileMap.end())
-				{
-					folder->addChild(newFolder);
-					fileMap[key] = newFolder;
-				}
+				folder->addChild(newFolder);
+				fileMap[key] = newFolder;
 			}
 		}
 	}
@@ -748,7 +1000,7 @@ bool SystemData::loadConfig(Window* window)
 		return false;
 	}
 
-	Utils::FileSystem::FileSystemCacheActivator fsc;
+	Utils::FileSystem::FileSystemCacheActivator fsc(true);
 
 	CustomFeatures::loadEsFeaturesFile();
 
@@ -756,28 +1008,28 @@ bool SystemData::loadConfig(Window* window)
 
 	typedef SystemData* SystemDataPtr;
 
-	ThreadPool* pThreadPool = NULL;
+	TaskGroup* pLoadGroup = NULL;
 	SystemDataPtr* systems = NULL;
 
 	// Allow threaded loading only if processor threads > 1 so it does not apply on machines like Pi0.
 	if (std::thread::hardware_concurrency() > 1 && Settings::ThreadedLoading())
 	{
-		pThreadPool = new ThreadPool();
+		pLoadGroup = new TaskGroup(TASK_UI);
 
 		systems = new SystemDataPtr[systemCount];
 		for (int i = 0; i < systemCount; i++)
 			systems[i] = nullptr;
 
-		pThreadPool->queueWorkItem([] { CollectionSystemManager::get()->loadCollectionSystems(); });
+		pLoadGroup->run([] { CollectionSystemManager::get()->loadCollectionSystems(); });
 	}
 
 	int processedSystem = 0;
 
 	for (pugi::xml_node system = systemList.child("system"); system; system = system.next_sibling("system"))
 	{
-		if (pThreadPool != NULL)
+		if (pLoadGroup != NULL)
 		{
-			pThreadPool->queueWorkItem([system, currentSystem, systems, &processedSystem]
+			pLoadGroup->run([system, currentSystem, systems, &processedSystem]
 			{
 				systems[currentSystem] = loadSystem(system);
 				processedSystem++;
@@ -800,11 +1052,11 @@ bool SystemData::loadConfig(Window* window)
 		currentSystem++;
 	}
 
-	if (pThreadPool != NULL)
+	if (pLoadGroup != NULL)
 	{
 		if (window != NULL)
 		{
-			pThreadPool->wait([window, &processedSystem, systemCount, &systemsNames]
+			pLoadGroup->wait([window, &processedSystem, systemCount, &systemsNames]
 			{
 				int px = processedSystem - 1;
 				if (px >= 0 && px < systemsNames.size())
@@ -812,7 +1064,7 @@ bool SystemData::loadConfig(Window* window)
 			}, 50);
 		}
 		else
-			pThreadPool->wait();
+			pLoadGroup->wait();
 
 		for (int i = 0; i < systemCount; i++)
 		{
@@ -822,7 +1074,7 @@ bool SystemData::loadConfig(Window* window)
 		}
 
 		delete[] systems;
-		delete pThreadPool;
+		delete pLoadGroup;
 
 		if (window != NULL)
 			window->renderSplashScreen(_("Collections"), systemCount == 0 ? 0 : currentSystem / systemCount);
@@ -855,6 +1107,8 @@ bool SystemData::loadConfig(Window* window)
 		}
 	}
 
+	ScreenSaverMediaCatalog::rebuild(window);
+
 	if (window != nullptr && !ThreadedHasher::isRunning())
 	{
 		int checkIndex = 0;
@@ -1113,6 +1367,8 @@ void SystemData::deleteSystems()
 {
 	bool saveOnExit = !Settings::IgnoreGamelist() && Settings::SaveGamelistsOnExit;
 
+	ScreenSaverMediaCatalog::clear();
+
 	for (unsigned int i = 0; i < sSystemVector.size(); i++)
 	{
 		SystemData* pData = sSystemVector.at(i);
@@ -4,7 +4,9 @@
 
 #include "PlatformId.h"
 #include <algorithm>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 #include <map>
@@ -16,6 +18,7 @@
 #include "KeyboardMapping.h"
 #include "math/Vector2f.h"
 #include "CustomFeatures.h"
+#include "GamelistCache.h"
 #include "utils/VectorEx.h"
 
 class FileData;
@@ -133,6 +136,19 @@ public:
 		if (mFilterIndex != nullptr) mFilterIndex->addToIndex(game);
 	};
 
+	// Path index of the FileData attached to the root folder tree, maintained by FolderData::addChild/removeChild
+	FileData* getFileByPath(const std::string& path);
+	FileData* findInPathIndex(const std::function<bool(FileData*)>& predicate);
+	void addToPathIndex(FileData* file);
+	void removeFromPathIndex(FileData* file);
+
+	// Games by id (MD5 of their path) for the web api. Built at the first lookup, then kept up to date with the path index
+	FileData* getFileById(const std::string& id);
+	static std::string getFileId(FileData* file);
+
+	// Incremented when files are added to or removed from the path index
+	unsigned int getChangeCount() { return mChangeCount; }
+
 	void resetFilters() {
 		if (mFilterIndex != nullptr) mFilterIndex->resetFilters();
 	};
@@ -225,7 +241,13 @@ private:
 	SystemEnvironmentData* mEnvData;
 	std::shared_ptr<ThemeData> mTheme;
 
-	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap);
+	struct FolderScan;
+	struct FolderScanContext;
+
+	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap, GamelistCache::FolderStates* folders = nullptr);
+	void populateFolder(FolderData* folder, FolderScan* scan, std::unordered_map<std::string, FileData*>& fileMap, GamelistCache::FolderStates* folders);
+	void scanFolder(FolderScan* scan, FolderScanContext* context, bool recursive = false);
+	void queueFolderScan(FolderScan* scan, FolderScanContext* context);
 	void indexAllGameFilters(const FolderData* folder);
 	void setIsGameSystemStatus();
 	void removeMultiDiskContent(std::unordered_map<std::string, FileData*>& fileMap);
@@ -237,6 +259,22 @@ private:
 
 	FolderData* mRootFolder;
 
+	// Same FileData can be referenced by a real folder & a virtual folder : keep a reference count.
+	// Different FileData may share a path : the first one is indexed, the next one replaces it when it's removed.
+	struct PathIndexEntry
+	{
+		FileData*	file;
+		int			count;
+	};
+
+	std::unordered_map<std::string, std::vector<PathIndexEntry>> mPathIndex;
+	unsigned int mChangeCount;
+
+	// Guards mIdIndex & mIdIndexBuilt, and the changes of mPathIndex, which getFileById reads from the web api thread
+	std::mutex mIdIndexLock;
+	std::unordered_map<std::string, FileData*> mIdIndex;
+	bool mIdIndexBuilt;
+
 	std::vector<EmulatorData> mEmulators;
 	
 	unsigned int mSortId;
@@ -16,6 +16,7 @@
 #include "SystemData.h"
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
+#include <algorithm>
 #include <unordered_map>
 #include <time.h>
 #include "AudioManager.h"
@@ -24,23 +25,22 @@
 #include "ImageIO.h"
 #include "utils/Randomizer.h"
 #include "Paths.h"
+#include "ScreenSaverMediaCatalog.h"
 
 #define FADE_TIME 			500
+#define PRELOAD_WAIT_TIME	2000
 
 SystemScreenSaver::SystemScreenSaver(Window* window) :
 	mVideoScreensaver(NULL),
 	mImageScreensaver(NULL),
 	mWindow(window),
-	mVideosCounted(false),
-	mVideoCount(0),
-	mImagesCounted(false),
-	mImageCount(0),
 	mState(STATE_INACTIVE),
 	mOpacity(0.0f),
 	mTimer(0),
 	mSystemName(""),
 	mGameName(""),
 	mCurrentGame(NULL),
+	mNextVideoGame(NULL),
 	mLoadingNext(false)
 {
 
@@ -97,7 +97,15 @@ void SystemScreenSaver::startScreenSaver()
 			mOpacity = 0.0f;
 			
 		std::string path;
-		if (Settings::getInstance()->getBool("SlideshowScreenSaverCustomVideoSource"))
+		if (!mNextVideoPath.empty())
+		{
+			path = mNextVideoPath;
+			mCurrentGame = mNextVideoGame;
+
+			mNextVideoPath = "";
+			mNextVideoGame = NULL;
+		}
+		else if (Settings::getInstance()->getBool("SlideshowScreenSaverCustomVideoSource"))
 		{
 			path = pickRandomCustomImage(true);
 			// Custom images are not tied to the game list
@@ -127,6 +135,8 @@ void SystemScreenSaver::startScreenSaver()
 			if (mCurrentGame)
 				Scripting::fireEvent("game-selected", mCurrentGame->getSystem()->getName(), mCurrentGame->getPath(), mCurrentGame->getName());
 
+			preloadNextVideo();
+
 			PowerSaver::runningScreenSaver(true);
 			mTimer = 0;
 			return;
@@ -149,28 +159,34 @@ void SystemScreenSaver::startScreenSaver()
 		else
 			mOpacity = 0.0f;
 
-		// Load a random image
-		std::string path;
-		if (Settings::getInstance()->getBool("SlideshowScreenSaverCustomImageSource"))
+		if (mPreloadedSlides.size() > 0)
 		{
-			path = pickRandomCustomImage();
-			// Custom images are not tied to the game list
-			mCurrentGame = NULL;
+			mImageScreensaver = mPreloadedSlides.front();
+			mPreloadedSlides.pop_front();
+
+			mCurrentGame = mImageScreensaver->getGame();
 		}
 		else
-			path = pickRandomGameListImage();
-
-		if (!path.empty() && Utils::FileSystem::exists(path))
 		{
-			LOG(LogDebug) << "ImageScreenSaver::startScreenSaver " << path.c_str();
+			// Load a random image
+			std::string path = pickSlideshowImage();
+			if (!path.empty() && Utils::FileSystem::exists(path))
+			{
+				LOG(LogDebug) << "ImageScreenSaver::startScreenSaver " << path.c_str();
 
-			mImageScreensaver = std::make_shared<ImageScreenSaver>(mWindow);
-			mImageScreensaver->setGame(mCurrentGame);
-			mImageScreensaver->setImage(path);
+				mImageScreensaver = std::make_shared<ImageScreenSaver>(mWindow);
+				mImageScreensaver->setGame(mCurrentGame);
+				mImageScreensaver->setImage(path);
+			}
+		}
 
+		if (mImageScreensaver != nullptr)
+		{
 			if (mCurrentGame)
 				Scripting::fireEvent("game-selected", mCurrentGame->getSystem()->getName(), mCurrentGame->getPath(), mCurrentGame->getName());
 
+			preloadNextSlides();
+
 			PowerSaver::runningScreenSaver(true);
 			mTimer = 0;
 			return;
@@ -195,6 +211,9 @@ void SystemScreenSaver::stopScreenSaver()
 	// so that we stop the background audio next time, unless we're restarting the screensaver
 	mLoadingNext = false;
 
+	if (isExitingScreenSaver)
+		clearPreloads();
+
 	mVideoScreensaver = nullptr;
 	mImageScreensaver = nullptr;
 
@@ -269,133 +288,123 @@ void SystemScreenSaver::renderScreenSaver()
 	}
 }
 
-unsigned long SystemScreenSaver::countGameListNodes(const char *nodeName)
+std::string SystemScreenSaver::pickGameListNode(const char *nodeName)
 {
-	unsigned long nodeCount = 0;
-	std::vector<SystemData*>::const_iterator it;
-	for (it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
-	{
-		// We only want nodes from game systems that are not collections
-		if (!(*it)->isGameSystem() || (*it)->isCollection())
-			continue;
+	mCurrentGame = NULL;
 
-		FolderData* rootFileData = (*it)->getRootFolder();
+	ScreenSaverMediaCatalog::Entry entry;
+	if (!ScreenSaverMediaCatalog::pickRandom(strcmp(nodeName, "video") == 0 ? ScreenSaverMediaCatalog::VIDEO : ScreenSaverMediaCatalog::IMAGE, entry))
+		return "";
 
-		std::vector<FileData*> allFiles = rootFileData->getFilesRecursive(GAME, true);
-		std::vector<FileData*>::const_iterator itf;  // declare an iterator to a vector of strings
+	mSystemName = entry.file->getSystem()->getFullName();
+	mGameName = entry.file->getName();
+	mCurrentGame = entry.file;
 
-		for (itf=allFiles.cbegin() ; itf < allFiles.cend(); itf++) 
+#ifdef _RPI_
+	if (Settings::getInstance()->getBool("ScreenSaverOmxPlayer"))
+	{
+		if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never" && strcmp(nodeName, "video") == 0)
 		{
-			if ((strcmp(nodeName, "video") == 0 && (*itf)->getVideoPath() != "") ||
-				(strcmp(nodeName, "image") == 0 && (*itf)->getImagePath() != ""))
-			{
-				nodeCount++;
-			}
+			std::string path = getTitleFolder();
+			if (!Utils::FileSystem::exists(path))
+				Utils::FileSystem::createDirectory(path);
+
+			writeSubtitle(mGameName.c_str(), mSystemName.c_str(), (Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
 		}
 	}
-	return nodeCount;
+#endif
+
+	return entry.path;
 }
 
-void SystemScreenSaver::countVideos()
+std::string SystemScreenSaver::pickRandomVideo()
 {
-	if (!mVideosCounted)
-	{
-		mVideoCount = countGameListNodes("video");
-		mVideosCounted = true;
-	}
+	return pickGameListNode("video");
 }
 
-void SystemScreenSaver::countImages()
+std::string SystemScreenSaver::pickRandomGameListImage()
 {
-	if (!mImagesCounted)
+	return pickGameListNode("image");
+}
+
+std::string SystemScreenSaver::pickSlideshowImage()
+{
+	if (Settings::getInstance()->getBool("SlideshowScreenSaverCustomImageSource"))
 	{
-		mImageCount = countGameListNodes("image");
-		mImagesCounted = true;
+		// Custom images are not tied to the game list
+		mCurrentGame = NULL;
+		return pickRandomCustomImage();
 	}
+
+	return pickRandomGameListImage();
 }
 
-std::string SystemScreenSaver::pickGameListNode(unsigned long index, const char *nodeName)
+// The next slide is always loaded ahead, the following ones while their textures fit in ScreenSaverPreloadVRAM
+void SystemScreenSaver::preloadNextSlides()
 {
-	std::string path;
-
-	std::vector<SystemData*>::const_iterator it;
-	for (it = SystemData::sSystemVector.cbegin(); it != SystemData::sSystemVector.cend(); ++it)
-	{
-		// We only want nodes from game systems that are not collections
-		if (!(*it)->isGameSystem() || (*it)->isCollection())
-			continue;
+	int count = Settings::getInstance()->getInt("ScreenSaverPreloadCount");
+	size_t budget = (size_t)std::max(0, Settings::getInstance()->getInt("ScreenSaverPreloadVRAM")) * 1024 * 1024;
 
-		FolderData* rootFileData = (*it)->getRootFolder();
+	size_t usage = 0;
+	for (auto slide : mPreloadedSlides)
+		usage += slide->getVRAMUsage();
 
-		FileType type = GAME;
-		std::vector<FileData*> allFiles = rootFileData->getFilesRecursive(type, true);
-		std::vector<FileData*>::const_iterator itf;  // declare an iterator to a vector of strings
+	FileData* currentGame = mCurrentGame;
 
-		for(itf=allFiles.cbegin() ; itf < allFiles.cend(); itf++) 
-		{
-			if ((strcmp(nodeName, "video") == 0 && (*itf)->getVideoPath() != "") ||
-				(strcmp(nodeName, "image") == 0 && (*itf)->getImagePath() != ""))
-			{
-				if (index-- <= 0)
-				{
-					// We have it
-					if (strcmp(nodeName, "video") == 0)
-						path = (*itf)->getVideoPath();
-					else if (strcmp(nodeName, "image") == 0)
-						path = (*itf)->getImagePath();
+	while ((int)mPreloadedSlides.size() < count && (mPreloadedSlides.size() == 0 || usage < budget))
+	{
+		std::string path = pickSlideshowImage();
+		if (path.empty() || !Utils::FileSystem::exists(path))
+			break;
 
-					if (!Utils::FileSystem::exists(path))
-						continue;
+		auto slide = std::make_shared<ImageScreenSaver>(mWindow);
+		slide->setGame(mCurrentGame);
+		slide->setImage(path, true);
 
-					mSystemName = (*it)->getFullName();
-					mGameName = (*itf)->getName();
-					mCurrentGame = (*itf);
+		usage += slide->getVRAMUsage();
+		mPreloadedSlides.push_back(slide);
+	}
 
+	mCurrentGame = currentGame;
+}
 
+void SystemScreenSaver::preloadNextVideo()
+{
 #ifdef _RPI_
-					if (Settings::getInstance()->getBool("ScreenSaverOmxPlayer"))
-					{
-						if (Settings::getInstance()->getString("ScreenSaverGameInfo") != "never" && strcmp(nodeName, "video") == 0)
-						{
-							std::string path = getTitleFolder();
-							if (!Utils::FileSystem::exists(path))
-								Utils::FileSystem::createDirectory(path);
-
-							writeSubtitle(mGameName.c_str(), mSystemName.c_str(), (Settings::getInstance()->getString("ScreenSaverGameInfo") == "always"));
-						}
-				}
+	if (Settings::getInstance()->getBool("ScreenSaverOmxPlayer"))
+		return;
 #endif
 
-					return path;
-				}
-			}
-		}
+	if (Settings::getInstance()->getInt("ScreenSaverPreloadCount") <= 0)
+		return;
+
+	FileData* currentGame = mCurrentGame;
+
+	if (Settings::getInstance()->getBool("SlideshowScreenSaverCustomVideoSource"))
+	{
+		mNextVideoPath = pickRandomCustomImage(true);
+		mNextVideoGame = NULL;
+	}
+	else
+	{
+		mNextVideoPath = pickRandomVideo();
+		mNextVideoGame = mCurrentGame;
 	}
 
-	return "";
-}
+	mCurrentGame = currentGame;
 
-std::string SystemScreenSaver::pickRandomVideo()
-{
-	countVideos();
-	mCurrentGame = NULL;
-	if (mVideoCount == 0)
-		return "";
-		
-	int video = Randomizer::random(mVideoCount); // (int)(((float)rand() / float(RAND_MAX)) * (float)mVideoCount);
-	return pickGameListNode(video, "video");
+	if (!mNextVideoPath.empty())
+		VideoVlcComponent::preloadVideo(mNextVideoPath);
 }
 
-std::string SystemScreenSaver::pickRandomGameListImage()
+void SystemScreenSaver::clearPreloads()
 {
-	countImages();
-	mCurrentGame = NULL;
-	if (mImageCount == 0)
-		return "";
-	
-	//rand();
-	int image = Randomizer::random(mImageCount); // (int)(((float)rand() / float(RAND_MAX)) * (float)mImageCount);
-	return pickGameListNode(image, "image");
+	mPreloadedSlides.clear();
+
+	mNextVideoPath = "";
+	mNextVideoGame = NULL;
+
+	VideoVlcComponent::clearPreloadedVideos();
 }
 
 std::string SystemScreenSaver::pickRandomCustomImage(bool video)
@@ -475,7 +484,11 @@ void SystemScreenSaver::update(int deltaTime)
 	{
 		// Update the timer that swaps the videos
 		mTimer += deltaTime;
-		if (mTimer > mVideoChangeTime)
+
+		// Give the next slide a little more time to load rather than showing it while its texture is missing
+		bool waitNextSlide = mPreloadedSlides.size() > 0 && !mPreloadedSlides.front()->isLoaded() && mTimer < mVideoChangeTime + PRELOAD_WAIT_TIME;
+
+		if (mTimer > mVideoChangeTime && !waitNextSlide)
 			nextVideo();
 	}
 
@@ -522,6 +535,7 @@ void SystemScreenSaver::launchGame()
 GameScreenSaverBase::GameScreenSaverBase(Window* window) : GuiComponent(window),
 	mViewport(0, 0, Renderer::getScreenWidth(), Renderer::getScreenHeight())
 {
+	mGame = nullptr;
 	mDecoration = nullptr;
 	mMarquee = nullptr;
 	mLabelGame = nullptr;
@@ -562,6 +576,8 @@ GameScreenSaverBase::~GameScreenSaverBase()
 
 void GameScreenSaverBase::setGame(FileData* game)
 {	
+	mGame = game;
+
 	if (mLabelGame != nullptr)
 	{
 		delete mLabelGame;
@@ -780,6 +796,7 @@ void GameScreenSaverBase::setOpacity(unsigned char opacity)
 ImageScreenSaver::ImageScreenSaver(Window* window) : GameScreenSaverBase(window)
 {
 	mImage = nullptr;
+	mVRAMUsage = 0;
 }
 
 ImageScreenSaver::~ImageScreenSaver()
@@ -788,21 +805,37 @@ ImageScreenSaver::~ImageScreenSaver()
 		delete mImage;
 }
 
-void ImageScreenSaver::setImage(const std::string path)
+void ImageScreenSaver::setImage(const std::string path, bool preload)
 {
+	bool stretch = Settings::getInstance()->getBool("SlideshowScreenSaverStretch");
+
 	if (mImage == nullptr)
 	{
-		mImage = new ImageComponent(mWindow, true);
+		// Preloaded images are loaded by the texture loader instead of blocking the UI
+		mImage = new ImageComponent(mWindow, !preload);
 		mImage->setOrigin(0.5f, 0.5f);
 		mImage->setPosition(mViewport.x + mViewport.w / 2.0f, mViewport.y + mViewport.h / 2.0f);
 
-		if (Settings::getInstance()->getBool("SlideshowScreenSaverStretch"))
+		if (stretch)
 			mImage->setMinSize((float)mViewport.w, (float)mViewport.h);
 		else
 			mImage->setMaxSize((float)mViewport.w, (float)mViewport.h);
 	}
 
-	mImage->setImage(path);
+	mImage->setImage(path, false, MaxSizeInfo((float)mViewport.w, (float)mViewport.h, stretch));
+
+	// Textures are RGBA, scaled down to the screen
+	mVRAMUsage = (size_t)mViewport.w * mViewport.h * 4;
+
+	unsigned int width = 0, height = 0;
+	if (ImageIO::loadImageSize(path.c_str(), &width, &height) && width > 0 && height > 0)
+	{
+		Vector2i size = ImageIO::adjustPictureSize(Vector2i(width, height), Vector2i(mViewport.w, mViewport.h), stretch);
+		mVRAMUsage = (size_t)std::min((int)width, size.x()) * std::min((int)height, size.y()) * 4;
+	}
+
+	if (preload)
+		mImage->preload();
 }
 
 bool ImageScreenSaver::hasImage()
@@ -810,6 +843,11 @@ bool ImageScreenSaver::hasImage()
 	return mImage != nullptr && mImage->hasImage();
 }
 
+bool ImageScreenSaver::isLoaded()
+{
+	return mImage != nullptr && mImage->isLoaded();
+}
+
 void ImageScreenSaver::render(const Transform4x4f& transform)
 {
 	if (mImage)
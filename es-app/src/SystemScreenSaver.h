@@ -5,6 +5,7 @@
 #include "Window.h"
 #include "GuiComponent.h"
 #include "renderers/Renderer.h"
+#include <deque>
 
 class ImageComponent;
 class Sound;
@@ -18,12 +19,15 @@ public:
 	~GameScreenSaverBase();
 
 	virtual void setGame(FileData* mCurrentGame);
+	FileData* getGame() { return mGame; }
 
 	void render(const Transform4x4f& transform) override;
 
 	void setOpacity(unsigned char opacity) override;
 
 protected:
+	FileData*			mGame;
+
 	ImageComponent*		mMarquee;
 	TextComponent*		mLabelGame;
 	TextComponent*		mLabelSystem;
@@ -39,13 +43,17 @@ public:
 	ImageScreenSaver(Window* window);
 	~ImageScreenSaver();
 
-	void setImage(const std::string path);
+	void setImage(const std::string path, bool preload = false);
 	bool hasImage();
+	bool isLoaded();
+
+	size_t getVRAMUsage() { return mVRAMUsage; }
 
 	void render(const Transform4x4f& transform) override;	
 
 private:
 	ImageComponent*		mImage;	
+	size_t				mVRAMUsage;
 };
 
 class VideoScreenSaver : public GameScreenSaverBase
@@ -82,17 +90,18 @@ public:
 
 	virtual FileData* getCurrentGame();
 	virtual void launchGame();
-	inline virtual void resetCounts() { mVideosCounted = false; mImagesCounted = false; };
+	inline virtual void resetCounts() { }; // ScreenSaverMediaCatalog follows the changes of the games
 
 private:
-	unsigned long countGameListNodes(const char *nodeName);
-	void countVideos();
-	void countImages();
-
-	std::string pickGameListNode(unsigned long index, const char *nodeName);
+	std::string pickGameListNode(const char *nodeName);
 	std::string pickRandomVideo();
 	std::string pickRandomGameListImage();
 	std::string pickRandomCustomImage(bool video = false);
+	std::string pickSlideshowImage();
+
+	void preloadNextSlides();
+	void preloadNextVideo();
+	void clearPreloads();
 
 	enum STATE {
 		STATE_INACTIVE,
@@ -102,17 +111,19 @@ private:
 	};
 
 private:
-	bool			mVideosCounted;
-	unsigned long		mVideoCount;	
-	bool			mImagesCounted;
-	unsigned long		mImageCount;
-
 	//VideoComponent*		mVideoScreensaver;
 	std::shared_ptr<VideoScreenSaver>		mVideoScreensaver;
 
 	std::shared_ptr<ImageScreenSaver>		mFadingImageScreensaver;
 	std::shared_ptr<ImageScreenSaver>		mImageScreensaver;
 
+	// Next slides, loading in the background while the current one is shown
+	std::deque<std::shared_ptr<ImageScreenSaver>>	mPreloadedSlides;
+
+	// Next video, opened in the background by VideoVlcComponent::preloadVideo
+	std::string		mNextVideoPath;
+	FileData*		mNextVideoGame;
+
 	Window*			mWindow;
 	STATE			mState;
 	float			mOpacity;
@@ -9,10 +9,13 @@
 #include "SystemData.h"
 #include "FileData.h"
 #include "ApiSystem.h"
+#include "HashDatabase.h"
 #include "utils/StringUtil.h"
 #include "Log.h"
 #include <unordered_set>
+#include <unordered_map>
 #include <queue>
+#include <condition_variable>
 
 #include "LocaleES.h"
 
@@ -22,6 +25,7 @@ ThreadedHasher* ThreadedHasher::mInstance = nullptr;
 bool ThreadedHasher::mPaused = false;
 
 static std::mutex mLoaderLock;
+static std::condition_variable mLoaderCondition;
 
 ThreadedHasher::ThreadedHasher(Window* window, HasherType type, std::queue<FileData*> searchQueue, bool forceAllGames)
 	: mWindow(window)
@@ -30,8 +34,8 @@ ThreadedHasher::ThreadedHasher(Window* window, HasherType type, std::queue<FileD
 	mExit = false;
 	mType = type;
 
-	mSearchQueue = searchQueue;
-	mTotal = mSearchQueue.size();
+	mTotal = searchQueue.size();
+	mNextDevice = 0;
 
 	mWndNotification = mWindow->createAsyncNotificationComponent();
 
@@ -39,8 +43,8 @@ ThreadedHasher::ThreadedHasher(Window* window, HasherType type, std::queue<FileD
 	{
 		mCheevosHashes = RetroAchievements::getCheevosHashes();
 		if (mCheevosHashes.size() == 0)
-			while (!mSearchQueue.empty())
-				mSearchQueue.pop();
+			while (!searchQueue.empty())
+				searchQueue.pop();
 	}
 
 	if (mType == HASH_CHEEVOS_MD5)
@@ -48,10 +52,51 @@ ThreadedHasher::ThreadedHasher(Window* window, HasherType type, std::queue<FileD
 	else 
 		mWndNotification->updateTitle(ICONINDEX + _("SEARCHING NETPLAY GAMES"));
 
-	int num_threads = std::thread::hardware_concurrency() / 2;
+	mRemaining = searchQueue.size();
+
+	// Games are grouped by the device of their system
+	std::map<SystemData*, int> systemDevices;
+	std::unordered_map<unsigned long long, int> deviceIndexes;
+
+	while (!searchQueue.empty())
+	{
+		FileData* game = searchQueue.front();
+		searchQueue.pop();
+
+		SystemData* system = game->getSourceFileData()->getSystem();
+
+		auto it = systemDevices.find(system);
+		if (it == systemDevices.cend())
+		{
+			unsigned long long device = HashDatabase::getDevice(system->getRootFolder()->getPath());
+
+			auto idx = deviceIndexes.find(device);
+			if (idx == deviceIndexes.cend())
+			{
+				DeviceQueue queue;
+				queue.maxJobs = HashDatabase::getIoConcurrency(device);
+				queue.jobs = 0;
+				mDevices.push_back(queue);
+
+				idx = deviceIndexes.insert(std::make_pair(device, (int)mDevices.size() - 1)).first;
+			}
+
+			it = systemDevices.insert(std::make_pair(system, idx->second)).first;
+		}
+
+		mDevices[it->second].games.push(game);
+	}
+
+	int num_threads = 0;
+	for (auto& device : mDevices)
+		num_threads += device.maxJobs;
+
+	num_threads = Math::min(num_threads, Math::max(1, (int) std::thread::hardware_concurrency() / 2));
 	if (num_threads == 0)
 		num_threads = 1;
 
+	LOG(LogInfo) << "ThreadedHasher : " << mRemaining << " games on " << mDevices.size() << " devices, " << num_threads << " threads";
+
 	mThreadCount = num_threads;
 	for (size_t i = 0; i < num_threads; i++)
 		mThreads.push_back(new std::thread(&ThreadedHasher::run, this));
@@ -75,8 +120,8 @@ std::string ThreadedHasher::formatGameName(FileData* game)
 
 void ThreadedHasher::updateUI(const std::string label)
 {
-	std::string idx = std::to_string(mTotal + 1 - mSearchQueue.size()) + "/" + std::to_string(mTotal);
-	int percent = 100 - (mSearchQueue.size() * 100 / mTotal);
+	std::string idx = std::to_string(mTotal + 1 - mRemaining) + "/" + std::to_string(mTotal);
+	int percent = 100 - (mRemaining * 100 / mTotal);
 		
 	mWndNotification->updateText(label);
 	mWndNotification->updatePercent(percent);	
@@ -89,17 +134,26 @@ void ThreadedHasher::run()
 	bool cheevos = ((mType & HASH_CHEEVOS_MD5) == HASH_CHEEVOS_MD5);
 	bool netplay = ((mType & HASH_NETPLAY_CRC) == HASH_NETPLAY_CRC);
 
-	while (!mExit && !mSearchQueue.empty())
+	while (!mExit && mRemaining > 0)
 	{
-		FileData* game = mSearchQueue.front();
+		DeviceQueue* device = getNextDevice();
+		if (device == nullptr)
+		{
+			// Every device with games left is busy : wait for a job to finish
+			mLoaderCondition.wait(lock);
+			continue;
+		}
+
+		FileData* game = device->games.front();
+		device->games.pop();
+		device->jobs++;
+		mRemaining--;
 
 		auto label = formatGameName(game);
 
 		LOG(LogDebug) << "Hashing " << formatGameName(game);
 		updateUI(label);
 
-		mSearchQueue.pop();
-
 		lock.unlock();
 
 		if (mPaused)
@@ -136,9 +190,13 @@ void ThreadedHasher::run()
 		}		
 
 		lock.lock();
+
+		device->jobs--;
+		mLoaderCondition.notify_all();
 	}
 
 	mThreadCount--;
+	mLoaderCondition.notify_all();
 
 	if (mThreadCount == 0)
 	{
@@ -149,6 +207,21 @@ void ThreadedHasher::run()
 	}
 }
 
+ThreadedHasher::DeviceQueue* ThreadedHasher::getNextDevice()
+{
+	for (int i = 0; i < (int)mDevices.size(); i++)
+	{
+		DeviceQueue& device = mDevices[(mNextDevice + i) % mDevices.size()];
+		if (device.games.empty() || device.jobs >= device.maxJobs)
+			continue;
+
+		mNextDevice = (mNextDevice + i + 1) % mDevices.size();
+		return &device;
+	}
+
+	return nullptr;
+}
+
 bool ThreadedHasher::checkCloseIfRunning(Window* window)
 {
 	if (ThreadedHasher::mInstance != nullptr)
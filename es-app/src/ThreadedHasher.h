@@ -32,7 +32,19 @@ private:
 	void updateUI(const std::string label);
 	static std::string formatGameName(FileData* game);
 
-	std::queue<FileData*> mSearchQueue;
+	// Games are hashed in parallel on different devices, but only as many at a time on a device as it handles well
+	struct DeviceQueue
+	{
+		std::queue<FileData*> games;
+		int maxJobs;
+		int jobs;
+	};
+
+	DeviceQueue* getNextDevice();
+
+	std::vector<DeviceQueue> mDevices;
+	int mNextDevice;
+	int mRemaining;
 
 	Window* mWindow;
 	AsyncNotificationComponent* mWndNotification;
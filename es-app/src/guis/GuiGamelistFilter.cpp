@@ -97,6 +97,16 @@ void GuiGamelistFilter::addTextFilterToMenu()
 	mMenu.addRow(row);
 }
 
+// Number of games having the key, among the games kept by the other filters
+static std::string getCountLabel(const std::string& label, const std::map<std::string, int>& counts, const std::string& key)
+{
+	auto it = counts.find(key);
+	if (it == counts.cend())
+		return label;
+
+	return label + " (" + std::to_string(it->second) + ")";
+}
+
 void GuiGamelistFilter::addFiltersToMenu()
 {
 	std::vector<FilterDataDecl> decls = mFilterIndex->getFilterDataDecls();
@@ -119,6 +129,8 @@ void GuiGamelistFilter::addFiltersToMenu()
 
 		optionList = std::make_shared< OptionListComponent<std::string> >(mWindow, menuLabel, true);
 
+		std::map<std::string, int> counts = mFilterIndex->getFacetCounts(type);
+
 		if (it->type == GENRE_FILTER)
 		{
 			std::map<std::string, std::string> keyValues;
@@ -138,7 +150,7 @@ void GuiGamelistFilter::addFiltersToMenu()
 						label = "      " + Utils::String::trim(label.substr(split + 1));
 				}
 
-				optionList->add(label, key.second, mFilterIndex->isKeyBeingFilteredBy(key.second, type));
+				optionList->add(getCountLabel(label, counts, key.second), key.second, mFilterIndex->isKeyBeingFilteredBy(key.second, type));
 			}
 		}
 		else
@@ -146,11 +158,11 @@ void GuiGamelistFilter::addFiltersToMenu()
 			for (auto key : *allKeys)
 			{
 				if (key.first == "UNKNOWN")
-					optionList->add(_("Unknown"), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type));
+					optionList->add(getCountLabel(_("Unknown"), counts, key.first), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type));
 				else if (key.first == "TRUE")
-					optionList->add(_("YES"), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type));
+					optionList->add(getCountLabel(_("YES"), counts, key.first), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type));
 				else if (key.first == "FALSE")
-					optionList->add(_("NO"), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type));
+					optionList->add(getCountLabel(_("NO"), counts, key.first), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type));
 				else
 				{
 					std::string label = key.first;
@@ -167,7 +179,7 @@ void GuiGamelistFilter::addFiltersToMenu()
 						}
 					}
 
-					optionList->add(_(label.c_str()), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type), false);
+					optionList->add(getCountLabel(_(label.c_str()), counts, key.first), key.first, mFilterIndex->isKeyBeingFilteredBy(key.first, type), false);
 				}
 			}
 		}
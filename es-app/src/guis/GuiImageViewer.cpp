@@ -278,11 +278,11 @@ void GuiImageViewer::loadPdf(const std::string& imagePath)
 	
 	if (pages > INITIALPAGES)
 	{
-		mPdfThreads = new Utils::ThreadPool(1);
+		mPdfThreads = new Utils::TaskGroup(Utils::TASK_PREFETCH);
 
 		for (int i = INITIALPAGES; i < pages; i += PAGESPERTHREAD)
 		{
-			mPdfThreads->queueWorkItem([this, imagePath, window, i]
+			mPdfThreads->run([this, imagePath, window, i]
 			{
 				auto fl = ApiSystem::getInstance()->extractPdfImages(imagePath, i + 1, PAGESPERTHREAD);
 				if (fl.size() == 0 || !g_isGuiImageViewerRunning)
@@ -302,8 +302,6 @@ void GuiImageViewer::loadPdf(const std::string& imagePath)
 				});
 			});
 		}
-
-		mPdfThreads->start();
 	}
 	
 	window->pushGui(new GuiLoading<std::vector<std::string>>(window, _("Loading..."),
@@ -420,12 +418,12 @@ void GuiImageViewer::loadCbz(const std::string& imagePath)
 
 	if (pages > INITIALPAGES)
 	{
-		mPdfThreads = new Utils::ThreadPool(1);
+		mPdfThreads = new Utils::TaskGroup(Utils::TASK_PREFETCH);
 
 		for (int i = INITIALPAGES; i < pages; i += PAGESPERTHREAD)
 		{
 			auto fileToExtract = files[i];
-			mPdfThreads->queueWorkItem([this, imagePath, fileToExtract, window, i]
+			mPdfThreads->run([this, imagePath, fileToExtract, window, i]
 			{
 				auto localFile = _extractZipFile(imagePath, fileToExtract);
 				if (localFile.empty() || !g_isGuiImageViewerRunning)
@@ -441,8 +439,6 @@ void GuiImageViewer::loadCbz(const std::string& imagePath)
 				});
 			});
 		}
-
-		mPdfThreads->start();
 	}
 
 	window->pushGui(new GuiLoading<std::vector<std::string>>(window, _("Loading..."),
@@ -484,7 +480,8 @@ GuiImageViewer::~GuiImageViewer()
 
 	if (mPdfThreads != nullptr)
 	{
-		mPdfThreads->stop();
+		// Drops the pages which are not extracted yet & waits for the running ones
+		mPdfThreads->cancel();
 		delete mPdfThreads;
 	}
 
@@ -3,7 +3,7 @@
 #include "GuiComponent.h"
 #include "Window.h"
 #include "components/ImageGridComponent.h"
-#include "utils/ThreadPool.h"
+#include "utils/TaskScheduler.h"
 
 class ThemeData;
 class VideoComponent;
@@ -34,7 +34,7 @@ protected:
 	std::shared_ptr<ThemeData> mTheme;
 	std::string mPdf;
 
-	Utils::ThreadPool* mPdfThreads;
+	Utils::TaskGroup* mPdfThreads;
 };
 
 class GuiVideoViewer : public GuiComponent
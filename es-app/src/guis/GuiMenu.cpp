@@ -24,6 +24,10 @@
 #include "views/ViewController.h"
 #include "CollectionSystemManager.h"
 #include "EmulationStation.h"
+#include "GamelistCache.h"
+#include "HashDatabase.h"
+#include "resources/ThumbnailCache.h"
+#include "resources/VideoInfoCache.h"
 #include "Scripting.h"
 #include "SystemData.h"
 #include "VolumeControl.h"
@@ -551,6 +555,10 @@ void GuiMenu::openDeveloperSettings()
 	s->addEntry(_("CLEAR CACHES"), true, [this, s]
 	{
 		ImageIO::clearImageCache();
+		GamelistCache::clear();
+		ThumbnailCache::clear();
+		VideoInfoCache::clear();
+		HashDatabase::clear();
 
 		auto rootPath = Utils::FileSystem::getGenericPath(Paths::getUserEmulationStationPath());
 
@@ -31,6 +31,7 @@
 #include "ThreadedHasher.h"
 #include <FreeImage.h>
 #include "ImageIO.h"
+#include "resources/ThumbnailCache.h"
 #include "components/VideoVlcComponent.h"
 #include <csignal>
 #include "InputConfig.h"
@@ -698,6 +699,15 @@ int main(int argc, char* argv[])
 			deltaTime = 1000;
 
 		TRYCATCH("Window.update" ,window.update(deltaTime))	
+
+		if (!window.isRenderNeeded())
+		{
+			// The screen didn't change : keep the previous frame, and give up the CPU until the next frame is due or an event comes
+			SDL_WaitEventTimeout(NULL, 16);
+			Log::flush();
+			continue;
+		}
+
 		TRYCATCH("Window.render", window.render())
 
 #ifdef WIN32		
@@ -729,6 +739,7 @@ int main(int argc, char* argv[])
 	if (SystemData::hasDirtySystems())
 		window.renderSplashScreen(_("SAVING METADATAS. PLEASE WAIT..."));
 
+	ThumbnailCache::stop();
 	ImageIO::saveImageCache();
 	MameNames::deinit();
 	ViewController::saveState();
@@ -11,12 +11,15 @@
 #include <fstream>
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
+#include "math/Misc.h"
 #include <thread>
+#include <stdlib.h>
 #include <SDL_timer.h>
 #include "HfsDBScraper.h"
 
-#define OVERQUOTA_RETRY_DELAY 15000
-#define OVERQUOTA_RETRY_COUNT 5
+#define RETRY_DELAY		3000
+#define RETRY_MAX_DELAY	60000
+#define RETRY_COUNT		5
 
 std::vector<std::pair<std::string, Scraper*>> Scraper::scrapers
 {
@@ -35,6 +38,19 @@ std::vector<std::pair<std::string, Scraper*>> Scraper::scrapers
 	{ "ArcadeDB", new ArcadeDBScraper() }
 };
 
+// Requests over quota, or failing because of the network or the server, are sent again later
+static bool canRetry(HttpReq* request, HttpReq::Status status)
+{
+	return status == HttpReq::REQ_429_TOOMANYREQUESTS || request->isTransientError();
+}
+
+// Exponential backoff, with a random part so the requests failing together aren't sent again together
+static int getRetryDelay(int retryCount)
+{
+	int delay = Math::min(RETRY_DELAY << Math::min(retryCount - 1, 8), RETRY_MAX_DELAY);
+	return delay + rand() % (delay / 4 + 1);
+}
+
 std::string Scraper::getScraperName(Scraper* scraper)
 {
 	for (auto engine : scrapers)
@@ -184,6 +200,12 @@ bool Scraper::isMediaSupported(const Scraper::ScraperMediaSource& md)
 	return mdds.find(md) != mdds.cend();
 }
 
+int Scraper::getThreadCount(std::string &result)
+{
+	int threads = Settings::getInstance()->getInt(getScraperName(this) + ".threads");
+	return threads > 0 ? threads : 1;
+}
+
 std::unique_ptr<ScraperSearchHandle> Scraper::search(const ScraperSearchParams& params)
 {
 	std::unique_ptr<ScraperSearchHandle> handle(new ScraperSearchHandle());
@@ -263,6 +285,7 @@ ScraperHttpRequest::ScraperHttpRequest(std::vector<ScraperSearchResult>& results
 
 	mRequest = new HttpReq(url, &mOptions);
 	mRetryCount = 0;
+	mRetryDelay = 0;
 	mOverQuotaPendingTime = 0;
 }
 
@@ -276,11 +299,11 @@ void ScraperHttpRequest::update()
 	if (mOverQuotaPendingTime > 0)
 	{
 		int lastTime = SDL_GetTicks();
-		if (lastTime - mOverQuotaPendingTime > OVERQUOTA_RETRY_DELAY)
+		if (lastTime - mOverQuotaPendingTime > mRetryDelay)
 		{
 			mOverQuotaPendingTime = 0;
 
-			LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying";
+			LOG(LogDebug) << "ScraperHttpRequest : Retrying " << mRequest->getUrl();
 
 			std::string url = mRequest->getUrl();
 			delete mRequest;
@@ -303,24 +326,20 @@ void ScraperHttpRequest::update()
 		return;
 	}
 
-	if (status == HttpReq::REQ_429_TOOMANYREQUESTS)
+	if (canRetry(mRequest, status) && mRetryCount + 1 < RETRY_COUNT)
 	{
 		mRetryCount++;
-		if (mRetryCount >= OVERQUOTA_RETRY_COUNT)
-		{
-			setStatus(ASYNC_DONE); // Ignore error
-			return;
-		}
+		mRetryDelay = getRetryDelay(mRetryCount);
 
 		setStatus(ASYNC_IN_PROGRESS);
 
 		mOverQuotaPendingTime = SDL_GetTicks();
-		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying in 5 seconds";
+		LOG(LogDebug) << "ScraperHttpRequest : HTTP " << status << ", retrying in " << mRetryDelay << "ms";
 		return;
 	}
 
 	// Ignored errors
-	if (status == HttpReq::REQ_404_NOTFOUND || status == HttpReq::REQ_IO_ERROR)
+	if (status == HttpReq::REQ_404_NOTFOUND || status == HttpReq::REQ_IO_ERROR || status == HttpReq::REQ_429_TOOMANYREQUESTS)
 	{
 		setStatus(ASYNC_DONE);
 		return;
@@ -478,6 +497,7 @@ ImageDownloadHandle::ImageDownloadHandle(const std::string& url, const std::stri
 	mSavePath(path), mMaxWidth(maxWidth), mMaxHeight(maxHeight)
 {
 	mRetryCount = 0;
+	mRetryDelay = 0;
 	mOverQuotaPendingTime = 0;
 
 	if (url.find("screenscraper") != std::string::npos && (path.find(".jpg") != std::string::npos || path.find(".png") != std::string::npos) && url.find("media=map") == std::string::npos)
@@ -513,11 +533,11 @@ void ImageDownloadHandle::update()
 	if (mOverQuotaPendingTime > 0)
 	{
 		int lastTime = SDL_GetTicks();
-		if (lastTime - mOverQuotaPendingTime > OVERQUOTA_RETRY_DELAY)
+		if (lastTime - mOverQuotaPendingTime > mRetryDelay)
 		{
 			mOverQuotaPendingTime = 0;
 
-			LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying";
+			LOG(LogDebug) << "ImageDownloadHandle : Retrying " << mRequest->getUrl();
 
 			std::string url = mRequest->getUrl();
 			delete mRequest;
@@ -532,25 +552,20 @@ void ImageDownloadHandle::update()
 	if (status == HttpReq::REQ_IN_PROGRESS)
 		return;
 	
-	if (status == HttpReq::REQ_429_TOOMANYREQUESTS)
+	if (canRetry(mRequest, status) && mRetryCount + 1 < RETRY_COUNT)
 	{
 		mRetryCount++;
-		if (mRetryCount >= OVERQUOTA_RETRY_COUNT)
-		{
-			setStatus(ASYNC_DONE); // Ignore error
-			return;
-		}
+		mRetryDelay = getRetryDelay(mRetryCount);
 
 		setStatus(ASYNC_IN_PROGRESS);
 
 		mOverQuotaPendingTime = SDL_GetTicks();
-		LOG(LogDebug) << "REQ_429_TOOMANYREQUESTS : Retrying in 5 seconds";
+		LOG(LogDebug) << "ImageDownloadHandle : HTTP " << status << ", retrying in " << mRetryDelay << "ms";
 		return;
 	}
 
-
 	// Ignored errors
-	if (status == HttpReq::REQ_404_NOTFOUND || status == HttpReq::REQ_IO_ERROR)
+	if (status == HttpReq::REQ_404_NOTFOUND || status == HttpReq::REQ_IO_ERROR || status == HttpReq::REQ_429_TOOMANYREQUESTS)
 	{
 		setStatus(ASYNC_DONE);
 		return;
@@ -97,6 +97,7 @@ private:
 	HttpReq* mRequest;
 	HttpReqOptions mOptions;
 	int	mRetryCount;
+	int mRetryDelay;
 
 	int mOverQuotaPendingTime;
 };
@@ -135,6 +136,7 @@ public:
 private:
 	HttpReq* mRequest;
 	int	mRetryCount;
+	int mRetryDelay;
 	int mOverQuotaPendingTime;
 
 	std::string mSavePath;
@@ -249,9 +251,11 @@ public:
 
 	std::unique_ptr<ScraperSearchHandle> search(const ScraperSearchParams& params);
 
-	virtual	int getThreadCount(std::string &result) {
-		return 1;
-	}
+	// Concurrent requests : the "<scraper>.threads" setting, 1 by default. Sites with a quota return it.
+	virtual	int getThreadCount(std::string &result);
+
+	// Games which can be looked up per minute, 0 when the site doesn't limit them
+	virtual	int getRequestsPerMinute() { return 0; }
 
 	bool isMediaSupported(const ScraperMediaSource& md);
 
@@ -904,11 +904,17 @@ int ScreenScraperScraper::getThreadCount(std::string &result)
 	if (parseResult)
 	{
 		auto userInfo = ScreenScraperRequest::processUserInfo(doc);
-		
-		// userInfo.maxRequestsPerMin / userInfo.maxthreads;
+		mRequestsPerMinute = userInfo.maxRequestsPerMin;
 
 		if (userInfo.maxthreads > 0)
+		{
+			// The setting can only use less threads than the account allows
+			int threads = Settings::getInstance()->getInt("ScreenScraper.threads");
+			if (threads > 0 && threads < userInfo.maxthreads)
+				return threads;
+
 			return userInfo.maxthreads;
+		}
 	}	
 
 	return 1;
@@ -21,8 +21,14 @@ public:
 
 	bool isSupportedPlatform(SystemData* system) override;
 	int getThreadCount(std::string &result) override;
+	int getRequestsPerMinute() override { return mRequestsPerMinute; }
 
 	const std::set<ScraperMediaSource>& getSupportedMedias() override;
+
+	ScreenScraperScraper() : mRequestsPerMinute(0) { }
+
+private:
+	int mRequestsPerMinute; // Quota of the account, known once getThreadCount has been called
 };
 
 struct ScreenScraperUser
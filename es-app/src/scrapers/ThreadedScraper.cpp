@@ -6,30 +6,40 @@
 #include "guis/GuiMsgBox.h"
 #include "Gamelist.h"
 #include "Log.h"
+#include "math/Misc.h"
+#include <SDL_timer.h>
+#include <algorithm>
 
 #define GUIICON _U("\uF03E ")
 
+// Longest sleep without any network activity, so retries are sent on time
+#define WAIT_MAX_TIME 100
+
 ThreadedScraper* ThreadedScraper::mInstance = nullptr;
 bool ThreadedScraper::mPaused = false;
 
-ThreadedScraper::ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, int threadCount)
-	: mSearchQueue(searches), mWindow(window)
+ThreadedScraper::ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, int threadCount, int requestsPerMinute)
+	: mSearchQueue(searches), mWindow(window), mRateLimiter(requestsPerMinute, threadCount - threadCount / 2)
 {
 	mExitCode = ASYNC_IN_PROGRESS;
 	mTotal = (int) mSearchQueue.size();
+	mFinished = 0;
 
 	mWndNotification = mWindow->createAsyncNotificationComponent();
 	mWndNotification->updateTitle(GUIICON + _("SCRAPING"));
 
-	for (int i = 0; i < threadCount; i++)
-	{
-		if (mSearchQueue.size() == 0)
-			break;
+	// With a single thread allowed, the lookups and the downloads of a game share it
+	int mediaThreads = threadCount / 2;
+	int lookupThreads = threadCount - mediaThreads;
+
+	for (int i = 0; i < lookupThreads; i++)
+		mScraperThreads.push_back(new ScraperThread(i, mediaThreads == 0));
 
-		ScraperThread* thread = new ScraperThread(i);
-		mScraperThreads.push_back(thread);
-		ProcessNextGame(thread);
-	}	
+	for (int i = 0; i < mediaThreads; i++)
+		mMediaThreads.push_back(new ScraperThread(lookupThreads + i, false));
+
+	LOG(LogInfo) << "ThreadedScraper : " << lookupThreads << " lookup threads, " << mediaThreads << " media threads, " << 
+		(requestsPerMinute > 0 ? std::to_string(requestsPerMinute) : std::string("unlimited")) << " requests per minute";
 
 	mHandle = new std::thread(&ThreadedScraper::run, this);	
 }
@@ -47,6 +57,16 @@ void ThreadedScraper::ProcessNextGame(ScraperThread* thread)
 	updateUI();
 }
 
+void ThreadedScraper::ProcessNextMedias(ScraperThread* thread)
+{
+	auto item = mMediaQueue.front();
+	mMediaQueue.pop();
+
+	LOG(LogInfo) << "[Thread " << thread->mThreadId << "] ProcessNextMedias : " << item.first.getGameName();
+
+	thread->resolve(item.first, item.second);
+}
+
 ThreadedScraper::~ThreadedScraper()
 {
 	mWndNotification->close();
@@ -55,7 +75,11 @@ ThreadedScraper::~ThreadedScraper()
 	for (auto scraperThread : mScraperThreads)
 		delete scraperThread;
 
+	for (auto scraperThread : mMediaThreads)
+		delete scraperThread;
+
 	mScraperThreads.clear();
+	mMediaThreads.clear();
 
 	ThreadedScraper::mInstance = nullptr;
 }
@@ -65,25 +89,42 @@ std::string ThreadedScraper::formatGameName(FileData* game)
 	return "["+game->getSystemName()+"] " + game->getName();
 }
 
-ScraperThread::ScraperThread(int threadId)
+ScraperThread::ScraperThread(int threadId, bool resolveMedias)
 {
 	mThreadId = threadId;
 	mErrorStatus = 0;
 	mStatus = ASYNC_IN_PROGRESS;
+	mRunning = false;
+	mResolveMedias = resolveMedias;
+	mPendingMedias = false;
 }
 
-void ScraperThread::run(const ScraperSearchParams& params)
+void ScraperThread::reset(const ScraperSearchParams& params)
 {
 	mResult = ScraperSearchResult();
 	mErrorStatus = 0;
 	mStatusString = "";
 	mStatus = ASYNC_IN_PROGRESS;
 	mSearch = params;
+	mRunning = true;
+	mPendingMedias = false;
+	mSearchHandle.reset();
 	mMDResolveHandle.reset();
+}
 
+void ScraperThread::run(const ScraperSearchParams& params)
+{
+	reset(params);
 	mSearchHandle = Scraper::getScraper()->search(params);
 }
 
+void ScraperThread::resolve(const ScraperSearchParams& params, const ScraperSearchResult& result)
+{
+	reset(params);
+	mResult = result;
+	mMDResolveHandle = mResult.resolveMetaDataAssets(mSearch);
+}
+
 int ScraperThread::updateState()
 {
 	if (mSearchHandle && mSearchHandle->status() != ASYNC_IN_PROGRESS)
@@ -101,10 +142,15 @@ int ScraperThread::updateState()
 		{
 			if (results.size() > 0)
 			{
-				if (results[0].hasMedia())
+				if (!results[0].hasMedia())
+					acceptResult(results[0]);
+				else if (mResolveMedias)
 					mMDResolveHandle = results[0].resolveMetaDataAssets(mSearch);
 				else
+				{
+					mPendingMedias = true;
 					acceptResult(results[0]);
+				}
 			}
 			else
 			{
@@ -133,6 +179,9 @@ int ScraperThread::updateState()
 			processError(httpCode, statusString);
 	}
 
+	if (mStatus != ASYNC_IN_PROGRESS)
+		mRunning = false;
+
 	return mStatus;
 }
 
@@ -150,6 +199,84 @@ void ThreadedScraper::processError(int status, const std::string statusString)
 		mErrors.push_back(statusString);
 }
 
+bool ThreadedScraper::updateThreads()
+{
+	bool changed = false;
+
+	for (auto thread : mScraperThreads)
+	{
+		if (mExitCode != ASYNC_IN_PROGRESS)
+			return changed;
+
+		if (thread->isRunning())
+		{
+			int state = thread->updateState();
+			if (state == ASYNC_IN_PROGRESS)
+				continue;
+
+			if (state == ASYNC_ERROR)
+			{
+				processError(thread->getError(), thread->getErrorString());
+				mFinished++;
+			}
+			else if (thread->hasPendingMedias())
+				mMediaQueue.push(std::make_pair(thread->getSearchParams(), thread->getResult()));
+			else
+			{
+				acceptResult(*thread);
+				mFinished++;
+			}
+
+			changed = true;
+		}
+
+		if (!mSearchQueue.empty() && mRateLimiter.tryAcquire())
+		{
+			ProcessNextGame(thread);
+			changed = true;
+		}
+	}
+
+	for (auto thread : mMediaThreads)
+	{
+		if (mExitCode != ASYNC_IN_PROGRESS)
+			return changed;
+
+		if (thread->isRunning())
+		{
+			int state = thread->updateState();
+			if (state == ASYNC_IN_PROGRESS)
+				continue;
+
+			if (state == ASYNC_ERROR)
+				processError(thread->getError(), thread->getErrorString());
+			else
+				acceptResult(*thread);
+
+			mFinished++;
+			changed = true;
+		}
+
+		if (!mMediaQueue.empty())
+		{
+			ProcessNextMedias(thread);
+			changed = true;
+		}
+	}
+
+	if (changed)
+		updateUI();
+	else if (mSearchQueue.empty() && mMediaQueue.empty() &&
+		std::none_of(mScraperThreads.cbegin(), mScraperThreads.cend(), [](ScraperThread* thread) { return thread->isRunning(); }) &&
+		std::none_of(mMediaThreads.cbegin(), mMediaThreads.cend(), [](ScraperThread* thread) { return thread->isRunning(); }))
+	{
+		mExitCode = ASYNC_DONE;
+		LOG(LogDebug) << "ThreadedScraper::finished";
+	}
+
+	return changed;
+}
+
 void ThreadedScraper::run()
 {
 	while (mExitCode == ASYNC_IN_PROGRESS)
@@ -162,47 +289,16 @@ void ThreadedScraper::run()
 				std::this_thread::sleep_for(std::chrono::milliseconds(500));
 			}
 		}
-		
-		for (auto iter = mScraperThreads.cbegin(); iter != mScraperThreads.cend(); ++iter)
-		{
-			if (mExitCode != ASYNC_IN_PROGRESS)
-				break;
 
-			auto mScraperThread = *iter;
+		if (updateThreads() || mExitCode != ASYNC_IN_PROGRESS)
+			continue;
 
-			int state = mScraperThread->updateState();
-			switch (state)
-			{
-			case ASYNC_DONE:
-				acceptResult(*mScraperThread);
-				break;
-
-			case ASYNC_ERROR:
-				processError(mScraperThread->getError(), mScraperThread->getErrorString());
-				break;
-
-			default:
-				//std::this_thread::yield();
-				// std::this_thread::sleep_for(std::chrono::milliseconds(10));
-				break;
-			}
+		// Nothing to do until data is received : retries and the rate limit are checked again after the timeout
+		int timeout = WAIT_MAX_TIME;
+		if (!mSearchQueue.empty())
+			timeout = Math::max(1, Math::min(timeout, mRateLimiter.getWaitTime()));
 
-			if (mExitCode == ASYNC_IN_PROGRESS && state != ASYNC_IN_PROGRESS)
-			{
-				if (!mSearchQueue.empty())
-					ProcessNextGame(mScraperThread);
-				else
-				{					
-					mScraperThreads.erase(iter);
-					if (mScraperThreads.size() == 0)
-					{
-						mExitCode = ASYNC_DONE;
-						LOG(LogDebug) << "ThreadedScraper::finished";
-					}
-					break;
-				}
-			}
-		}
+		HttpReq::waitForActivity(timeout);
 	}
 	
 	if (mExitCode == ASYNC_DONE)
@@ -214,12 +310,8 @@ void ThreadedScraper::run()
 
 void ThreadedScraper::updateUI()
 {
-	int remaining = mTotal + 1 - mSearchQueue.size() - mScraperThreads.size();
-	if (remaining < 0)
-		remaining = 0;
-
-	std::string idx = std::to_string(remaining) + "/" + std::to_string(mTotal);	
-	int percentDone = remaining * 100 / (mTotal + 1);
+	std::string idx = std::to_string(Math::min(mTotal - (int)mSearchQueue.size(), mTotal)) + "/" + std::to_string(mTotal);
+	int percentDone = mTotal > 0 ? mFinished * 100 / mTotal : 100;
 
 	mWndNotification->updateTitle(GUIICON + _("SCRAPING") + " " + idx);
 	mWndNotification->updateText(mCurrentGame);
@@ -272,7 +364,7 @@ void ThreadedScraper::start(Window* window, const std::queue<ScraperSearchParams
 	if (threadCount == 0)
 		threadCount = 1;
 
-	ThreadedScraper::mInstance = new ThreadedScraper(window, searches, threadCount);
+	ThreadedScraper::mInstance = new ThreadedScraper(window, searches, threadCount, Scraper::getScraper()->getRequestsPerMinute());
 }
 
 void ThreadedScraper::stop()
@@ -288,3 +380,43 @@ void ThreadedScraper::stop()
 	catch (...) {}
 }
 
+
+ScraperRateLimiter::ScraperRateLimiter(int requestsPerMinute, int burst)
+{
+	mCapacity = Math::max(1, burst);
+	mTokens = mCapacity;
+	mTokensPerMs = requestsPerMinute > 0 ? requestsPerMinute / 60000.0 : 0;
+	mLastTime = SDL_GetTicks();
+}
+
+void ScraperRateLimiter::refill()
+{
+	int now = SDL_GetTicks();
+	mTokens = std::min(mCapacity, mTokens + (now - mLastTime) * mTokensPerMs);
+	mLastTime = now;
+}
+
+bool ScraperRateLimiter::tryAcquire()
+{
+	if (mTokensPerMs == 0)
+		return true;
+
+	refill();
+	if (mTokens < 1)
+		return false;
+
+	mTokens -= 1;
+	return true;
+}
+
+int ScraperRateLimiter::getWaitTime()
+{
+	if (mTokensPerMs == 0)
+		return 0;
+
+	refill();
+	if (mTokens >= 1)
+		return 0;
+
+	return (int)((1 - mTokens) / mTokensPerMs) + 1;
+}
@@ -7,10 +7,20 @@
 class ScraperThread
 {
 public:
-	ScraperThread(int threadId);
+	ScraperThread(int threadId, bool resolveMedias);
+
+	// Looks up the game. Medias are downloaded by the same thread, unless it was created without resolveMedias :
+	// the result is then returned with its medias pending.
 	void run(const ScraperSearchParams& params);
+
+	// Downloads the medias of a result
+	void resolve(const ScraperSearchParams& params, const ScraperSearchResult& result);
+
 	int updateState();
 
+	bool isRunning() { return mRunning; }
+	bool hasPendingMedias() { return mPendingMedias; }
+
 	ScraperSearchParams& getSearchParams() { return mSearch; }
 	ScraperSearchResult& getResult() { return mResult; }
 
@@ -34,17 +44,39 @@ private:
 		mStatusString = statusString;
 	}
 
-	
+	void reset(const ScraperSearchParams& params);
+
 	int mStatus;
 	int mErrorStatus;
 	std::string mStatusString;
 
+	bool mRunning;
+	bool mResolveMedias;
+	bool mPendingMedias;
+
 	ScraperSearchResult mResult;
 	ScraperSearchParams mSearch;
 	std::unique_ptr<ScraperSearchHandle> mSearchHandle;
 	std::unique_ptr<MDResolveHandle> mMDResolveHandle;
 };
 
+// Token bucket : games are looked up at the rate allowed by the site, with bursts up to the bucket size
+class ScraperRateLimiter
+{
+public:
+	ScraperRateLimiter(int requestsPerMinute, int burst);
+
+	bool tryAcquire();
+	int getWaitTime(); // Milliseconds before a token is available
+
+private:
+	void refill();
+
+	double mTokens;
+	double mCapacity;
+	double mTokensPerMs;
+	int mLastTime;
+};
 
 class ThreadedScraper
 {
@@ -52,37 +84,45 @@ public:
 	static void start(Window* window, const std::queue<ScraperSearchParams>& searches);
 	static void stop();
 	static bool isRunning() { return mInstance != nullptr; }
-	
+
 	static void pause() { mPaused = true; }
 	static void resume() { mPaused = false; }
 
 	static std::string formatGameName(FileData* game);
 
 private:
-	ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, int threadCount);
+	ThreadedScraper(Window* window, const std::queue<ScraperSearchParams>& searches, int threadCount, int requestsPerMinute);
 	~ThreadedScraper();
 
 	void ProcessNextGame(ScraperThread* thread);
+	void ProcessNextMedias(ScraperThread* thread);
 
 	Window* mWindow;
 	AsyncNotificationComponent* mWndNotification;
-	
+
 	std::string		mCurrentGame;
 
 	std::vector<std::string> mErrors;
 
 	void run();
+	bool updateThreads(); // Returns true if a thread finished or started
 
 	std::thread* mHandle;
 	std::queue<ScraperSearchParams> mSearchQueue;
 
+	// Lookups and media downloads have their own threads, so lookups never wait behind large downloads
 	std::vector<ScraperThread*> mScraperThreads;
-	
+	std::vector<ScraperThread*> mMediaThreads;
+	std::queue<std::pair<ScraperSearchParams, ScraperSearchResult>> mMediaQueue;
+
+	ScraperRateLimiter mRateLimiter;
+
 	void acceptResult(ScraperThread& thread);
 	void processError(int status, const std::string statusString);
 	void updateUI();
 
 	int mTotal;
+	int mFinished;
 	int mExitCode;
 
 	static bool mPaused;
@@ -12,7 +12,6 @@
 #include "CollectionSystemManager.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
-#include "utils/md5.h"
 #include "scrapers/Scraper.h"
 #include <unordered_map>
 
@@ -94,65 +93,44 @@ std::string HttpApi::getSystemList()
 	return s.GetString();
 }
 
-std::string HttpApi::getFileDataId(FileData* game)
-{
-	MD5 md5;
-	md5.update(game->getPath().c_str(), game->getPath().size());
-	md5.finalize();
-	return md5.hexdigest();
-}
-
 FileData* HttpApi::findFileData(SystemData* system, const std::string& id)
 {
-	std::stack<FolderData*> stack;
-	stack.push(system->getRootFolder());
-
-	while (stack.size())
-	{
-		FolderData* current = stack.top();
-		stack.pop();
-
-		for (auto it : current->getChildren())
-		{			
-			if (it->getType() == FOLDER)
-				stack.push((FolderData*)it);
-			else if (getFileDataId(it) == id)
-				return it;
-		}
-	}
-
-	return nullptr;
+	return system->getFileById(id);
 }
 
-void HttpApi::getFileDataJson(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, FileData* game)
+template<typename Writer>
+void HttpApi::getFileDataJson(Writer& writer, FileData* game, const std::set<std::string>* fields)
 {
 	if (game->getType() != GAME)
 		return;
 
-	std::string id = getFileDataId(game);
+	auto hasField = [fields](const std::string& key) { return fields == nullptr || fields->empty() || fields->find(key) != fields->cend(); };
+
+	std::string id = SystemData::getFileId(game);
 
 	writer.StartObject();
-	writer.Key("id"); writer.String(id.c_str());
-	writer.Key("path"); writer.String(game->getPath().c_str());
-	writer.Key("name"); writer.String(game->getName().c_str());
 
-	auto meta = game->getMetadata();
-	for (auto mdd : MetaDataList::getMDD())
+	if (hasField("id")) { writer.Key("id"); writer.String(id.c_str()); }
+	if (hasField("path")) { writer.Key("path"); writer.String(game->getPath().c_str()); }
+	if (hasField("name")) { writer.Key("name"); writer.String(game->getName().c_str()); }
+
+	auto& meta = game->getMetadata();
+	for (auto& mdd : MetaDataList::getMDD())
 	{
 		if (mdd.id == MetaDataId::Name)
 			continue;
 
+		std::string key = mdd.id == MetaDataId::ScraperId ? "scraperId" : mdd.key;
+		if (!hasField(key))
+			continue;
+
 		std::string value = game->getMetadata(mdd.id);
 		if (!value.empty())
 		{
 			if (meta.getType(mdd.id) == MD_PATH)
 				value = "/systems/" + game->getSourceFileData()->getSystemName() + "/games/" + id + "/media/" + mdd.key;
 
-			if (mdd.id == MetaDataId::ScraperId)
-				writer.Key("scraperId");
-			else 
-				writer.Key(mdd.key.c_str());
-
+			writer.Key(key.c_str());
 			writer.String(value.c_str());
 		}
 	}
@@ -273,13 +251,8 @@ std::string HttpApi::ToJson(SystemData* system)
 	return s.GetString();
 }
 
-std::string HttpApi::getSystemGames(SystemData* system)
+std::vector<FileData*> HttpApi::getSystemGames(SystemData* system)
 {
-	rapidjson::StringBuffer s;
-	rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(s);
-
-	writer.StartArray();
-
 	std::vector<FileData*> files;
 
 	std::stack<FolderData*> stack;
@@ -292,19 +265,45 @@ std::string HttpApi::getSystemGames(SystemData* system)
 
 		for (auto it : current->getChildren())
 		{
-			files.push_back(it);
-			if (it->getType() == FOLDER)
+			if (it->getType() == GAME)
+				files.push_back(it);
+			else if (it->getType() == FOLDER)
 				stack.push((FolderData*)it);
 		}
 	}
 
-	for (auto game : files)
-		getFileDataJson(writer, game);
+	return files;
+}
 
-	writer.EndArray();
+std::string HttpApi::getGamesJson(const std::vector<FileData*>& games, size_t from, size_t to, const std::set<std::string>& fields)
+{
+	std::string json;
 
-	return s.GetString();
-}
+	rapidjson::StringBuffer s;
+	rapidjson::Writer<rapidjson::StringBuffer> writer(s);
 
+	for (size_t i = from; i < to && i < games.size(); i++)
+	{
+		s.Clear();
+		writer.Reset(s);
+		getFileDataJson(writer, games[i], &fields);
+
+		if (!json.empty())
+			json += ",";
+
+		json.append(s.GetString(), s.GetSize());
+	}
+
+	return json;
+}
 
+// Metadata revisions are global : any metadata change renews the tag, structural changes of another system don't
+std::string HttpApi::getSystemGamesETag(SystemData* system)
+{
+	return "\"" + system->getName() + "-" + std::to_string(system->getChangeCount()) + "-" + std::to_string(MetaDataList::getGlobalRevision()) + "\"";
+}
 
+std::string HttpApi::getGameETag(FileData* game)
+{
+	return "\"" + SystemData::getFileId(game) + "-" + std::to_string(game->getMetadata().getRevision()) + "\"";
+}
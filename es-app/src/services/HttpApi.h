@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <set>
+#include <vector>
 #include <rapidjson/rapidjson.h>
 #include <rapidjson/pointer.h>
 #include <rapidjson/prettywriter.h>
@@ -13,7 +15,16 @@ class HttpApi
 {
 public:
 	static std::string getSystemList();
-	static std::string getSystemGames(SystemData* system);
+
+	// Games of a system, in the order of the listings
+	static std::vector<FileData*> getSystemGames(SystemData* system);
+	// Compact json of the games [from, to[ separated by commas, without the array brackets, so large listings can be sent in chunks.
+	// When fields is not empty, only those keys are written.
+	static std::string getGamesJson(const std::vector<FileData*>& games, size_t from, size_t to, const std::set<std::string>& fields);
+
+	// Change when the content of the system listing or of the game can have changed
+	static std::string getSystemGamesETag(SystemData* system);
+	static std::string getGameETag(FileData* game);
 
 	static std::string ToJson(SystemData* system);
 	static std::string ToJson(FileData* file);
@@ -26,7 +37,7 @@ public:
 	
 
 private:
-	static std::string getFileDataId(FileData* game);
-	static void getFileDataJson(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, FileData* game);
+	template<typename Writer>
+	static void getFileDataJson(Writer& writer, FileData* game, const std::set<std::string>* fields = nullptr);
 	static void getSystemDataJson(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer, SystemData* sys);
 };
\ No newline at end of file
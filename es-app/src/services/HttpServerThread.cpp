@@ -12,10 +12,13 @@
 #include "FileData.h"
 #include "views/ViewController.h"
 #include <unordered_map>
+#include <memory>
+#include <set>
 #include "CollectionSystemManager.h"
 #include "guis/GuiMenu.h"
 #include "guis/GuiMsgBox.h"
 #include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
 #include "HttpApi.h"
 #include "Settings.h"
 #include "ApiSystem.h"
@@ -37,6 +40,7 @@ System/Games APIS
 GET  /systems
 GET  /systems/{systemName}
 GET  /systems/{systemName}/logo
+GET  /systems/{systemName}/games								-> chunked json. Optional ?offset=&limit=&fields=name,path,... X-Total-Count has the game count
 GET  /systems/{systemName}/games/{gameId}		
 POST /systems/{systemName}/games/{gameId}						-> body must contain the game metadatas to save as application/json
 GET  /systems/{systemName}/games/{gameId}/media/{mediaType}
@@ -128,6 +132,31 @@ static bool isAllowed(const httplib::Request& req, httplib::Response& res)
 	return true;
 }
 
+// Sets the ETag of the response, and answers 304 if the client already has this version
+static bool isNotModified(const httplib::Request& req, httplib::Response& res, const std::string& etag)
+{
+	res.set_header("ETag", etag);
+
+	if (!req.has_header("If-None-Match"))
+		return false;
+
+	std::string tags = req.get_header_value("If-None-Match");
+	if (tags != "*" && tags.find(etag) == std::string::npos)
+		return false;
+
+	res.status = 304;
+	return true;
+}
+
+#define GAMES_PER_CHUNK 200
+
+// Json chunks of a game listing : games may be deleted while the response is sent, so they are serialized beforehand
+struct GameListStream
+{
+	std::vector<std::string> chunks;
+	size_t position;
+};
+
 void HttpServerThread::run()
 {
 	mHttpServer = new httplib::Server();
@@ -273,7 +302,55 @@ void HttpServerThread::run()
 		SystemData* system = SystemData::getSystem(systemName);
 		if (system != nullptr)
 		{
-			res.set_content(HttpApi::getSystemGames(system), "application/json");
+			if (isNotModified(req, res, HttpApi::getSystemGamesETag(system)))
+				return;
+
+			std::vector<FileData*> games = HttpApi::getSystemGames(system);
+
+			size_t total = games.size();
+			size_t offset = req.has_param("offset") ? (size_t)std::max(0, atoi(req.get_param_value("offset").c_str())) : 0;
+			size_t limit = req.has_param("limit") ? (size_t)std::max(0, atoi(req.get_param_value("limit").c_str())) : total;
+
+			size_t begin = std::min(offset, total);
+			size_t end = std::min(total, begin + limit);
+
+			std::set<std::string> fields;
+			if (req.has_param("fields"))
+				for (auto field : Utils::String::split(req.get_param_value("fields"), ',', true))
+					fields.insert(Utils::String::trim(field));
+
+			auto stream = std::make_shared<GameListStream>();
+			stream->position = 0;
+
+			for (size_t from = begin; from < end; from += GAMES_PER_CHUNK)
+				stream->chunks.push_back(HttpApi::getGamesJson(games, from, std::min(from + GAMES_PER_CHUNK, end), fields));
+
+			res.set_header("X-Total-Count", std::to_string(total));
+			res.set_header("Content-Type", "application/json");
+			res.set_chunked_content_provider([stream](size_t sent, httplib::DataSink& sink)
+			{
+				// The list only has games, so every chunk has some json
+				std::string chunk = stream->position == 0 ? "[" : ",";
+
+				if (stream->position < stream->chunks.size())
+				{
+					chunk += stream->chunks[stream->position];
+					stream->chunks[stream->position] = std::string();
+					stream->position++;
+				}
+
+				bool finished = stream->position >= stream->chunks.size();
+				if (finished)
+					chunk += "]";
+
+				sink.write(chunk.data(), chunk.size());
+
+				if (finished)
+					sink.done();
+
+				return true;
+			});
+
 			return;
 		}
 		
@@ -415,7 +492,9 @@ void HttpServerThread::run()
 			auto game = HttpApi::findFileData(system, gameId);
 			if (game != nullptr)
 			{
-				res.set_content(HttpApi::ToJson(game), "application/json");
+				if (!isNotModified(req, res, HttpApi::getGameETag(game)))
+					res.set_content(HttpApi::ToJson(game), "application/json");
+
 				return;
 			}
 		}
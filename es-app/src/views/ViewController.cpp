@@ -26,9 +26,10 @@
 #include "guis/GuiImageViewer.h"
 #include "ApiSystem.h"
 #include "guis/GuiMsgBox.h"
-#include "utils/ThreadPool.h"
+#include "utils/TaskScheduler.h"
 #include <SDL_timer.h>
 #include "TextToSpeech.h"
+#include "ScreenSaverMediaCatalog.h"
 
 ViewController* ViewController::sInstance = nullptr;
 
@@ -422,6 +423,8 @@ void ViewController::playViewTransition(bool forceImmediate)
 
 void ViewController::onFileChanged(FileData* file, FileChangeType change)
 {
+	ScreenSaverMediaCatalog::onFileChanged(file, change);
+
 	std::string key = file->getFullPath();
 	auto sourceSystem = file->getSourceFileData()->getSystem();
 
@@ -1123,13 +1126,13 @@ void ViewController::reloadAll(Window* window, bool reloadTheme)
 		int processedSystem = 0;
 		int systemCount = cursorMap.size();
 
-		Utils::ThreadPool pool;
+		Utils::TaskGroup pool(Utils::TASK_UI);
 
 		for (auto it = cursorMap.cbegin(); it != cursorMap.cend(); it++)
 		{
 			SystemData* pooledSystem = it->first;
 
-			pool.queueWorkItem([pooledSystem, &processedSystem]
+			pool.run([pooledSystem, &processedSystem]
 			{ 
 				pooledSystem->loadTheme();
 				pooledSystem->resetFilters();
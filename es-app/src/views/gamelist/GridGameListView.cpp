@@ -12,6 +12,10 @@
 #include "guis/GuiGamelistOptions.h"
 #include "GameNameFormatter.h"
 #include "utils/Randomizer.h"
+#include "resources/ThumbnailCache.h"
+#include <unordered_set>
+
+#define THUMBNAIL_WARMUP_PAGES 2
 
 GridGameListView::GridGameListView(Window* window, FolderData* root, const std::shared_ptr<ThemeData>& theme, std::string themeName, Vector2f gridSize) :
 	ISimpleGameListView(window, root),
@@ -28,7 +32,13 @@ GridGameListView::GridGameListView(Window* window, FolderData* root, const std::
 	mGrid.setGridSizeOverride(gridSize);
 	mGrid.setPosition(mSize.x() * 0.1f, mSize.y() * 0.1f);
 	mGrid.setDefaultZIndex(20);
-	mGrid.setCursorChangedCallback([&](const CursorState& /*state*/) { updateInfoPanel(); });
+	mGrid.setCursorChangedCallback([&](const CursorState& state)
+	{
+		updateInfoPanel();
+
+		if (state == CursorState::CURSOR_STOPPED)
+			warmupThumbnails();
+	});
 	addChild(&mGrid);
 	
 	if (!themeName.empty())
@@ -224,6 +234,8 @@ void GridGameListView::populateList(const std::vector<FileData*>& files)
 		// if we have the ".." PLACEHOLDER, then select the first game instead of the placeholder
 		if (showParentFolder && mCursorStack.size() && mGrid.size() > 1 && mGrid.getCursorIndex() == 0)
 			mGrid.setCursorIndex(1);
+
+		warmupThumbnails();
 	}
 	else
 		addPlaceholder();
@@ -234,6 +246,26 @@ void GridGameListView::populateList(const std::vector<FileData*>& files)
 		onShow();
 }
 
+// Prepare the downscaled pictures around the cursor in background, from the paths the grid already has
+void GridGameListView::warmupThumbnails()
+{
+	if (!ThumbnailCache::isEnabled())
+		return;
+
+	MaxSizeInfo maxSize = mGrid.getImageMaxSizeInfo();
+	if (maxSize.empty())
+		return;
+
+	std::vector<std::string> paths;
+	std::unordered_set<std::string> known;
+
+	for (auto path : mGrid.getImagePathsAround(THUMBNAIL_WARMUP_PAGES))
+		if (!path.empty() && known.insert(path).second)
+			paths.push_back(path);
+
+	ThumbnailCache::warmup(paths, maxSize);
+}
+
 void GridGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 {
 	ISimpleGameListView::onThemeChanged(theme);
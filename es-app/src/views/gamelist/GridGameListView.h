@@ -57,6 +57,7 @@ private:
 
 	void updateInfoPanel();
 	const std::string getImagePath(FileData* file);
+	void warmupThumbnails();
 	const bool isVirtualFolder(FileData* file);
 };
 
@@ -56,6 +56,8 @@ void GuiComponent::updateSelf(int deltaTime)
 {
 	if (mAnimationMap.size())
 	{
+		invalidate();
+
 		for (auto it = mAnimationMap.cbegin(), next_it = it; it != mAnimationMap.cend(); it = next_it)
 		{
 			++next_it;
@@ -67,6 +69,12 @@ void GuiComponent::updateSelf(int deltaTime)
 		mStoryboardAnimator->update(deltaTime);
 }
 
+void GuiComponent::invalidate()
+{
+	if (mWindow != nullptr)
+		mWindow->invalidate();
+}
+
 void GuiComponent::updateChildren(int deltaTime)
 {
 	for (auto it = mChildren.cbegin(), next_it = it; it != mChildren.cend(); it = next_it)
@@ -945,72 +953,145 @@ ThemeData::ThemeElement::Property GuiComponent::getProperty(const std::string na
 	return "";
 }
 
+// Names are resolved to the ids storyboards use : components only implement setAnimatedProperty
 void GuiComponent::setProperty(const std::string name, const ThemeData::ThemeElement::Property& value)
 {
-	Vector2f screenScale = Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
-	Vector2f scale = getParent() ? getParent()->getSize() : screenScale;
-
-	if (getParent() != nullptr && getParent()->isKindOf<ScrollableContainer>())
-	{
-		if (name == "pos" || name == "x" || name == "y" || name == "size" || name == "w" || name == "h" || name == "offset" || name == "offsetX" || name == "offsetY")
-		{
-			getParent()->setProperty(name, value);
-			return;
-		}
-	}
-
-	if (name == "pos" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
-		setPosition(Vector3f(value.v.x() * scale.x(), value.v.y() * scale.y(), 0));
-
-	if (name == "x" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
-		setPosition(Vector3f(value.f * scale.x(), mPosition.y(), 0));
-
-	if (name == "y" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
-		setPosition(Vector3f(mPosition.x(), value.f * scale.y(), 0));
+	setAnimatedProperty(getPropertyId(name), value);
+}
 
-	if (name == "size" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
-		setSize(Vector2f(value.v.x() * scale.x(), value.v.y() * scale.y()));
+bool GuiComponent::setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value)
+{
+	typedef ThemeData::ThemeElement::Property::PropertyType PropertyType;
 
-	if (name == "w" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
-		setSize(Vector2f(value.f * scale.x(), mSize.y()));
+	switch (id)
+	{
+	case PropertyId::Pos:
+	case PropertyId::Size:
+	case PropertyId::Offset:
+		if (value.type != PropertyType::Pair)
+			return false;
+		break;
+
+	case PropertyId::X:
+	case PropertyId::Y:
+	case PropertyId::W:
+	case PropertyId::H:
+	case PropertyId::OffsetX:
+	case PropertyId::OffsetY:
+		if (value.type != PropertyType::Float)
+			return false;
+		break;
 
-	if (name == "h" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
-		setSize(Vector2f(mSize.x(), value.f * scale.y()));
+	case PropertyId::Origin:
+		if (value.type != PropertyType::Pair)
+			return false;
 
-	if (name == "origin" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
 		setOrigin(Vector2f(value.v.x(), value.v.y()));
+		mTransformDirty = true;
+		return true;
+
+	case PropertyId::Rotation:
+		if (value.type != PropertyType::Float)
+			return false;
 
-	if (name == "rotation" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
 		setRotationDegrees(value.f);
+		mTransformDirty = true;
+		return true;
+
+	case PropertyId::RotationOrigin:
+		if (value.type != PropertyType::Pair)
+			return false;
 
-	if (name == "rotationOrigin" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
 		setRotationOrigin(Vector2f(value.v.x(), value.v.y()));
+		mTransformDirty = true;
+		return true;
+
+	case PropertyId::ZIndex:
+		if (value.type != PropertyType::Float)
+			return false;
 
-	if (name == "zIndex" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
 		setZIndex(value.f);
+		mTransformDirty = true;
+		return true;
+
+	case PropertyId::Opacity:
+		if (value.type != PropertyType::Float)
+			return false;
 
-	if (name == "opacity" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
 		setOpacity(value.f * 255.0f);
+		mTransformDirty = true;
+		return true;
+
+	case PropertyId::Scale:
+		if (value.type != PropertyType::Float)
+			return false;
 
-	if (name == "scale" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
 		setScale(value.f);
+		mTransformDirty = true;
+		return true;
+
+	case PropertyId::ScaleOrigin:
+		if (value.type != PropertyType::Pair)
+			return false;
 
-	if (name == "scaleOrigin" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
 		setScaleOrigin(Vector2f(value.v.x(), value.v.y()));
+		mTransformDirty = true;
+		return true;
+
+	case PropertyId::ClipRect:
+		if (value.type != PropertyType::Rect)
+			return false;
+		break;
 
-	if (name == "offset" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
+	default:
+		return false;
+	}
+
+	// Position, size & offset properties are relative to the parent or the screen
+	if (id != PropertyId::ClipRect && getParent() != nullptr && getParent()->isKindOf<ScrollableContainer>())
+		return getParent()->setAnimatedProperty(id, value);
+
+	Vector2f screenScale = Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+	Vector2f scale = getParent() ? getParent()->getSize() : screenScale;
+
+	switch (id)
+	{
+	case PropertyId::Pos:
+		setPosition(Vector3f(value.v.x() * scale.x(), value.v.y() * scale.y(), 0));
+		break;
+	case PropertyId::X:
+		setPosition(Vector3f(value.f * scale.x(), mPosition.y(), 0));
+		break;
+	case PropertyId::Y:
+		setPosition(Vector3f(mPosition.x(), value.f * scale.y(), 0));
+		break;
+	case PropertyId::Size:
+		setSize(Vector2f(value.v.x() * scale.x(), value.v.y() * scale.y()));
+		break;
+	case PropertyId::W:
+		setSize(Vector2f(value.f * scale.x(), mSize.y()));
+		break;
+	case PropertyId::H:
+		setSize(Vector2f(mSize.x(), value.f * scale.y()));
+		break;
+	case PropertyId::Offset:
 		setScreenOffset(Vector2f(value.v.x() * screenScale.x(), value.v.y() * screenScale.y()));
-	
-	if (name == "offsetX" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
+		break;
+	case PropertyId::OffsetX:
 		setScreenOffset(Vector2f(value.f * screenScale.x(), mScreenOffset.y()));
-
-	if (name == "offsetY" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
+		break;
+	case PropertyId::OffsetY:
 		setScreenOffset(Vector2f(mScreenOffset.x(), value.f * screenScale.y()));
-
-	if (name == "clipRect" && value.type == ThemeData::ThemeElement::Property::PropertyType::Rect)
+		break;
+	case PropertyId::ClipRect:
 		setClipRect(Vector4f(value.r.x() * screenScale.x(), value.r.y() * screenScale.y(), value.r.z() * screenScale.x(), value.r.w() * screenScale.y()));
+		break;
+	default:
+		break;
+	}
 
 	mTransformDirty = true;
+	return true;
 }
 
 void GuiComponent::setClipRect(const Vector4f& vec)
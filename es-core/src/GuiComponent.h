@@ -9,6 +9,7 @@
 #include "InputConfig.h"
 #include <functional>
 #include "ThemeData.h"
+#include "anim/PropertyId.h"
 #include <memory>
 
 class Animation;
@@ -166,6 +167,9 @@ public:
 
 	// Returns true if the component is busy doing background processing (e.g. HTTP downloads)
 	bool isProcessing() const;
+
+	// Call when the component looks different without any input, so the window renders it again
+	void invalidate();
 	
 	void animateTo(Vector2f from, Vector2f to, unsigned int flags = 0xFFFFFFFF, int delay = 350);
 	void animateTo(Vector2f from, unsigned int flags = AnimateFlags::OPACITY | AnimateFlags::SCALE, int delay = 350) { animateTo(from, from, flags, delay); }
@@ -179,8 +183,13 @@ public:
 	void setIsStaticExtra(bool value) { mStaticExtra = value; }
 
 	virtual ThemeData::ThemeElement::Property getProperty(const std::string name);
+
+	// Calls setAnimatedProperty with the id of the name. Only override it for properties without id.
 	virtual void setProperty(const std::string name, const ThemeData::ThemeElement::Property& value);
 
+	// Called by storyboards at each frame. Returns false if the property is unknown or has another type.
+	virtual bool setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value);
+
 	bool isShowing() { return mShowing; }
 
 	// Storyboards
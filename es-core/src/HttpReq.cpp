@@ -2,6 +2,7 @@
 
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
+#include "math/Misc.h"
 #include "Log.h"
 #include <assert.h>
 #include <thread>
@@ -14,9 +15,18 @@
 #include <unistd.h>
 #endif
 
+#include <atomic>
 #include <mutex>
 static std::mutex mMutex;
 
+// curl_multi_poll can be interrupted by curl_multi_wakeup, from any thread
+#if LIBCURL_VERSION_NUM >= 0x074400
+#define HTTPREQ_HAS_MULTI_POLL
+#endif
+
+static std::atomic<bool> sPolling(false);
+static std::atomic<int> sWaiters(0);
+
 CURLM* HttpReq::s_multi_handle = curl_multi_init();
 
 std::map<CURL*, HttpReq*> HttpReq::s_requests;
@@ -93,7 +103,7 @@ std::string _regGetString(HKEY hKey, const std::string &strPath, const std::stri
 #endif
 
 HttpReq::HttpReq(const std::string& url, const std::string& outputFilename) 
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL), mTransientError(false)
 {
 	HttpReqOptions options;
 	options.outputFilename = outputFilename;	
@@ -101,7 +111,7 @@ HttpReq::HttpReq(const std::string& url, const std::string& outputFilename)
 }
 
 HttpReq::HttpReq(const std::string& url, HttpReqOptions* options)
-	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL)
+	: mStatus(REQ_IN_PROGRESS), mHandle(NULL), mFile(NULL), mTransientError(false)
 {
 	performRequest(url, options);
 }
@@ -257,7 +267,7 @@ void HttpReq::performRequest(const std::string& url, HttpReqOptions* options)
 	}
 #endif
 	
-	std::unique_lock<std::mutex> lock(mMutex);
+	std::unique_lock<std::mutex> lock = lockMultiHandle();
 
 	if (!mFilePath.empty())
 	{
@@ -308,7 +318,7 @@ void HttpReq::closeStream()
 
 HttpReq::~HttpReq()
 {
-	std::unique_lock<std::mutex> lock(mMutex);
+	std::unique_lock<std::mutex> lock = lockMultiHandle();
 
 	closeStream();
 	
@@ -332,102 +342,165 @@ HttpReq::Status HttpReq::status()
 {
 	if (mStatus == REQ_IN_PROGRESS)
 	{
-		std::unique_lock<std::mutex> lock(mMutex);
+		std::unique_lock<std::mutex> lock = lockMultiHandle();
 
-		int handle_count;
-		CURLMcode merr = curl_multi_perform(s_multi_handle, &handle_count);
-		if (merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
+		CURLMcode merr = performAll();
+		if (merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM && mStatus == REQ_IN_PROGRESS)
 		{
 			closeStream();
 
 			mStatus = REQ_IO_ERROR;
 			onError(curl_multi_strerror(merr));
-			return mStatus;
 		}
+	}
+
+	return mStatus;
+}
+
+// Waiters are counted before the poller is checked, and the poller is flagged before the waiters are checked :
+// either the waiter wakes the poll, or the poller skips it. The polling thread never wakes itself.
+std::unique_lock<std::mutex> HttpReq::lockMultiHandle()
+{
+	sWaiters++;
+
+#ifdef HTTPREQ_HAS_MULTI_POLL
+	if (sPolling)
+		curl_multi_wakeup(s_multi_handle);
+#endif
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	sWaiters--;
+	return lock;
+}
+
+void HttpReq::waitForActivity(int timeoutMs)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
 
-		int msgs_left;
-		CURLMsg* msg;
-		while ((msg = curl_multi_info_read(s_multi_handle, &msgs_left)) != nullptr)
+	if (s_requests.empty())
+	{
+		lock.unlock();
+		std::this_thread::sleep_for(std::chrono::milliseconds(timeoutMs));
+		return;
+	}
+
+#ifdef HTTPREQ_HAS_MULTI_POLL
+	sPolling = true;
+
+	// Another thread is waiting for the multi handle : let it have it
+	if (sWaiters > 0)
+	{
+		sPolling = false;
+		return;
+	}
+
+	CURLMcode merr = curl_multi_poll(s_multi_handle, nullptr, 0, timeoutMs, nullptr);
+	sPolling = false;
+#else
+	// Without wakeups, other threads would wait for the timeout to use the multi handle : keep it short
+	CURLMcode merr = curl_multi_wait(s_multi_handle, nullptr, 0, Math::min(timeoutMs, 20), nullptr);
+#endif
+	if (merr != CURLM_OK)
+	{
+		LOG(LogError) << "HttpReq::waitForActivity : " << curl_multi_strerror(merr);
+		return;
+	}
+
+	performAll();
+}
+
+CURLMcode HttpReq::performAll()
+{
+	int handle_count;
+	CURLMcode merr = curl_multi_perform(s_multi_handle, &handle_count);
+	if (merr != CURLM_OK && merr != CURLM_CALL_MULTI_PERFORM)
+		return merr;
+
+	int msgs_left;
+	CURLMsg* msg;
+	while ((msg = curl_multi_info_read(s_multi_handle, &msgs_left)) != nullptr)
+	{
+		if (msg->msg == CURLMSG_DONE)
 		{
-			if (msg->msg == CURLMSG_DONE)
+			HttpReq* req = s_requests[msg->easy_handle];
+			if (req == NULL)
 			{
-				HttpReq* req = s_requests[msg->easy_handle];
-				if (req == NULL)
-				{
-					LOG(LogError) << "Cannot find easy handle!";
-					continue;
-				}
+				LOG(LogError) << "Cannot find easy handle!";
+				continue;
+			}
 
-				req->closeStream();
+			req->closeStream();
 
-				if (req->mStatus == REQ_FILESTREAM_ERROR)
-				{
-					std::string err = "File stream error (disk full ?)";
-					req->onError(err.c_str());
-				}
-				else if (msg->data.result == CURLE_OK)
-				{
-					int http_status_code;
-					curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_status_code);
+			if (req->mStatus == REQ_FILESTREAM_ERROR)
+			{
+				std::string err = "File stream error (disk full ?)";
+				req->onError(err.c_str());
+			}
+			else if (msg->data.result == CURLE_OK)
+			{
+				int http_status_code;
+				curl_easy_getinfo(msg->easy_handle, CURLINFO_RESPONSE_CODE, &http_status_code);
 
-					char *ct = NULL;
-					if (!curl_easy_getinfo(msg->easy_handle, CURLINFO_CONTENT_TYPE, &ct) && ct)
-						req->mResponseContentType = ct;
+				char *ct = NULL;
+				if (!curl_easy_getinfo(msg->easy_handle, CURLINFO_CONTENT_TYPE, &ct) && ct)
+					req->mResponseContentType = ct;
 
-					if (http_status_code < 200 || http_status_code > 299)
+				if (http_status_code < 200 || http_status_code > 299)
+				{
+					std::string err;
+
+					if (http_status_code >= 400 && http_status_code <= 500)
 					{
-						std::string err;
+						if (req->mFilePath.empty())
+							err = req->getContent();
 
-						if (http_status_code >= 400 && http_status_code <= 500)
-						{
-							if (req->mFilePath.empty())
-								err = req->getContent();
+						req->mStatus = (Status)http_status_code;
+					}
+					else
+						req->mStatus = REQ_IO_ERROR;
 
-							req->mStatus = (Status)http_status_code;
-						}
-						else
-							req->mStatus = REQ_IO_ERROR;
+					req->mTransientError = (http_status_code >= 500);
 
-						if (err.empty())
-							err = "HTTP status " + std::to_string(http_status_code);
+					if (err.empty())
+						err = "HTTP status " + std::to_string(http_status_code);
 
-						req->onError(err.c_str());
-					}
-					else
+					req->onError(err.c_str());
+				}
+				else
+				{
+					if (!req->mFilePath.empty())
 					{
-						if (!req->mFilePath.empty())
+						bool renamed = Utils::FileSystem::renameFile(req->mTempStreamPath.c_str(), req->mFilePath.c_str());
+						if (!renamed)
 						{
-							bool renamed = Utils::FileSystem::renameFile(req->mTempStreamPath.c_str(), req->mFilePath.c_str());
-							if (!renamed)
-							{
-								// Strange behaviour on Windows : sometimes std::rename fails if it's done too early after closing stream
-								// Copy file instead & try to delete it
-								if (Utils::FileSystem::copyFile(req->mTempStreamPath, req->mFilePath))
-									renamed = true;
-							}
-
-							if (renamed)
-								req->mStatus = REQ_SUCCESS;
-							else
-							{
-								req->mStatus = REQ_IO_ERROR;
-								req->onError("file rename failed");
-							}
+							// Strange behaviour on Windows : sometimes std::rename fails if it's done too early after closing stream
+							// Copy file instead & try to delete it
+							if (Utils::FileSystem::copyFile(req->mTempStreamPath, req->mFilePath))
+								renamed = true;
 						}
-						else
+
+						if (renamed)
 							req->mStatus = REQ_SUCCESS;
+						else
+						{
+							req->mStatus = REQ_IO_ERROR;
+							req->onError("file rename failed");
+						}
 					}
+					else
+						req->mStatus = REQ_SUCCESS;
 				}
-				else
-				{
-					req->mStatus = REQ_IO_ERROR;
-					req->onError(curl_easy_strerror(msg->data.result));
-				}
+			}
+			else
+			{
+				req->mStatus = REQ_IO_ERROR;
+				req->mTransientError = true;
+				req->onError(curl_easy_strerror(msg->data.result));
 			}
 		}
 	}
 
-	return mStatus;
+	return merr;
 }
 
 std::string HttpReq::getContent() 
@@ -516,7 +589,7 @@ size_t HttpReq::write_content(void* buff, size_t size, size_t nmemb, void* req_p
 bool HttpReq::wait()
 {
 	while (status() == HttpReq::REQ_IN_PROGRESS)
-		std::this_thread::sleep_for(std::chrono::milliseconds(20));
+		waitForActivity(20);
 
 	return status() == HttpReq::REQ_SUCCESS;
 }
@@ -4,6 +4,7 @@
 
 #include <curl/curl.h>
 #include <map>
+#include <mutex>
 #include <sstream>
 #include <fstream>
 #include <string>
@@ -88,12 +89,25 @@ public:
 	std::string getFilePath() { return mFilePath; }
 	std::string getResponseContentType() { return mResponseContentType; }
 
+	// The request failed because of the network or of the server (5xx), and may succeed later
+	bool isTransientError() { return mTransientError; }
+
 	bool wait();
 
+	// Blocks until one of the pending requests receives data or completes, or until the timeout (in ms) expires,
+	// then processes the received data. Lets a thread waiting for many requests sleep instead of polling them.
+	static void waitForActivity(int timeoutMs);
+
 private:
 	void performRequest(const std::string& url, HttpReqOptions* options);
 	void closeStream();
 
+	// Transfers pending data and completes the finished requests : the multi handle must be locked
+	static CURLMcode performAll();
+
+	// Locks the multi handle, interrupting waitForActivity only if another thread is blocked in it
+	static std::unique_lock<std::mutex> lockMultiHandle();
+
 	static size_t write_content(void* buff, size_t size, size_t nmemb, void* req_ptr);
 	//static int update_progress(void* req_ptr, double dlTotal, double dlNow, double ulTotal, double ulNow);
 
@@ -121,6 +135,7 @@ private:
 
 	std::string mErrorMsg;
 	std::string mUrl;
+	bool		mTransientError;
 
 	int mPercent;
 	double mPosition;
@@ -3,12 +3,15 @@
 #include "Log.h"
 #include <FreeImage.h>
 #include <string.h>
+#include "utils/AppendLog.h"
 #include "utils/FileSystemUtil.h"
 #include "utils/StringUtil.h"
-#include <sstream>
-#include <fstream>
-#include <map>
+#include <algorithm>
+#include <atomic>
 #include <mutex>
+#include <set>
+#include <stdint.h>
+#include <stdio.h>
 #include "renderers/Renderer.h"
 #include "Paths.h"
 
@@ -192,6 +195,15 @@ Vector2f ImageIO::getPictureMinSize(Vector2f imageSize, Vector2f maxSize)
 	return Vector2f(cxDIB, cyDIB);
 }
 
+// Image size cache : a binary hash table snapshot memory mapped at startup, with the changes of the session kept
+// in memory and appended to a log file. The snapshot is only rewritten when the log becomes too large.
+
+#define IMAGECACHE_MAGIC		0x43495345 // "ESIC"
+#define IMAGECACHE_VERSION		1
+#define IMAGECACHE_LOG_MAGIC	0x4C495345 // "ESIL"
+#define IMAGECACHE_REMOVED		-2	// Size of the entries removed from the cache
+#define IMAGECACHE_LOG_RATIO	4	// Compact when the log has more than 1/4 of the snapshot entries
+
 struct CachedFileInfo
 {
 	CachedFileInfo(int sz, int sx, int sy)
@@ -208,174 +220,527 @@ struct CachedFileInfo
 		y = 0;		
 	};
 
+	bool operator==(const CachedFileInfo& other) const { return size == other.size && x == other.x && y == other.y; }
+
 	int size;
 	int x;
 	int y;	
 };
 
-static std::map<std::string, CachedFileInfo> sizeCache;
-static bool sizeCacheDirty = false;
-
-std::string getImageCacheFilename()
+struct ImageCacheHeader
 {
-	return Paths::getUserEmulationStationPath() + "/imagecache.db";
-}
+	uint32_t magic;
+	uint32_t version;
+	uint32_t bucketCount;
+	uint32_t entryCount;
+	uint32_t rootLength;	// Root path the snapshot was built with, stored after the header
+	uint32_t entriesOffset;
+	uint32_t stringsOffset;
+	uint32_t reserved;
+};
 
-void ImageIO::clearImageCache()
+struct ImageCacheEntry
 {
-	std::string fname = getImageCacheFilename();
-	Utils::FileSystem::removeFile(fname);
-	sizeCache.clear();
-}
+	uint64_t hash;
+	uint32_t next;			// Index + 1 of the next entry in the same bucket, 0 at the end of the chain
+	uint32_t pathOffset;
+	uint32_t pathLength;
+	int32_t  size;
+	int32_t  x;
+	int32_t  y;
+};
 
-void ImageIO::loadImageCache()
+// Read-only view of the snapshot file : lookups don't need any lock
+class ImageCacheSnapshot
 {
-	std::string fname = getImageCacheFilename();
+public:
+	ImageCacheSnapshot() : mFile(nullptr), mHeader(nullptr), mBuckets(nullptr), mEntries(nullptr), mStrings(nullptr) { }
+	~ImageCacheSnapshot() { close(); }
 
-	std::ifstream f(fname.c_str());
-	if (f.fail())
-		return;
+	bool open(const std::string& fileName, const std::string& root)
+	{
+		close();
+
+		mFile = new Utils::FileSystem::MappedFile(fileName);
+		if (!mFile->isValid() || mFile->size() < sizeof(ImageCacheHeader))
+		{
+			close();
+			return false;
+		}
 
-	sizeCache.clear();
+		const char* data = mFile->data();
+		const ImageCacheHeader* header = (const ImageCacheHeader*)data;
 
-	std::string relativeTo = Paths::getRootPath();
+		if (header->magic != IMAGECACHE_MAGIC || header->version != IMAGECACHE_VERSION || header->bucketCount == 0 ||
+			sizeof(ImageCacheHeader) + align(header->rootLength) + (size_t)header->bucketCount * sizeof(uint32_t) > header->entriesOffset ||
+			header->entriesOffset + (size_t)header->entryCount * sizeof(ImageCacheEntry) > mFile->size() || header->stringsOffset > mFile->size() ||
+			sizeof(ImageCacheHeader) + header->rootLength > mFile->size() || root.compare(0, std::string::npos, data + sizeof(ImageCacheHeader), header->rootLength) != 0)
+		{
+			close();
+			return false;
+		}
+
+		// Paths must lie in the strings area : lookups read them without any check
+		const ImageCacheEntry* entries = (const ImageCacheEntry*)(data + header->entriesOffset);
+		for (uint32_t i = 0; i < header->entryCount; i++)
+		{
+			if ((uint64_t)header->stringsOffset + entries[i].pathOffset + entries[i].pathLength > mFile->size())
+			{
+				close();
+				return false;
+			}
+		}
 
-	std::vector<std::string> splits;
+		mHeader = header;
+		mBuckets = (const uint32_t*)(data + sizeof(ImageCacheHeader) + align(header->rootLength));
+		mEntries = entries;
+		mStrings = data + header->stringsOffset;
+		return true;
+	}
 
-	std::string line;
-	while (std::getline(f, line))
+	void close()
 	{
-		splits.clear();
+		if (mFile != nullptr)
+			delete mFile;
+
+		mFile = nullptr;
+		mHeader = nullptr;
+		mBuckets = nullptr;
+		mEntries = nullptr;
+		mStrings = nullptr;
+	}
 
-		const char* src = line.c_str();
+	const ImageCacheEntry* find(const std::string& path, uint64_t hash) const
+	{
+		if (mHeader == nullptr)
+			return nullptr;
 
-		while (true)
+		// A chain can't be longer than the entry count : a longer one has a cycle
+		uint32_t index = mBuckets[hash % mHeader->bucketCount];
+		for (uint32_t steps = 0; index != 0 && index <= mHeader->entryCount && steps < mHeader->entryCount; steps++)
 		{
-			const char* d = strchr(src, '|');
-			size_t len = (d) ? d - src : strlen(src);
-
-			if (len)
-				splits.push_back(std::string(src, len)); // capture token
+			const ImageCacheEntry* entry = &mEntries[index - 1];
+			if (entry->hash == hash && entry->pathLength == path.size() && memcmp(mStrings + entry->pathOffset, path.data(), path.size()) == 0)
+				return entry;
 
-			if (d) src += len + 1; else break;
+			index = entry->next;
 		}
 
-		if (splits.size() == 4)
+		return nullptr;
+	}
+
+	uint32_t getEntryCount() const { return mHeader == nullptr ? 0 : mHeader->entryCount; }
+	const ImageCacheEntry* getEntry(uint32_t index) const { return &mEntries[index]; }
+	std::string getPath(const ImageCacheEntry* entry) const { return std::string(mStrings + entry->pathOffset, entry->pathLength); }
+
+	static size_t align(size_t size) { return (size + 7) & ~((size_t)7); }
+
+private:
+	Utils::FileSystem::MappedFile*	mFile;
+	const ImageCacheHeader*			mHeader;
+	const uint32_t*					mBuckets;
+	const ImageCacheEntry*			mEntries;
+	const char*						mStrings;
+};
+
+// Changes made since the snapshot was loaded. Nodes are never modified once published,
+// an update pushes a new node in front of the older ones, so readers don't need to lock.
+class ImageCacheOverlay
+{
+public:
+	ImageCacheOverlay()
+	{
+		for (int i = 0; i < BUCKET_COUNT; i++)
+			mBuckets[i] = nullptr;
+	}
+
+	~ImageCacheOverlay() { clear(); }
+
+	const CachedFileInfo* find(const std::string& path, uint64_t hash) const
+	{
+		for (Node* node = mBuckets[hash % BUCKET_COUNT].load(std::memory_order_acquire); node != nullptr; node = node->next)
+			if (node->hash == hash && node->path == path)
+				return &node->info;
+
+		return nullptr;
+	}
+
+	// Writers are serialized by the caller
+	void insert(const std::string& path, uint64_t hash, const CachedFileInfo& info)
+	{
+		std::atomic<Node*>& bucket = mBuckets[hash % BUCKET_COUNT];
+		bucket.store(new Node(path, hash, info, bucket.load(std::memory_order_relaxed)), std::memory_order_release);
+	}
+
+	template<typename T> void forEach(T callback)
+	{
+		for (int i = 0; i < BUCKET_COUNT; i++)
 		{
-			std::string file = Utils::FileSystem::resolveRelativePath(splits[0], relativeTo, true);
+			std::set<std::string> seen;
 
-			CachedFileInfo fi;
-			fi.size = Utils::String::toInteger(splits[1]);
-			fi.x = Utils::String::toInteger(splits[2]);
-			fi.y = Utils::String::toInteger(splits[3]);
+			// Newest nodes first : only the first one of each path is current
+			for (Node* node = mBuckets[i].load(std::memory_order_acquire); node != nullptr; node = node->next)
+				if (seen.insert(node->path).second)
+					callback(node->path, node->hash, node->info);
+		}
+	}
 
-			sizeCache[file] = fi;
+	// Not safe while other threads are reading
+	void clear()
+	{
+		for (int i = 0; i < BUCKET_COUNT; i++)
+		{
+			Node* node = mBuckets[i].exchange(nullptr);
+			while (node != nullptr)
+			{
+				Node* next = node->next;
+				delete node;
+				node = next;
+			}
 		}
 	}
 
-	f.close();
+private:
+	static const int BUCKET_COUNT = 16384;
+
+	struct Node
+	{
+		Node(const std::string& _path, uint64_t _hash, const CachedFileInfo& _info, Node* _next) : path(_path), hash(_hash), info(_info), next(_next) { }
+
+		std::string		path;
+		uint64_t		hash;
+		CachedFileInfo	info;
+		Node*			next;
+	};
+
+	std::atomic<Node*> mBuckets[BUCKET_COUNT];
+};
+
+// Readers may still use a replaced snapshot or overlay : they are kept alive until exit
+static std::atomic<ImageCacheSnapshot*>	sizeCacheSnapshot(nullptr);
+static std::atomic<ImageCacheOverlay*>	sizeCacheOverlay(new ImageCacheOverlay());
+static std::vector<ImageCacheSnapshot*>	sizeCacheRetiredSnapshots;
+static std::vector<ImageCacheOverlay*>	sizeCacheRetiredOverlays;
+
+static std::mutex			sizeCacheLock;		// Serializes writers only
+static bool					sizeCacheDirty = false;
+
+static std::string getImageCacheFilename()
+{
+	return Paths::getUserEmulationStationPath() + "/imagecache.bin";
+}
+
+// Log records : uint32 path length, path, int32 size, int32 x, int32 y
+static Utils::AppendLog& getImageCacheLog()
+{
+	static Utils::AppendLog log(Paths::getUserEmulationStationPath() + "/imagecache.log", IMAGECACHE_LOG_MAGIC, IMAGECACHE_VERSION);
+	return log;
 }
 
 static bool _isCachablePath(const std::string& path)
 {
 	return 
 		path.find("/themes/") == std::string::npos && 
-		path.find("/tmp/") != std::string::npos &&
-		path.find("/emulationstation.tmp/") != std::string::npos &&
+		path.find("/tmp/") == std::string::npos &&
+		path.find("/emulationstation.tmp/") == std::string::npos &&
 		path.find("/pdftmp/") == std::string::npos && 
-		path.find("/saves/") != std::string::npos;
+		path.find("/saves/") == std::string::npos;
 }
 
-void ImageIO::saveImageCache()
+static bool _isPersistent(const std::string& path, const CachedFileInfo& info)
 {
-	if (!sizeCacheDirty)
-		return;
+	return (info.size == IMAGECACHE_REMOVED || (info.size > 0 && info.x > 0)) && _isCachablePath(path);
+}
 
-	std::string fname = getImageCacheFilename();
-	std::ofstream f(fname.c_str(), std::ios::binary);
-	if (f.fail())
-		return;
+static bool findImageCache(const std::string& path, CachedFileInfo& info)
+{
+	uint64_t hash = Utils::String::computeHash(path);
+
+	const CachedFileInfo* item = sizeCacheOverlay.load(std::memory_order_acquire)->find(path, hash);
+	if (item != nullptr)
+	{
+		if (item->size == IMAGECACHE_REMOVED)
+			return false;
+
+		info = *item;
+		return true;
+	}
+
+	ImageCacheSnapshot* snapshot = sizeCacheSnapshot.load(std::memory_order_acquire);
+	if (snapshot == nullptr)
+		return false;
+
+	const ImageCacheEntry* entry = snapshot->find(path, hash);
+	if (entry == nullptr)
+		return false;
+
+	info = CachedFileInfo(entry->size, entry->x, entry->y);
+	return true;
+}
+
+static void appendImageCacheLog(const std::string& path, const CachedFileInfo& info)
+{
+	uint32_t length = (uint32_t)path.size();
+	int32_t values[3] = { info.size, info.x, info.y };
+
+	std::string data;
+	data.append((const char*)&length, sizeof(uint32_t));
+	data.append(path);
+	data.append((const char*)values, sizeof(values));
+
+	getImageCacheLog().append(data);
+}
+
+// Returns the size of the record, 0 if it is incomplete
+static size_t readImageCacheLogRecord(const char* data, size_t size)
+{
+	if (size < sizeof(uint32_t))
+		return 0;
+
+	uint32_t length;
+	memcpy(&length, data, sizeof(uint32_t));
+
+	size_t recordSize = sizeof(uint32_t) + length + 3 * sizeof(int32_t);
+	if (recordSize > size)
+		return 0;
+
+	std::string path(data + sizeof(uint32_t), length);
 
-	std::string relativeTo = Paths::getRootPath();
+	int32_t values[3];
+	memcpy(values, data + sizeof(uint32_t) + length, sizeof(values));
 
-	for (auto it : sizeCache)
+	sizeCacheOverlay.load()->insert(path, Utils::String::computeHash(path), CachedFileInfo(values[0], values[1], values[2]));
+	return recordSize;
+}
+
+// Merges the snapshot and the changes of the session in a new snapshot
+static bool writeImageCacheSnapshot()
+{
+	std::vector<ImageCacheEntry> entries;
+	std::string strings;
+
+	auto addEntry = [&entries, &strings](const std::string& path, uint64_t hash, const CachedFileInfo& info)
 	{
-		if (it.second.size < 0)
-			continue;
+		if (info.size <= 0 || info.x <= 0 || !_isCachablePath(path))
+			return;
+
+		ImageCacheEntry entry;
+		entry.hash = hash;
+		entry.next = 0;
+		entry.pathOffset = (uint32_t)strings.size();
+		entry.pathLength = (uint32_t)path.size();
+		entry.size = info.size;
+		entry.x = info.x;
+		entry.y = info.y;
+
+		entries.push_back(entry);
+		strings.append(path);
+	};
+
+	ImageCacheOverlay* overlay = sizeCacheOverlay.load();
+	overlay->forEach(addEntry);
+
+	ImageCacheSnapshot* snapshot = sizeCacheSnapshot.load();
+	if (snapshot != nullptr)
+	{
+		for (uint32_t i = 0; i < snapshot->getEntryCount(); i++)
+		{
+			const ImageCacheEntry* entry = snapshot->getEntry(i);
+
+			std::string path = snapshot->getPath(entry);
+			if (overlay->find(path, entry->hash) == nullptr)
+				addEntry(path, entry->hash, CachedFileInfo(entry->size, entry->x, entry->y));
+		}
+	}
+
+	std::string root = Paths::getRootPath();
+
+	uint32_t bucketCount = (uint32_t)std::max<size_t>(1024, entries.size() * 2);
+	std::vector<uint32_t> buckets(bucketCount, 0);
+
+	for (uint32_t i = 0; i < (uint32_t)entries.size(); i++)
+	{
+		uint32_t& bucket = buckets[entries[i].hash % bucketCount];
+		entries[i].next = bucket;
+		bucket = i + 1;
+	}
 
-		if (!_isCachablePath(it.first))
-			continue;
+	ImageCacheHeader header;
+	memset(&header, 0, sizeof(ImageCacheHeader));
+	header.magic = IMAGECACHE_MAGIC;
+	header.version = IMAGECACHE_VERSION;
+	header.bucketCount = bucketCount;
+	header.entryCount = (uint32_t)entries.size();
+	header.rootLength = (uint32_t)root.size();
+	header.entriesOffset = (uint32_t)ImageCacheSnapshot::align(sizeof(ImageCacheHeader) + ImageCacheSnapshot::align(root.size()) + bucketCount * sizeof(uint32_t));
+	header.stringsOffset = header.entriesOffset + (uint32_t)(entries.size() * sizeof(ImageCacheEntry));
+
+	std::string buffer;
+	buffer.reserve(header.stringsOffset + strings.size());
+	buffer.append((const char*)&header, sizeof(ImageCacheHeader));
+	buffer.append(root);
+	buffer.resize(sizeof(ImageCacheHeader) + ImageCacheSnapshot::align(root.size()), '\0');
+	buffer.append((const char*)buckets.data(), buckets.size() * sizeof(uint32_t));
+	buffer.resize(header.entriesOffset, '\0');
+	buffer.append((const char*)entries.data(), entries.size() * sizeof(ImageCacheEntry));
+	buffer.append(strings);
 
-		std::string path = Utils::FileSystem::createRelativePath(it.first, relativeTo, true); 
+	std::string fname = getImageCacheFilename();
+	std::string tmpName = fname + ".tmp";
+
+#if WIN32
+	FILE* file = _wfopen(Utils::String::convertToWideString(tmpName).c_str(), L"wb");
+#else
+	FILE* file = fopen(tmpName.c_str(), "wb");
+#endif
+	if (file == nullptr)
+		return false;
 
-		f << path;
-		f << "|";
-		f << std::to_string(it.second.size);
-		f << "|";
-		f << std::to_string(it.second.x);
-		f << "|";
-		f << std::to_string(it.second.y);
-		f << "\n";
+	bool written = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+	fclose(file);
+
+	// The mapping of the current snapshot stays valid after the file is replaced
+	if (!written || !Utils::FileSystem::renameFile(tmpName, fname))
+	{
+		Utils::FileSystem::removeFile(tmpName);
+		return false;
 	}
 
-	f.close();
+	return true;
 }
 
-static std::mutex sizeCacheLock;
+static void resetImageCache(ImageCacheSnapshot* snapshot)
+{
+	ImageCacheSnapshot* oldSnapshot = sizeCacheSnapshot.exchange(snapshot);
+	if (oldSnapshot != nullptr)
+		sizeCacheRetiredSnapshots.push_back(oldSnapshot);
 
-void ImageIO::removeImageCache(const std::string fn)
+	sizeCacheRetiredOverlays.push_back(sizeCacheOverlay.exchange(new ImageCacheOverlay()));
+}
+
+void ImageIO::clearImageCache()
 {
 	std::unique_lock<std::mutex> lock(sizeCacheLock);
 
-	auto it = sizeCache.find(fn);
-	if (it != sizeCache.cend())
-		sizeCache.erase(fn);
+	getImageCacheLog().remove();
+	resetImageCache(nullptr);
+	sizeCacheDirty = false;
+
+	Utils::FileSystem::removeFile(getImageCacheFilename());
+
+	// Text cache of previous versions
+	Utils::FileSystem::removeFile(Paths::getUserEmulationStationPath() + "/imagecache.db");
 }
 
-void ImageIO::updateImageCache(const std::string fn, int sz, int x, int y)
+void ImageIO::loadImageCache()
 {
+	StopWatch stopWatch("ImageIO::loadImageCache :", LogDebug);
+
 	std::unique_lock<std::mutex> lock(sizeCacheLock);
 
-	auto it = sizeCache.find(fn);
-	if (it != sizeCache.cend())
+	// The snapshot is tied to the root path : paths would not match anymore if it moved
+	ImageCacheSnapshot* snapshot = new ImageCacheSnapshot();
+	if (!snapshot->open(getImageCacheFilename(), Paths::getRootPath()))
 	{
-		if (x != it->second.x || y != it->second.y || sz != it->second.size)
-		{
-			auto& item = it->second;
+		delete snapshot;
+		resetImageCache(nullptr);
 
-			item.x = x;
-			item.y = y;
-			item.size = sz;
+		getImageCacheLog().remove();
+		return;
+	}
 
-			if (sz > 0 && x > 0 && _isCachablePath(fn))
-				sizeCacheDirty = true;
-		}
+	resetImageCache(snapshot);
+	getImageCacheLog().load(readImageCacheLogRecord);
+}
+
+void ImageIO::saveImageCache()
+{
+	std::unique_lock<std::mutex> lock(sizeCacheLock);
+
+	Utils::AppendLog& log = getImageCacheLog();
+	log.close();
+
+	if (!sizeCacheDirty && log.getRecordCount() == 0)
+		return;
+
+	// Appending to the log is enough while it stays small compared to the snapshot
+	ImageCacheSnapshot* snapshot = sizeCacheSnapshot.load();
+	if (snapshot != nullptr && snapshot->getEntryCount() > 0 && log.getRecordCount() * IMAGECACHE_LOG_RATIO < (int)snapshot->getEntryCount())
+		return;
+
+	StopWatch stopWatch("ImageIO::saveImageCache :", LogDebug);
+
+	if (writeImageCacheSnapshot())
+	{
+		log.remove();
+		sizeCacheDirty = false;
 	}
-	else
+}
+
+void ImageIO::removeImageCache(const std::string fn)
+{
+	std::unique_lock<std::mutex> lock(sizeCacheLock);
+
+	CachedFileInfo info;
+	if (!findImageCache(fn, info))
+		return;
+
+	CachedFileInfo removed(IMAGECACHE_REMOVED, 0, 0);
+	sizeCacheOverlay.load()->insert(fn, Utils::String::computeHash(fn), removed);
+
+	if (_isPersistent(fn, removed))
 	{
-		sizeCache[fn] = CachedFileInfo(sz, x, y);
+		appendImageCacheLog(fn, removed);
+		sizeCacheDirty = true;
+	}
+}
+
+void ImageIO::updateImageCache(const std::string fn, int sz, int x, int y)
+{
+	CachedFileInfo info(sz, x, y);
+
+	CachedFileInfo current;
+	if (findImageCache(fn, current) && current == info)
+		return;
+
+	std::unique_lock<std::mutex> lock(sizeCacheLock);
+
+	// Another thread may have stored the same value meanwhile
+	if (findImageCache(fn, current) && current == info)
+		return;
+
+	sizeCacheOverlay.load()->insert(fn, Utils::String::computeHash(fn), info);
 
-		if (sz > 0 && x > 0 && _isCachablePath(fn))
-			sizeCacheDirty = true;
+	if (_isPersistent(fn, info))
+	{
+		appendImageCacheLog(fn, info);
+		sizeCacheDirty = true;
 	}
 }
 
+// Never reads the file : false if the size is not in the cache
+bool ImageIO::getCachedImageSize(const std::string& fn, unsigned int *x, unsigned int *y)
+{
+	CachedFileInfo info;
+	if (!findImageCache(fn, info) || info.size < 0 || info.x <= 0 || info.y <= 0)
+		return false;
+
+	*x = info.x;
+	*y = info.y;
+	return true;
+}
 
 bool ImageIO::loadImageSize(const char *fn, unsigned int *x, unsigned int *y)
 {
+	CachedFileInfo info;
+	if (findImageCache(fn, info))
 	{
-		std::unique_lock<std::mutex> lock(sizeCacheLock);
-
-		auto it = sizeCache.find(fn);
-		if (it != sizeCache.cend())
-		{
-			if (it->second.size < 0)
-				return false;
+		if (info.size < 0)
+			return false;
 
-			*x = it->second.x;
-			*y = it->second.y;
-			return true;
-		}
+		*x = info.x;
+		*y = info.y;
+		return true;
 	}
 
 	LOG(LogDebug) << "ImageIO::loadImageSize " << fn;
@@ -37,6 +37,8 @@ IMPLEMENT_STATIC_BOOL_SETTING(ShowNetworkIndicator, true)
 
 void Settings::updateCachedSetting(const std::string& name)
 {
+	mVersion++;
+
 	UPDATE_STATIC_BOOL_SETTING_EX("audio.bgmusic", BackgroundMusic)
 	UPDATE_STATIC_BOOL_SETTING(DebugText)
 	UPDATE_STATIC_BOOL_SETTING(DebugImage)
@@ -83,7 +85,7 @@ std::vector<const char*> settings_dont_save {
 	{ "MonitorID" },
 };
 
-Settings::Settings() : mLoaded(false)
+Settings::Settings() : mVersion(0), mLoaded(false)
 {
 	setDefaults();
 	loadFile();
@@ -107,6 +109,7 @@ void Settings::setDefaults()
 	mBoolMap["BackgroundJoystickInput"] = false;
 	mBoolMap["ParseGamelistOnly"] = false;
 	mBoolMap["ShowHiddenFiles"] = false;
+	mBoolMap["PersistentDirectoryCache"] = false;
 	mBoolMap["ShowParentFolder"] = true;
 	mBoolMap["IgnoreLeadingArticles"] = Settings::_IgnoreLeadingArticles;
 	mBoolMap["DrawFramerate"] = false;
@@ -159,6 +162,12 @@ void Settings::setDefaults()
 	mBoolMap["QuickSystemSelect"] = true;
 	mBoolMap["MoveCarousel"] = true;
 	mBoolMap["SaveGamelistsOnExit"] = true;
+	mBoolMap["GamelistCache"] = true;
+	mStringMap["GamelistFsync"] = "gamelist"; // none, gamelist or always (journal appends too)
+	mBoolMap["ThumbnailCache"] = true;
+	mIntMap["ThumbnailCacheSize"] = 256; // Megabytes
+	mBoolMap["SpriteBatching"] = true;
+	mBoolMap["RetainedRendering"] = true;
 	mStringMap["ShowBattery"] = "text";
 	mBoolMap["CheckBiosesAtLaunch"] = true;
 	mBoolMap["RemoveMultiDiskContent"] = true;
@@ -215,6 +224,8 @@ void Settings::setDefaults()
 
 	mBoolMap["RetroachievementsMenuitem"] = true;
 	mIntMap["ScreenSaverSwapImageTimeout"] = 10000;
+	mIntMap["ScreenSaverPreloadCount"] = 2;
+	mIntMap["ScreenSaverPreloadVRAM"] = 32; // Megabytes used by the slides loaded ahead
 	mBoolMap["SlideshowScreenSaverStretch"] = false;
 	mBoolMap["SlideshowScreenSaverCustomImageSource"] = false;
 	mStringMap["SlideshowScreenSaverImageFilter"] = ".png,.jpg";
@@ -64,6 +64,9 @@ public:
 
 	std::map<std::string, std::string>& getStringMap() { return mStringMap; }
 
+	// Incremented when a setting changes : lets callers cache values built from settings
+	inline unsigned int getVersion() { return mVersion; }
+
 	// Cached settings using static fields. They must be implemented using IMPLEMENT_STATIC_xx_SETTING & updated with UPDATE_STATIC_xxx_SETTING
 	DECLARE_STATIC_BOOL_SETTING(DebugText)
 	DECLARE_STATIC_BOOL_SETTING(DebugImage)
@@ -83,10 +86,12 @@ public:
 
 	// Non-cached settings with only shortcut methods
 	DEFINE_BOOL_SETTING(ShowHiddenFiles)
+	DEFINE_BOOL_SETTING(PersistentDirectoryCache)
 	DEFINE_BOOL_SETTING(HiddenSystemsShowGames)
 	DEFINE_BOOL_SETTING(AllImagesAsync)
 	DEFINE_BOOL_SETTING(IgnoreGamelist)
 	DEFINE_BOOL_SETTING(SaveGamelistsOnExit)
+	DEFINE_BOOL_SETTING(GamelistCache)
 	DEFINE_BOOL_SETTING(RemoveMultiDiskContent)	
 	DEFINE_BOOL_SETTING(ParseGamelistOnly)
 	DEFINE_BOOL_SETTING(ThreadedLoading)
@@ -115,6 +120,7 @@ private:
 	std::map<std::string, std::string> mStringMap;
 
 	bool mWasChanged;
+	unsigned int mVersion;
 
 	std::map<std::string, bool> mDefaultBoolMap;
 	std::map<std::string, int> mDefaultIntMap;
@@ -11,6 +11,7 @@
 #include "Settings.h"
 #include "SystemConf.h"
 #include <algorithm>
+#include <mutex>
 #include "LocaleES.h"
 #include "anim/ThemeStoryboard.h"
 #include "Paths.h"
@@ -518,6 +519,54 @@ ThemeData* ThemeData::mDefaultTheme = nullptr;
 #define CURRENT_THEME_FORMAT_VERSION 6
 
 
+// Theme files are parsed once and shared by the themes of all systems, which include mostly the same files.
+// Documents are only read : variables & subsets are resolved by each theme while it walks them.
+#define MAX_THEME_DOCUMENTS 512
+
+struct ThemeDocument
+{
+	time_t time;
+	unsigned long long size;
+	std::shared_ptr<pugi::xml_document> document;
+	pugi::xml_parse_result result;
+};
+
+static std::mutex sDocumentsLock;
+static std::map<std::string, ThemeDocument> sDocuments;
+
+static std::shared_ptr<pugi::xml_document> loadDocument(const std::string& path, pugi::xml_parse_result& result)
+{
+	time_t time = Utils::FileSystem::getFileModificationDate(path).getTime();
+	unsigned long long size = Utils::FileSystem::getFileSize(path);
+
+	{
+		std::unique_lock<std::mutex> lock(sDocumentsLock);
+
+		auto it = sDocuments.find(path);
+		if (it != sDocuments.cend() && it->second.time == time && it->second.size == size)
+		{
+			result = it->second.result;
+			return it->second.document;
+		}
+	}
+
+	std::shared_ptr<pugi::xml_document> document = std::make_shared<pugi::xml_document>();
+	result = document->load_file(path.c_str());
+
+	std::unique_lock<std::mutex> lock(sDocumentsLock);
+
+	if (sDocuments.size() >= MAX_THEME_DOCUMENTS)
+		sDocuments.clear();
+
+	ThemeDocument& item = sDocuments[path];
+	item.time = time;
+	item.size = size;
+	item.document = document;
+	item.result = result;
+
+	return document;
+}
+
 std::string ThemeData::resolvePlaceholders(const char* in)
 {
 	if (in == nullptr || in[0] == 0)
@@ -546,6 +595,7 @@ std::string ThemeData::resolvePlaceholders(const char* in)
 ThemeData::ThemeData()
 {	
 	mPerGameOverrideTmp = false;
+	mSubsetElement = nullptr;
 	mColorset = Settings::getInstance()->getString("ThemeColorSet");
 	mIconset = Settings::getInstance()->getString("ThemeIconSet");
 	mMenu = Settings::getInstance()->getString("ThemeMenu");
@@ -589,12 +639,21 @@ void ThemeData::loadFile(const std::string system, std::map<std::string, std::st
 	mVariables.insert(sysDataMap.cbegin(), sysDataMap.cend());
 	mVariables["lang"] = mLanguage;
 
-	pugi::xml_document doc;
-	pugi::xml_parse_result res = fromFile ? doc.load_file(path.c_str()) : doc.load_string(path.c_str());
+	std::shared_ptr<pugi::xml_document> doc;
+	pugi::xml_parse_result res;
+
+	if (fromFile)
+		doc = loadDocument(path, res);
+	else
+	{
+		doc = std::make_shared<pugi::xml_document>();
+		res = doc->load_string(path.c_str());
+	}
+
 	if(!res)
 		throw error << "XML parsing error: \n    " << res.description();
 
-	pugi::xml_node root = doc.child("theme");
+	pugi::xml_node root = doc->child("theme");
 	if(!root)
 		throw error << "Missing <theme> tag!";
 
@@ -705,11 +764,8 @@ std::string ThemeData::resolveSystemVariable(const std::string& systemThemeFolde
 	return result;
 }
 
-bool ThemeData::isFirstSubset(const pugi::xml_node& node)
+bool ThemeData::isFirstSubset(const std::string& subsetToFind, const std::string& name)
 {
-	const std::string subsetToFind = resolvePlaceholders(node.attribute("subset").as_string());
-	const std::string name = node.attribute("name").as_string();
-
 	for (const auto& it : mSubsets)
 		if (it.subset == subsetToFind)
 			return it.name == name;
@@ -719,11 +775,16 @@ bool ThemeData::isFirstSubset(const pugi::xml_node& node)
 
 bool ThemeData::parseSubset(const pugi::xml_node& node)
 {
-	if (!node.attribute("subset"))
+	// Attributes of the <subset> element only apply to its includes, not to the files they include
+	const SubsetAttributes* subsetElement = mSubsetElement;
+	mSubsetElement = nullptr;
+
+	if (subsetElement == nullptr && !node.attribute("subset"))
 		return true;
 
-	const std::string subsetAttr = resolvePlaceholders(node.attribute("subset").as_string());
+	const std::string subsetAttr = resolvePlaceholders(subsetElement != nullptr ? subsetElement->subset.c_str() : node.attribute("subset").as_string());
 	const std::string nameAttr = resolvePlaceholders(node.attribute("name").as_string());
+	const std::string firstSubsetName = node.attribute("name").as_string();
 
 	if (!subsetAttr.empty())
 	{
@@ -731,7 +792,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 		if (displayNameAttr.empty())
 			displayNameAttr = nameAttr;
 
-		std::string subSetDisplayNameAttr = resolvePlaceholders(node.attribute("subSetDisplayName").as_string());
+		std::string subSetDisplayNameAttr = resolvePlaceholders(subsetElement != nullptr && !subsetElement->subSetDisplayName.empty() ? subsetElement->subSetDisplayName.c_str() : node.attribute("subSetDisplayName").as_string());
 		if (subSetDisplayNameAttr.empty())
 		{
 			std::string byVarName = getVariable("subset." + subsetAttr);
@@ -751,7 +812,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 		{
 			Subset subSet(subsetAttr, nameAttr, displayNameAttr, subSetDisplayNameAttr);
 
-			std::string appliesToAttr = resolvePlaceholders(node.attribute("appliesTo").as_string());
+			std::string appliesToAttr = resolvePlaceholders(subsetElement != nullptr && !subsetElement->appliesTo.empty() ? subsetElement->appliesTo.c_str() : node.attribute("appliesTo").as_string());
 			if (!appliesToAttr.empty())
 				subSet.appliesTo = Utils::String::splitAny(appliesToAttr, ", ", true);
 
@@ -767,7 +828,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 			if (nameAttr == perSystemSetName)
 				return true;
 		}
-		else if (nameAttr == mColorset || (mColorset.empty() && isFirstSubset(node)))
+		else if (nameAttr == mColorset || (mColorset.empty() && isFirstSubset(subsetAttr, firstSubsetName)))
 			return true;
 	}
 	else if (subsetAttr == "iconset")
@@ -778,17 +839,17 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 			if (nameAttr == perSystemSetName)
 				return true;
 		}
-		else if (nameAttr == mIconset || (mIconset.empty() && isFirstSubset(node)))
+		else if (nameAttr == mIconset || (mIconset.empty() && isFirstSubset(subsetAttr, firstSubsetName)))
 			return true;
 	}
 	else if (subsetAttr == "menu")
 	{
-		if (nameAttr == mMenu || (mMenu.empty() && isFirstSubset(node)))
+		if (nameAttr == mMenu || (mMenu.empty() && isFirstSubset(subsetAttr, firstSubsetName)))
 			return true;
 	}
 	else if (subsetAttr == "systemview")
 	{
-		if (nameAttr == mSystemview || (mSystemview.empty() && isFirstSubset(node)))
+		if (nameAttr == mSystemview || (mSystemview.empty() && isFirstSubset(subsetAttr, firstSubsetName)))
 			return true;
 	}
 	else if (subsetAttr == "gamelistview")
@@ -799,7 +860,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 			if (nameAttr == perSystemSetName)
 				return true;
 		}
-		else if (nameAttr == mGamelistview || (mGamelistview.empty() && isFirstSubset(node)))
+		else if (nameAttr == mGamelistview || (mGamelistview.empty() && isFirstSubset(subsetAttr, firstSubsetName)))
 			return true;
 	}
 	else
@@ -813,7 +874,7 @@ bool ThemeData::parseSubset(const pugi::xml_node& node)
 		else
 		{
 			std::string setID = Settings::getInstance()->getString("subset." + subsetAttr);
-			if (nameAttr == setID || (setID.empty() && isFirstSubset(node)))
+			if (nameAttr == setID || (setID.empty() && isFirstSubset(subsetAttr, firstSubsetName)))
 				return true;
 		}
 	}
@@ -1176,24 +1237,16 @@ void ThemeData::parseSubsetElement(const pugi::xml_node& root)
 	const std::string displayName = resolvePlaceholders(root.attribute("displayName").as_string());
 	const std::string appliesTo = root.attribute("appliesTo").as_string();
 
+	SubsetAttributes attributes;
+	attributes.subset = name;
+	attributes.appliesTo = appliesTo;
+	attributes.subSetDisplayName = displayName;
+
 	for (pugi::xml_node node = root.child("include"); node; node = node.next_sibling("include"))
 	{
-		node.remove_attribute("subset");
-		node.append_attribute("subset") = name.c_str();
-
-		if (!appliesTo.empty())
-		{
-			node.remove_attribute("appliesTo");
-			node.append_attribute("appliesTo") = appliesTo.c_str();
-		}
-
-		if (!displayName.empty())
-		{
-			node.remove_attribute("subSetDisplayName");
-			node.append_attribute("subSetDisplayName") = displayName.c_str();
-		}
-
+		mSubsetElement = &attributes;
 		parseInclude(node);
+		mSubsetElement = nullptr;
 	}
 }
 
@@ -1505,7 +1558,11 @@ void ThemeData::parseElement(const pugi::xml_node& root, const std::map<std::str
 			if (element.type == "menuIcons")
 				type = PATH;
 			else if (name == "animate" && std::string(root.name()) == "imagegrid")
-				node.set_name("animateSelection");
+			{
+				// Old name of animateSelection : the shared document can't be renamed
+				name = "animateSelection";
+				type = BOOLEAN;
+			}
 			else
 			{
 				LOG(LogWarning) << "Unknown property type \"" << name << "\" (for element of type " << root.name() << ").";
@@ -2158,8 +2215,8 @@ bool ThemeData::appendFile(const std::string& path, bool perGameOverride)
 {
 	mPaths.push_back(path);
 
-	pugi::xml_document includeDoc;
-	pugi::xml_parse_result result = includeDoc.load_file(path.c_str());
+	pugi::xml_parse_result result;
+	std::shared_ptr<pugi::xml_document> includeDoc = loadDocument(path, result);
 	if (!result)
 	{
 		mPaths.pop_back();
@@ -2167,7 +2224,7 @@ bool ThemeData::appendFile(const std::string& path, bool perGameOverride)
 		return false;
 	}
 
-	pugi::xml_node theme = includeDoc.child("theme");
+	pugi::xml_node theme = includeDoc->child("theme");
 	if (!theme)
 	{
 		mPaths.pop_back();
@@ -385,7 +385,7 @@ private:
 	void parseElement(const pugi::xml_node& elementNode, const std::map<std::string, ElementPropertyType>& typeMap, ThemeElement& element, ThemeView& view, bool overwrite = true);
 	bool parseRegion(const pugi::xml_node& node);
 	bool parseSubset(const pugi::xml_node& node);
-	bool isFirstSubset(const pugi::xml_node& node);
+	bool isFirstSubset(const std::string& subsetToFind, const std::string& name);
 	bool parseLanguage(const pugi::xml_node& node);
 	bool parseFilterAttributes(const pugi::xml_node& node);
 	void parseSubsetElement(const pugi::xml_node& root);
@@ -453,6 +453,16 @@ private:
 	static ThemeData* mDefaultTheme;	
 
 	bool mPerGameOverrideTmp;
+
+	// Attributes a <subset> element gives to the include being parsed : the shared documents are never modified
+	struct SubsetAttributes
+	{
+		std::string subset;
+		std::string appliesTo;
+		std::string subSetDisplayName;
+	};
+
+	const SubsetAttributes* mSubsetElement;
 };
 
 #endif // ES_CORE_THEME_DATA_H
@@ -1,9 +1,11 @@
 #include "Window.h"
 
+#include "anim/StoryboardAnimator.h"
 #include "components/HelpComponent.h"
 #include "components/ImageComponent.h"
 #include "components/TextComponent.h"
 #include "resources/Font.h"
+#include "resources/TextureDataManager.h"
 #include "resources/TextureResource.h"
 #include "InputManager.h"
 #include "Log.h"
@@ -15,6 +17,7 @@
 #include "LocaleES.h"
 #include "AudioManager.h"
 #include <SDL_events.h>
+#include <SDL_timer.h>
 #include "ThemeData.h"
 #include <mutex>
 #include "components/AsyncNotificationComponent.h"
@@ -25,11 +28,28 @@
 #include "Splash.h"
 #include "PowerSaver.h"
 
+// Delay before rendering an unchanged screen again, so changes that didn't invalidate the window still show up.
+// It grows while the screen stays the same.
+#define RECHECK_MIN_DELAY	100
+#define RECHECK_MAX_DELAY	500
+
 Window::Window() : mNormalizeNextUpdate(false), mFrameTimeElapsed(0), mFrameCountElapsed(0), mAverageDeltaTime(10),
   mAllowSleep(true), mSleeping(false), mTimeSinceLastInput(0), mScreenSaver(NULL), mRenderScreenSaver(false), mClockElapsed(0) 
 {		
 	mTransitionOffset = 0;
 
+	mRetainedRendering = false;
+	mInvalidated = true;
+	mLoadedTextures = 0;
+	mTimeSinceRender = 0;
+	mRecheckDelay = RECHECK_MIN_DELAY;
+
+	mRenderedFrames = 0;
+	mSkippedFrames = 0;
+	mRenderTime = 0;
+	mSavedTime = 0;
+	mRenderStatsElapsed = 0;
+
 	mHelp = new HelpComponent(this);
 	mBackgroundOverlay = new ImageComponent(this);
 	mBackgroundOverlay->setImage(":/scroll_gradient.png"); 
@@ -62,6 +82,8 @@ void Window::pushGui(GuiComponent* gui)
 	gui->onShow();
 	mGuiStack.push_back(gui);
 	gui->updateHelpPrompts();
+
+	invalidate();
 }
 
 void Window::removeGui(GuiComponent* gui)
@@ -73,6 +95,8 @@ void Window::removeGui(GuiComponent* gui)
 			gui->onHide();
 			i = mGuiStack.erase(i);
 
+			invalidate();
+
 			if(i == mGuiStack.cend() && mGuiStack.size()) // we just popped the stack and the stack is not empty
 			{
 				mGuiStack.back()->updateHelpPrompts();
@@ -110,6 +134,9 @@ bool Window::init(bool initRenderer, bool initInputManager)
 	if (initInputManager)
 		InputManager::getInstance()->init();
 
+	mRetainedRendering = Settings::getInstance()->getBool("RetainedRendering");
+	invalidate();
+
 	ResourceManager::getInstance()->reloadAll();
 
 	//keep a reference to the default fonts, so they don't keep getting destroyed/recreated
@@ -185,6 +212,8 @@ void Window::deinit(bool deinitRenderer)
 
 void Window::textInput(const char* text)
 {
+	invalidate();
+
 	if(peekGui())
 		peekGui()->textInput(text);
 }
@@ -197,6 +226,8 @@ void Window::input(InputConfig* config, Input input)
 	if (config->getDeviceIndex() > 0 && Settings::getInstance()->getBool("FirstJoystickOnly"))
 		return;
 
+	invalidate();
+
 	if (mScreenSaver) 
 	{
 		if (mScreenSaver->isScreenSaverActive() && Settings::getInstance()->getBool("ScreenSaverControls") &&
@@ -303,6 +334,7 @@ void Window::processNotificationMessages()
 	mNotificationPopups.push_back(infoPopup);
 
 	layoutNotificationPopups();
+	invalidate();
 }
 
 void Window::stopNotificationPopups()
@@ -345,6 +377,8 @@ void Window::updateNotificationPopups(int deltaTime)
 			PowerSaver::resume();
 		else
 			layoutNotificationPopups();
+
+		invalidate();
 	}
 }
 
@@ -424,6 +458,8 @@ void Window::update(int deltaTime)
 	{
 		mAverageDeltaTime = mFrameTimeElapsed / mFrameCountElapsed;
 
+		StoryboardAnimator::FrameStats storyboardStats = StoryboardAnimator::collectFrameStats();
+
 		if (Settings::DrawFramerate())
 		{
 			std::stringstream ss;
@@ -439,7 +475,21 @@ void Window::update(int deltaTime)
 
 			ss << "\nFont VRAM: " << fontVramUsageMb << " Tex VRAM: " << textureVramUsageMb <<
 				" Tex Max: " << textureTotalUsageMb;
+
+			// draw calls
+			const Renderer::FrameStats& stats = Renderer::getFrameStats();
+			ss << "\nDraw calls: " << stats.drawCalls << " (" << stats.batches << " batches) Sprites: " << stats.sprites << " Vertices: " << stats.vertices;
+
+			// storyboards, per frame
+			ss << "\nStoryboards: " << (storyboardStats.updates / mFrameCountElapsed) << " Properties: " << (storyboardStats.properties / mFrameCountElapsed) <<
+				" (" << (storyboardStats.fallbacks / mFrameCountElapsed) << " by name) Time: " << std::setprecision(3) << (storyboardStats.time / (float)mFrameCountElapsed) << "ms";
+
+			// retained rendering
+			if (mRetainedRendering)
+				ss << "\nFrames rendered: " << mRenderedFrames << " skipped: " << mSkippedFrames << " Render time saved: " << (int)mSavedTime << "ms";
+
 			mFrameDataText = std::unique_ptr<TextCache>(mDefaultFonts.at(1)->buildTextCache(ss.str(), 50.f, 50.f, 0xFF00FFFF));
+			invalidate();
 		}
 
 		mFrameTimeElapsed = 0;
@@ -466,7 +516,11 @@ void Window::update(int deltaTime)
 				else
 					clockBuf = Utils::Time::timeToString(clockNow, "%H:%M");
 
-				mClock->setText(clockBuf);
+				if (mClock->getText() != clockBuf)
+				{
+					mClock->setText(clockBuf);
+					invalidate();
+				}
 			}
 
 			mClockElapsed = 1000; // next update in 1000ms
@@ -493,10 +547,77 @@ void Window::update(int deltaTime)
 	updateNotificationPopups(deltaTime);
 
 	AudioManager::update(deltaTime);
+
+	updateScreenSaverState();
+	updateRenderStats(deltaTime);
+}
+
+void Window::updateScreenSaverState()
+{
+	unsigned int screensaverTime = (unsigned int)Settings::ScreenSaverTime();
+	if (mTimeSinceLastInput < screensaverTime || screensaverTime == 0)
+		return;
+
+	startScreenSaver();
+
+	if (!isProcessing() && mAllowSleep && (!mScreenSaver || mScreenSaver->allowSleep()))
+	{
+		// go to sleep
+		if (mSleeping == false) {
+			mSleeping = true;
+			onSleep();
+		}
+	}
+}
+
+bool Window::isRenderNeeded()
+{
+	if (!mRetainedRendering)
+		return true;
+
+	// Textures loaded in the background are displayed by the components when they render
+	unsigned int loadedTextures = TextureLoader::loadedCount;
+
+	if (mInvalidated.exchange(false) || loadedTextures != mLoadedTextures || Renderer::isFrameChanged())
+	{
+		mLoadedTextures = loadedTextures;
+		mRecheckDelay = RECHECK_MIN_DELAY;
+		return true;
+	}
+
+	if (mTimeSinceRender >= mRecheckDelay)
+	{
+		mRecheckDelay = Math::min(mRecheckDelay * 2, RECHECK_MAX_DELAY);
+		return true;
+	}
+
+	mSkippedFrames++;
+	if (mRenderedFrames > 0)
+		mSavedTime += mRenderTime / mRenderedFrames;
+
+	return false;
+}
+
+void Window::updateRenderStats(int deltaTime)
+{
+	mTimeSinceRender += deltaTime;
+
+	if (!mRetainedRendering)
+		return;
+
+	mRenderStatsElapsed += deltaTime;
+	if (mRenderStatsElapsed < 10000)
+		return;
+
+	LOG(LogDebug) << "Window : " << mRenderedFrames << " frames rendered, " << mSkippedFrames << " skipped, " << (int)mSavedTime << "ms of rendering saved";
+	mRenderStatsElapsed = 0;
 }
 
 void Window::render()
 {
+	Uint64 renderStart = SDL_GetPerformanceCounter();
+	mTimeSinceRender = 0;
+
 	Transform4x4f transform = Transform4x4f::Identity();
 
 	mRenderedHelpPrompts = false;
@@ -557,10 +678,6 @@ void Window::render()
 
 	Renderer::setMatrix(Transform4x4f::Identity());
 
-	unsigned int screensaverTime = (unsigned int)Settings::ScreenSaverTime();
-	if (mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
-		startScreenSaver();
-
 	// Render notifications
 	if (!mRenderScreenSaver)
 	{
@@ -580,17 +697,8 @@ void Window::render()
 	if (mVolumeInfo && Settings::VolumePopup())
 		mVolumeInfo->render(transform);
 
-	if(mTimeSinceLastInput >= screensaverTime && screensaverTime != 0)
-	{
-		if (!isProcessing() && mAllowSleep && (!mScreenSaver || mScreenSaver->allowSleep()))
-		{
-			// go to sleep
-			if (mSleeping == false) {
-				mSleeping = true;
-				onSleep();
-			}
-		}
-	}
+	mRenderedFrames++;
+	mRenderTime += (double)(SDL_GetPerformanceCounter() - renderStart) * 1000.0 / (double)SDL_GetPerformanceFrequency();
 }
 
 void Window::normalizeNextUpdate()
@@ -758,6 +866,8 @@ void Window::startScreenSaver()
 
 		mScreenSaver->startScreenSaver();
 		mRenderScreenSaver = true;
+
+		invalidate();
 	}
 }
 
@@ -769,6 +879,8 @@ bool Window::cancelScreenSaver()
 		mRenderScreenSaver = false;
 		mScreenSaver->resetCounts();
 
+		invalidate();
+
 		// Tell the GUI components the screensaver has stopped
 		for(auto i = mGuiStack.cbegin(); i != mGuiStack.cend(); i++)
 			(*i)->onScreenSaverDeactivate();
@@ -876,6 +988,10 @@ void Window::updateAsyncNotifications(int deltaTime)
 
 	if (changed && mAsyncNotificationComponent.size() == 0)
 		PowerSaver::resume();
+
+	// Their progress is set from other threads
+	if (changed || mAsyncNotificationComponent.size() > 0)
+		invalidate();
 }
 
 void Window::unregisterPostedFunctions(void* data)
@@ -912,12 +1028,16 @@ void Window::processPostedFunctions()
 {
 	std::unique_lock<std::mutex> lock(mNotificationMessagesLock);
 
+	if (mFunctions.empty())
+		return;
+
 	for (auto func : mFunctions)
 	{
 		TRYCATCH("processPostedFunction", func.func())
 	}
 
 	mFunctions.clear();
+	invalidate();
 }
 
 void Window::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
@@ -965,4 +1085,6 @@ void Window::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 		mBatteryIndicator->applyTheme(theme, "screen", "batteryIndicator", ThemeFlags::ALL);
 	
 	mVolumeInfo = std::make_shared<VolumeInfoComponent>(this);
+
+	invalidate();
 }
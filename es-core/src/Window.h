@@ -8,6 +8,7 @@
 #include "math/Vector2f.h"
 #include <memory>
 #include <functional>
+#include <atomic>
 
 class FileData;
 class Font;
@@ -59,6 +60,13 @@ public:
 	void update(int deltaTime);
 	void render();
 
+	// Asks for the next frame to be rendered. Can be called from any thread.
+	void invalidate() { mInvalidated = true; }
+
+	// With "RetainedRendering", false while the screen doesn't change : the previous frame is still displayed,
+	// and neither rendering nor presenting it again is needed. Called once per frame, after update().
+	bool isRenderNeeded();
+
 	bool init(bool initRenderer = true, bool initInputManager = true);
 	void deinit(bool deinitRenderer = true);
 
@@ -124,6 +132,9 @@ private:
 	// Returns true if at least one component on the stack is processing
 	bool isProcessing();
 
+	void updateScreenSaverState();
+	void updateRenderStats(int deltaTime);
+
 	HelpComponent*	mHelp;
 	ImageComponent* mBackgroundOverlay;
 	ScreenSaver*	mScreenSaver;	
@@ -159,6 +170,19 @@ private:
 	bool mRenderedHelpPrompts;
 
 	int mTransitionOffset;
+
+	// Retained rendering
+	bool				mRetainedRendering;
+	std::atomic<bool>	mInvalidated;
+	unsigned int		mLoadedTextures;
+	int					mTimeSinceRender;
+	int					mRecheckDelay;
+
+	unsigned int		mRenderedFrames;
+	unsigned int		mSkippedFrames;
+	double				mRenderTime;	// Milliseconds spent in render(), over the rendered frames
+	double				mSavedTime;		// Estimate of the rendering time of the skipped frames
+	int					mRenderStatsElapsed;
 };
 
 #endif // ES_CORE_WINDOW_H
@@ -0,0 +1,54 @@
+#include "PropertyId.h"
+
+#include <unordered_map>
+
+PropertyId getPropertyId(const std::string& name)
+{
+	static const std::unordered_map<std::string, PropertyId> ids =
+	{
+		{ "pos", PropertyId::Pos },
+		{ "x", PropertyId::X },
+		{ "y", PropertyId::Y },
+		{ "size", PropertyId::Size },
+		{ "w", PropertyId::W },
+		{ "h", PropertyId::H },
+		{ "origin", PropertyId::Origin },
+		{ "rotation", PropertyId::Rotation },
+		{ "rotationOrigin", PropertyId::RotationOrigin },
+		{ "opacity", PropertyId::Opacity },
+		{ "zIndex", PropertyId::ZIndex },
+		{ "scale", PropertyId::Scale },
+		{ "scaleOrigin", PropertyId::ScaleOrigin },
+		{ "offset", PropertyId::Offset },
+		{ "offsetX", PropertyId::OffsetX },
+		{ "offsetY", PropertyId::OffsetY },
+		{ "clipRect", PropertyId::ClipRect },
+
+		{ "maxSize", PropertyId::MaxSize },
+		{ "minSize", PropertyId::MinSize },
+		{ "color", PropertyId::Color },
+		{ "colorEnd", PropertyId::ColorEnd },
+		{ "reflexion", PropertyId::Reflexion },
+		{ "roundCorners", PropertyId::RoundCorners },
+		{ "path", PropertyId::Path },
+		{ "padding", PropertyId::Padding },
+		{ "backgroundColor", PropertyId::BackgroundColor },
+		{ "glowColor", PropertyId::GlowColor },
+		{ "glowSize", PropertyId::GlowSize },
+		{ "glowOffset", PropertyId::GlowOffset },
+		{ "lineSpacing", PropertyId::LineSpacing },
+		{ "text", PropertyId::Text },
+		{ "value", PropertyId::Value },
+
+		{ "centerColor", PropertyId::CenterColor },
+		{ "edgeColor", PropertyId::EdgeColor },
+		{ "animateColor", PropertyId::AnimateColor },
+		{ "cornerSize", PropertyId::CornerSize }
+	};
+
+	auto it = ids.find(name);
+	if (it == ids.cend())
+		return PropertyId::Unknown;
+
+	return it->second;
+}
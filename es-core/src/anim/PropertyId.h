@@ -0,0 +1,54 @@
+#pragma once
+
+#include <string>
+
+// Storyboard properties, resolved from their names when the theme is parsed.
+// Components set them with GuiComponent::setAnimatedProperty, without comparing strings at each frame.
+enum class PropertyId : unsigned char
+{
+	Unknown = 0,
+
+	// GuiComponent
+	Pos,
+	X,
+	Y,
+	Size,
+	W,
+	H,
+	Origin,
+	Rotation,
+	RotationOrigin,
+	Opacity,
+	ZIndex,
+	Scale,
+	ScaleOrigin,
+	Offset,
+	OffsetX,
+	OffsetY,
+	ClipRect,
+
+	// Images, texts & videos
+	MaxSize,
+	MinSize,
+	Color,
+	ColorEnd,
+	Reflexion,
+	RoundCorners,
+	Path,
+	Padding,
+	BackgroundColor,
+	GlowColor,
+	GlowSize,
+	GlowOffset,
+	LineSpacing,
+	Text,
+	Value,
+
+	// NinePatchComponent
+	CenterColor,
+	EdgeColor,
+	AnimateColor,
+	CornerSize
+};
+
+PropertyId getPropertyId(const std::string& name);
@@ -1,5 +1,16 @@
 #include "StoryboardAnimator.h"
 #include "PowerSaver.h"
+#include <SDL_timer.h>
+
+// Storyboards are only updated by the UI thread
+static StoryboardAnimator::FrameStats sFrameStats;
+
+StoryboardAnimator::FrameStats StoryboardAnimator::collectFrameStats()
+{
+	FrameStats stats = sFrameStats;
+	sFrameStats = FrameStats();
+	return stats;
+}
 
 StoryboardAnimator::StoryboardAnimator(GuiComponent* comp, ThemeStoryboard* storyboard)
 {
@@ -127,6 +138,33 @@ bool StoryboardAnimator::update(int elapsed)
 	if (mPaused || elapsed > 500)
 		return true;
 
+	const Uint64 start = SDL_GetPerformanceCounter();
+
+	bool ret = updateStories(elapsed);
+
+	sFrameStats.updates++;
+	sFrameStats.time += (float)((double)(SDL_GetPerformanceCounter() - start) * 1000.0 / (double)SDL_GetPerformanceFrequency());
+
+	return ret;
+}
+
+// Property ids are resolved by ThemeStoryboard : names are only compared for the properties a component doesn't know
+void StoryboardAnimator::applyProperty(ThemeAnimation* anim, const ThemeData::ThemeElement::Property& value)
+{
+	sFrameStats.properties++;
+
+	if (anim->propertyId != PropertyId::Unknown)
+	{
+		mComponent->setAnimatedProperty(anim->propertyId, value);
+		return;
+	}
+
+	sFrameStats.fallbacks++;
+	mComponent->setProperty(anim->propertyName, value);
+}
+
+bool StoryboardAnimator::updateStories(int elapsed)
+{
 	if (!mHasInitialProperties)
 	{
 		mHasInitialProperties = true;
@@ -143,7 +181,7 @@ bool StoryboardAnimator::update(int elapsed)
 				if (anim->from.type == ThemeData::ThemeElement::Property::Unknown)
 					anim->from = mComponent->getProperty(anim->propertyName);
 				else if (mDisabledProperties.find(anim->propertyName) == mDisabledProperties.cend())
-					mComponent->setProperty(anim->propertyName, anim->from);
+					applyProperty(anim, anim->from);
 			}
 		}
 	}
@@ -157,8 +195,8 @@ bool StoryboardAnimator::update(int elapsed)
 		auto story = _currentStories[i];
 		bool ended = !story->update(elapsed);
 
-		if (mDisabledProperties.find(story->animation->propertyName) == mDisabledProperties.cend())
-			mComponent->setProperty(story->animation->propertyName, story->currentValue);
+		if (mDisabledProperties.size() == 0 || mDisabledProperties.find(story->animation->propertyName) == mDisabledProperties.cend())
+			applyProperty(story->animation, story->currentValue);
 
 		if (ended)
 		{
@@ -156,6 +156,19 @@ private:
 class StoryboardAnimator
 {
 public:
+	struct FrameStats
+	{
+		FrameStats() : updates(0), properties(0), fallbacks(0), time(0) { }
+
+		unsigned int updates;    // Storyboards updated
+		unsigned int properties; // Properties set
+		unsigned int fallbacks;  // Properties set by their names
+		float        time;       // Milliseconds spent in update
+	};
+
+	// Totals since the previous call, shown with the framerate
+	static FrameStats collectFrameStats();
+
 	StoryboardAnimator(GuiComponent* comp, ThemeStoryboard* storyboard);
 	~StoryboardAnimator();
 
@@ -174,6 +187,8 @@ public:
 private:
 	void addNewAnimations();
 	void clearStories();
+	bool updateStories(int elapsed);
+	void applyProperty(ThemeAnimation* anim, const ThemeData::ThemeElement::Property& value);
 
 	GuiComponent* mComponent;
 	ThemeStoryboard* mStoryBoard;
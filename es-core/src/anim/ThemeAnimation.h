@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ThemeData.h"
+#include "PropertyId.h"
 #include "renderers/Renderer.h"
 #include <string>
 
@@ -27,12 +28,14 @@ public:
 		begin = 0;
 		autoReverse = false;
 		easingMode = EasingMode::Linear;
+		propertyId = PropertyId::Unknown;
 
 		from.type = ThemeData::ThemeElement::Property::PropertyType::Unknown;
 		to.type = ThemeData::ThemeElement::Property::PropertyType::Unknown;
 	}
 
 	std::string propertyName;
+	PropertyId propertyId;
 	int duration;
 	int begin;
 	bool autoReverse;	
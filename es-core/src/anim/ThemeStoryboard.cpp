@@ -122,6 +122,7 @@ bool ThemeStoryboard::fromXmlNode(const pugi::xml_node& root, const std::map<std
 		if (anim != nullptr)
 		{
 			anim->propertyName = prop;
+			anim->propertyId = getPropertyId(prop);
 
 			if (node.attribute("begin")) anim->begin = Utils::String::toInteger(node.attribute("begin").as_string());
 			if (node.attribute("duration")) anim->duration = Utils::String::toInteger(node.attribute("duration").as_string());
@@ -60,6 +60,7 @@ void AnimatedImageComponent::update(int deltaTime)
 	while(mFrames.at(mCurrentFrame).second <= mFrameAccumulator)
 	{
 		mCurrentFrame++;
+		invalidate();
 
 		if(mCurrentFrame == (int)mFrames.size())
 		{
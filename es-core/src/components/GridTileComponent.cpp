@@ -116,6 +116,15 @@ std::shared_ptr<TextureResource> GridTileComponent::getTexture(bool marquee)
 	return nullptr; 
 }
 
+void GridTileComponent::setLoadPriority(int priority)
+{
+	if (mImage != nullptr)
+		mImage->setLoadPriority(priority);
+
+	if (mMarquee != nullptr)
+		mMarquee->setLoadPriority(priority);
+}
+
 void GridTileComponent::resize()
 {
 	auto& currentProperties = getCurrentProperties();
@@ -911,14 +920,19 @@ void GridTileComponent::setImage(const std::string& path, bool isDefaultImage)
 
 	mCurrentPath = path;
 	
-	if (mSelectedProperties.Size.x() > mSize.x())
-		mImage->setImage(path, false, MaxSizeInfo(mSelectedProperties.Size, mSelectedProperties.Image.sizeMode != "maxSize"), false);
-	else
-		mImage->setImage(path, false, MaxSizeInfo(mSize, mSelectedProperties.Image.sizeMode != "maxSize"), false);
+	mImage->setImage(path, false, getImageMaxSizeInfo(), false);
 
 	resize();
 }
 
+MaxSizeInfo GridTileComponent::getImageMaxSizeInfo()
+{
+	if (mSelectedProperties.Size.x() > mSize.x())
+		return MaxSizeInfo(mSelectedProperties.Size, mSelectedProperties.Image.sizeMode != "maxSize");
+
+	return MaxSizeInfo(mSize, mSelectedProperties.Image.sizeMode != "maxSize");
+}
+
 void GridTileComponent::setMarquee(const std::string& path)
 {
 	if (mMarquee == nullptr)
@@ -244,6 +244,8 @@ public:
 	void forceMarquee(const std::string& path);
 
 	std::shared_ptr<TextureResource> getTexture(bool marquee = false);
+	void setLoadPriority(int priority);
+	MaxSizeInfo getImageMaxSizeInfo();
 
 	Vector3f getLaunchTarget();
 
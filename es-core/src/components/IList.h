@@ -129,6 +129,7 @@ public:
 		if(index >= 0 && index < (int)mEntries.size()) 
 		{
 			mCursor = onBeforeScroll(index, 1);			
+			invalidate();
 
 			listInput(0);
 			onCursorChanged(CURSOR_STOPPED);
@@ -144,6 +145,7 @@ public:
 	{
 		mEntries.clear();
 		mCursor = 0;
+		invalidate();
 		listInput(0);
 		onCursorChanged(CURSOR_STOPPED);
 	}
@@ -164,6 +166,7 @@ public:
 	{
 		assert(it != mEntries.cend());
 		mCursor = it - mEntries.cbegin();
+		invalidate();
 		onCursorChanged(CURSOR_STOPPED);
 	}
 
@@ -175,6 +178,7 @@ public:
 			if((*it).object == obj)
 			{
 				mCursor = (int)(it - mEntries.cbegin());
+				invalidate();
 				onCursorChanged(CURSOR_STOPPED);
 				return true;
 			}
@@ -234,6 +238,7 @@ protected:
 		if(mCursor > 0 && it - mEntries.cbegin() <= mCursor)
 		{
 			mCursor--;
+			invalidate();
 			onCursorChanged(CURSOR_STOPPED);
 		}
 
@@ -251,6 +256,9 @@ protected:
 		if (velocity == 0 && mScrollVelocity != 0)
 			sendCursorChanged = true; // onCursorChanged(CURSOR_STOPPED);
 
+		if (velocity != mScrollVelocity || mScrollTier != 0)
+			invalidate();
+
 		mScrollVelocity = velocity;
 		mScrollTier = 0;
 		mScrollTierAccumulator = 0;
@@ -269,6 +277,8 @@ protected:
 	void listUpdate(int deltaTime)
 	{
 		// update the title overlay opacity
+		unsigned char prevOpacity = mTitleOverlayOpacity;
+
 		const int dir = (mScrollTier >= mTierList.count - 1) ? 1 : -1; // fade in if scroll tier is >= 1, otherwise fade out
 		int op = mTitleOverlayOpacity + deltaTime*dir; // we just do a 1-to-1 time -> opacity, no scaling
 		if(op >= 255)
@@ -278,6 +288,9 @@ protected:
 		else
 			mTitleOverlayOpacity = (unsigned char)op;
 
+		if (mTitleOverlayOpacity != prevOpacity)
+			invalidate();
+
 		if(mScrollVelocity == 0 || size() < 2)
 			return;
 
@@ -298,6 +311,7 @@ protected:
 		{
 			mScrollTierAccumulator -= mTierList.tiers[mScrollTier].length;
 			mScrollTier++;
+			invalidate();
 		}
 
 		// actually perform the scrolling
@@ -386,7 +400,12 @@ protected:
 			cursor = onBeforeScroll(cursor, amt > 0 ? 1 : -1);
 
 		if(cursor != mCursor)
+		{
 			onScroll(absAmt);
+			invalidate();
+		}
+		else if (mScrollVelocity == 0)
+			invalidate(); // scrolling stopped at the end of the list
 
 		mCursor = cursor;
 		onCursorChanged((mScrollTier > 0) ? CURSOR_SCROLLING : CURSOR_STOPPED);
@@ -44,6 +44,9 @@ ImageComponent::~ImageComponent()
 {
 	if (mTexture != nullptr)
 		mTexture->setRequired(false);
+
+	if (mLoadingTexture != nullptr)
+		mLoadingTexture->setRequired(false);
 }
 
 void ImageComponent::resize()
@@ -196,6 +199,15 @@ void ImageComponent::setImage(std::string path, bool tile, MaxSizeInfo maxSize,
 		resize();
 }
 
+void ImageComponent::setLoadPriority(int priority)
+{
+	if (mLoadingTexture != nullptr)
+		mLoadingTexture->setLoadPriority(priority);
+
+	if (mTexture != nullptr && !mTexture->isLoaded())
+		mTexture->setLoadPriority(priority);
+}
+
 void ImageComponent::setImage(const char* path, size_t length, bool tile)
 {
 	mPath = "";
@@ -635,6 +647,25 @@ bool ImageComponent::hasImage()
 	return (bool)mTexture;
 }
 
+void ImageComponent::preload()
+{
+	auto texture = mLoadingTexture != nullptr ? mLoadingTexture : mTexture;
+	if (texture == nullptr || texture->isLoaded())
+		return;
+
+	// Required textures are not released when VRAM is cleaned up
+	texture->setRequired(true);
+	texture->preload();
+}
+
+bool ImageComponent::isLoaded()
+{
+	if (mLoadingTexture != nullptr)
+		return mLoadingTexture->isLoaded();
+
+	return mTexture != nullptr && mTexture->isLoaded();
+}
+
 void ImageComponent::applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties)
 {
 	using namespace ThemeFlags;
@@ -862,7 +893,10 @@ void ImageComponent::update(int deltaTime)
 		{
 			auto item = mPlaylist->getNextItem();
 			if (!item.empty())
+			{
 				setImage(item, false, getMaxSizeInfo());
+				invalidate();
+			}
 
 			mPlaylistTimer = 0.0;
 		}
@@ -896,41 +930,78 @@ ThemeData::ThemeElement::Property ImageComponent::getProperty(const std::string
 	return GuiComponent::getProperty(name);
 }
 
-void ImageComponent::setProperty(const std::string name, const ThemeData::ThemeElement::Property& value)
-{	
-	Vector2f scale = getParent() ? getParent()->getSize() : Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+bool ImageComponent::setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value)
+{
+	typedef ThemeData::ThemeElement::Property::PropertyType PropertyType;
 
-	if ((name == "maxSize" || name == "minSize") && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
-	{
-		mTargetSize = Vector2f(value.v.x() * scale.x(), value.v.y() * scale.y());
-		resize();
-	}
-	else if (name == "color" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+	switch (id)
 	{
+	case PropertyId::MaxSize:
+	case PropertyId::MinSize:
+		if (value.type != PropertyType::Pair)
+			break;
+		{
+			Vector2f scale = getParent() ? getParent()->getSize() : Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+			mTargetSize = Vector2f(value.v.x() * scale.x(), value.v.y() * scale.y());
+			resize();
+		}
+		return true;
+
+	case PropertyId::Color:
+		if (value.type != PropertyType::Int)
+			break;
+
 		if (mColorShift == mColorShiftEnd)
 			setColorShift(value.i);
 		else
 		{
-			mColorShift = value.i;			
+			mColorShift = value.i;
 			updateColors();
 		}
-	}
-	else if (name == "colorEnd" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+		return true;
+
+	case PropertyId::ColorEnd:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setColorShiftEnd(value.i);
-	else if (name == "reflexion" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
+		return true;
+
+	case PropertyId::Reflexion:
+		if (value.type != PropertyType::Pair)
+			break;
+
 		mReflection = value.v;
-	else if (name == "roundCorners" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
+		return true;
+
+	case PropertyId::RoundCorners:
+		if (value.type != PropertyType::Float)
+			break;
+
 		setRoundCorners(value.f);
-	else if (name == "padding" && value.type == ThemeData::ThemeElement::Property::PropertyType::Rect)
+		return true;
+
+	case PropertyId::Padding:
+		if (value.type != PropertyType::Rect)
+			break;
+
 		setPadding(value.r);
-	else if (name == "path" && value.type == ThemeData::ThemeElement::Property::PropertyType::String)
-	{
+		return true;
+
+	case PropertyId::Path:
+		if (value.type != PropertyType::String)
+			break;
+
 		mForceLoad = true;
 		mDynamic = false;
 		setImage(value.s, false);
+		return true;
+
+	default:
+		break;
 	}
-	else
-		GuiComponent::setProperty(name, value);
+
+	return GuiComponent::setAnimatedProperty(id, value);
 }
 
 void ImageComponent::setRoundCorners(float value) 
@@ -85,6 +85,10 @@ public:
 
 	bool hasImage();
 
+	// Loads the texture in the background before the image is rendered. isLoaded tells when it's ready.
+	void preload();
+	bool isLoaded();
+
 	void render(const Transform4x4f& parentTrans) override;
 
 	virtual void applyTheme(const std::shared_ptr<ThemeData>& theme, const std::string& view, const std::string& element, unsigned int properties) override;
@@ -95,6 +99,7 @@ public:
 	void setMirroring(Vector2f mirror) { mReflection = mirror; };
 
 	std::shared_ptr<TextureResource> getTexture() { return mTexture; };
+	void setLoadPriority(int priority);
 
 	const MaxSizeInfo getMaxSizeInfo()
 	{
@@ -126,7 +131,7 @@ public:
 	void setIsLinear(bool value) { mLinear = value; }
 
 	ThemeData::ThemeElement::Property getProperty(const std::string name) override;
-	void setProperty(const std::string name, const ThemeData::ThemeElement::Property& value) override;
+	bool setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value) override;
 	void setTargetIsMax() { mTargetIsMax = true; }
 
 protected:
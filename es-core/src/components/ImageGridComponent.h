@@ -106,6 +106,10 @@ public:
 	void setGridSizeOverride(Vector2f size);
 
 	std::shared_ptr<GridTileComponent> getSelectedTile();
+	MaxSizeInfo getImageMaxSizeInfo() { return mTiles.size() == 0 ? MaxSizeInfo() : mTiles.at(0)->getImageMaxSizeInfo(); }
+
+	// Pictures of the entries around the cursor, nearest first : the visible page and `pages` more pages on each side
+	std::vector<std::string> getImagePathsAround(int pages);
 	
 	void resetLastCursor() { mLastCursor = -1; mLastCursorState = CursorState::CURSOR_STOPPED; }
 	int getLastCursor() { return mLastCursor; }
@@ -238,6 +242,27 @@ void ImageGridComponent<T>::add(const std::string& name, const std::string& imag
 	mEntriesDirty = true;
 }
 
+template<typename T>
+std::vector<std::string> ImageGridComponent<T>::getImagePathsAround(int pages)
+{
+	std::vector<std::string> paths;
+
+	int count = (int)mEntries.size();
+	int cursor = Math::max(0, Math::min(mCursor, count - 1));
+	int range = mGridDimension.x() * mGridDimension.y() * (pages + 1);
+
+	for (int i = 0; i <= range && count > 0; i++)
+	{
+		if (cursor + i < count)
+			paths.push_back(mEntries.at(cursor + i).data.texturePath);
+
+		if (i > 0 && cursor - i >= 0)
+			paths.push_back(mEntries.at(cursor - i).data.texturePath);
+	}
+
+	return paths;
+}
+
 template<typename T>
 std::string ImageGridComponent<T>::getImage(const T& obj)
 {
@@ -989,6 +1014,11 @@ void ImageGridComponent<T>::updateTiles(bool allowAnimation, bool updateSelected
 		i++; img++;
 	}
 	
+	// Load the images nearest to the cursor first
+	img = mStartPosition - EXTRAITEMS * (isVertical() ? mGridDimension.x() : mGridDimension.y());
+	for (int ti = 0; ti < (int)mTiles.size(); ti++)
+		mTiles.at(ti)->setLoadPriority(std::abs(img + ti - mCursor));
+
 	// Collect new textures
 	std::vector<std::shared_ptr<TextureResource>> newTextures;
 	for (int ti = 0; ti < (int)mTiles.size(); ti++)
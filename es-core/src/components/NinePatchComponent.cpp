@@ -352,27 +352,60 @@ ThemeData::ThemeElement::Property NinePatchComponent::getProperty(const std::str
 	return GuiComponent::getProperty(name);
 }
 
-void NinePatchComponent::setProperty(const std::string name, const ThemeData::ThemeElement::Property& value)
+bool NinePatchComponent::setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value)
 {
-	Vector2f scale = getParent() ? getParent()->getSize() : Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+	typedef ThemeData::ThemeElement::Property::PropertyType PropertyType;
 
-	if (name == "color" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+	switch (id)
 	{
+	case PropertyId::Color:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setCenterColor(value.i);
 		setEdgeColor(value.i);
-	}
-	else if (name == "centerColor" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+		return true;
+
+	case PropertyId::CenterColor:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setCenterColor(value.i);
-	else if (name == "edgeColor" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+		return true;
+
+	case PropertyId::EdgeColor:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setEdgeColor(value.i);
-	else if (name == "animateColor" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+		return true;
+
+	case PropertyId::AnimateColor:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setAnimateColor(value.i);
-	else if (name == "cornerSize" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
+		return true;
+
+	case PropertyId::CornerSize:
+		if (value.type != PropertyType::Pair)
+			break;
+
 		setCornerSize(value.v);
-	else if (name == "padding" && value.type == ThemeData::ThemeElement::Property::PropertyType::Rect)
+		return true;
+
+	case PropertyId::Padding:
+		if (value.type != PropertyType::Rect)
+			break;
+
 		setPadding(value.r);
-	else
-		GuiComponent::setProperty(name, value);
+		return true;
+
+	default:
+		break;
+	}
+
+	return GuiComponent::setAnimatedProperty(id, value);
 }
 
 void NinePatchComponent::setPadding(const Vector4f padding) 
@@ -50,7 +50,7 @@ public:
 	virtual void onHide() override;
 
 	ThemeData::ThemeElement::Property getProperty(const std::string name) override;
-	void setProperty(const std::string name, const ThemeData::ThemeElement::Property& value) override;
+	bool setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value) override;
 
 	Vector4f getPadding() { return mPadding; }
 	void setPadding(const Vector4f padding);
@@ -401,6 +401,9 @@ void TextComponent::update(int deltaTime)
 		return;
 	}
 
+	const int marqueeOffset = mMarqueeOffset;
+	const int marqueeOffset2 = mMarqueeOffset2;
+
 	int sy = mSize.y() - mPadding.y() - mPadding.w();
 	const bool isMultiline = mAutoScroll != AutoScrollType::HORIZONTAL && (mSize.y() == 0 || sy > mFont->getHeight()*1.95f);
 
@@ -485,6 +488,9 @@ void TextComponent::update(int deltaTime)
 		mMarqueeOffset = 0;
 		mMarqueeOffset2 = 0;
 	}
+
+	if (mMarqueeOffset != marqueeOffset || mMarqueeOffset2 != marqueeOffset2)
+		invalidate();
 }
 
 void TextComponent::onShow()
@@ -698,30 +704,80 @@ ThemeData::ThemeElement::Property TextComponent::getProperty(const std::string n
 	return GuiComponent::getProperty(name);
 }
 
-void TextComponent::setProperty(const std::string name, const ThemeData::ThemeElement::Property& value)
+bool TextComponent::setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value)
 {
-	Vector2f scale = getParent() ? getParent()->getSize() : Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+	typedef ThemeData::ThemeElement::Property::PropertyType PropertyType;
+
+	switch (id)
+	{
+	case PropertyId::Color:
+		if (value.type != PropertyType::Int)
+			break;
 
-	if (name == "color" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
 		setColor(value.i);
-	else if (name == "backgroundColor" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+		return true;
+
+	case PropertyId::BackgroundColor:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setBackgroundColor(value.i);
-	else if (name == "glowColor" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+		return true;
+
+	case PropertyId::GlowColor:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setGlowColor(value.i);
-	else if (name == "glowSize" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
+		return true;
+
+	case PropertyId::GlowSize:
+		if (value.type != PropertyType::Float)
+			break;
+
 		setGlowSize(value.f);
-	else if (name == "glowOffset" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
+		return true;
+
+	case PropertyId::GlowOffset:
+		if (value.type != PropertyType::Pair)
+			break;
+
 		setGlowOffset(value.v.x(), value.v.y());
-	else if (name == "reflexion" && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
+		return true;
+
+	case PropertyId::Reflexion:
+		if (value.type != PropertyType::Pair)
+			break;
+
 		mReflection = value.v;
-	else if (name == "lineSpacing" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
+		return true;
+
+	case PropertyId::LineSpacing:
+		if (value.type != PropertyType::Float)
+			break;
+
 		setLineSpacing(value.f);
-	else if (name == "text" && value.type == ThemeData::ThemeElement::Property::PropertyType::String)
-		setText(value.s);	
-	else if (name == "value" && value.type == ThemeData::ThemeElement::Property::PropertyType::String)
+		return true;
+
+	case PropertyId::Text:
+		if (value.type != PropertyType::String)
+			break;
+
+		setText(value.s);
+		return true;
+
+	case PropertyId::Value:
+		if (value.type != PropertyType::String)
+			break;
+
 		setValue(value.s);
-	else
-		GuiComponent::setProperty(name, value);
+		return true;
+
+	default:
+		break;
+	}
+
+	return GuiComponent::setAnimatedProperty(id, value);
 }
 
 void TextComponent::setPadding(const Vector4f padding) 
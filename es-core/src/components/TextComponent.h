@@ -68,7 +68,7 @@ public:
 	std::string getOriginalThemeText() { return mSourceText; }
 
 	ThemeData::ThemeElement::Property getProperty(const std::string name) override;
-	void setProperty(const std::string name, const ThemeData::ThemeElement::Property& value) override;
+	bool setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value) override;
 
 	virtual void onShow() override;
 
@@ -241,6 +241,9 @@ void TextEditComponent::update(int deltaTime)
 	if (mBlinkTime >= BLINKTIME)
 		mBlinkTime = 0;
 
+	if (mEditing && (mBlinkTime == 0 || (mBlinkTime >= BLINKTIME / 2 && mBlinkTime - deltaTime < BLINKTIME / 2)))
+		invalidate();
+
 	updateCursorRepeat(deltaTime);
 	GuiComponent::update(deltaTime);
 }
@@ -486,6 +486,7 @@ void VideoComponent::update(int deltaTime)
 				if (diff < FADE_TIME_MS)
 				{
 					mFadeIn = (float)diff / (float)FADE_TIME_MS;
+					invalidate();
 					return;
 				}
 			}
@@ -494,6 +495,8 @@ void VideoComponent::update(int deltaTime)
 		// If the fade in is less than 1 then increment it
 		if (mFadeIn < 1.0f)
 		{
+			invalidate();
+
 			mFadeIn += deltaTime / (float)FADE_TIME_MS;
 			if (mFadeIn > 1.0f)
 				mFadeIn = 1.0f;
@@ -608,15 +611,18 @@ void VideoComponent::setRoundCorners(float value)
 	mStaticImage.setRoundCorners(value);
 }
 
-void VideoComponent::setProperty(const std::string name, const ThemeData::ThemeElement::Property& value)
+bool VideoComponent::setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value)
 {
-	GuiComponent::setProperty(name, value);
+	if (!GuiComponent::setAnimatedProperty(id, value))
+		return false;
 
 	if (hasStoryBoard() && !mStaticImage.hasStoryBoard("snapshot"))
 	{
-		if (name == "offset" || name == "offsetX" || name == "offsetY" || name == "scale")
-			mStaticImage.setProperty(name, value);
+		if (id == PropertyId::Offset || id == PropertyId::OffsetX || id == PropertyId::OffsetY || id == PropertyId::Scale)
+			mStaticImage.setAnimatedProperty(id, value);
 	}
+
+	return true;
 }
 
 void VideoComponent::setClipRect(const Vector4f& vec)
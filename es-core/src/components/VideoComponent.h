@@ -150,7 +150,7 @@ public:
 	bool getPlayAudio() { return mPlayAudio; }
 	void setPlayAudio(bool value) { mPlayAudio = value; }
 
-	void setProperty(const std::string name, const ThemeData::ThemeElement::Property& value) override;
+	bool setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value) override;
 
 	virtual void setClipRect(const Vector4f& vec);
 
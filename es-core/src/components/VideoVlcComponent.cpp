@@ -8,6 +8,7 @@
 #include <vlc/vlc.h>
 #include <SDL_mutex.h>
 #include <cmath>
+#include <deque>
 #include "SystemConf.h"
 #include "ThemeData.h"
 #include <SDL_timer.h>
@@ -18,11 +19,134 @@
 #endif
 
 #include "ImageIO.h"
+#include "resources/VideoInfoCache.h"
+#include "utils/TaskScheduler.h"
 
 #define MATHPI          3.141592653589793238462643383279502884L
 
 libvlc_instance_t* VideoVlcComponent::mVLC = NULL;
 
+// Media being opened in the background : parsing a file & creating its player can take long enough to freeze the UI.
+// The request is dropped by the component when the video is stopped meanwhile, the task then releases what it has created.
+struct VideoOpenRequest
+{
+	VideoOpenRequest() : vlc(nullptr), media(nullptr), player(nullptr), done(false), cancelled(false) { }
+
+	libvlc_instance_t*		 vlc;
+	std::string				 path;
+	std::vector<std::string> options;
+
+	std::mutex				 lock;
+	libvlc_media_t*			 media;
+	libvlc_media_player_t*	 player;
+	VideoInfo				 info;
+	bool					 done;
+	bool					 cancelled;
+};
+
+#define MAX_PRELOADED_VIDEOS 2
+
+// Medias opened by preloadVideo, before the components playing them exist. Only used by the UI thread
+static std::deque<std::shared_ptr<VideoOpenRequest>> sPreloadedVideos;
+
+// Tasks are run on a group which lives as long as the process : the scheduler may still be running them at exit
+static Utils::TaskGroup& getTaskGroup()
+{
+	static Utils::TaskGroup* group = new Utils::TaskGroup(Utils::TASK_UI);
+	return *group;
+}
+
+static void releaseMedia(libvlc_media_t*& media, libvlc_media_player_t*& player)
+{
+	if (player != nullptr)
+	{
+		libvlc_media_player_release(player);
+		player = nullptr;
+	}
+
+	if (media != nullptr)
+	{
+		libvlc_media_release(media);
+		media = nullptr;
+	}
+}
+
+// The task releases what it creates for a cancelled request, or it's released here if the task has already finished
+static void cancelRequest(const std::shared_ptr<VideoOpenRequest>& request)
+{
+	std::unique_lock<std::mutex> lock(request->lock);
+	request->cancelled = true;
+	releaseMedia(request->media, request->player);
+}
+
+static std::vector<std::string> getMediaOptions()
+{
+	// use : vlc long-help
+	// WIN32 ? libvlc_media_add_option(mMedia, ":avcodec-hw=dxva2");
+	// RPI/OMX ? libvlc_media_add_option(mMedia, ":codec=mediacodec,iomx,all"); .
+
+	std::string options = SystemConf::getInstance()->get("vlc.options");
+	if (!options.empty())
+		return Utils::String::split(options, ' ');
+
+	return std::vector<std::string>();
+}
+
+static void openMedia(const std::shared_ptr<VideoOpenRequest>& request)
+{
+	libvlc_media_t* media = libvlc_media_new_path(request->vlc, request->path.c_str());
+	libvlc_media_player_t* player = nullptr;
+
+	VideoInfo info;
+
+	if (media != nullptr)
+	{
+		for (auto option : request->options)
+			libvlc_media_add_option(media, option.c_str());
+
+		// Get the media metadata so we can find the aspect ratio
+		if (!VideoInfoCache::get(request->path, info))
+		{
+			libvlc_media_parse(media);
+
+			libvlc_media_track_t** tracks;
+			unsigned track_count = libvlc_media_tracks_get(media, &tracks);
+			for (unsigned track = 0; track < track_count; ++track)
+			{
+				if (tracks[track]->i_type == libvlc_track_audio)
+					info.hasAudio = true;
+				else if (tracks[track]->i_type == libvlc_track_video && info.width == 0)
+				{
+					info.width = tracks[track]->video->i_width;
+					info.height = tracks[track]->video->i_height;
+				}
+			}
+			libvlc_media_tracks_release(tracks, track_count);
+
+			libvlc_time_t duration = libvlc_media_get_duration(media);
+			info.duration = duration > 0 ? (int)duration : 0;
+			VideoInfoCache::set(request->path, info);
+		}
+
+		// Make sure we found a valid video track
+		if (info.width > 0 && info.height > 0)
+			player = libvlc_media_player_new_from_media(media);
+	}
+
+	std::unique_lock<std::mutex> lock(request->lock);
+
+	if (request->cancelled)
+	{
+		releaseMedia(media, player);
+		return;
+	}
+
+	request->media = media;
+	request->player = player;
+	request->info = info;
+	request->done = true;
+}
+
 // VLC prepares to render a video frame.
 static void *lock(void *data, void **p_pixels) 
 {
@@ -533,7 +657,7 @@ void VideoVlcComponent::handleLooping()
 
 void VideoVlcComponent::startVideo()
 {
-	if (mIsPlaying)
+	if (mIsPlaying || mOpenRequest != nullptr)
 		return;
 
 	if (hasStoryBoard("", true) && mConfig.startDelay > 0)
@@ -555,126 +679,134 @@ void VideoVlcComponent::startVideo()
 		// Set the video that we are going to be playing so we don't attempt to restart it
 		mPlayingVideoPath = mVideoPath;
 
-		// Open the media
-		mMedia = libvlc_media_new_path(mVLC, path.c_str());
-		if (mMedia)
-		{			
-			// use : vlc long-help
-			// WIN32 ? libvlc_media_add_option(mMedia, ":avcodec-hw=dxva2");
-			// RPI/OMX ? libvlc_media_add_option(mMedia, ":codec=mediacodec,iomx,all"); .
-
-			std::string options = SystemConf::getInstance()->get("vlc.options");
-			if (!options.empty())
-			{
-				std::vector<std::string> tokens = Utils::String::split(options, ' ');
-				for (auto token : tokens)
-					libvlc_media_add_option(mMedia, token.c_str());
-			}
-			
-			// If we have a playlist : most videos have a fader, skip it 1 second
-			if (mPlaylist != nullptr && mConfig.startDelay == 0 && !mConfig.showSnapshotDelay && !mConfig.showSnapshotNoVideo)
-				libvlc_media_add_option(mMedia, ":start-time=0.7");			
+		auto request = std::make_shared<VideoOpenRequest>();
+		request->vlc = mVLC;
+		request->path = path;
+		request->options = getMediaOptions();
 
-			bool hasAudioTrack = false;
+		// If we have a playlist : most videos have a fader, skip it 1 second
+		if (mPlaylist != nullptr && mConfig.startDelay == 0 && !mConfig.showSnapshotDelay && !mConfig.showSnapshotNoVideo)
+			request->options.push_back(":start-time=0.7");
 
-			unsigned track_count;
-			// Get the media metadata so we can find the aspect ratio
-			libvlc_media_parse(mMedia);
-			libvlc_media_track_t** tracks;
-			track_count = libvlc_media_tracks_get(mMedia, &tracks);
-			for (unsigned track = 0; track < track_count; ++track)
+		// The media may already be opened by preloadVideo
+		for (auto it = sPreloadedVideos.begin(); it != sPreloadedVideos.end(); it++)
+		{
+			if ((*it)->path == request->path && (*it)->options == request->options)
 			{
-				if (tracks[track]->i_type == libvlc_track_audio)
-					hasAudioTrack = true;
-				else if (tracks[track]->i_type == libvlc_track_video)
-				{
-					mVideoWidth = tracks[track]->video->i_width;
-					mVideoHeight = tracks[track]->video->i_height;		
+				mOpenRequest = *it;
+				sPreloadedVideos.erase(it);
 
-					if (hasAudioTrack)
-						break;
-				}
+				handleOpening();
+				return;
 			}
-			libvlc_media_tracks_release(tracks, track_count);
+		}
 
-			// Make sure we found a valid video track
-			if ((mVideoWidth > 0) && (mVideoHeight > 0))
-			{			
-				if (Settings::getInstance()->getBool("OptimizeVideo"))
-				{
-					// Avoid videos bigger than resolution
-					Vector2f maxSize(Renderer::getScreenWidth(), Renderer::getScreenHeight());
-										
-#ifdef _RPI_
-					// Temporary -> RPI -> Try to limit videos to 400x300 for performance benchmark
-					if (!Renderer::isSmallScreen())
-						maxSize = Vector2f(400, 300);
+		// The media is opened in the background, the player is started by handleOpening
+		mOpenRequest = request;
+		getTaskGroup().run([request] { openMedia(request); });
+	}
+}
+
+void VideoVlcComponent::preloadVideo(const std::string& videoPath)
+{
+	if (mVLC == nullptr || videoPath.empty())
+		return;
+
+#ifdef WIN32
+	std::string path(Utils::String::replace(videoPath, "/", "\\"));
+#else
+	std::string path(videoPath);
 #endif
 
-					if (!mTargetSize.empty() && (mTargetSize.x() < maxSize.x() || mTargetSize.y() < maxSize.y()))
-						maxSize = mTargetSize;
+	for (auto preloaded : sPreloadedVideos)
+		if (preloaded->path == path)
+			return;
 
-					
+	auto request = std::make_shared<VideoOpenRequest>();
+	request->vlc = mVLC;
+	request->path = path;
+	request->options = getMediaOptions();
 
-					// If video is bigger than display, ask VLC for a smaller image
-					auto sz = ImageIO::adjustPictureSize(Vector2i(mVideoWidth, mVideoHeight), Vector2i(maxSize.x(), maxSize.y()), mTargetIsMin);
-					if (sz.x() < mVideoWidth || sz.y() < mVideoHeight)
-					{
-						mVideoWidth = sz.x();
-						mVideoHeight = sz.y();
-					}
-				}
+	sPreloadedVideos.push_back(request);
+
+	while (sPreloadedVideos.size() > MAX_PRELOADED_VIDEOS)
+	{
+		cancelRequest(sPreloadedVideos.front());
+		sPreloadedVideos.pop_front();
+	}
 
-				PowerSaver::pause();
-				setupContext();
+	getTaskGroup().run([request] { openMedia(request); });
+}
 
-				// Setup the media player
-				mMediaPlayer = libvlc_media_player_new_from_media(mMedia);
-			
-				if (hasAudioTrack)
-				{
-					if (!getPlayAudio() || (!mScreensaverMode && !Settings::getInstance()->getBool("VideoAudio")) || (Settings::getInstance()->getBool("ScreenSaverVideoMute") && mScreensaverMode))
-						libvlc_audio_set_mute(mMediaPlayer, 1);
-					else
-						AudioManager::setVideoPlaying(true);
-				}
+void VideoVlcComponent::clearPreloadedVideos()
+{
+	for (auto preloaded : sPreloadedVideos)
+		cancelRequest(preloaded);
 
-				libvlc_media_player_play(mMediaPlayer);
-				libvlc_video_set_callbacks(mMediaPlayer, lock, unlock, display, (void*)&mContext);
-				libvlc_video_set_format(mMediaPlayer, "RGBA", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 4);
-				/*
-				if (true) // test wait video stream
-				{
-					int ps_time = SDL_GetTicks();
+	sPreloadedVideos.clear();
+}
 
-					int frame = mContext.surfaceId;
+void VideoVlcComponent::handleOpening()
+{
+	std::shared_ptr<VideoOpenRequest> request = mOpenRequest;
+
+	{
+		std::unique_lock<std::mutex> lock(request->lock);
+		if (!request->done)
+			return;
 
-					int cnt = 0;
-					while (cnt < 5)
-					{
-						int id = mContext.surfaceId;
+		mMedia = request->media;
+		mMediaPlayer = request->player;
+		request->media = nullptr;
+		request->player = nullptr;
+	}
 
-						if (frame != id)
-						{
-							cnt++;
-							frame = id;
-						}
-						::_sleep(2);
+	mOpenRequest = nullptr;
 
-						if (SDL_GetTicks() - ps_time > 300)
-							break;
-					}
+	if (mMediaPlayer == nullptr)
+		return;
 
-					mFadeIn = 1.0f;
-					mElapsed = 1000;
-				}*/
+	mVideoWidth = request->info.width;
+	mVideoHeight = request->info.height;
 
-				// Update the playing state -> Useless now set by display() & onVideoStarted
-				//mIsPlaying = true;
-				//mFadeIn = 0.0f;
-			}
+	if (Settings::getInstance()->getBool("OptimizeVideo"))
+	{
+		// Avoid videos bigger than resolution
+		Vector2f maxSize(Renderer::getScreenWidth(), Renderer::getScreenHeight());
+							
+#ifdef _RPI_
+		// Temporary -> RPI -> Try to limit videos to 400x300 for performance benchmark
+		if (!Renderer::isSmallScreen())
+			maxSize = Vector2f(400, 300);
+#endif
+
+		if (!mTargetSize.empty() && (mTargetSize.x() < maxSize.x() || mTargetSize.y() < maxSize.y()))
+			maxSize = mTargetSize;
+
+		// If video is bigger than display, ask VLC for a smaller image
+		auto sz = ImageIO::adjustPictureSize(Vector2i(mVideoWidth, mVideoHeight), Vector2i(maxSize.x(), maxSize.y()), mTargetIsMin);
+		if (sz.x() < mVideoWidth || sz.y() < mVideoHeight)
+		{
+			mVideoWidth = sz.x();
+			mVideoHeight = sz.y();
 		}
 	}
+
+	PowerSaver::pause();
+	setupContext();
+
+	if (request->info.hasAudio)
+	{
+		if (!getPlayAudio() || (!mScreensaverMode && !Settings::getInstance()->getBool("VideoAudio")) || (Settings::getInstance()->getBool("ScreenSaverVideoMute") && mScreensaverMode))
+			libvlc_audio_set_mute(mMediaPlayer, 1);
+		else
+			AudioManager::setVideoPlaying(true);
+	}
+
+	// The component is playing once the first frame is displayed -> set by display() & onVideoStarted
+	libvlc_video_set_callbacks(mMediaPlayer, lock, unlock, display, (void*)&mContext);
+	libvlc_video_set_format(mMediaPlayer, "RGBA", (int)mVideoWidth, (int)mVideoHeight, (int)mVideoWidth * 4);
+	libvlc_media_player_play(mMediaPlayer);
 }
 
 void VideoVlcComponent::stopVideo()
@@ -683,6 +815,13 @@ void VideoVlcComponent::stopVideo()
 	mIsWaitingForVideoToStart = false;
 	mStartDelayed = false;
 
+	// Media still opening
+	if (mOpenRequest != nullptr)
+	{
+		cancelRequest(mOpenRequest);
+		mOpenRequest = nullptr;
+	}
+
 	// Release the media player so it stops calling back to us
 	if (mMediaPlayer)
 	{
@@ -751,6 +890,13 @@ void VideoVlcComponent::update(int deltaTime)
 {
 	mElapsed += deltaTime;
 
+	if (mOpenRequest != nullptr)
+		handleOpening();
+
+	// Frames are uploaded when rendering
+	if (mIsPlaying && mContext.valid && mContext.hasFrame[mContext.surfaceId])
+		invalidate();
+
 	if (mConfig.showSnapshotNoVideo || mConfig.showSnapshotDelay)
 		mStaticImage.update(deltaTime);
 
@@ -782,23 +928,43 @@ ThemeData::ThemeElement::Property VideoVlcComponent::getProperty(const std::stri
 	return VideoComponent::getProperty(name);
 }
 
-void VideoVlcComponent::setProperty(const std::string name, const ThemeData::ThemeElement::Property& value)
+bool VideoVlcComponent::setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value)
 {
-	Vector2f scale = getParent() ? getParent()->getSize() : Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+	typedef ThemeData::ThemeElement::Property::PropertyType PropertyType;
 
-	if ((name == "maxSize" || name == "minSize") && value.type == ThemeData::ThemeElement::Property::PropertyType::Pair)
+	switch (id)
 	{
-		mTargetSize = Vector2f(value.v.x() * scale.x(), value.v.y() * scale.y());
-		resize();
-	}
-	else if (name == "color" && value.type == ThemeData::ThemeElement::Property::PropertyType::Int)
+	case PropertyId::MaxSize:
+	case PropertyId::MinSize:
+		if (value.type != PropertyType::Pair)
+			break;
+		{
+			Vector2f scale = getParent() ? getParent()->getSize() : Vector2f((float)Renderer::getScreenWidth(), (float)Renderer::getScreenHeight());
+			mTargetSize = Vector2f(value.v.x() * scale.x(), value.v.y() * scale.y());
+			resize();
+		}
+		return true;
+
+	case PropertyId::Color:
+		if (value.type != PropertyType::Int)
+			break;
+
 		setColorShift(value.i);
-	else if (name == "roundCorners" && value.type == ThemeData::ThemeElement::Property::PropertyType::Float)
+		return true;
+
+	case PropertyId::RoundCorners:
+		if (value.type != PropertyType::Float)
+			break;
+
 		setRoundCorners(value.f);
-	else
-		VideoComponent::setProperty(name, value);
-}
+		return true;
 
+	default:
+		break;
+	}
+
+	return VideoComponent::setAnimatedProperty(id, value);
+}
 
 void VideoVlcComponent::pauseVideo()
 {
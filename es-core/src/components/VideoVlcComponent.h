@@ -9,6 +9,7 @@
 struct libvlc_instance_t;
 struct libvlc_media_t;
 struct libvlc_media_player_t;
+struct VideoOpenRequest;
 
 struct VideoContext 
 {
@@ -58,6 +59,11 @@ class VideoVlcComponent : public VideoComponent
 public:
 	static void setupVLC(std::string subtitles);
 
+	// Opens the media of a video in the background before it's played, so the next video of a slideshow starts at once.
+	// Medias which are not played are released after a few other preloads, or by clearPreloadedVideos.
+	static void preloadVideo(const std::string& path);
+	static void clearPreloadedVideos();
+
 	VideoVlcComponent(Window* window, std::string subtitles="");
 	virtual ~VideoVlcComponent();
 
@@ -83,7 +89,7 @@ public:
 	virtual void onShow() override;
 
 	ThemeData::ThemeElement::Property getProperty(const std::string name) override;
-	void setProperty(const std::string name, const ThemeData::ThemeElement::Property& value) override;
+	bool setAnimatedProperty(PropertyId id, const ThemeData::ThemeElement::Property& value) override;
 
 	void setEffect(VideoVlcFlags::VideoVlcEffect effect) { mEffect = effect; }
 
@@ -111,10 +117,14 @@ private:
 	void setupContext();
 	void freeContext();
 
+	// Called on update : starts the player once the media was opened in the background
+	void handleOpening();
+
 private:
 	static libvlc_instance_t*		mVLC;
 	libvlc_media_t*					mMedia;
 	libvlc_media_player_t*			mMediaPlayer;
+	std::shared_ptr<VideoOpenRequest> mOpenRequest;
 	VideoContext					mContext;
 	std::shared_ptr<TextureResource> mTexture;
 
@@ -3,6 +3,8 @@
 #include "Renderer_GL21.h"
 #include "Renderer_GLES10.h"
 #include "Renderer_GLES20.h"
+#include "SpriteBatch.h"
+#include "TextureAtlas.h"
 
 #include "math/Transform4x4f.h"
 #include "math/Vector2i.h"
@@ -31,6 +33,38 @@ namespace Renderer
 
 	static Vector2i			sdlWindowPosition = Vector2i(SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED);
 
+	// Triangle strips are gathered in a batch, transformed by the matrix they were drawn with, until the texture,
+	// the blending or another state changes. The renderer then has an identity matrix, and gets the matrix back for other draws.
+	static SpriteBatch          spriteBatch;
+	static TextureAtlas         textureAtlas;
+	static bool                 batchingEnabled    = false;
+
+	static Transform4x4f        worldMatrix        = Transform4x4f::Identity();
+	static bool                 worldMatrixFlat    = true;
+	static bool                 rendererHasMatrix  = false;
+	static bool                 rendererIsIdentity = false;
+
+	static unsigned int         boundTexture       = 0;
+	static bool                 boundInAtlas       = false;
+	static TextureAtlas::Region boundRegion;
+
+	static FrameStats           frameStats;
+	static FrameStats           lastFrameStats;
+	static Uint64               frameStartTime     = 0;
+	static Uint64               statsStartTime     = 0;
+	static FrameStats           statsTotal;
+	static unsigned int         statsFrames        = 0;
+
+	#define FRAMEHASH_SEED  0xCBF29CE484222325ULL
+	#define FRAMEHASH_PRIME 0x100000001B3ULL
+
+	// Everything a frame draws is hashed, so a frame identical to the previous one can be detected without reading pixels back
+	static bool                 frameHashing       = false;
+	static uint64_t             frameHash          = FRAMEHASH_SEED;
+	static uint64_t             lastFrameHash      = 0;
+	static bool                 texturesChanged    = false;
+	static bool                 frameChanged       = true;
+
 	static void setIcon()
 	{
 		size_t                     width   = 0;
@@ -207,6 +241,9 @@ namespace Renderer
 
 	bool init()
 	{
+		batchingEnabled = Settings::getInstance()->getBool("SpriteBatching");
+		frameHashing = Settings::getInstance()->getBool("RetainedRendering");
+
 		if(!createWindow())
 			return false;
 
@@ -634,78 +671,329 @@ namespace Renderer
 		return Instance()->setupWindow();
 	}
 
+	//////////////////////////////////////////////////////////////////////////
+
+	static void flushBatch()
+	{
+		if (spriteBatch.isEmpty())
+			return;
+
+		if (!rendererIsIdentity)
+		{
+			Instance()->setMatrix(Transform4x4f::Identity());
+			rendererIsIdentity = true;
+			rendererHasMatrix = false;
+		}
+
+		frameStats.drawCalls++;
+		frameStats.batches++;
+		frameStats.vertices += spriteBatch.getNumVertices();
+
+		spriteBatch.flush(Instance());
+	}
+
+	// Draws the pending batch, and gives the current matrix and texture to the renderer
+	static void prepareDraw()
+	{
+		flushBatch();
+
+		if (!rendererHasMatrix)
+		{
+			Instance()->setMatrix(worldMatrix);
+			rendererHasMatrix = true;
+			rendererIsIdentity = false;
+		}
+
+		Instance()->bindTexture(boundInAtlas ? boundRegion.texture : boundTexture);
+		frameStats.drawCalls++;
+	}
+
+	// Texture coordinates of the vertices, moved into the atlas page of the bound texture
+	static std::vector<Vertex> getAtlasVertices(const Vertex* _vertices, const unsigned int _numVertices)
+	{
+		std::vector<Vertex> vertices(_vertices, _vertices + _numVertices);
+
+		for (auto& vertex : vertices)
+			vertex.tex = Vector2f(
+				boundRegion.x + Math::clamp(vertex.tex.x(), 0.0f, 1.0f) * boundRegion.w,
+				boundRegion.y + Math::clamp(vertex.tex.y(), 0.0f, 1.0f) * boundRegion.h);
+
+		return vertices;
+	}
+
+	static void updateBoundRegion()
+	{
+		const TextureAtlas::Region* region = TextureAtlas::isAtlasTexture(boundTexture) ? textureAtlas.getRegion(boundTexture) : nullptr;
+
+		boundInAtlas = region != nullptr;
+		if (boundInAtlas)
+			boundRegion = *region;
+	}
+
+	// FNV-1a, on 32 bits words rather than bytes : every hashed structure is made of 4 bytes members
+	static void hashFrameData(const void* _data, const size_t _size)
+	{
+		if (!frameHashing)
+			return;
+
+		const unsigned int* words = (const unsigned int*)_data;
+		const size_t        count = _size / sizeof(unsigned int);
+
+		uint64_t hash = frameHash;
+		for (size_t i = 0; i < count; i++)
+			hash = (hash ^ words[i]) * FRAMEHASH_PRIME;
+
+		frameHash = hash;
+	}
+
+	static void hashDraw(const unsigned int _type, const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		if (!frameHashing)
+			return;
+
+		const unsigned int state[4] = { _type, boundTexture, (unsigned int)_srcBlendFactor, (unsigned int)_dstBlendFactor };
+		hashFrameData(state, sizeof(state));
+		hashFrameData(&worldMatrix, sizeof(worldMatrix));
+		hashFrameData(_vertices, _numVertices * sizeof(Vertex));
+	}
+
+	static void updateFrameHash()
+	{
+		if (!frameHashing)
+			return;
+
+		frameChanged = texturesChanged || frameHash != lastFrameHash;
+		lastFrameHash = frameHash;
+
+		frameHash = FRAMEHASH_SEED;
+		texturesChanged = false;
+	}
+
+	static void updateFrameStats()
+	{
+		const Uint64 now = SDL_GetPerformanceCounter();
+		const Uint64 frequency = SDL_GetPerformanceFrequency();
+
+		if (frameStartTime != 0)
+			frameStats.frameTime = (float)((double)(now - frameStartTime) * 1000.0 / (double)frequency);
+
+		frameStartTime = now;
+		lastFrameStats = frameStats;
+
+		// Averages are logged so the renderer can be measured without looking at the screen
+		statsTotal.drawCalls += frameStats.drawCalls;
+		statsTotal.batches += frameStats.batches;
+		statsTotal.sprites += frameStats.sprites;
+		statsTotal.vertices += frameStats.vertices;
+		statsTotal.frameTime += frameStats.frameTime;
+		statsFrames++;
+
+		if (statsStartTime == 0)
+			statsStartTime = now;
+		else if (now - statsStartTime >= frequency * 10)
+		{
+			LOG(LogDebug) << "Renderer : " << statsFrames << " frames, per frame " <<
+				(statsTotal.drawCalls / statsFrames) << " draw calls (" << (statsTotal.batches / statsFrames) << " batches), " <<
+				(statsTotal.sprites / statsFrames) << " sprites, " << (statsTotal.vertices / statsFrames) << " vertices, " <<
+				(statsTotal.frameTime / statsFrames) << "ms";
+
+			statsTotal = FrameStats();
+			statsFrames = 0;
+			statsStartTime = now;
+		}
+
+		frameStats = FrameStats();
+	}
+
+	const FrameStats& getFrameStats()
+	{
+		return lastFrameStats;
+	}
+
+	bool isFrameChanged()
+	{
+		// Textures changed since are shown by the next frame
+		return !frameHashing || frameChanged || texturesChanged;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
 	void createContext() 
 	{
 		Instance()->createContext();
+
+		rendererHasMatrix = false;
+		rendererIsIdentity = false;
+		boundTexture = 0;
+		boundInAtlas = false;
 	}
 
 	void destroyContext()
 	{
+		flushBatch();
+		textureAtlas.clear();
+
 		Instance()->destroyContext();
 	}
 
 	unsigned int createTexture(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		return Instance()->createTexture(_type, _linear, _repeat, _width, _height, _data);
+		unsigned int texture = 0;
+
+		if (batchingEnabled && TextureAtlas::accepts(_type, _linear, _repeat, _width, _height, _data))
+			texture = textureAtlas.add(Instance(), _width, _height, _data);
+
+		if (texture == 0)
+			texture = Instance()->createTexture(_type, _linear, _repeat, _width, _height, _data);
+
+		texturesChanged = true;
+
+		// Like the renderers, leave the new texture bound
+		if (texture != 0)
+			bindTexture(texture);
+
+		return texture;
 	}
 
 	void  destroyTexture(const unsigned int _texture)
 	{
-		Instance()->destroyTexture(_texture);
+		flushBatch();
+		texturesChanged = true;
+
+		if (TextureAtlas::isAtlasTexture(_texture))
+			textureAtlas.remove(Instance(), _texture);
+		else
+			Instance()->destroyTexture(_texture);
+
+		if (boundTexture == _texture)
+		{
+			boundTexture = 0;
+			boundInAtlas = false;
+		}
 	}
 
 	void updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		Instance()->updateTexture(_texture, _type, _x, _y, _width, _height, _data);
+		flushBatch();
+		texturesChanged = true;
+
+		if (TextureAtlas::isAtlasTexture(_texture))
+		{
+			if (!textureAtlas.update(Instance(), _texture, _x, _y, _width, _height, _data))
+				LOG(LogWarning) << "Renderer::updateTexture : " << _width << "x" << _height << " doesn't fit in the texture atlas";
+
+			if (boundTexture == _texture)
+				updateBoundRegion();
+		}
+		else
+			Instance()->updateTexture(_texture, _type, _x, _y, _width, _height, _data);
 	}
 
 	void bindTexture(const unsigned int _texture)
 	{
-		Instance()->bindTexture(_texture);
+		if (boundTexture == _texture)
+			return;
+
+		boundTexture = _texture;
+		updateBoundRegion();
 	}
 
 	void drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
+		prepareDraw();
+		frameStats.vertices += _numVertices;
+		hashDraw(0, _vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
+
 		Instance()->drawLines(_vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
 	}
 
 	void drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor, bool verticesChanged)
 	{
-		Instance()->drawTriangleStrips(_vertices, _numVertices, _srcBlendFactor, _dstBlendFactor, verticesChanged);
+		frameStats.sprites++;
+		hashDraw(1, _vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
+
+		if (batchingEnabled && worldMatrixFlat)
+		{
+			const unsigned int texture = boundInAtlas ? boundRegion.texture : boundTexture;
+
+			if (!spriteBatch.matches(texture, _srcBlendFactor, _dstBlendFactor))
+			{
+				flushBatch();
+				spriteBatch.begin(texture, _srcBlendFactor, _dstBlendFactor);
+			}
+
+			spriteBatch.add(worldMatrix, boundInAtlas ? &boundRegion : nullptr, _vertices, _numVertices);
+			return;
+		}
+
+		prepareDraw();
+		frameStats.vertices += _numVertices;
+
+		if (boundInAtlas)
+		{
+			std::vector<Vertex> vertices = getAtlasVertices(_vertices, _numVertices);
+			Instance()->drawTriangleStrips(vertices.data(), _numVertices, _srcBlendFactor, _dstBlendFactor, true);
+		}
+		else // The previous strip may have been batched, the renderer doesn't have its vertices
+			Instance()->drawTriangleStrips(_vertices, _numVertices, _srcBlendFactor, _dstBlendFactor, verticesChanged || batchingEnabled);
 	}
 
 	void drawTriangleFan(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
-		Instance()->drawTriangleFan(_vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
+		prepareDraw();
+		frameStats.vertices += _numVertices;
+		hashDraw(2, _vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
+
+		if (boundInAtlas)
+		{
+			std::vector<Vertex> vertices = getAtlasVertices(_vertices, _numVertices);
+			Instance()->drawTriangleFan(vertices.data(), _numVertices, _srcBlendFactor, _dstBlendFactor);
+		}
+		else
+			Instance()->drawTriangleFan(_vertices, _numVertices, _srcBlendFactor, _dstBlendFactor);
 	}
 
 	void setProjection(const Transform4x4f& _projection)
 	{
+		flushBatch();
+		hashFrameData(&_projection, sizeof(_projection));
 		Instance()->setProjection(_projection);
 	}
 
 	void setMatrix(const Transform4x4f& _matrix)
 	{
-		Instance()->setMatrix(_matrix);
+		worldMatrix = _matrix;
+		worldMatrix.round();
+		worldMatrixFlat = SpriteBatch::isFlat(worldMatrix);
+
+		rendererHasMatrix = false;
 	}
 
 	void setViewport(const Rect& _viewport)
 	{
+		flushBatch();
+		hashFrameData(&_viewport, sizeof(_viewport));
 		return Instance()->setViewport(_viewport);
 	}
 
 	void setScissor(const Rect& _scissor)
 	{
+		flushBatch();
+		hashFrameData(&_scissor, sizeof(_scissor));
 		Instance()->setScissor(_scissor);
 	}
 
 	void setStencil(const Vertex* _vertices, const unsigned int _numVertices)
 	{
+		prepareDraw();
+		hashDraw(3, _vertices, _numVertices, Blend::ZERO, Blend::ZERO);
 		Instance()->setStencil(_vertices, _numVertices);
 	}
 
 	void disableStencil()
 	{
+		flushBatch();
+		hashDraw(4, nullptr, 0, Blend::ZERO, Blend::ZERO);
 		Instance()->disableStencil();
 	}
 
@@ -716,7 +1004,11 @@ namespace Renderer
 
 	void swapBuffers() 
 	{
+		flushBatch();
 		Instance()->swapBuffers();
+
+		updateFrameHash();
+		updateFrameStats();
 	}
 
 } // Renderer::
@@ -63,6 +63,18 @@ namespace Renderer
 
 	}; // Vertex
 
+	struct FrameStats
+	{
+		FrameStats() : drawCalls(0), batches(0), sprites(0), vertices(0), frameTime(0) { }
+
+		unsigned int drawCalls; // Calls to the graphics API
+		unsigned int batches;   // Draw calls of sprite batches
+		unsigned int sprites;   // Triangle strips drawn
+		unsigned int vertices;
+		float        frameTime; // Milliseconds between the last two frames
+
+	}; // FrameStats
+
 	class IRenderer
 	{
 	public:
@@ -84,6 +96,7 @@ namespace Renderer
 		virtual void         drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA) = 0;
 		virtual void         drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA, bool verticesChanged = true) = 0;
 		virtual void		 drawTriangleFan(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA) = 0;
+		virtual void         drawTriangles(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor = Blend::SRC_ALPHA, const Blend::Factor _dstBlendFactor = Blend::ONE_MINUS_SRC_ALPHA) = 0;
 
 		virtual void         setProjection(const Transform4x4f& _projection) = 0;
 		virtual void         setMatrix(const Transform4x4f& _matrix) = 0;
@@ -158,6 +171,13 @@ namespace Renderer
 
 	void		activateWindow();
 
+	// Draw calls and frame time of the last frame
+	const FrameStats& getFrameStats();
+
+	// False when the last frame drew exactly what the one before it did, with the same textures, and no texture changed since.
+	// Always true when frames aren't compared ("RetainedRendering" disabled).
+	bool isFrameChanged();
+
 } // Renderer::
 
 #endif // ES_CORE_RENDERER_RENDERER_H
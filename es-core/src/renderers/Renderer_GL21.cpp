@@ -153,11 +153,15 @@ namespace Renderer
 	{
 		glDeleteTextures(1, &_texture);
 
+		// Deleting the bound texture binds 0, and its id may be given again to a new texture
+		if (boundTexture == _texture)
+			bindTexture(0);
+
 	} // destroyTexture
 
 	void OpenGL21Renderer::updateTexture(const unsigned int _texture, const Texture::Type _type, const unsigned int _x, const unsigned _y, const unsigned int _width, const unsigned int _height, void* _data)
 	{
-		glBindTexture(GL_TEXTURE_2D, _texture);
+		bindTexture(_texture);
 
 		if (_x == -1 && _y == -1)
 		{
@@ -167,7 +171,7 @@ namespace Renderer
 		else 
 			glTexSubImage2D(GL_TEXTURE_2D, 0, _x, _y, _width, _height, convertTextureType(_type), GL_UNSIGNED_BYTE, _data);
 
-		glBindTexture(GL_TEXTURE_2D, 0);
+		bindTexture(0);
 
 	} // updateTexture
 
@@ -230,6 +234,28 @@ namespace Renderer
 
 	} // drawTriangleStrips
 
+	void OpenGL21Renderer::drawTriangles(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		glEnable(GL_BLEND);
+		glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor));
+
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+		glEnableClientState(GL_COLOR_ARRAY);
+
+		glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &_vertices[0].pos);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &_vertices[0].tex);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &_vertices[0].col);
+		glDrawArrays(GL_TRIANGLES, 0, _numVertices);
+
+		glDisableClientState(GL_COLOR_ARRAY);
+		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		glDisableClientState(GL_VERTEX_ARRAY);
+
+		glDisable(GL_BLEND);
+
+	} // drawTriangles
+
 	void OpenGL21Renderer::setProjection(const Transform4x4f& _projection)
 	{
 		glMatrixMode(GL_PROJECTION);
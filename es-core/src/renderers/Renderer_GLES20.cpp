@@ -8,12 +8,17 @@
 #include "Log.h"
 #include "Settings.h"
 
+#include <algorithm>
 #include <vector>
 #include <set>
 
 #include "GlExtensions.h"
 #include "Shader.h"
 
+// Vertices are appended to the buffer, which is orphaned once per frame or when it's full :
+// draws never wait for the previous ones still reading it
+#define VERTEXBUFFER_SIZE 16384
+
 namespace Renderer
 {
 
@@ -24,6 +29,7 @@ namespace Renderer
 	static Transform4x4f projectionMatrix = Transform4x4f::Identity();
 	static Transform4x4f worldViewMatrix  = Transform4x4f::Identity();
 	static Transform4x4f mvpMatrix		  = Transform4x4f::Identity();
+	static unsigned int  mvpVersion       = 1;
 
 	static Shader  	vertexShaderTexture;
 	static Shader  	fragmentShaderColorTexture;
@@ -37,25 +43,39 @@ namespace Renderer
 	static ShaderProgram    shaderProgramAlpha;
 
 	static GLuint        vertexBuffer     = 0;
+	static unsigned int  vertexBufferSize = 0;
+	static unsigned int  vertexBufferUsed = 0;
+	static GLint         verticesFirst    = 0;
 
 	static std::set<unsigned int> _alphaTextures;
 
 	static unsigned int boundTexture = 0;
+	static bool         boundAlphaTexture = false;
+
+	static bool          blendEnabled     = false;
+	static Blend::Factor blendSrcFactor   = Blend::ZERO;
+	static Blend::Factor blendDstFactor   = Blend::ZERO;
 
 //////////////////////////////////////////////////////////////////////////
 
 	static ShaderProgram* currentProgram = nullptr;
+
+	// Uniforms are kept by each program : the matrix is only given again when it has changed since
+	static void updateMvp(ShaderProgram* program)
+	{
+		if (program->mvpVersion == mvpVersion)
+			return;
+
+		GL_CHECK_ERROR(glUniformMatrix4fv(program->mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+		program->mvpVersion = mvpVersion;
+	}
 	
 	static void useProgram(ShaderProgram* program)
 	{
 		if (program == currentProgram)
 		{
-			if (currentProgram == &shaderProgramColorTexture)
-				GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorTexture.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
-			else  if (currentProgram == &shaderProgramColorNoTexture)
-				GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorNoTexture.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
-			else  if (currentProgram == &shaderProgramAlpha)
-				GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramAlpha.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+			if (currentProgram != nullptr)
+				updateMvp(currentProgram);
 
 			return;
 		}
@@ -88,7 +108,7 @@ namespace Renderer
 		if (currentProgram == &shaderProgramColorTexture)
 		{
 			GL_CHECK_ERROR(glUseProgram(shaderProgramColorTexture.id));
-			GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorTexture.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+			updateMvp(&shaderProgramColorTexture);
 
 			GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorTexture.posAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
 			GL_CHECK_ERROR(glEnableVertexAttribArray(shaderProgramColorTexture.posAttrib));
@@ -104,7 +124,7 @@ namespace Renderer
 		{
 			// Setup shader (always NOT textured)
 			GL_CHECK_ERROR(glUseProgram(shaderProgramColorNoTexture.id));
-			GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramColorNoTexture.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+			updateMvp(&shaderProgramColorNoTexture);
 
 			GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramColorNoTexture.posAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
 			GL_CHECK_ERROR(glEnableVertexAttribArray(shaderProgramColorNoTexture.posAttrib));
@@ -116,7 +136,7 @@ namespace Renderer
 		if (currentProgram == &shaderProgramAlpha)
 		{
 			GL_CHECK_ERROR(glUseProgram(shaderProgramAlpha.id));
-			GL_CHECK_ERROR(glUniformMatrix4fv(shaderProgramAlpha.mvpUniform, 1, GL_FALSE, (float*)&mvpMatrix));
+			updateMvp(&shaderProgramAlpha);
 
 			GL_CHECK_ERROR(glVertexAttribPointer(shaderProgramAlpha.posAttrib, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const void*)offsetof(Vertex, pos)));
 			GL_CHECK_ERROR(glEnableVertexAttribArray(shaderProgramAlpha.posAttrib));
@@ -265,6 +285,10 @@ namespace Renderer
 		texUniform = glGetUniformLocation(shaderProgramAlpha.id, "u_tex");
 		GL_CHECK_ERROR(glUniform1i(texUniform, 0));
 
+		shaderProgramColorNoTexture.mvpVersion = 0;
+		shaderProgramColorTexture.mvpVersion = 0;
+		shaderProgramAlpha.mvpVersion = 0;
+
 		useProgram(nullptr);
 	} // setupShaders
 
@@ -275,8 +299,31 @@ namespace Renderer
 		GL_CHECK_ERROR(glGenBuffers(1, &vertexBuffer));
 		GL_CHECK_ERROR(glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer));
 
+		vertexBufferSize = 0;
+		vertexBufferUsed = 0;
+
 	} // setupVertexBuffer
 
+	// Returns the index of the first vertex in the buffer
+	static GLint uploadVertices(const Vertex* _vertices, const unsigned int _numVertices)
+	{
+		if (vertexBufferUsed + _numVertices > vertexBufferSize)
+		{
+			vertexBufferSize = std::max((unsigned int)VERTEXBUFFER_SIZE, _numVertices);
+			vertexBufferUsed = 0;
+
+			GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertexBufferSize, nullptr, GL_STREAM_DRAW));
+		}
+
+		GL_CHECK_ERROR(glBufferSubData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertexBufferUsed, sizeof(Vertex) * _numVertices, _vertices));
+
+		verticesFirst = vertexBufferUsed;
+		vertexBufferUsed += _numVertices;
+
+		return verticesFirst;
+
+	} // uploadVertices
+
 //////////////////////////////////////////////////////////////////////////
 
 	static GLenum convertBlendFactor(const Blend::Factor _blendFactor)
@@ -298,6 +345,45 @@ namespace Renderer
 
 	} // convertBlendFactor
 
+//////////////////////////////////////////////////////////////////////////
+
+	static void setBlending(const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		const bool enabled = _srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE;
+
+		if (enabled != blendEnabled)
+		{
+			if (enabled)
+				GL_CHECK_ERROR(glEnable(GL_BLEND));
+			else
+				GL_CHECK_ERROR(glDisable(GL_BLEND));
+
+			blendEnabled = enabled;
+		}
+
+		if (enabled && (_srcBlendFactor != blendSrcFactor || _dstBlendFactor != blendDstFactor))
+		{
+			GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
+
+			blendSrcFactor = _srcBlendFactor;
+			blendDstFactor = _dstBlendFactor;
+		}
+
+	} // setBlending
+
+//////////////////////////////////////////////////////////////////////////
+
+	static void useTextureProgram()
+	{
+		if (boundTexture == 0)
+			useProgram(&shaderProgramColorNoTexture);
+		else if (boundAlphaTexture)
+			useProgram(&shaderProgramAlpha);
+		else
+			useProgram(&shaderProgramColorTexture);
+
+	} // useTextureProgram
+
 //////////////////////////////////////////////////////////////////////////
 
 	static GLenum convertTextureType(const Texture::Type _type)
@@ -447,6 +533,13 @@ namespace Renderer
 
 		GL_CHECK_ERROR(glClearColor(0.0f, 0.0f, 0.0f, 1.0f));
 
+		currentProgram = nullptr;
+		boundTexture = 0;
+		boundAlphaTexture = false;
+		blendEnabled = false;
+		blendSrcFactor = Blend::ZERO;
+		blendDstFactor = Blend::ZERO;
+
 #if OPENGL_EXTENSIONS
 		GL_CHECK_ERROR(glActiveTexture_(GL_TEXTURE0));
 #else
@@ -525,8 +618,13 @@ namespace Renderer
 		}
 
 		if (type == GL_ALPHA && texture != 0 && _alphaTextures.find(texture) == _alphaTextures.cend())
+		{
 			_alphaTextures.insert(texture);
 
+			if (boundTexture == texture)
+				boundAlphaTexture = true;
+		}
+
 		return texture;
 
 	} // createTexture
@@ -541,6 +639,13 @@ namespace Renderer
 
 		GL_CHECK_ERROR(glDeleteTextures(1, &_texture));
 
+		// Deleting the bound texture binds 0, and its id may be given again to a new texture
+		if (boundTexture == _texture)
+		{
+			boundTexture = 0;
+			boundAlphaTexture = false;
+		}
+
 	} // destroyTexture
 
 //////////////////////////////////////////////////////////////////////////
@@ -587,11 +692,13 @@ namespace Renderer
 		{
 			GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, 0));
 			boundTexture = 0;
+			boundAlphaTexture = false;
 		}
 		else
 		{
 			GL_CHECK_ERROR(glBindTexture(GL_TEXTURE_2D, _texture));
 			boundTexture = _texture;
+			boundAlphaTexture = _alphaTextures.find(_texture) != _alphaTextures.cend();
 		}
 
 	} // bindTexture
@@ -601,23 +708,13 @@ namespace Renderer
 	void GLES20Renderer::drawLines(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{
 		// Pass buffer data
-		GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_DYNAMIC_DRAW));
+		const GLint first = uploadVertices(_vertices, _numVertices);
 
 		useProgram(&shaderProgramColorNoTexture);
 
 		// Do rendering
-		if (_srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE)
-		{
-			GL_CHECK_ERROR(glEnable(GL_BLEND));
-			GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
-			GL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, _numVertices));
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-		}
-		else
-		{
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-			GL_CHECK_ERROR(glDrawArrays(GL_LINES, 0, _numVertices));
-		}
+		setBlending(_srcBlendFactor, _dstBlendFactor);
+		GL_CHECK_ERROR(glDrawArrays(GL_LINES, first, _numVertices));
 
 	} // drawLines
 
@@ -625,41 +722,36 @@ namespace Renderer
 
 	void GLES20Renderer::drawTriangleStrips(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor, bool verticesChanged)
 	{
-		if (verticesChanged)
-			GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_DYNAMIC_DRAW));
+		// The same vertices as the previous draw are still in the buffer
+		const GLint first = verticesChanged ? uploadVertices(_vertices, _numVertices) : verticesFirst;
 
 		// Setup shader
-		if (boundTexture != 0)
-		{
-			if (_alphaTextures.find(boundTexture) != _alphaTextures.cend())
-				useProgram(&shaderProgramAlpha);
-			else
-				useProgram(&shaderProgramColorTexture);
-		}
-		else
-			useProgram(&shaderProgramColorNoTexture);
+		useTextureProgram();
 
 		// Do rendering
-		if (_srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE)
-		{
-			GL_CHECK_ERROR(glEnable(GL_BLEND));
-			GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices));
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-		}
-		else
-		{
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, 0, _numVertices));
-		}
+		setBlending(_srcBlendFactor, _dstBlendFactor);
+		GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_STRIP, first, _numVertices));
 	} // drawTriangleStrips
 
+//////////////////////////////////////////////////////////////////////////
+
+	void GLES20Renderer::drawTriangles(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		const GLint first = uploadVertices(_vertices, _numVertices);
+
+		useTextureProgram();
+
+		setBlending(_srcBlendFactor, _dstBlendFactor);
+		GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLES, first, _numVertices));
+	} // drawTriangles
+
 //////////////////////////////////////////////////////////////////////////
 
 	void GLES20Renderer::setProjection(const Transform4x4f& _projection)
 	{
 		projectionMatrix = _projection;
 		mvpMatrix = projectionMatrix * worldViewMatrix;
+		mvpVersion++;
 	} // setProjection
 
 //////////////////////////////////////////////////////////////////////////
@@ -669,6 +761,7 @@ namespace Renderer
 		worldViewMatrix = _matrix;
 		worldViewMatrix.round();
 		mvpMatrix = projectionMatrix * worldViewMatrix;
+		mvpVersion++;
 	} // setMatrix
 
 //////////////////////////////////////////////////////////////////////////
@@ -724,6 +817,9 @@ namespace Renderer
 	{
 		useProgram(nullptr);
 		SDL_GL_SwapWindow(getSDLWindow());
+
+		// The next frame starts with a new buffer
+		vertexBufferUsed = vertexBufferSize;
 		GL_CHECK_ERROR(glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
 	} // swapBuffers
 
@@ -732,32 +828,14 @@ namespace Renderer
 	void GLES20Renderer::drawTriangleFan(const Vertex* _vertices, const unsigned int _numVertices, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
 	{		
 		// Pass buffer data
-		GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_DYNAMIC_DRAW));
+		const GLint first = uploadVertices(_vertices, _numVertices);
 
 		// Setup shader
-		if (boundTexture != 0)
-		{
-			if (_alphaTextures.find(boundTexture) != _alphaTextures.cend())
-				useProgram(&shaderProgramAlpha);
-			else
-				useProgram(&shaderProgramColorTexture);
-		}
-		else
-			useProgram(&shaderProgramColorNoTexture);
+		useTextureProgram();
 
 		// Do rendering
-		if (_srcBlendFactor != Blend::ONE && _dstBlendFactor != Blend::ONE)
-		{
-			GL_CHECK_ERROR(glEnable(GL_BLEND));
-			GL_CHECK_ERROR(glBlendFunc(convertBlendFactor(_srcBlendFactor), convertBlendFactor(_dstBlendFactor)));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_FAN, 0, _numVertices));
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-		}
-		else
-		{
-			GL_CHECK_ERROR(glDisable(GL_BLEND));
-			GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_FAN, 0, _numVertices));			
-		}
+		setBlending(_srcBlendFactor, _dstBlendFactor);
+		GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLE_FAN, first, _numVertices));
 	}
 
 	void GLES20Renderer::setStencil(const Vertex* _vertices, const unsigned int _numVertices)
@@ -772,8 +850,8 @@ namespace Renderer
 		glStencilMask(0xFF);
 		glClear(GL_STENCIL_BUFFER_BIT);
 		
-		glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _numVertices, _vertices, GL_DYNAMIC_DRAW);
-		glDrawArrays(GL_TRIANGLE_FAN, 0, _numVertices);
+		const GLint first = uploadVertices(_vertices, _numVertices);
+		glDrawArrays(GL_TRIANGLE_FAN, first, _numVertices);
 
 		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 		glDepthMask(GL_TRUE);
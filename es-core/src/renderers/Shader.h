@@ -26,6 +26,7 @@ namespace Renderer
 		GLint colAttrib;
 		GLint texAttrib;
 		GLint mvpUniform;
+		unsigned int mvpVersion; // Version of the matrix last given to mvpUniform
 
 		// Links vertex and fragment shaders together to make a GLSL program
 		bool linkShaderProgram(Shader &vertexShader, Shader &fragmentShader);
@@ -0,0 +1,82 @@
+#include "renderers/SpriteBatch.h"
+
+#include "math/Transform4x4f.h"
+
+namespace Renderer
+{
+	SpriteBatch::SpriteBatch() : mTexture(0), mSrcBlendFactor(Blend::SRC_ALPHA), mDstBlendFactor(Blend::ONE_MINUS_SRC_ALPHA)
+	{
+
+	} // SpriteBatch
+
+	bool SpriteBatch::isFlat(const Transform4x4f& _matrix)
+	{
+		const float* tm = (const float*)&_matrix;
+		return tm[2] == 0 && tm[6] == 0 && tm[14] == 0 && tm[3] == 0 && tm[7] == 0 && tm[15] == 1;
+
+	} // isFlat
+
+	void SpriteBatch::begin(const unsigned int _texture, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor)
+	{
+		mTexture = _texture;
+		mSrcBlendFactor = _srcBlendFactor;
+		mDstBlendFactor = _dstBlendFactor;
+
+	} // begin
+
+	void SpriteBatch::add(const Transform4x4f& _matrix, const TextureAtlas::Region* _region, const Vertex* _vertices, const unsigned int _numVertices)
+	{
+		if (_numVertices < 3)
+			return;
+
+		const float* tm = (const float*)&_matrix;
+
+		mStrip.resize(_numVertices);
+
+		for (unsigned int i = 0; i < _numVertices; i++)
+		{
+			const Vertex& source = _vertices[i];
+			Vertex&       vertex = mStrip[i];
+
+			vertex.pos = Vector2f(tm[0] * source.pos.x() + tm[4] * source.pos.y() + tm[12], tm[1] * source.pos.x() + tm[5] * source.pos.y() + tm[13]);
+			vertex.col = source.col;
+
+			// Atlas pages are clamped at the border of the picture, as its own texture would be
+			if (_region != nullptr)
+				vertex.tex = Vector2f(
+					_region->x + Math::clamp(source.tex.x(), 0.0f, 1.0f) * _region->w,
+					_region->y + Math::clamp(source.tex.y(), 0.0f, 1.0f) * _region->h);
+			else
+				vertex.tex = source.tex;
+		}
+
+		// Degenerated triangles, which join the quads of a text, are not drawn anyway
+		for (unsigned int i = 0; i + 2 < _numVertices; i++)
+		{
+			const Vertex& a = mStrip[i];
+			const Vertex& b = mStrip[i + 1];
+			const Vertex& c = mStrip[i + 2];
+
+			if (a.pos == b.pos || b.pos == c.pos || a.pos == c.pos)
+				continue;
+
+			mVertices.push_back(a);
+			mVertices.push_back(b);
+			mVertices.push_back(c);
+		}
+
+	} // add
+
+	void SpriteBatch::flush(IRenderer* _renderer)
+	{
+		if (mVertices.empty())
+			return;
+
+		_renderer->bindTexture(mTexture);
+		_renderer->drawTriangles(mVertices.data(), (unsigned int)mVertices.size(), mSrcBlendFactor, mDstBlendFactor);
+
+		mVertices.clear();
+
+	} // flush
+
+} // Renderer::
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef ES_CORE_RENDERER_SPRITE_BATCH_H
+#define ES_CORE_RENDERER_SPRITE_BATCH_H
+
+#include "renderers/Renderer.h"
+#include "renderers/TextureAtlas.h"
+#include <vector>
+
+class Transform4x4f;
+
+namespace Renderer
+{
+	// Triangle strips sharing the same texture and blending, gathered as triangles in screen coordinates
+	// so they are drawn with a single call.
+	class SpriteBatch
+	{
+	public:
+		SpriteBatch();
+
+		// Only 2D transforms can be applied before drawing : the others would change depth clipping
+		static bool isFlat(const Transform4x4f& _matrix);
+
+		bool isEmpty() const { return mVertices.empty(); }
+		bool matches(const unsigned int _texture, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor) const { return mTexture == _texture && mSrcBlendFactor == _srcBlendFactor && mDstBlendFactor == _dstBlendFactor; }
+
+		// Starts a batch with a new state, the previous one must have been drawn
+		void begin(const unsigned int _texture, const Blend::Factor _srcBlendFactor, const Blend::Factor _dstBlendFactor);
+
+		// Texture coordinates are moved into the region when the texture is in the atlas
+		void add(const Transform4x4f& _matrix, const TextureAtlas::Region* _region, const Vertex* _vertices, const unsigned int _numVertices);
+
+		// Draws the batch with the renderer, which must have an identity matrix, and empties it
+		void flush(IRenderer* _renderer);
+
+		unsigned int  getTexture() const        { return mTexture; }
+		unsigned int  getNumVertices() const    { return (unsigned int)mVertices.size(); }
+
+	private:
+		unsigned int        mTexture;
+		Blend::Factor       mSrcBlendFactor;
+		Blend::Factor       mDstBlendFactor;
+		std::vector<Vertex> mVertices;
+		std::vector<Vertex> mStrip; // Strip being added, once transformed
+
+	}; // SpriteBatch
+
+} // Renderer::
+
+#endif // ES_CORE_RENDERER_SPRITE_BATCH_H
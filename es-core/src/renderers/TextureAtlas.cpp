@@ -0,0 +1,251 @@
+#include "renderers/TextureAtlas.h"
+
+#include "Log.h"
+#include <algorithm>
+#include <string.h>
+
+#define TEXTUREATLAS_PAGE_SIZE	1024
+#define TEXTUREATLAS_MAX_PAGES	8
+#define TEXTUREATLAS_MIN_CELL	32
+#define TEXTUREATLAS_MAX_CELL	128
+
+namespace Renderer
+{
+	static int getCellSize(const int _width, const int _height)
+	{
+		const int size = std::max(_width, _height) + 2;
+
+		for (int cell = TEXTUREATLAS_MIN_CELL; cell <= TEXTUREATLAS_MAX_CELL; cell *= 2)
+			if (size <= cell)
+				return cell;
+
+		return 0;
+
+	} // getCellSize
+
+	TextureAtlas::TextureAtlas()
+	{
+
+	} // TextureAtlas
+
+	bool TextureAtlas::accepts(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		// Pages are linear and clamped, repeated textures need their own one
+		if (_type != Texture::RGBA || !_linear || _repeat || _data == nullptr)
+			return false;
+
+		return _width > 0 && _height > 0 && getCellSize(_width, _height) != 0;
+
+	} // accepts
+
+	unsigned int TextureAtlas::add(IRenderer* _renderer, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		int page, cell;
+		if (!allocate(_renderer, _width, _height, page, cell))
+			return 0;
+
+		unsigned int index;
+		if (!mFreeEntries.empty())
+		{
+			index = mFreeEntries.back();
+			mFreeEntries.pop_back();
+		}
+		else
+		{
+			index = (unsigned int)mEntries.size();
+			mEntries.push_back(Entry());
+		}
+
+		Entry& entry = mEntries[index];
+		entry.page = page;
+		entry.cell = cell;
+		upload(_renderer, entry, _width, _height, _data);
+
+		return TEXTUREATLAS_FIRST_ID + index;
+
+	} // add
+
+	bool TextureAtlas::update(IRenderer* _renderer, const unsigned int _texture, const unsigned int _x, const unsigned int _y, const unsigned int _width, const unsigned int _height, void* _data)
+	{
+		const unsigned int index = _texture - TEXTUREATLAS_FIRST_ID;
+		if (!isAtlasTexture(_texture) || index >= mEntries.size() || mEntries[index].page < 0 || _data == nullptr)
+			return false;
+
+		Entry& entry = mEntries[index];
+
+		// Whole picture : its border is copied again, and it moves to another cell when it doesn't fit anymore
+		if ((_x == 0 && _y == 0) || (_x == (unsigned int)-1 && _y == (unsigned int)-1))
+		{
+			const int cellSize = getCellSize(_width, _height);
+			if (cellSize == 0)
+				return false;
+
+			if (cellSize != mPages[entry.page].cellSize)
+			{
+				int page, cell;
+				if (!allocate(_renderer, _width, _height, page, cell))
+					return false;
+
+				release(_renderer, entry.page, entry.cell);
+				entry.page = page;
+				entry.cell = cell;
+			}
+
+			upload(_renderer, entry, _width, _height, _data);
+			return true;
+		}
+
+		if (_x + _width > (unsigned int)entry.width || _y + _height > (unsigned int)entry.height)
+			return false;
+
+		const Page& page   = mPages[entry.page];
+		const int   perRow = TEXTUREATLAS_PAGE_SIZE / page.cellSize;
+		const int   cellX  = (entry.cell % perRow) * page.cellSize;
+		const int   cellY  = (entry.cell / perRow) * page.cellSize;
+
+		_renderer->updateTexture(page.texture, Texture::RGBA, cellX + 1 + _x, cellY + 1 + _y, _width, _height, _data);
+		return true;
+
+	} // update
+
+	void TextureAtlas::remove(IRenderer* _renderer, const unsigned int _texture)
+	{
+		const unsigned int index = _texture - TEXTUREATLAS_FIRST_ID;
+		if (!isAtlasTexture(_texture) || index >= mEntries.size() || mEntries[index].page < 0)
+			return;
+
+		release(_renderer, mEntries[index].page, mEntries[index].cell);
+
+		mEntries[index] = Entry();
+		mFreeEntries.push_back(index);
+
+	} // remove
+
+	void TextureAtlas::clear()
+	{
+		mPages.clear();
+		mEntries.clear();
+		mFreeEntries.clear();
+
+	} // clear
+
+	const TextureAtlas::Region* TextureAtlas::getRegion(const unsigned int _texture) const
+	{
+		const unsigned int index = _texture - TEXTUREATLAS_FIRST_ID;
+		if (!isAtlasTexture(_texture) || index >= mEntries.size() || mEntries[index].page < 0)
+			return nullptr;
+
+		return &mEntries[index].region;
+
+	} // getRegion
+
+	bool TextureAtlas::allocate(IRenderer* _renderer, const int _width, const int _height, int& _page, int& _cell)
+	{
+		const int cellSize = getCellSize(_width, _height);
+		if (cellSize == 0)
+			return false;
+
+		int freePage = -1;
+
+		for (int i = 0; i < (int)mPages.size(); i++)
+		{
+			Page& page = mPages[i];
+
+			if (page.texture == 0)
+			{
+				if (freePage < 0)
+					freePage = i;
+			}
+			else if (page.cellSize == cellSize && !page.freeCells.empty())
+			{
+				_page = i;
+				_cell = page.freeCells.back();
+				page.freeCells.pop_back();
+				page.usedCells++;
+				return true;
+			}
+		}
+
+		if (freePage < 0)
+		{
+			if (mPages.size() >= TEXTUREATLAS_MAX_PAGES)
+				return false;
+
+			freePage = (int)mPages.size();
+			mPages.push_back(Page());
+		}
+
+		const unsigned int texture = _renderer->createTexture(Texture::RGBA, true, false, TEXTUREATLAS_PAGE_SIZE, TEXTUREATLAS_PAGE_SIZE, nullptr);
+		if (texture == 0)
+		{
+			LOG(LogWarning) << "TextureAtlas : unable to create a page";
+			return false;
+		}
+
+		Page& page = mPages[freePage];
+		page.texture = texture;
+		page.cellSize = cellSize;
+		page.usedCells = 1;
+
+		// Cells are used from the top left corner
+		const int cells = (TEXTUREATLAS_PAGE_SIZE / cellSize) * (TEXTUREATLAS_PAGE_SIZE / cellSize);
+		page.freeCells.clear();
+		for (int cell = cells - 1; cell > 0; cell--)
+			page.freeCells.push_back(cell);
+
+		_page = freePage;
+		_cell = 0;
+		return true;
+
+	} // allocate
+
+	void TextureAtlas::release(IRenderer* _renderer, const int _page, const int _cell)
+	{
+		Page& page = mPages[_page];
+		page.freeCells.push_back(_cell);
+
+		if (--page.usedCells > 0)
+			return;
+
+		_renderer->destroyTexture(page.texture);
+		page = Page();
+
+	} // release
+
+	void TextureAtlas::upload(IRenderer* _renderer, Entry& _entry, const int _width, const int _height, void* _data)
+	{
+		const Page& page   = mPages[_entry.page];
+		const int   perRow = TEXTUREATLAS_PAGE_SIZE / page.cellSize;
+		const int   cellX  = (_entry.cell % perRow) * page.cellSize;
+		const int   cellY  = (_entry.cell / perRow) * page.cellSize;
+
+		// Copy of the picture, with its first and last rows and columns repeated around it
+		const int      width  = _width + 2;
+		const int      height = _height + 2;
+		unsigned int*  pixels = new unsigned int[width * height];
+		unsigned int*  source = (unsigned int*)_data;
+
+		for (int y = 0; y < height; y++)
+		{
+			const unsigned int* row  = source + std::min(std::max(y - 1, 0), _height - 1) * _width;
+			unsigned int*       dest = pixels + y * width;
+
+			dest[0] = row[0];
+			memcpy(dest + 1, row, _width * 4);
+			dest[width - 1] = row[_width - 1];
+		}
+
+		_renderer->updateTexture(page.texture, Texture::RGBA, cellX, cellY, width, height, pixels);
+		delete[] pixels;
+
+		_entry.width = _width;
+		_entry.height = _height;
+		_entry.region.texture = page.texture;
+		_entry.region.x = (float)(cellX + 1) / TEXTUREATLAS_PAGE_SIZE;
+		_entry.region.y = (float)(cellY + 1) / TEXTUREATLAS_PAGE_SIZE;
+		_entry.region.w = (float)_width / TEXTUREATLAS_PAGE_SIZE;
+		_entry.region.h = (float)_height / TEXTUREATLAS_PAGE_SIZE;
+
+	} // upload
+
+} // Renderer::
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef ES_CORE_RENDERER_TEXTURE_ATLAS_H
+#define ES_CORE_RENDERER_TEXTURE_ATLAS_H
+
+#include "renderers/Renderer.h"
+#include <vector>
+
+// Textures of the atlas get ids far above the ones of the graphics API
+#define TEXTUREATLAS_FIRST_ID 0x40000000
+
+namespace Renderer
+{
+	// Small RGBA textures (icons, badges, nine-patch frames...) are stored in the cells of a few large pages,
+	// so the sprites using them share the same texture and can be drawn in one batch.
+	// Pictures get a 1 pixel border copied from their edges, so filtering at their edges is the same as with their own texture.
+	class TextureAtlas
+	{
+	public:
+		struct Region
+		{
+			unsigned int texture; // Page
+			float        x;       // Texture coordinates of the picture in the page
+			float        y;
+			float        w;
+			float        h;
+
+		}; // Region
+
+		TextureAtlas();
+
+		static bool  isAtlasTexture(const unsigned int _texture) { return _texture >= TEXTUREATLAS_FIRST_ID; }
+		static bool  accepts(const Texture::Type _type, const bool _linear, const bool _repeat, const unsigned int _width, const unsigned int _height, void* _data);
+
+		// Returns 0 when the atlas is full
+		unsigned int add(IRenderer* _renderer, const unsigned int _width, const unsigned int _height, void* _data);
+		bool         update(IRenderer* _renderer, const unsigned int _texture, const unsigned int _x, const unsigned int _y, const unsigned int _width, const unsigned int _height, void* _data);
+		void         remove(IRenderer* _renderer, const unsigned int _texture);
+
+		// Pages are lost with the context : forgets them without destroying them
+		void         clear();
+
+		const Region* getRegion(const unsigned int _texture) const;
+
+	private:
+		struct Page
+		{
+			Page() : texture(0), cellSize(0), usedCells(0) { }
+
+			unsigned int     texture;
+			int              cellSize;
+			int              usedCells;
+			std::vector<int> freeCells;
+
+		}; // Page
+
+		struct Entry
+		{
+			Entry() : page(-1), cell(-1), width(0), height(0) { }
+
+			Region region;
+			int    page;
+			int    cell;
+			int    width;
+			int    height;
+
+		}; // Entry
+
+		bool allocate(IRenderer* _renderer, const int _width, const int _height, int& _page, int& _cell);
+		void release(IRenderer* _renderer, const int _page, const int _cell);
+		void upload(IRenderer* _renderer, Entry& _entry, const int _width, const int _height, void* _data);
+
+		std::vector<Page>         mPages;
+		std::vector<Entry>        mEntries;
+		std::vector<unsigned int> mFreeEntries;
+
+	}; // TextureAtlas
+
+} // Renderer::
+
+#endif // ES_CORE_RENDERER_TEXTURE_ATLAS_H
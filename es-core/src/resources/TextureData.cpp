@@ -3,6 +3,7 @@
 #include "math/Misc.h"
 #include "renderers/Renderer.h"
 #include "resources/ResourceManager.h"
+#include "resources/ThumbnailCache.h"
 #include "ImageIO.h"
 #include "Log.h"
 #include <nanosvg/nanosvg.h>
@@ -171,6 +172,10 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 		return false;
 	}
 
+	// Keep the downscaled picture so the next loads don't have to decode the source again
+	if (mPackedSize != Vector2i(0, 0) && ThumbnailCache::isCacheable(mPath, mMaxSize))
+		ThumbnailCache::save(mPath, mMaxSize, imageRGBA, width, height, mBaseSize);
+
 	mSourceWidth = (float) width;
 	mSourceHeight = (float) height;
 	mScalable = false;
@@ -178,6 +183,40 @@ bool TextureData::initImageFromMemory(const unsigned char* fileData, size_t leng
 	return initFromRGBA(imageRGBA, width, height, false);
 }
 
+bool TextureData::loadFromThumbnailCache(bool updateCache)
+{
+	if (!ThumbnailCache::isCacheable(mPath, mMaxSize))
+		return false;
+
+	// If already initialised then don't read again
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		if (mDataRGBA || (mTextureID != 0))
+			return true;
+	}
+
+	size_t width, height, fileSize;
+	Vector2i baseSize;
+
+	unsigned char* imageRGBA = ThumbnailCache::load(mPath, mMaxSize, width, height, baseSize, fileSize);
+	if (imageRGBA == nullptr)
+		return false;
+
+	mBaseSize = baseSize;
+	mPackedSize = Vector2i((int)width, (int)height);
+	mSourceWidth = (float)width;
+	mSourceHeight = (float)height;
+	mScalable = false;
+
+	if (!initFromRGBA(imageRGBA, width, height, false))
+		return false;
+
+	if (updateCache)
+		ImageIO::updateImageCache(mPath, fileSize, mBaseSize.x(), mBaseSize.y());
+
+	return true;
+}
+
 bool TextureData::initFromRGBA(unsigned char* dataRGBA, size_t width, size_t height, bool copyData)
 {
 	// If already initialised then don't read again
@@ -288,6 +327,9 @@ bool TextureData::load(bool updateCache)
 	{
 		LOG(LogDebug) << "TextureData::load " << mPath;
 
+		if (loadFromThumbnailCache(updateCache))
+			return true;
+
 		if (mPath.substr(mPath.size() - 4, std::string::npos) == ".cbz")
 			return loadFromCbz();
 		
@@ -428,6 +470,22 @@ size_t TextureData::getVRAMUsage()
 		return 0;
 }
 
+size_t TextureData::getEstimatedVRAMUsage()
+{
+	if (mWidth != 0 && mHeight != 0)
+		return mWidth * mHeight * 4;
+
+	unsigned int x, y;
+	if (mPath.empty() || !ImageIO::getCachedImageSize(mPath, &x, &y))
+		return 0;
+
+	Vector2i sz(x, y);
+	if (OPTIMIZEVRAM && !mMaxSize.empty())
+		sz = ImageIO::adjustPictureSize(sz, Vector2i(mMaxSize.x(), mMaxSize.y()), mMaxSize.externalZoom());
+
+	return (size_t)sz.x() * (size_t)sz.y() * 4;
+}
+
 void TextureData::setMaxSize(MaxSizeInfo maxSize)
 {
 	if (!Settings::getInstance()->getBool("OptimizeVRAM"))
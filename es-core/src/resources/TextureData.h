@@ -25,6 +25,7 @@ public:
 	// Read the data into memory if necessary
 	bool load(bool updateCache = false);
 	bool loadFromCbz();
+	bool loadFromThumbnailCache(bool updateCache);
 
 	bool isLoaded();
 
@@ -41,6 +42,9 @@ public:
 	// Get the amount of VRAM currenty used by this texture
 	size_t getVRAMUsage();
 
+	// VRAM the texture should use once loaded, from the known or cached image size. Never loads the texture.
+	size_t getEstimatedVRAMUsage();
+
 	size_t width();
 	size_t height();
 	float sourceWidth();
@@ -30,15 +30,9 @@ void TextureDataManager::onTextureLoaded(std::shared_ptr<TextureData> tex)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
 
-	for (auto it = mTextureLookup.cbegin(); it != mTextureLookup.cend(); it++)
-	{
-		std::shared_ptr<TextureData> texture = *(*it).second;
-		if (texture == tex)
-		{
-			const TextureResource* pResource = it->first;
-			((TextureResource*)pResource)->onTextureLoaded(tex);
-		}
-	}
+	auto it = mResourceLookup.find(tex.get());
+	if (it != mResourceLookup.cend())
+		((TextureResource*)it->second)->onTextureLoaded(tex);
 }
 
 std::shared_ptr<TextureData> TextureDataManager::add(const TextureResource* key, bool tiled, bool linear)
@@ -49,6 +43,8 @@ std::shared_ptr<TextureData> TextureDataManager::add(const TextureResource* key,
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
+		// Remove the reverse lookup
+		mResourceLookup.erase((*(*it).second).get());
 		// Remove the list entry
 		mTextures.erase((*it).second);
 		// And the lookup
@@ -58,6 +54,7 @@ std::shared_ptr<TextureData> TextureDataManager::add(const TextureResource* key,
 	std::shared_ptr<TextureData> data = std::make_shared<TextureData>(tiled, linear);
 	mTextures.push_front(data);
 	mTextureLookup[key] = mTextures.cbegin();
+	mResourceLookup[data.get()] = key;
 
 	return data;
 }
@@ -70,6 +67,8 @@ void TextureDataManager::remove(const TextureResource* key)
 	auto it = mTextureLookup.find(key);
 	if (it != mTextureLookup.cend())
 	{
+		// Remove the reverse lookup
+		mResourceLookup.erase((*(*it).second).get());
 		// Remove the list entry
 		mTextures.erase((*it).second);
 		// And the lookup
@@ -86,6 +85,15 @@ void TextureDataManager::cancelAsync(const TextureResource* key)
 		mLoader->remove(*(*it).second);
 }
 
+void TextureDataManager::setLoadPriority(const TextureResource* key, int priority)
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+
+	auto it = mTextureLookup.find(key);
+	if (it != mTextureLookup.cend())
+		mLoader->setPriority(*(*it).second, priority);
+}
+
 std::shared_ptr<TextureData> TextureDataManager::get(const TextureResource* key, TextureLoadMode enableLoading)
 {
 	std::unique_lock<std::mutex> lock(mMutex);
@@ -243,7 +251,7 @@ void TextureDataManager::load(std::shared_ptr<TextureData> tex, bool block)
 	}
 }
 
-TextureLoader::TextureLoader(TextureDataManager* mgr) : mManager(mgr), mExit(false)
+TextureLoader::TextureLoader(TextureDataManager* mgr) : mManager(mgr), mExit(false), mQueueSize(0), mSequence(0)
 {
 	int num_threads = std::thread::hardware_concurrency() / 2;
 	if (num_threads == 0)
@@ -279,10 +287,15 @@ void TextureLoader::threadProc()
 
 		if (!mTextureDataQ.empty())
 		{
-			std::shared_ptr<TextureData> textureData = mTextureDataQ.front();
-			mTextureDataQ.pop_front();
+			// Take the most urgent request
+			auto it = mTextureDataQ.begin();
 
-			mProcessingTextureDataQ.push_back(textureData);
+			std::shared_ptr<TextureData> textureData = it->second.data;
+			mQueueSize -= it->second.size;
+			mTextureDataIndex.erase(textureData.get());
+			mTextureDataQ.erase(it);
+
+			mProcessingTextureData.insert(textureData.get());
 
 			lock.unlock();
 
@@ -293,24 +306,29 @@ void TextureLoader::threadProc()
 
 				textureData->load(true);
 				//mManager->onTextureLoaded(textureData);				
-
-				lock.lock();
-				mProcessingTextureDataQ.remove(textureData);			
-				lock.unlock();
+				loadedCount++;
 			}
 
+			lock.lock();
+			mProcessingTextureData.erase(textureData.get());
+			lock.unlock();
+
 			std::this_thread::yield();
 		}		
 	}
 }
 
 bool TextureLoader::paused = false;
+std::atomic<unsigned int> TextureLoader::loadedCount(0);
 
-void TextureLoader::load(std::shared_ptr<TextureData> textureData)
+void TextureLoader::load(std::shared_ptr<TextureData> textureData, int priority)
 {
 //	if (paused)
 	//	return;
 
+	// Read before locking : the loader thread may hold the texture while it decodes it
+	size_t size = textureData->getEstimatedVRAMUsage();
+
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Make sure it's not already loaded
@@ -318,28 +336,61 @@ void TextureLoader::load(std::shared_ptr<TextureData> textureData)
 		return;
 
 	// If is is currently loading, don't add again
-	if (std::find(mProcessingTextureDataQ.cbegin(), mProcessingTextureDataQ.cend(), textureData) != mProcessingTextureDataQ.cend())
+	if (mProcessingTextureData.find(textureData.get()) != mProcessingTextureData.cend())
 		return;
 
-	// Remove it from the queue if it is already there
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
-		mTextureDataQ.erase(tx);
+	// Within a priority, the newly requested textures load first
+	RequestKey key(priority, -(++mSequence));
+
+	// Already queued : keep its priority, only move it to the top of its priority
+	auto tx = mTextureDataIndex.find(textureData.get());
+	if (tx != mTextureDataIndex.cend())
+	{
+		key.first = tx->second->first.first;
+
+		Request request = tx->second->second;
+		mTextureDataQ.erase(tx->second);
+		tx->second = mTextureDataQ.insert(std::make_pair(key, request)).first;
+		return;
+	}
+
+	Request request;
+	request.data = textureData;
+	request.size = size;
+
+	mTextureDataIndex[textureData.get()] = mTextureDataQ.insert(std::make_pair(key, request)).first;
+	mQueueSize += request.size;
 
-	// Put it on the start of the queue as we want the newly requested textures to load first
-	mTextureDataQ.push_front(textureData);
 	mEvent.notify_one();
 }
 
+void TextureLoader::setPriority(std::shared_ptr<TextureData> textureData, int priority)
+{
+	std::unique_lock<std::mutex> lock(mLoaderLock);
+
+	auto tx = mTextureDataIndex.find(textureData.get());
+	if (tx == mTextureDataIndex.cend() || tx->second->first.first == priority)
+		return;
+
+	// Keep the original request order within the new priority
+	RequestKey key(priority, tx->second->first.second);
+	Request request = tx->second->second;
+
+	mTextureDataQ.erase(tx->second);
+	tx->second = mTextureDataQ.insert(std::make_pair(key, request)).first;
+}
+
 bool TextureLoader::remove(std::shared_ptr<TextureData> textureData)
 {
 	// Just remove it from the queue so we don't attempt to load it
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
-	auto tx = std::find(mTextureDataQ.cbegin(), mTextureDataQ.cend(), textureData);
-	if (tx != mTextureDataQ.cend())
+	auto tx = mTextureDataIndex.find(textureData.get());
+	if (tx != mTextureDataIndex.cend())
 	{
-		mTextureDataQ.erase(tx);
+		mQueueSize -= tx->second->second.size;
+		mTextureDataQ.erase(tx->second);
+		mTextureDataIndex.erase(tx);
 		return true;
 	}
 
@@ -352,11 +403,7 @@ size_t TextureLoader::getQueueSize()
 
 	// Gets the amount of video memory that will be used once all textures in
 	// the queue are loaded
-	size_t mem = 0;
-	for (auto tex : mTextureDataQ)
-		mem += tex->width() * tex->height() * 4;
-
-	return mem;
+	return mQueueSize;
 }
 
 void TextureLoader::clearQueue()
@@ -364,7 +411,9 @@ void TextureLoader::clearQueue()
 	std::unique_lock<std::mutex> lock(mLoaderLock);
 
 	// Just abort any waiting texture
-	mTextureDataQ.clear();	
+	mTextureDataQ.clear();
+	mTextureDataIndex.clear();
+	mQueueSize = 0;
 }
 
 void TextureDataManager::clearQueue()
@@ -2,13 +2,17 @@
 #ifndef ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 #define ES_CORE_RESOURCES_TEXTURE_DATA_MANAGER_H
 
+#include <atomic>
 #include <condition_variable>
 #include <list>
 #include <map>
+#include <unordered_map>
+#include <unordered_set>
 #include <memory>
 #include <mutex>
 #include <thread>
 #include <vector>
+#include <stdint.h>
 
 class TextureDataManager;
 class TextureData;
@@ -20,19 +24,38 @@ public:
 	TextureLoader(TextureDataManager* mgr);
 	~TextureLoader();
 
-	void load(std::shared_ptr<TextureData> textureData);
+	// Lower priorities are loaded first (for lists & grids : the distance from the cursor)
+	void load(std::shared_ptr<TextureData> textureData, int priority = 0);
 	bool remove(std::shared_ptr<TextureData> textureData);
+	void setPriority(std::shared_ptr<TextureData> textureData, int priority);
 	void clearQueue();
 
 	size_t getQueueSize();
 
 	static bool paused;
 
+	// Incremented each time a texture has been loaded, so the UI knows new pictures are ready to be displayed
+	static std::atomic<unsigned int> loadedCount;
+
 private:	
 	void threadProc();
 
-	std::list<std::shared_ptr<TextureData>> 										mProcessingTextureDataQ;
-	std::list<std::shared_ptr<TextureData>> 										mTextureDataQ;
+	// Requests are sorted by priority, then newest first
+	typedef std::pair<int, int64_t> RequestKey;
+
+	struct Request
+	{
+		std::shared_ptr<TextureData> data;
+		size_t size;
+	};
+
+	typedef std::map<RequestKey, Request> RequestQueue;
+
+	RequestQueue														mTextureDataQ;
+	std::unordered_map<const TextureData*, RequestQueue::iterator>		mTextureDataIndex;
+	std::unordered_set<const TextureData*>								mProcessingTextureData;
+	size_t																mQueueSize;
+	int64_t																mSequence;
 
 	std::vector<std::thread>	mThreads;
 	std::mutex					mLoaderLock;
@@ -78,6 +101,7 @@ public:
 	void remove(const TextureResource* key);
 
 	void cancelAsync(const TextureResource* key);
+	void setLoadPriority(const TextureResource* key, int priority);
 	std::shared_ptr<TextureData> get(const TextureResource* key, TextureLoadMode enableLoading = TextureLoadMode::ENABLED);
 	bool bind(const TextureResource* key);
 
@@ -99,7 +123,8 @@ private:
 	std::mutex					mMutex;
 
 	std::list<std::shared_ptr<TextureData> >												mTextures;
-	std::map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
+	std::unordered_map<const TextureResource*, std::list<std::shared_ptr<TextureData> >::const_iterator > 	mTextureLookup;
+	std::unordered_map<const TextureData*, const TextureResource*>							mResourceLookup;
 	std::shared_ptr<TextureData>															mBlank;
 	TextureLoader*																			mLoader;
 };
@@ -162,6 +162,12 @@ void TextureResource::prioritize() const
 		sTextureDataManager.get(this, TextureDataManager::TextureLoadMode::MOVETOTOPONLY);
 }
 
+void TextureResource::setLoadPriority(int priority) const
+{
+	if (mTextureData == nullptr)
+		sTextureDataManager.setLoadPriority(this, priority);
+}
+
 void TextureResource::setRequired(bool value) const
 {
 	if (mTextureData != nullptr)
@@ -172,6 +178,12 @@ void TextureResource::setRequired(bool value) const
 		data->setRequired(value);	
 }
 
+void TextureResource::preload() const
+{
+	if (mTextureData == nullptr)
+		sTextureDataManager.get(this, TextureDataManager::TextureLoadMode::ENABLED);
+}
+
 bool TextureResource::bind()
 {
 	if (mTextureData != nullptr)
@@ -34,7 +34,9 @@ public:
 	bool isLoaded() const;
 	bool isTiled() const;
 	void prioritize() const;
+	void setLoadPriority(int priority) const;
 	void setRequired(bool value) const;
+	void preload() const; // Queues the texture for loading in the background without waiting to be bound
 
 	const Vector2i getSize() const;
 	bool bind();
@@ -0,0 +1,347 @@
+#include "resources/ThumbnailCache.h"
+
+#include "renderers/Renderer.h"
+#include "resources/ResourceManager.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/TaskScheduler.h"
+#include "utils/ZipFile.h"
+#include "Log.h"
+#include "Paths.h"
+#include "Settings.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define THUMBNAILCACHE_MAGIC	0x43545345 // "ESTC"
+#define THUMBNAILCACHE_VERSION	1
+
+struct ThumbnailHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	int32_t  screenWidth;
+	int32_t  screenHeight;
+	int64_t  sourceSize;
+	int64_t  sourceTime;
+	int32_t  baseWidth;
+	int32_t  baseHeight;
+	int32_t  width;
+	int32_t  height;
+	uint32_t dataSize;		// Size of the deflated pixels, or 0 when they are stored as is
+	uint32_t pathSize;		// Followed by the source path, then the pixels
+};
+
+static std::mutex				sWarmupLock;
+static Utils::CancellationToken sWarmupToken;
+
+static std::mutex				sSizeLock;
+static int64_t					sCacheSize = -1; // Bytes, counted at the first write
+
+static std::string getCacheDirectory()
+{
+	return Utils::FileSystem::getGenericPath(Paths::getUserEmulationStationPath() + "/cache/thumbnails");
+}
+
+// Tasks are run on a group which lives as long as the process : the scheduler may still be running them at exit
+static Utils::TaskGroup& getTaskGroup()
+{
+	static Utils::TaskGroup* group = new Utils::TaskGroup(Utils::TASK_BACKGROUND);
+	return *group;
+}
+
+bool ThumbnailCache::isEnabled()
+{
+	return Settings::getInstance()->getBool("ThumbnailCache");
+}
+
+bool ThumbnailCache::isCacheable(const std::string& path, MaxSizeInfo& maxSize)
+{
+	if (path.empty() || maxSize.empty() || !isEnabled())
+		return false;
+
+	// Embedded resources are fast to load, svg are rasterized at the right size
+	if (path[0] == ':' || Utils::String::toLower(Utils::FileSystem::getExtension(path)) == ".svg")
+		return false;
+
+	return true;
+}
+
+std::string ThumbnailCache::getCachePath(const std::string& path, MaxSizeInfo& maxSize)
+{
+	std::string key = path + "|" + std::to_string((int)maxSize.x()) + "x" + std::to_string((int)maxSize.y()) + (maxSize.externalZoom() ? "z" : "");
+
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.rgba", Utils::String::computeHash(key));
+
+	return getCacheDirectory() + "/" + name;
+}
+
+static bool readHeader(const Utils::FileSystem::MappedFile& file, const std::string& path, ThumbnailHeader& header, size_t& fileSize)
+{
+	if (!file.isValid() || file.size() < sizeof(ThumbnailHeader))
+		return false;
+
+	memcpy(&header, file.data(), sizeof(ThumbnailHeader));
+
+	if (header.magic != THUMBNAILCACHE_MAGIC || header.version != THUMBNAILCACHE_VERSION)
+		return false;
+
+	// Pictures larger than the screen are also clamped to the screen size
+	if (header.screenWidth != Renderer::getScreenWidth() || header.screenHeight != Renderer::getScreenHeight())
+		return false;
+
+	if (sizeof(ThumbnailHeader) + header.pathSize > file.size() || path.compare(0, std::string::npos, file.data() + sizeof(ThumbnailHeader), header.pathSize) != 0)
+		return false;
+
+	fileSize = (size_t)Utils::FileSystem::getFileSize(path);
+	if (header.sourceSize != (int64_t)fileSize || header.sourceTime != (int64_t)Utils::FileSystem::getFileModificationDate(path).getTime())
+		return false;
+
+	return header.width > 0 && header.height > 0;
+}
+
+bool ThumbnailCache::exists(const std::string& path, MaxSizeInfo& maxSize)
+{
+	Utils::FileSystem::MappedFile file(getCachePath(path, maxSize));
+
+	ThumbnailHeader header;
+	size_t fileSize;
+	return readHeader(file, path, header, fileSize);
+}
+
+unsigned char* ThumbnailCache::load(const std::string& path, MaxSizeInfo maxSize, size_t& width, size_t& height, Vector2i& baseSize, size_t& fileSize)
+{
+	if (!isCacheable(path, maxSize))
+		return nullptr;
+
+	Utils::FileSystem::MappedFile file(getCachePath(path, maxSize));
+
+	ThumbnailHeader header;
+	if (!readHeader(file, path, header, fileSize))
+		return nullptr;
+
+	size_t length = (size_t)header.width * (size_t)header.height * 4;
+	size_t offset = sizeof(ThumbnailHeader) + header.pathSize;
+	size_t dataSize = header.dataSize == 0 ? length : header.dataSize;
+
+	if (offset + dataSize != file.size())
+		return nullptr;
+
+	unsigned char* data = new unsigned char[length];
+
+	if (header.dataSize == 0)
+		memcpy(data, file.data() + offset, length);
+	else if (!Utils::Zip::ZipFile::uncompressBuffer(file.data() + offset, dataSize, data, length))
+	{
+		LOG(LogWarning) << "ThumbnailCache : corrupted entry for " << path;
+		delete[] data;
+		return nullptr;
+	}
+
+	width = header.width;
+	height = header.height;
+	baseSize = Vector2i(header.baseWidth, header.baseHeight);
+
+	return data;
+}
+
+bool ThumbnailCache::write(const std::string& path, MaxSizeInfo& maxSize, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize)
+{
+	size_t length = width * height * 4;
+
+	std::vector<unsigned char> packed;
+	bool compressed = Utils::Zip::ZipFile::compressBuffer(data, length, packed) && packed.size() < length;
+
+	ThumbnailHeader header;
+	memset(&header, 0, sizeof(ThumbnailHeader));
+	header.magic = THUMBNAILCACHE_MAGIC;
+	header.version = THUMBNAILCACHE_VERSION;
+	header.screenWidth = Renderer::getScreenWidth();
+	header.screenHeight = Renderer::getScreenHeight();
+	header.sourceSize = (int64_t)Utils::FileSystem::getFileSize(path);
+	header.sourceTime = (int64_t)Utils::FileSystem::getFileModificationDate(path).getTime();
+	header.baseWidth = baseSize.x();
+	header.baseHeight = baseSize.y();
+	header.width = (int32_t)width;
+	header.height = (int32_t)height;
+	header.dataSize = compressed ? (uint32_t)packed.size() : 0;
+	header.pathSize = (uint32_t)path.size();
+
+	std::string cachePath = getCachePath(path, maxSize);
+
+	// Several threads may write the same entry : each one writes its own file, the last rename wins
+	std::string tmpPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(cachePath));
+
+#if defined(_WIN32)
+	FILE* file = _wfopen(Utils::String::convertToWideString(tmpPath).c_str(), L"wb");
+#else
+	FILE* file = fopen(tmpPath.c_str(), "wb");
+#endif
+	if (file == nullptr)
+		return false;
+
+	bool written = fwrite(&header, sizeof(ThumbnailHeader), 1, file) == 1 && fwrite(path.data(), 1, path.size(), file) == path.size();
+
+	if (written && compressed)
+		written = fwrite(packed.data(), 1, packed.size(), file) == packed.size();
+	else if (written)
+		written = fwrite(data, 1, length, file) == length;
+
+	fclose(file);
+
+	if (!written || !Utils::FileSystem::renameFile(tmpPath, cachePath))
+	{
+		Utils::FileSystem::removeFile(tmpPath);
+		return false;
+	}
+
+	onEntryWritten((int64_t)(sizeof(ThumbnailHeader) + path.size() + (compressed ? packed.size() : length)));
+	return true;
+}
+
+// The cache is kept under ThumbnailCacheSize : when it's over, the oldest entries are removed until 3/4 of the budget
+void ThumbnailCache::onEntryWritten(int64_t size)
+{
+	int64_t budget = (int64_t)Settings::getInstance()->getInt("ThumbnailCacheSize") * 1024 * 1024;
+	if (budget <= 0)
+		return;
+
+	std::unique_lock<std::mutex> lock(sSizeLock);
+
+	if (sCacheSize >= 0)
+	{
+		sCacheSize += size;
+		if (sCacheSize <= budget)
+			return;
+	}
+
+	struct CacheEntry
+	{
+		std::string path;
+		time_t		time;
+		int64_t		size;
+	};
+
+	std::vector<CacheEntry> entries;
+	int64_t total = 0;
+
+	for (auto file : Utils::FileSystem::getDirContent(getCacheDirectory()))
+	{
+		if (!Utils::String::endsWith(file, ".rgba"))
+			continue;
+
+		CacheEntry entry;
+		entry.path = file;
+		entry.time = Utils::FileSystem::getFileModificationDate(file).getTime();
+		entry.size = (int64_t)Utils::FileSystem::getFileSize(file);
+
+		total += entry.size;
+		entries.push_back(entry);
+	}
+
+	if (total > budget)
+	{
+		std::sort(entries.begin(), entries.end(), [](const CacheEntry& a, const CacheEntry& b) { return a.time < b.time; });
+
+		int removed = 0;
+		for (auto& entry : entries)
+		{
+			if (total <= budget * 3 / 4)
+				break;
+
+			if (Utils::FileSystem::removeFile(entry.path))
+			{
+				total -= entry.size;
+				removed++;
+			}
+		}
+
+		LOG(LogDebug) << "ThumbnailCache : " << removed << " entries removed";
+	}
+
+	sCacheSize = total;
+}
+
+void ThumbnailCache::save(const std::string& path, MaxSizeInfo maxSize, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize)
+{
+	if (data == nullptr || width == 0 || height == 0 || !isCacheable(path, maxSize))
+		return;
+
+	std::shared_ptr<std::vector<unsigned char>> pixels = std::make_shared<std::vector<unsigned char>>(data, data + width * height * 4);
+
+	getTaskGroup().run([path, maxSize, pixels, width, height, baseSize]
+	{
+		MaxSizeInfo size = maxSize;
+		write(path, size, pixels->data(), width, height, baseSize);
+	});
+}
+
+void ThumbnailCache::warmup(const std::vector<std::string>& paths, MaxSizeInfo maxSize)
+{
+	if (paths.size() == 0 || maxSize.empty() || !isEnabled())
+		return;
+
+	Utils::CancellationToken token;
+
+	{
+		std::unique_lock<std::mutex> lock(sWarmupLock);
+		sWarmupToken.cancel();
+		sWarmupToken = token;
+	}
+
+	getTaskGroup().run([paths, maxSize, token]
+	{
+		StopWatch stopWatch("ThumbnailCache::warmup :", LogDebug);
+
+		MaxSizeInfo size = maxSize;
+		std::shared_ptr<ResourceManager>& rm = ResourceManager::getInstance();
+
+		for (auto path : paths)
+		{
+			if (token.isCancelled())
+				break;
+
+			if (!isCacheable(path, size) || !Utils::FileSystem::exists(path) || exists(path, size))
+				continue;
+
+			const ResourceData& data = rm->getFileData(path);
+			if (data.ptr == nullptr)
+				continue;
+
+			size_t width, height;
+			Vector2i baseSize, packedSize;
+
+			unsigned char* pixels = ImageIO::loadFromMemoryRGBA32(data.ptr.get(), data.length, width, height, &size, &baseSize, &packedSize);
+			if (pixels == nullptr)
+				continue;
+
+			// Only pictures which had to be downscaled are worth caching
+			if (packedSize != Vector2i(0, 0))
+				write(path, size, pixels, width, height, baseSize);
+
+			delete[] pixels;
+		}
+	});
+}
+
+void ThumbnailCache::stop()
+{
+	std::unique_lock<std::mutex> lock(sWarmupLock);
+	sWarmupToken.cancel();
+}
+
+void ThumbnailCache::clear()
+{
+	stop();
+	Utils::FileSystem::deleteDirectoryFiles(getCacheDirectory());
+
+	std::unique_lock<std::mutex> lock(sSizeLock);
+	sCacheSize = 0;
+}
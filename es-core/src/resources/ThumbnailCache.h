@@ -0,0 +1,39 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+#define ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
+
+#include "ImageIO.h"
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+// On-disk cache of pictures already decoded & downscaled to the size they are displayed at.
+// Entries are raw RGBA pixels (deflated) keyed by the source path, its size & mtime and the target size,
+// so TextureData can skip reading and decoding the full resolution image.
+class ThumbnailCache
+{
+public:
+	static bool isEnabled();
+	static bool isCacheable(const std::string& path, MaxSizeInfo& maxSize);
+
+	// Returns a new[] RGBA buffer, or nullptr if the entry is missing or outdated
+	static unsigned char* load(const std::string& path, MaxSizeInfo maxSize, size_t& width, size_t& height, Vector2i& baseSize, size_t& fileSize);
+
+	// Stores the pixels from a background task : the buffer is copied
+	static void save(const std::string& path, MaxSizeInfo maxSize, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize);
+
+	// Decodes the pictures which are not cached yet, one after the other, in a background task.
+	// A new warmup cancels the previous one.
+	static void warmup(const std::vector<std::string>& paths, MaxSizeInfo maxSize);
+	static void stop();
+
+	static void clear();
+
+private:
+	static std::string getCachePath(const std::string& path, MaxSizeInfo& maxSize);
+	static bool write(const std::string& path, MaxSizeInfo& maxSize, const unsigned char* data, size_t width, size_t height, const Vector2i& baseSize);
+	static bool exists(const std::string& path, MaxSizeInfo& maxSize);
+	static void onEntryWritten(int64_t size);
+};
+
+#endif // ES_CORE_RESOURCES_THUMBNAIL_CACHE_H
@@ -0,0 +1,151 @@
+#include "resources/VideoInfoCache.h"
+
+#include "utils/AppendLog.h"
+#include "utils/FileSystemUtil.h"
+#include "Log.h"
+#include "Paths.h"
+#include <mutex>
+#include <unordered_map>
+#include <stdint.h>
+#include <string.h>
+
+#define VIDEOCACHE_MAGIC	0x43565345 // "ESVC"
+#define VIDEOCACHE_VERSION	1
+#define VIDEOCACHE_VALUES_SIZE	(sizeof(int64_t) * 2 + sizeof(int32_t) * 4)
+
+struct VideoCacheEntry
+{
+	int64_t   size;
+	int64_t   time;
+	VideoInfo info;
+};
+
+static std::mutex sVideoCacheLock;
+static std::unordered_map<std::string, VideoCacheEntry> sVideoCache;
+static bool sVideoCacheLoaded = false;
+
+// Records : uint32 path length, path, int64 size, int64 time, int32 width, int32 height, int32 duration, int32 hasAudio
+static Utils::AppendLog& getVideoCache()
+{
+	static Utils::AppendLog cache(Paths::getUserEmulationStationPath() + "/videocache.bin", VIDEOCACHE_MAGIC, VIDEOCACHE_VERSION);
+	return cache;
+}
+
+static void addVideoCacheRecord(std::string& data, const std::string& path, const VideoCacheEntry& entry)
+{
+	uint32_t length = (uint32_t)path.size();
+	int64_t stamps[2] = { entry.size, entry.time };
+	int32_t values[4] = { entry.info.width, entry.info.height, entry.info.duration, entry.info.hasAudio ? 1 : 0 };
+
+	data.append((const char*)&length, sizeof(uint32_t));
+	data.append(path);
+	data.append((const char*)stamps, sizeof(stamps));
+	data.append((const char*)values, sizeof(values));
+}
+
+// Returns the size of the record, 0 if it is incomplete
+static size_t readVideoCacheRecord(const char* data, size_t size)
+{
+	if (size < sizeof(uint32_t))
+		return 0;
+
+	uint32_t length;
+	memcpy(&length, data, sizeof(uint32_t));
+
+	size_t recordSize = sizeof(uint32_t) + length + VIDEOCACHE_VALUES_SIZE;
+	if (recordSize > size)
+		return 0;
+
+	std::string path(data + sizeof(uint32_t), length);
+
+	int64_t stamps[2];
+	int32_t values[4];
+	memcpy(stamps, data + sizeof(uint32_t) + length, sizeof(stamps));
+	memcpy(values, data + sizeof(uint32_t) + length + sizeof(stamps), sizeof(values));
+
+	VideoCacheEntry& entry = sVideoCache[path];
+	entry.size = stamps[0];
+	entry.time = stamps[1];
+	entry.info.width = values[0];
+	entry.info.height = values[1];
+	entry.info.duration = values[2];
+	entry.info.hasAudio = values[3] != 0;
+
+	return recordSize;
+}
+
+// New records are appended : the file is rewritten when most of its records were replaced
+static void loadVideoCache()
+{
+	if (sVideoCacheLoaded)
+		return;
+
+	sVideoCacheLoaded = true;
+
+	Utils::AppendLog& cache = getVideoCache();
+	if (!cache.load(readVideoCacheRecord))
+		return;
+
+	LOG(LogDebug) << "VideoInfoCache : " << sVideoCache.size() << " videos loaded";
+
+	if (cache.needsCompaction((int)sVideoCache.size(), 64))
+	{
+		std::string data;
+		for (auto& item : sVideoCache)
+			addVideoCacheRecord(data, item.first, item.second);
+
+		cache.rewrite(data, (int)sVideoCache.size());
+	}
+}
+
+bool VideoInfoCache::get(const std::string& path, VideoInfo& info)
+{
+	VideoCacheEntry entry;
+
+	{
+		std::unique_lock<std::mutex> lock(sVideoCacheLock);
+		loadVideoCache();
+
+		auto it = sVideoCache.find(path);
+		if (it == sVideoCache.cend())
+			return false;
+
+		entry = it->second;
+	}
+
+	if (entry.size != (int64_t)Utils::FileSystem::getFileSize(path) || entry.time != (int64_t)Utils::FileSystem::getFileModificationDate(path).getTime())
+		return false;
+
+	info = entry.info;
+	return true;
+}
+
+void VideoInfoCache::set(const std::string& path, const VideoInfo& info)
+{
+	if (info.width <= 0 || info.height <= 0)
+		return;
+
+	VideoCacheEntry entry;
+	entry.size = (int64_t)Utils::FileSystem::getFileSize(path);
+	entry.time = (int64_t)Utils::FileSystem::getFileModificationDate(path).getTime();
+	entry.info = info;
+
+	std::unique_lock<std::mutex> lock(sVideoCacheLock);
+	loadVideoCache();
+
+	sVideoCache[path] = entry;
+
+	std::string data;
+	addVideoCacheRecord(data, path, entry);
+	getVideoCache().append(data);
+}
+
+void VideoInfoCache::clear()
+{
+	std::unique_lock<std::mutex> lock(sVideoCacheLock);
+
+	sVideoCache.clear();
+	sVideoCacheLoaded = true;
+
+	getVideoCache().remove();
+}
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef ES_CORE_RESOURCES_VIDEO_INFO_CACHE_H
+#define ES_CORE_RESOURCES_VIDEO_INFO_CACHE_H
+
+#include <string>
+
+struct VideoInfo
+{
+	VideoInfo() : width(0), height(0), duration(0), hasAudio(false) { }
+
+	int  width;
+	int  height;
+	int  duration; // Milliseconds, 0 if unknown
+	bool hasAudio;
+};
+
+// Dimensions & duration of the video files already probed, stored next to the image size cache.
+// Entries are checked against the size & modification time of the file, so probing a video with VLC is only needed once.
+class VideoInfoCache
+{
+public:
+	static bool get(const std::string& path, VideoInfo& info);
+	static void set(const std::string& path, const VideoInfo& info);
+
+	static void clear();
+};
+
+#endif // ES_CORE_RESOURCES_VIDEO_INFO_CACHE_H
@@ -0,0 +1,154 @@
+#include "utils/AppendLog.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include <string.h>
+
+namespace Utils
+{
+	AppendLog::AppendLog(const std::string& path, uint32_t magic, uint32_t version)
+		: mPath(path), mMagic(magic), mVersion(version), mFile(nullptr), mRecords(0)
+	{
+	}
+
+	AppendLog::~AppendLog()
+	{
+		close();
+	}
+
+	FILE* AppendLog::open(const std::string& path, const char* mode)
+	{
+#if WIN32
+		return _wfopen(Utils::String::convertToWideString(path).c_str(), Utils::String::convertToWideString(mode).c_str());
+#else
+		return fopen(path.c_str(), mode);
+#endif
+	}
+
+	bool AppendLog::load(const std::function<size_t(const char* data, size_t size)>& readRecord)
+	{
+		close();
+		mRecords = 0;
+
+		bool valid = false;
+		std::string records;
+
+		{
+			Utils::FileSystem::MappedFile file(mPath);
+			if (!file.isValid())
+				return false;
+
+			const char* data = file.data();
+			size_t size = file.size();
+
+			uint32_t header[2];
+			if (size >= sizeof(header))
+			{
+				memcpy(header, data, sizeof(header));
+
+				if (header[0] == mMagic && header[1] == mVersion)
+				{
+					size_t pos = sizeof(header);
+					while (pos < size)
+					{
+						size_t length = readRecord(data + pos, size - pos);
+						if (length == 0 || length > size - pos)
+							break;
+
+						pos += length;
+						mRecords++;
+					}
+
+					valid = (pos == size);
+
+					// Interrupted while appending : new records must not follow the partial one
+					if (!valid)
+						records.assign(data + sizeof(header), pos - sizeof(header));
+				}
+			}
+		}
+
+		if (!valid)
+		{
+			LOG(LogWarning) << "AppendLog : invalid or truncated file \"" << mPath << "\", keeping " << mRecords << " records";
+			rewrite(records, mRecords);
+		}
+
+		return true;
+	}
+
+	bool AppendLog::append(const std::string& records, int count)
+	{
+		if (mFile == nullptr)
+		{
+			Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(mPath));
+
+			mFile = open(mPath, "ab");
+			if (mFile == nullptr)
+				return false;
+
+			// The file cache may not know the file yet : the opened file tells if the header is needed
+			if (fseek(mFile, 0, SEEK_END) == 0 && ftell(mFile) == 0)
+			{
+				uint32_t header[2] = { mMagic, mVersion };
+				fwrite(header, sizeof(header), 1, mFile);
+			}
+		}
+
+		bool written = fwrite(records.data(), 1, records.size(), mFile) == records.size();
+		fflush(mFile);
+
+		if (written)
+			mRecords += count;
+
+		return written;
+	}
+
+	bool AppendLog::rewrite(const std::string& records, int count)
+	{
+		close();
+
+		std::string tmpPath = mPath + ".tmp";
+
+		FILE* file = open(tmpPath, "wb");
+		if (file == nullptr)
+			return false;
+
+		uint32_t header[2] = { mMagic, mVersion };
+		bool written = fwrite(header, sizeof(header), 1, file) == 1;
+		written = written && fwrite(records.data(), 1, records.size(), file) == records.size();
+		fclose(file);
+
+		if (!written || !Utils::FileSystem::renameFile(tmpPath, mPath))
+		{
+			Utils::FileSystem::removeFile(tmpPath);
+			return false;
+		}
+
+		mRecords = count;
+		return true;
+	}
+
+	bool AppendLog::needsCompaction(int entries, int minRecords) const
+	{
+		return mRecords > minRecords && mRecords > entries * 2;
+	}
+
+	void AppendLog::close()
+	{
+		if (mFile != nullptr)
+			fclose(mFile);
+
+		mFile = nullptr;
+	}
+
+	void AppendLog::remove()
+	{
+		close();
+		mRecords = 0;
+
+		Utils::FileSystem::removeFile(mPath);
+	}
+
+} // Utils::
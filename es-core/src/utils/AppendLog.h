@@ -0,0 +1,54 @@
+#pragma once
+#ifndef ES_CORE_UTILS_APPEND_LOG_H
+#define ES_CORE_UTILS_APPEND_LOG_H
+
+#include <functional>
+#include <string>
+#include <stdint.h>
+#include <stdio.h>
+
+namespace Utils
+{
+	// Binary file made of a magic & version header followed by records appended as they are produced.
+	// Records replacing older ones are appended too : the file is rewritten from the live entries when it grows too much.
+	// Not thread safe : the owner serializes the calls.
+	class AppendLog
+	{
+	public:
+		AppendLog(const std::string& path, uint32_t magic, uint32_t version);
+		~AppendLog();
+
+		// Calls readRecord with the remaining data until it returns 0 (incomplete record) : it returns the size of the record read.
+		// A file with a bad header or an incomplete tail is rewritten with its valid records only. Returns false if there's no file.
+		bool load(const std::function<size_t(const char* data, size_t size)>& readRecord);
+
+		// Appends records, after the header if the file is empty
+		bool append(const std::string& records, int count = 1);
+
+		// Replaces the file with these records
+		bool rewrite(const std::string& records, int count);
+
+		// Many more records than live entries : rewriting would save space and loading time
+		bool needsCompaction(int entries, int minRecords) const;
+
+		inline int getRecordCount() const { return mRecords; }
+
+		void close();
+		void remove();
+
+	private:
+		AppendLog(const AppendLog&) = delete;
+		AppendLog& operator=(const AppendLog&) = delete;
+
+		FILE* open(const std::string& path, const char* mode);
+
+		std::string mPath;
+		uint32_t	mMagic;
+		uint32_t	mVersion;
+		FILE*		mFile;
+		int			mRecords;
+	};
+
+} // Utils::
+
+#endif // ES_CORE_UTILS_APPEND_LOG_H
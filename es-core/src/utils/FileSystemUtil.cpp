@@ -6,6 +6,7 @@
 #include "utils/md5.h"
 
 #include "Settings.h"
+#include "Log.h"
 #include <sys/stat.h>
 #include <string.h>
 #include <algorithm>
@@ -26,11 +27,17 @@
 #else // _WIN32
 #include <dirent.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <mutex>
 #endif // _WIN32
 
 #include <fstream>
 #include <sstream>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+#include <time.h>
 
 #include "Paths.h"
 
@@ -89,106 +96,457 @@ namespace Utils
 			}
 #endif
 
+			bool operator==(const FileCache& other) const
+			{
+				return exists == other.exists && directory == other.directory && hidden == other.hidden && isSymLink == other.isSymLink;
+			}
+
 			bool exists;
 			bool directory;
 			bool hidden;
 			bool isSymLink;
 
-			static int fromStat64(const std::string& key, struct stat64* info)
+			static int fromStat64(const std::string& key, struct stat64* info);
+			static void add(const std::string& key, const FileCache& cache);
+			static FileCache* get(const std::string& key);
+			static void resetCache();
+
+			static void setEnabled(bool value) { mEnabled = value; }
+			static bool isEnabled() { return mEnabled; }
+
+			static std::atomic<unsigned long long> mHits;
+			static std::atomic<unsigned long long> mMisses;
+
+		private:
+			static std::atomic<bool> mEnabled;
+		};
+
+		// Hash map split in shards : writers lock the shard of their bucket, readers walk bucket chains without any lock.
+		// Nodes are never changed nor freed until clear(), a new value for an existing key is pushed in front of the old one.
+		class FileCacheMap
+		{
+		public:
+			FileCache* find(const std::string& key)
+			{
+				size_t hash = std::hash<std::string>()(key);
+
+				for (Node* node = mBuckets[hash % BUCKET_COUNT].load(std::memory_order_acquire); node != nullptr; node = node->next)
+					if (node->hash == hash && node->key == key)
+						return &node->value;
+
+				return nullptr;
+			}
+
+			FileCache* insert(const std::string& key, const FileCache& value)
 			{
+				size_t hash = std::hash<std::string>()(key);
+				size_t bucket = hash % BUCKET_COUNT;
+
+				std::unique_lock<std::mutex> lock(mShardLocks[bucket % SHARD_COUNT]);
+
+				Node* head = mBuckets[bucket].load(std::memory_order_relaxed);
+
+				for (Node* node = head; node != nullptr; node = node->next)
+				{
+					if (node->hash == hash && node->key == key)
+					{
+						if (node->value == value)
+							return &node->value;
+
+						break;
+					}
+				}
+
+				Node* node = new Node(key, hash, value, head);
+				mBuckets[bucket].store(node, std::memory_order_release);
+				return &node->value;
+			}
+
+			// Not safe while other threads are reading
+			void clear()
+			{
+				for (int shard = 0; shard < SHARD_COUNT; shard++)
+					mShardLocks[shard].lock();
+
+				for (int bucket = 0; bucket < BUCKET_COUNT; bucket++)
+				{
+					Node* node = mBuckets[bucket].exchange(nullptr);
+					while (node != nullptr)
+					{
+						Node* next = node->next;
+						delete node;
+						node = next;
+					}
+				}
+
+				for (int shard = 0; shard < SHARD_COUNT; shard++)
+					mShardLocks[shard].unlock();
+			}
+
+		private:
+			static const int SHARD_COUNT = 32;
+			static const int BUCKET_COUNT = 65536;
+
+			struct Node
+			{
+				Node(const std::string& _key, size_t _hash, const FileCache& _value, Node* _next) : key(_key), hash(_hash), value(_value), next(_next) { }
+
+				std::string key;
+				size_t		hash;
+				FileCache	value;
+				Node*		next;
+			};
+
+			std::atomic<Node*> mBuckets[BUCKET_COUNT];
+			std::mutex mShardLocks[SHARD_COUNT];
+		};
+
+		static FileCacheMap mFileCache;
+
+		std::atomic<unsigned long long> FileCache::mHits(0);
+		std::atomic<unsigned long long> FileCache::mMisses(0);
+		std::atomic<bool> FileCache::mEnabled(false);
+
+		int FileCache::fromStat64(const std::string& key, struct stat64* info)
+		{
 #if defined(_WIN32)
-				int ret = _wstat64(Utils::String::convertToWideString(key).c_str(), info);
+			int ret = _wstat64(Utils::String::convertToWideString(key).c_str(), info);
 #else
-				int ret = stat64(key.c_str(), info);
+			int ret = stat64(key.c_str(), info);
 #endif
 
-				mFileCacheMutex.lock();
+			if (!mEnabled)
+				return ret;
 
-				FileCache cache(ret == 0, false);
-				if (cache.exists)
-				{
-					cache.directory = S_ISDIR(info->st_mode);
+			FileCache cache(ret == 0, false);
+			if (cache.exists)
+			{
+				cache.directory = S_ISDIR(info->st_mode);
 #ifndef WIN32
-					cache.isSymLink = S_ISLNK(info->st_mode);
-					if (cache.isSymLink)
-					{
-						struct stat64 si;
-						if (stat64(resolveSymlink(key).c_str(), &si) == 0)
-							cache.directory = S_ISDIR(si.st_mode);
-					}
+				cache.isSymLink = S_ISLNK(info->st_mode);
+				if (cache.isSymLink)
+				{
+					struct stat64 si;
+					if (stat64(resolveSymlink(key).c_str(), &si) == 0)
+						cache.directory = S_ISDIR(si.st_mode);
+				}
+#endif
+			}
+
+			mFileCache.insert(key, cache);
+			return ret;
+		}
+
+		void FileCache::add(const std::string& key, const FileCache& cache)
+		{
+			if (!mEnabled)
+				return;
+
+			mFileCache.insert(key, cache);
+		}
+
+		FileCache* FileCache::get(const std::string& key)
+		{
+			if (!mEnabled)
+				return nullptr;
+
+			FileCache* item = mFileCache.find(key);
+			if (item == nullptr && mFileCache.find(Utils::FileSystem::getParent(key) + "/*") != nullptr)
+				item = mFileCache.insert(key, FileCache(false, false));
+
+			if (item != nullptr)
+				mHits++;
+			else
+				mMisses++;
+
+			return item;
+		}
+
+		void FileCache::resetCache()
+		{
+			mFileCache.clear();
+		}
+
+	// DirectoryListingCache
+
+		// Listings of the directories enumerated while the file system cache is active are dumped to disk.
+		// Next time, a directory whose modification time is unchanged is restored from the dump with a single stat.
+		class DirectoryListingCache
+		{
+		public:
+			struct Entry
+			{
+				FileInfo info;
+				bool	 isSymLink;
+			};
+
+			struct Listing
+			{
+				time_t time;
+				std::vector<Entry> entries;
+			};
+
+			static bool isActive() { return mActive; }
+
+			static time_t getDirectoryTime(const std::string& path)
+			{
+				struct stat64 info;
+#if defined(_WIN32)
+				if (_wstat64(Utils::String::convertToWideString(path).c_str(), &info) == 0)
+#else
+				if (stat64(path.c_str(), &info) == 0)
 #endif
+					return info.st_mtime;
+
+				return 0;
+			}
+
+			static bool get(const std::string& path, time_t time, fileList& contentList)
+			{
+				keep(path);
+
+				auto it = mListings.find(path);
+				if (it == mListings.cend() || it->second.time != time)
+					return false;
+
+				for (auto& entry : it->second.entries)
+				{
+					FileCache cache(true, entry.info.directory);
+					cache.hidden = entry.info.hidden;
+					cache.isSymLink = entry.isSymLink;
+					FileCache::add(entry.info.path, cache);
+
+					contentList.push_back(entry.info);
 				}
 
-				mFileCache[key] = cache;
+				return true;
+			}
 
-				mFileCacheMutex.unlock();
+			static void put(const std::string& path, time_t time, Listing& listing)
+			{
+				// The modification time has a one second precision : a listing of a directory changed during the last seconds may already be obsolete
+				if (time == 0 || time + 2 >= ::time(NULL))
+					return;
 
-				return ret;
+				listing.time = time;
+
+				std::unique_lock<std::mutex> lock(mUpdatesLock);
+				mUpdates[path] = std::move(listing);
 			}
 
-			static void add(const std::string& key, FileCache cache)
+			static void keep(const std::string& path)
 			{
-				if (!mEnabled)
+				if (!mActive)
 					return;
 
-				mFileCacheMutex.lock();
-				mFileCache[key] = cache;
-				mFileCacheMutex.unlock();
+				std::unique_lock<std::mutex> lock(mUpdatesLock);
+				mUsedPaths.insert(path);
 			}
 
-			static FileCache* get(const std::string& key)
+			static void setFullScan() { mFullScan = true; }
+
+			static void activate()
 			{
-				if (!mEnabled)
-					return nullptr;
+				mListings.clear();
+				mUpdates.clear();
+				mUsedPaths.clear();
+				mFullScan = false;
+
+				mActive = Settings::PersistentDirectoryCache();
+				if (mActive)
+					load();
+			}
 
-				std::unique_lock<std::mutex> lock(mFileCacheMutex);
+			static void deactivate()
+			{
+				bool pruned = false;
 
-				auto it = mFileCache.find(key);
-				if (it != mFileCache.cend())
-					return &it->second;
+				// Directories which were not used during a full scan were removed, or are no longer part of a system
+				if (mActive && mFullScan)
+				{
+					for (auto it = mListings.begin(); it != mListings.end(); )
+					{
+						if (mUsedPaths.find(it->first) == mUsedPaths.cend())
+						{
+							it = mListings.erase(it);
+							pruned = true;
+						}
+						else
+							it++;
+					}
+				}
 
-				it = mFileCache.find(Utils::FileSystem::getParent(key) + "/*");
-				if (it != mFileCache.cend())
+				if (mActive && (mUpdates.size() > 0 || pruned))
 				{
-					mFileCache[key] = FileCache(false, false);
-					return &mFileCache[key];
+					for (auto& update : mUpdates)
+						mListings[update.first] = std::move(update.second);
+
+					save();
 				}
 
-				return nullptr;
+				mActive = false;
+				mFullScan = false;
+				mListings.clear();
+				mUpdates.clear();
+				mUsedPaths.clear();
 			}
 
-			static void resetCache()
+		private:
+			static std::string getCachePath()
 			{
-				mFileCacheMutex.lock();
-				mFileCache.clear();
-				mFileCacheMutex.unlock();
+				return Paths::getUserEmulationStationPath() + "/cache/directories.cache";
 			}
 
-			static void setEnabled(bool value) { mEnabled = value; }
-			static bool isEnabled() { return mEnabled; }
+			static void load()
+			{
+				MappedFile file(getCachePath());
+				if (!file.isValid())
+					return;
 
-		private:
-			static std::map<std::string, FileCache> mFileCache;
-			static std::mutex mFileCacheMutex;
-			static bool mEnabled;
+				const char* pos = file.data();
+				const char* end = file.data() + file.size();
+
+				auto readBytes = [&pos, end](void* dest, size_t size)
+				{
+					if (pos + size > end)
+						return false;
+
+					memcpy(dest, pos, size);
+					pos += size;
+					return true;
+				};
+
+				auto readString = [&pos, end, &readBytes](std::string& value)
+				{
+					unsigned int size;
+					if (!readBytes(&size, sizeof(size)) || pos + size > end)
+						return false;
+
+					value.assign(pos, size);
+					pos += size;
+					return true;
+				};
+
+				unsigned int version;
+				if (!readBytes(&version, sizeof(version)) || version != CACHE_VERSION)
+					return;
+
+				std::string path;
+				long long time;
+				unsigned int count;
+
+				while (pos < end)
+				{
+					if (!readString(path) || !readBytes(&time, sizeof(time)) || !readBytes(&count, sizeof(count)))
+						break;
+
+					Listing& listing = mListings[path];
+					listing.time = (time_t)time;
+					listing.entries.resize(count);
+
+					for (auto& entry : listing.entries)
+					{
+						unsigned char flags;
+						if (!readString(entry.info.path) || !readBytes(&flags, sizeof(flags)))
+						{
+							mListings.erase(path);
+							return;
+						}
+
+						entry.info.hidden = (flags & 1) != 0;
+						entry.info.directory = (flags & 2) != 0;
+						entry.isSymLink = (flags & 4) != 0;
+#if WIN32
+						long long lastWriteTime;
+						if (!readBytes(&lastWriteTime, sizeof(lastWriteTime)))
+						{
+							mListings.erase(path);
+							return;
+						}
+
+						entry.info.lastWriteTime = (time_t)lastWriteTime;
+#endif
+					}
+				}
+			}
+
+			static void save()
+			{
+				std::string buffer;
+
+				auto writeBytes = [&buffer](const void* data, size_t size) { buffer.append((const char*)data, size); };
+				auto writeString = [&writeBytes](const std::string& value)
+				{
+					unsigned int size = (unsigned int)value.size();
+					writeBytes(&size, sizeof(size));
+					writeBytes(value.c_str(), size);
+				};
+
+				unsigned int version = CACHE_VERSION;
+				writeBytes(&version, sizeof(version));
+
+				for (auto& item : mListings)
+				{
+					long long time = item.second.time;
+					unsigned int count = (unsigned int)item.second.entries.size();
+
+					writeString(item.first);
+					writeBytes(&time, sizeof(time));
+					writeBytes(&count, sizeof(count));
+
+					for (auto& entry : item.second.entries)
+					{
+						unsigned char flags = (entry.info.hidden ? 1 : 0) | (entry.info.directory ? 2 : 0) | (entry.isSymLink ? 4 : 0);
+
+						writeString(entry.info.path);
+						writeBytes(&flags, sizeof(flags));
+#if WIN32
+						long long lastWriteTime = entry.info.lastWriteTime;
+						writeBytes(&lastWriteTime, sizeof(lastWriteTime));
+#endif
+					}
+				}
+
+				std::string path = getCachePath();
+				createDirectory(getParent(path));
+				writeAllText(path + ".tmp", buffer);
+				renameFile(path + ".tmp", path);
+			}
+
+			static const unsigned int CACHE_VERSION = 1;
+
+			static bool mActive;
+			static bool mFullScan;
+			static std::unordered_map<std::string, Listing> mListings;
+
+			static std::mutex mUpdatesLock;
+			static std::unordered_map<std::string, Listing> mUpdates;
+			static std::unordered_set<std::string> mUsedPaths;
 		};
 
-		std::map<std::string, FileCache> FileCache::mFileCache;
-		std::mutex FileCache::mFileCacheMutex;
-		bool FileCache::mEnabled = false;
+		bool DirectoryListingCache::mActive = false;
+		bool DirectoryListingCache::mFullScan = false;
+		std::unordered_map<std::string, DirectoryListingCache::Listing> DirectoryListingCache::mListings;
+		std::mutex DirectoryListingCache::mUpdatesLock;
+		std::unordered_map<std::string, DirectoryListingCache::Listing> DirectoryListingCache::mUpdates;
+		std::unordered_set<std::string> DirectoryListingCache::mUsedPaths;
 
 	// FileSystemCacheActivator
 
 		int FileSystemCacheActivator::mReferenceCount = 0;
 
-		FileSystemCacheActivator::FileSystemCacheActivator()
+		FileSystemCacheActivator::FileSystemCacheActivator(bool fullScan)
 		{
 			if (mReferenceCount == 0)
 			{
 				FileCache::setEnabled(true);
 				FileCache::resetCache();
+				DirectoryListingCache::activate();
 			}
 
+			if (fullScan)
+				DirectoryListingCache::setFullScan();
+
 			mReferenceCount++;
 		}
 
@@ -198,11 +556,91 @@ namespace Utils
 
 			if (mReferenceCount <= 0)
 			{
+				LOG(LogDebug) << "FileSystemCache : " << FileCache::mHits << " hits, " << FileCache::mMisses << " misses";
+
+				DirectoryListingCache::deactivate();
 				FileCache::setEnabled(false);
 				FileCache::resetCache();
 			}
 		}
 
+		void FileSystemCacheActivator::keepDirectoryListing(const std::string& path)
+		{
+			DirectoryListingCache::keep(getGenericPath(path));
+		}
+
+		unsigned long long FileSystemCacheActivator::getCacheHits()
+		{
+			return FileCache::mHits;
+		}
+
+		unsigned long long FileSystemCacheActivator::getCacheMisses()
+		{
+			return FileCache::mMisses;
+		}
+
+	// MappedFile
+
+		MappedFile::MappedFile(const std::string& path) : mData(nullptr), mSize(0), mMapped(false)
+		{
+#if WIN32
+			FILE* file = _wfopen(Utils::String::convertToWideString(path).c_str(), L"rb");
+			if (file == nullptr)
+				return;
+
+			fseek(file, 0, SEEK_END);
+			long size = ftell(file);
+			fseek(file, 0, SEEK_SET);
+
+			if (size > 0)
+			{
+				char* buffer = new char[size];
+				if (fread(buffer, 1, size, file) == (size_t)size)
+				{
+					mData = buffer;
+					mSize = size;
+				}
+				else
+					delete[] buffer;
+			}
+
+			fclose(file);
+#else
+			int fd = open(path.c_str(), O_RDONLY);
+			if (fd < 0)
+				return;
+
+			struct stat64 info;
+			if (fstat64(fd, &info) == 0 && info.st_size > 0)
+			{
+				void* map = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (map != MAP_FAILED)
+				{
+					mData = (const char*)map;
+					mSize = info.st_size;
+					mMapped = true;
+				}
+			}
+
+			close(fd);
+#endif
+		}
+
+		MappedFile::~MappedFile()
+		{
+			if (mData == nullptr)
+				return;
+
+#if !WIN32
+			if (mMapped)
+			{
+				munmap((void*)mData, mSize);
+				return;
+			}
+#endif
+			delete[] mData;
+		}
+
 	// Methods
 
 		stringList getDirContent(const std::string& _path, const bool _recursive, const bool includeHidden)
@@ -319,6 +757,16 @@ namespace Utils
 			// tell filecache we enumerated the folder
 			FileCache::add(path + "/*", FileCache(true, true));
 
+			time_t directoryTime = 0;
+			DirectoryListingCache::Listing listing;
+
+			if (DirectoryListingCache::isActive())
+			{
+				directoryTime = DirectoryListingCache::getDirectoryTime(path);
+				if (directoryTime != 0 && DirectoryListingCache::get(path, directoryTime, contentList))
+					return contentList;
+			}
+
 			// only parse the directory, if it's a directory
 			// if (isDirectory(path))
 			{			
@@ -378,10 +826,16 @@ namespace Utils
 						contentList.push_back(fi);
 
 						FileCache::add(fi.path, FileCache((DWORD)findData.dwFileAttributes));
+
+						if (directoryTime != 0)
+							listing.entries.push_back({ fi, (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) != 0 });
 					} 
 					while (FindNextFileW(hFind, &findData));
 
 					FindClose(hFind);
+
+					if (directoryTime != 0)
+						DirectoryListingCache::put(path, directoryTime, listing);
 				}
 #else // _WIN32
 				DIR* dir = opendir(path.c_str());
@@ -419,10 +873,16 @@ namespace Utils
 
 							//DT_LNK
 							contentList.push_back(fi);
+
+							if (directoryTime != 0)
+								listing.entries.push_back({ fi, entry->d_type == 10 });
 						}
 					}
 
 					closedir(dir);
+
+					if (directoryTime != 0)
+						DirectoryListingCache::put(path, directoryTime, listing);
 				}
 #endif // _WIN32
 
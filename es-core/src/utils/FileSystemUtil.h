@@ -83,13 +83,40 @@ namespace Utils
 		class FileSystemCacheActivator
 		{
 		public:
-			FileSystemCacheActivator();
+			// A full scan lists every directory of the systems : the persistent listings of the other directories are dropped
+			FileSystemCacheActivator(bool fullScan = false);
 			~FileSystemCacheActivator();
 
+			static unsigned long long getCacheHits();
+			static unsigned long long getCacheMisses();
+
+			// Keeps the persistent listing of a directory which is used without being listed (restored from a gamelist snapshot)
+			static void keepDirectoryListing(const std::string& path);
+
 		private:
 			static int mReferenceCount;
 		};
 
+		// Read-only view of a whole file. Memory-mapped where the platform supports it, read into memory otherwise.
+		class MappedFile
+		{
+		public:
+			MappedFile(const std::string& path);
+			~MappedFile();
+
+			inline bool isValid() const { return mData != nullptr; }
+			inline const char* data() const { return mData; }
+			inline size_t size() const { return mSize; }
+
+		private:
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+
+			const char* mData;
+			size_t		mSize;
+			bool		mMapped;
+		};
+
 	} // FileSystem::
 
 } // Utils::
@@ -694,6 +694,30 @@ namespace Utils
 			}
 		}
 
+		std::string toCollationKey(const std::string& _string)
+		{
+			std::string key;
+			key.reserve(_string.length());
+
+			size_t p = 0;
+			while (p < _string.length())
+			{
+				char c = _string[p];
+				if (c == 0)
+					break;
+
+				if ((c & 0x80) == 0)
+				{
+					key += (c >= 'a' && c <= 'z') ? (char)(c - 0x20) : c;
+					p++;
+				}
+				else // UTF-8 keeps the order of the code points
+					key += unicode2Chars(toupperUnicode(chars2Unicode(_string, p)));
+			}
+
+			return key;
+		}
+
 		bool containsIgnoreCase(const std::string & _string, const std::string & _what)
 		{
 			auto it = std::search(
@@ -769,6 +793,19 @@ namespace Utils
 			return value;
 		}
 
+		unsigned long long computeHash(const std::string& string)
+		{
+			unsigned long long hash = 14695981039346656037ULL;
+
+			for (auto c : string)
+			{
+				hash ^= (unsigned char)c;
+				hash *= 1099511628211ULL;
+			}
+
+			return hash;
+		}
+
 		int	toInteger(const std::string& string)
 		{
 			if (string.empty())
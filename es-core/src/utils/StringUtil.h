@@ -34,6 +34,8 @@ namespace Utils
 
 		std::string join(const std::vector<std::string>& items, std::string separator);
 		int			compareIgnoreCase(const std::string& name1, const std::string& name2);
+		// Byte strings : comparing the keys of two strings gives the same order as compareIgnoreCase
+		std::string toCollationKey(const std::string& _string);
 		std::string proper(const std::string& _string);
 		std::string removeHtmlTags(const std::string& html);
 		bool        containsIgnoreCase(const std::string & _string, const std::string & _what);
@@ -46,6 +48,9 @@ namespace Utils
 		std::string toHexString(unsigned int color);
 		unsigned int fromHexString(const std::string& string);
 
+		// FNV-1a : stable between runs & platforms, can be stored in files
+		unsigned long long computeHash(const std::string& string);
+
 #if defined(_WIN32)
 		const std::string convertFromWideString(const std::wstring wstring);
 		const std::wstring convertToWideString(const std::string string);
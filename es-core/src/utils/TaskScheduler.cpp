@@ -0,0 +1,305 @@
+#include "utils/TaskScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if WIN32
+#include <Windows.h>
+#endif
+
+namespace Utils
+{
+	// Index of the worker running on the current thread, -1 for threads not owned by the scheduler
+	static thread_local int sWorkerIndex = -1;
+
+	// Workers sleep at most this delay when only background tasks are queued and they are not allowed to take them
+	#define IDLE_POLL_DELAY 10
+
+// GroupState
+
+	void TaskScheduler::GroupState::taskDone()
+	{
+		if (--pending > 0)
+			return;
+
+		std::function<void()> callback;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			callback = continuation;
+		}
+
+		if (callback)
+		{
+			try
+			{
+				callback();
+			}
+			catch (...) {}
+		}
+
+		std::unique_lock<std::mutex> guard(lock);
+		condition.notify_all();
+	}
+
+// TaskScheduler
+
+	TaskScheduler& TaskScheduler::getInstance()
+	{
+		static TaskScheduler instance;
+		return instance;
+	}
+
+	TaskScheduler::TaskScheduler() : mRunning(true), mNextWorker(0), mQueuedCount(0), mRunningBackground(0)
+	{
+		// Most tasks wait for I/O (storage, network) : use twice the number of cores, but keep the count bounded
+		size_t count = std::thread::hardware_concurrency() * 2;
+		count = std::max<size_t>(2, std::min<size_t>(16, count));
+
+		for (size_t i = 0; i < count; i++)
+			mWorkers.push_back(new Worker());
+
+		for (size_t i = 0; i < count; i++)
+			mWorkers[i]->thread = std::thread(&TaskScheduler::workerLoop, this, (int)i);
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		{
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			mRunning = false;
+		}
+
+		mIdleCondition.notify_all();
+
+		for (auto worker : mWorkers)
+			if (worker->thread.joinable())
+				worker->thread.join();
+
+		for (auto worker : mWorkers)
+			delete worker;
+
+		mWorkers.clear();
+	}
+
+	bool TaskScheduler::isWorkerThread() const
+	{
+		return sWorkerIndex >= 0;
+	}
+
+	void TaskScheduler::schedule(Task task)
+	{
+		// Tasks created by a worker go to its own deque, others are spread between workers
+		int index = sWorkerIndex;
+		if (index < 0 || index >= (int)mWorkers.size())
+			index = (int)(mNextWorker++ % mWorkers.size());
+
+		Worker* worker = mWorkers[index];
+
+		{
+			std::unique_lock<std::mutex> lock(worker->lock);
+			worker->queues[task.group->priority].push_back(std::move(task));
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			mQueuedCount++;
+		}
+
+		mIdleCondition.notify_one();
+	}
+
+	bool TaskScheduler::popTask(int index, Task& task)
+	{
+		int count = (int)mWorkers.size();
+
+		for (int priority = 0; priority < TASK_PRIORITY_COUNT; priority++)
+		{
+			// Always keep one worker available for UI & prefetch tasks
+			if (priority == TASK_BACKGROUND && mRunningBackground >= count - 1)
+				return false;
+
+			// Own work first, newest first
+			{
+				Worker* worker = mWorkers[index];
+				std::unique_lock<std::mutex> lock(worker->lock);
+
+				auto& queue = worker->queues[priority];
+				if (!queue.empty())
+				{
+					task = std::move(queue.back());
+					queue.pop_back();
+					mQueuedCount--;
+					return true;
+				}
+			}
+
+			// Then steal the oldest work of the other workers
+			for (int i = 1; i < count; i++)
+			{
+				Worker* victim = mWorkers[(index + i) % count];
+				std::unique_lock<std::mutex> lock(victim->lock);
+
+				auto& queue = victim->queues[priority];
+				if (!queue.empty())
+				{
+					task = std::move(queue.front());
+					queue.pop_front();
+					mQueuedCount--;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	bool TaskScheduler::runPendingTask(GroupState* group)
+	{
+		Task task;
+		bool found = false;
+
+		for (auto worker : mWorkers)
+		{
+			std::unique_lock<std::mutex> lock(worker->lock);
+
+			for (int priority = 0; priority < TASK_PRIORITY_COUNT && !found; priority++)
+			{
+				auto& queue = worker->queues[priority];
+
+				auto it = std::find_if(queue.begin(), queue.end(), [group](const Task& item) { return item.group.get() == group; });
+				if (it != queue.end())
+				{
+					task = std::move(*it);
+					queue.erase(it);
+					found = true;
+				}
+			}
+
+			if (found)
+				break;
+		}
+
+		if (!found)
+			return false;
+
+		mQueuedCount--;
+		execute(task);
+		return true;
+	}
+
+	void TaskScheduler::execute(Task& task)
+	{
+		bool background = (task.group->priority == TASK_BACKGROUND);
+		if (background)
+			mRunningBackground++;
+
+		if (!task.group->token.isCancelled())
+		{
+			try
+			{
+				task.work();
+			}
+			catch (...) {}
+		}
+
+		if (background)
+		{
+			mRunningBackground--;
+			mIdleCondition.notify_one();
+		}
+
+		task.group->taskDone();
+	}
+
+	void TaskScheduler::workerLoop(int index)
+	{
+#if WIN32
+		auto mask = (static_cast<DWORD_PTR>(1) << (index % std::max<unsigned int>(1, std::thread::hardware_concurrency())));
+		SetThreadAffinityMask(GetCurrentThread(), mask);
+#endif
+
+		sWorkerIndex = index;
+
+		while (mRunning)
+		{
+			Task task;
+			if (popTask(index, task))
+			{
+				execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(mIdleLock);
+			if (!mRunning)
+				break;
+
+			if (mQueuedCount <= 0)
+				mIdleCondition.wait(lock);
+			else
+				mIdleCondition.wait_for(lock, std::chrono::milliseconds(IDLE_POLL_DELAY));
+		}
+	}
+
+// TaskGroup
+
+	TaskGroup::TaskGroup(TaskPriority priority, const CancellationToken& token)
+		: mState(std::make_shared<TaskScheduler::GroupState>(priority, token))
+	{
+	}
+
+	TaskGroup::~TaskGroup()
+	{
+		// Queued tasks are dropped, running ones are waited for
+		cancel();
+		wait();
+	}
+
+	void TaskGroup::run(work_function work)
+	{
+		mState->pending++;
+
+		TaskScheduler::Task task;
+		task.work = work;
+		task.group = mState;
+
+		TaskScheduler::getInstance().schedule(std::move(task));
+	}
+
+	void TaskGroup::then(work_function continuation)
+	{
+		std::unique_lock<std::mutex> lock(mState->lock);
+		mState->continuation = continuation;
+	}
+
+	void TaskGroup::wait()
+	{
+		TaskScheduler& scheduler = TaskScheduler::getInstance();
+
+		while (mState->pending > 0)
+		{
+			if (scheduler.runPendingTask(mState.get()))
+				continue;
+
+			std::unique_lock<std::mutex> lock(mState->lock);
+			mState->condition.wait_for(lock, std::chrono::milliseconds(IDLE_POLL_DELAY), [this] { return mState->pending <= 0; });
+		}
+	}
+
+	void TaskGroup::wait(work_function idle, int delay)
+	{
+		TaskScheduler& scheduler = TaskScheduler::getInstance();
+
+		while (mState->pending > 0)
+		{
+			idle();
+
+			// Don't block a worker : other workers may all be waiting for this group
+			if (scheduler.isWorkerThread() && scheduler.runPendingTask(mState.get()))
+				continue;
+
+			std::unique_lock<std::mutex> lock(mState->lock);
+			mState->condition.wait_for(lock, std::chrono::milliseconds(delay), [this] { return mState->pending <= 0; });
+		}
+	}
+}
@@ -0,0 +1,132 @@
+#pragma once
+#ifndef ES_CORE_UTILS_TASK_SCHEDULER_H
+#define ES_CORE_UTILS_TASK_SCHEDULER_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+namespace Utils
+{
+	enum TaskPriority
+	{
+		TASK_UI = 0,			// Work the user is waiting for
+		TASK_PREFETCH = 1,		// Work the user will probably need soon
+		TASK_BACKGROUND = 2,	// Everything else
+
+		TASK_PRIORITY_COUNT = 3
+	};
+
+	// Shared cancellation flag : copies of a token are cancelled together
+	class CancellationToken
+	{
+	public:
+		CancellationToken() : mCancelled(std::make_shared<std::atomic<bool>>(false)) { }
+
+		void cancel() { *mCancelled = true; }
+		bool isCancelled() const { return *mCancelled; }
+
+	private:
+		std::shared_ptr<std::atomic<bool>> mCancelled;
+	};
+
+	class TaskGroup;
+
+	// Process-wide pool of worker threads. Each worker owns one deque per priority, pops its own work from the back
+	// and steals from the front of the other workers' deques when it runs out of work.
+	class TaskScheduler
+	{
+		friend class TaskGroup;
+
+	public:
+		static TaskScheduler& getInstance();
+
+		size_t getThreadCount() const { return mWorkers.size(); }
+		bool isWorkerThread() const;
+
+	private:
+		struct GroupState
+		{
+			GroupState(TaskPriority _priority, const CancellationToken& _token) : priority(_priority), token(_token), pending(0) { }
+
+			void taskDone();
+
+			TaskPriority			priority;
+			CancellationToken		token;
+			std::atomic<int>		pending;
+
+			std::mutex				lock;
+			std::condition_variable condition;
+			std::function<void()>	continuation;
+		};
+
+		struct Task
+		{
+			std::function<void()>		work;
+			std::shared_ptr<GroupState> group;
+		};
+
+		struct Worker
+		{
+			std::mutex			lock;
+			std::deque<Task>	queues[TASK_PRIORITY_COUNT];
+			std::thread			thread;
+		};
+
+		TaskScheduler();
+		~TaskScheduler();
+
+		void schedule(Task task);
+		bool runPendingTask(GroupState* group);
+
+		void workerLoop(int index);
+		bool popTask(int index, Task& task);
+		void execute(Task& task);
+
+		std::vector<Worker*>	 mWorkers;
+		std::atomic<bool>		 mRunning;
+		std::atomic<size_t>		 mNextWorker;
+		std::atomic<int>		 mQueuedCount;
+		std::atomic<int>		 mRunningBackground;
+
+		std::mutex				 mIdleLock;
+		std::condition_variable	 mIdleCondition;
+	};
+
+	// Set of tasks run on the TaskScheduler which can be waited for or cancelled together.
+	// An optional continuation is called each time the last pending task of the group completes.
+	class TaskGroup
+	{
+	public:
+		typedef std::function<void(void)> work_function;
+
+		TaskGroup(TaskPriority priority = TASK_BACKGROUND, const CancellationToken& token = CancellationToken());
+		~TaskGroup();
+
+		void run(work_function work);
+		void then(work_function continuation);
+
+		// Waiting threads run the queued tasks of the group themselves, so nested groups can't starve the workers
+		void wait();
+		void wait(work_function idle, int delay = 50);
+
+		void cancel() { mState->token.cancel(); }
+		bool isCancelled() const { return mState->token.isCancelled(); }
+		int  getPendingCount() const { return mState->pending; }
+
+		const CancellationToken& getToken() const { return mState->token; }
+
+	private:
+		TaskGroup(const TaskGroup&) = delete;
+		TaskGroup& operator=(const TaskGroup&) = delete;
+
+		std::shared_ptr<TaskScheduler::GroupState> mState;
+	};
+}
+
+#endif // ES_CORE_UTILS_TASK_SCHEDULER_H
@@ -25,6 +25,27 @@ namespace Utils
 			return (mz_uint32)mz_crc32((mz_uint32)crc, (const mz_uint8 *)ptr, buf_len);
 		}
 
+		bool ZipFile::compressBuffer(const void* data, size_t size, std::vector<unsigned char>& output)
+		{
+			mz_ulong length = mz_compressBound((mz_ulong)size);
+			output.resize(length);
+
+			if (mz_compress2(output.data(), &length, (const unsigned char*)data, (mz_ulong)size, MZ_BEST_SPEED) != MZ_OK)
+			{
+				output.clear();
+				return false;
+			}
+
+			output.resize(length);
+			return true;
+		}
+
+		bool ZipFile::uncompressBuffer(const void* data, size_t size, void* output, size_t outputSize)
+		{
+			mz_ulong length = (mz_ulong)outputSize;
+			return mz_uncompress((unsigned char*)output, &length, (const unsigned char*)data, (mz_ulong)size) == MZ_OK && length == outputSize;
+		}
+
 		#define mZipArchive   ((mz_zip_archive*) mZipFile)
 
 		static const uint16_t cp437_to_unicode[256] = {
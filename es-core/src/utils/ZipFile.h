@@ -38,6 +38,10 @@ namespace Utils
 
 			static unsigned int computeCRC(unsigned int crc, const void* ptr, size_t buf_len);
 
+			// Raw deflate helpers (fast level), used for cache files
+			static bool compressBuffer(const void* data, size_t size, std::vector<unsigned char>& output);
+			static bool uncompressBuffer(const void* data, size_t size, void* output, size_t outputSize);
+
 		private:
 			std::string getInternalFilename(const std::string& fileName);
 